@@ -86,7 +86,6 @@
 dsp* DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 static bool hasMIDISync()
 {
@@ -88,7 +88,6 @@
 dsp* DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 static bool hasMIDISync()
 {
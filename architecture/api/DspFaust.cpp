@@ -139,7 +139,6 @@ static void osc_compute_callback(void* arg)
 #include "DspFaust.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 DspFaust::DspFaust(bool auto_connect)
 {
@@ -356,7 +356,6 @@ class BelaUI : public GenericUI
 /*******************BEGIN ARCHITECTURE SECTION (part 2/2)***************/
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /**************************************************************************************
   Bela render.cpp that calls FAUST generated code
@@ -192,7 +192,6 @@ class Cdsp : public dsp {
 /*******************BEGIN ARCHITECTURE SECTION (part 2/2)***************/
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 //-------------------------------------------------------------------------
 // 									MAIN
@@ -122,7 +122,6 @@ struct DisplayUI : public GenericUI {
 mydsp DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 #define kFrames 512
 
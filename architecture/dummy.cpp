@@ -93,7 +93,6 @@ using namespace std;
 dsp* DSP;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /******************************************************************************
 *******************************************************************************
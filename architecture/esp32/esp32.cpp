@@ -77,7 +77,6 @@
 
 #ifdef MIDICTRL
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 #endif
 
 AudioFaust::AudioFaust(int sample_rate, int buffer_size)
@@ -27,20 +27,164 @@
 
 #include <string.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <assert.h>
 #include <sstream>
 
 #include "faust/dsp/dsp.h"
 #include "faust/gui/UI.h"
 
+/*
+ Intermediate channels of a combiners tree are planned at the tree level:
+ the sub-DSPs of a tree are computed one after the other (each leaf DSP compute being a 'step'),
+ so an intermediate channel is only live from the first step writing it to the last step reading it.
+ Channels with disjoint lifetimes share the same frames of a single pool, allocated by the root combiner.
+ The tree is only planned when its root is initialized (init or instanceInit), since the combiners are created
+ bottom-up and a combiner does not know whether it will be a sub-tree of another one: the channels are then
+ planned and allocated once for the whole tree.
+ */
+
+struct dsp_buffers_planner {
+
+    // Steps range [fFirst, fLast]
+    struct steps {
+        int fFirst;
+        int fLast;
+        steps():fFirst(0), fLast(-1) {}
+        steps(int first, int last):fFirst(first), fLast(last) {}
+        steps join(const steps& s) const { return steps(std::min(fFirst, s.fFirst), std::max(fLast, s.fLast)); }
+    };
+
+    struct channels {
+        FAUSTFLOAT** fChannels;
+        int fNum;
+        int fBufferSize;
+        steps fLive;
+        int fOffset;
+        int frames() const { return fNum * fBufferSize; }
+    };
+
+    std::vector<channels> fChannels;
+    int fStep;
+
+    dsp_buffers_planner():fStep(0) {}
+
+    void add(FAUSTFLOAT** chans, int num, int buffer_size, const steps& live)
+    {
+        if (num > 0) {
+            channels c = { chans, num, buffer_size, live, 0 };
+            fChannels.push_back(c);
+        }
+    }
+
+    // Place the largest channels first, each one at the lowest offset not used by a live channel, return the pool size
+    int allocate()
+    {
+        std::vector<channels*> placed;
+        std::vector<channels*> order;
+        for (auto& c : fChannels) order.push_back(&c);
+        std::stable_sort(order.begin(), order.end(), [](channels* c1, channels* c2) { return c1->frames() > c2->frames(); });
+        int frames = 0;
+        for (auto& c : order) {
+            int offset = 0;
+            bool moved = true;
+            while (moved) {
+                moved = false;
+                for (auto& p : placed) {
+                    if (p->fLive.fFirst <= c->fLive.fLast && c->fLive.fFirst <= p->fLive.fLast
+                        && p->fOffset < offset + c->frames() && offset < p->fOffset + p->frames()) {
+                        offset = p->fOffset + p->frames();
+                        moved = true;
+                    }
+                }
+            }
+            c->fOffset = offset;
+            placed.push_back(c);
+            frames = std::max(frames, offset + c->frames());
+        }
+        return frames;
+    }
+
+    void setChannels(FAUSTFLOAT* pool)
+    {
+        for (auto& c : fChannels) {
+            for (int chan = 0; chan < c.fNum; chan++) {
+                c.fChannels[chan] = pool + c.fOffset + chan * c.fBufferSize;
+            }
+        }
+    }
+
+};
+
 // Base class and common code for binary combiners
 
 class dsp_binary_combiner : public dsp {
 
     protected:
 
+        typedef dsp_buffers_planner::steps steps;
+
         dsp* fDSP1;
         dsp* fDSP2;
+        int fBufferSize;
+        FAUSTFLOAT* fPool;  // intermediate channels of the whole tree, only kept by its root
+
+        static dsp_binary_combiner* getCombiner(dsp* sub_dsp)
+        {
+            return dynamic_cast<dsp_binary_combiner*>(sub_dsp);
+        }
+
+        // Plan a sub-DSP, giving the steps reading its inputs and writing its outputs
+        static void planDSP(dsp* sub_dsp, dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            dsp_binary_combiner* combiner = getCombiner(sub_dsp);
+            if (combiner) {
+                // Planned in the tree pool, the pool allocated when the sub-tree was built is not needed anymore
+                combiner->deletePool();
+                combiner->plan(planner, read, write);
+            } else {
+                read = write = steps(planner.fStep, planner.fStep);
+                planner.fStep++;
+            }
+        }
+
+        // Plan the combiner channels, a combiner keeping its own channels is planned like a leaf DSP
+        virtual void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            read = write = steps(planner.fStep, planner.fStep);
+            planner.fStep++;
+        }
+
+        // DSP2 inputs are computed from DSP1 outputs kept in 'channels'
+        void planSequence(dsp_buffers_planner& planner, steps& read, steps& write, FAUSTFLOAT** channels, int num)
+        {
+            steps write1, read2;
+            planDSP(fDSP1, planner, read, write1);
+            planDSP(fDSP2, planner, read2, write);
+            planner.add(channels, num, fBufferSize, steps(write1.fFirst, read2.fLast));
+        }
+
+        // Plan and allocate the channels of the tree, at the end of each combiner constructor:
+        // the last built combiner, the root, keeps the only pool
+        void allocatePool()
+        {
+            dsp_buffers_planner planner;
+            steps read, write;
+            plan(planner, read, write);
+            int frames = planner.allocate();
+            if (frames > 0) {
+                fPool = new FAUSTFLOAT[frames];
+                memset(fPool, 0, sizeof(FAUSTFLOAT) * frames);
+                planner.setChannels(fPool);
+            }
+        }
+
+        void deletePool()
+        {
+            delete [] fPool;
+            fPool = nullptr;
+        }
 
         void buildUserInterfaceAux(UI* ui_interface, const char* name)
         {
@@ -74,13 +218,18 @@ class dsp_binary_combiner : public dsp {
 
      public:
 
-        dsp_binary_combiner(dsp* dsp1, dsp* dsp2):fDSP1(dsp1), fDSP2(dsp2)
+        dsp_binary_combiner(dsp* dsp1, dsp* dsp2, int buffer_size)
+        :fDSP1(dsp1), fDSP2(dsp2), fBufferSize(buffer_size), fPool(nullptr)
+        {}
+        dsp_binary_combiner(dsp* dsp1, dsp* dsp2)
+        :fDSP1(dsp1), fDSP2(dsp2), fBufferSize(4096), fPool(nullptr)
         {}
 
         virtual ~dsp_binary_combiner()
         {
             delete fDSP1;
             delete fDSP2;
+            deletePool();
         }
 
         virtual int getSampleRate()
@@ -131,16 +280,22 @@ class dsp_sequencer : public dsp_binary_combiner {
 
         FAUSTFLOAT** fDSP1Outputs;
 
+        void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            planSequence(planner, read, write, fDSP1Outputs, fDSP1->getNumOutputs());
+        }
+
     public:
 
-        dsp_sequencer(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2)
+        dsp_sequencer(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2, buffer_size)
         {
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs(), buffer_size);
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
+            allocatePool();
         }
 
         virtual ~dsp_sequencer()
         {
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
         }
 
         virtual int getNumInputs() { return fDSP1->getNumInputs(); }
@@ -153,7 +308,7 @@ class dsp_sequencer : public dsp_binary_combiner {
 
         virtual dsp* clone()
         {
-            return new dsp_sequencer(fDSP1->clone(), fDSP2->clone());
+            return new dsp_sequencer(fDSP1->clone(), fDSP2->clone(), fBufferSize);
         }
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
@@ -175,12 +330,22 @@ class dsp_parallelizer : public dsp_binary_combiner {
         FAUSTFLOAT** fDSP2Inputs;
         FAUSTFLOAT** fDSP2Outputs;
 
+        void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            steps read2, write2;
+            planDSP(fDSP1, planner, read, write);
+            planDSP(fDSP2, planner, read2, write2);
+            read = read.join(read2);
+            write = write.join(write2);
+        }
+
     public:
 
-        dsp_parallelizer(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2)
+        dsp_parallelizer(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2, buffer_size)
         {
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
             fDSP2Outputs = new FAUSTFLOAT*[fDSP2->getNumOutputs()];
+            allocatePool();
         }
 
         virtual ~dsp_parallelizer()
@@ -199,7 +364,7 @@ class dsp_parallelizer : public dsp_binary_combiner {
 
         virtual dsp* clone()
         {
-            return new dsp_parallelizer(fDSP1->clone(), fDSP2->clone());
+            return new dsp_parallelizer(fDSP1->clone(), fDSP2->clone(), fBufferSize);
         }
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
@@ -230,17 +395,23 @@ class dsp_splitter : public dsp_binary_combiner {
         FAUSTFLOAT** fDSP1Outputs;
         FAUSTFLOAT** fDSP2Inputs;
 
+        void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            planSequence(planner, read, write, fDSP1Outputs, fDSP1->getNumOutputs());
+        }
+
     public:
 
-        dsp_splitter(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2)
+        dsp_splitter(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2, buffer_size)
         {
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs(), buffer_size);
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
+            allocatePool();
         }
 
         virtual ~dsp_splitter()
         {
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
             delete [] fDSP2Inputs;
         }
 
@@ -254,7 +425,7 @@ class dsp_splitter : public dsp_binary_combiner {
 
         virtual dsp* clone()
         {
-            return new dsp_splitter(fDSP1->clone(), fDSP2->clone());
+            return new dsp_splitter(fDSP1->clone(), fDSP2->clone(), fBufferSize);
         }
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
@@ -275,10 +446,14 @@ class dsp_merger : public dsp_binary_combiner {
 
     private:
 
-        FAUSTFLOAT** fDSP1Inputs;
         FAUSTFLOAT** fDSP1Outputs;
         FAUSTFLOAT** fDSP2Inputs;
 
+        void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            planSequence(planner, read, write, fDSP1Outputs, fDSP1->getNumOutputs());
+        }
+
         void mix(int count, FAUSTFLOAT* dst, FAUSTFLOAT* src)
         {
             for (int frame = 0; frame < count; frame++) {
@@ -288,17 +463,16 @@ class dsp_merger : public dsp_binary_combiner {
 
     public:
 
-        dsp_merger(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2)
+        dsp_merger(dsp* dsp1, dsp* dsp2, int buffer_size = 4096):dsp_binary_combiner(dsp1, dsp2, buffer_size)
         {
-            fDSP1Inputs = allocateChannels(fDSP1->getNumInputs(), buffer_size);
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs(), buffer_size);
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
+            allocatePool();
         }
 
         virtual ~dsp_merger()
         {
-            deleteChannels(fDSP1Inputs, fDSP1->getNumInputs());
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
             delete [] fDSP2Inputs;
         }
 
@@ -312,12 +486,12 @@ class dsp_merger : public dsp_binary_combiner {
 
         virtual dsp* clone()
         {
-            return new dsp_merger(fDSP1->clone(), fDSP2->clone());
+            return new dsp_merger(fDSP1->clone(), fDSP2->clone(), fBufferSize);
         }
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
         {
-            fDSP1->compute(count, fDSP1Inputs, fDSP1Outputs);
+            fDSP1->compute(count, inputs, fDSP1Outputs);
 
             memset(fDSP2Inputs, 0, sizeof(FAUSTFLOAT*) * fDSP2->getNumInputs());
 
@@ -346,14 +520,25 @@ class dsp_recursiver : public dsp_binary_combiner {
         FAUSTFLOAT** fDSP2Inputs;
         FAUSTFLOAT** fDSP2Outputs;
 
+        // The one frame channels keep the feedback state and stay private,
+        // inputs are read and outputs written all along the frames loop
+        void plan(dsp_buffers_planner& planner, steps& read, steps& write)
+        {
+            steps read1, write1, read2, write2;
+            planDSP(fDSP1, planner, read1, write1);
+            planDSP(fDSP2, planner, read2, write2);
+            read = write = read1.join(write2);
+        }
+
     public:
 
-        dsp_recursiver(dsp* dsp1, dsp* dsp2):dsp_binary_combiner(dsp1, dsp2)
+        dsp_recursiver(dsp* dsp1, dsp* dsp2):dsp_binary_combiner(dsp1, dsp2, 1)
         {
             fDSP1Inputs = allocateChannels(fDSP1->getNumInputs(), 1);
             fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs(), 1);
             fDSP2Inputs = allocateChannels(fDSP2->getNumInputs(), 1);
             fDSP2Outputs = allocateChannels(fDSP2->getNumOutputs(), 1);
+            allocatePool();
         }
 
         virtual ~dsp_recursiver()
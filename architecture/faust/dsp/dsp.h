@@ -174,6 +174,29 @@ class decorator_dsp : public dsp {
     
 };
 
+/**
+ * DSP computing several independent instances (lanes) in lockstep, generated with the '-batch <n>' option.
+ *
+ * Lanes share their inputs, and output 'chan' of lane 'lane' is written in outputs[lane * (getNumOutputs() / getNumLanes()) + chan].
+ * 'buildUserInterface' gives the zones of the first lane, the zone of a given control in lane 'lane' is 'zone + lane'.
+ */
+
+class batch_dsp : public dsp {
+
+    public:
+
+        /* Return the number of lanes */
+        virtual int getNumLanes() = 0;
+
+        /**
+         * Init the state (delay lines...) of one lane, without changing the other lanes.
+         *
+         * @param lane - the lane, between 0 and getNumLanes() - 1
+         */
+        virtual void instanceClearLane(int lane) = 0;
+
+};
+
 /**
  * DSP factory class.
  */
@@ -37,10 +37,38 @@
 #include <float.h>
 #include <assert.h>
 
+#ifdef POLY_THREADS
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdint.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/semaphore.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <semaphore.h>
+#include <errno.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#endif
+
 #include "faust/midi/midi.h"
 #include "faust/dsp/dsp-combiner.h"
 #include "faust/gui/GUI.h"
 #include "faust/gui/MapUI.h"
+#include "faust/gui/DecoratorUI.h"
 #include "faust/dsp/proxy-dsp.h"
 #include "faust/gui/JSONControl.h"
 
@@ -147,6 +175,132 @@ class GroupUI : public GUI, public PathBuilder
 
 };
 
+/**
+ * Gives the zones of one lane of a batch_dsp.
+ */
+
+class LaneUI : public DecoratorUI {
+
+    private:
+
+        int fLane;
+
+        FAUSTFLOAT* getZone(FAUSTFLOAT* zone) { return (zone) ? zone + fLane : zone; }
+
+    public:
+
+        LaneUI(UI* ui, int lane):DecoratorUI(ui), fLane(lane) {}
+        virtual ~LaneUI()
+        {
+            // 'fUI' is not owned
+            fUI = nullptr;
+        }
+
+        // -- active widgets
+        void addButton(const char* label, FAUSTFLOAT* zone) { fUI->addButton(label, getZone(zone)); }
+        void addCheckButton(const char* label, FAUSTFLOAT* zone) { fUI->addCheckButton(label, getZone(zone)); }
+        void addVerticalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+        {
+            fUI->addVerticalSlider(label, getZone(zone), init, min, max, step);
+        }
+        void addHorizontalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+        {
+            fUI->addHorizontalSlider(label, getZone(zone), init, min, max, step);
+        }
+        void addNumEntry(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+        {
+            fUI->addNumEntry(label, getZone(zone), init, min, max, step);
+        }
+
+        // -- passive widgets
+        void addHorizontalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT min, FAUSTFLOAT max)
+        {
+            fUI->addHorizontalBargraph(label, getZone(zone), min, max);
+        }
+        void addVerticalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT min, FAUSTFLOAT max)
+        {
+            fUI->addVerticalBargraph(label, getZone(zone), min, max);
+        }
+
+        void declare(FAUSTFLOAT* zone, const char* key, const char* val) { fUI->declare(getZone(zone), key, val); }
+
+};
+
+/**
+ * One lane of a batch_dsp seen as a DSP: the state of the lane is cleared by 'instanceClear',
+ * the other methods apply to all lanes. Lanes of a shared batch_dsp are computed, and the batch_dsp
+ * is deleted, by mydsp_poly. A cloned lane owns a copy of the batch_dsp, and computes it alone.
+ */
+
+class dsp_lane : public dsp {
+
+    private:
+
+        batch_dsp* fBatch;
+        int fLane;
+        FAUSTFLOAT** fInputs;       // Only used with an owned batch_dsp
+        FAUSTFLOAT** fLaneBuffer;   // Outputs of all lanes, only used with an owned batch_dsp
+
+    public:
+
+        dsp_lane(batch_dsp* batch, int lane, bool owned = false):fBatch(batch), fLane(lane), fInputs(nullptr), fLaneBuffer(nullptr)
+        {
+            if (owned) {
+                fInputs = new FAUSTFLOAT*[fBatch->getNumInputs()];
+                fLaneBuffer = new FAUSTFLOAT*[fBatch->getNumOutputs()];
+                for (int chan = 0; chan < fBatch->getNumOutputs(); chan++) {
+                    fLaneBuffer[chan] = new FAUSTFLOAT[MIX_BUFFER_SIZE];
+                }
+            }
+        }
+
+        virtual ~dsp_lane()
+        {
+            if (fLaneBuffer) {
+                for (int chan = 0; chan < fBatch->getNumOutputs(); chan++) {
+                    delete[] fLaneBuffer[chan];
+                }
+                delete[] fLaneBuffer;
+                delete[] fInputs;
+                delete fBatch;
+            }
+        }
+
+        virtual int getNumInputs() { return fBatch->getNumInputs(); }
+        virtual int getNumOutputs() { return fBatch->getNumOutputs() / fBatch->getNumLanes(); }
+        virtual void buildUserInterface(UI* ui_interface)
+        {
+            LaneUI lane_ui(ui_interface, fLane);
+            fBatch->buildUserInterface(&lane_ui);
+        }
+        virtual int getSampleRate() { return fBatch->getSampleRate(); }
+        virtual void init(int sample_rate) { fBatch->init(sample_rate); }
+        virtual void instanceInit(int sample_rate) { fBatch->instanceInit(sample_rate); }
+        virtual void instanceConstants(int sample_rate) { fBatch->instanceConstants(sample_rate); }
+        virtual void instanceResetUserInterface() { fBatch->instanceResetUserInterface(); }
+        virtual void instanceClear() { fBatch->instanceClearLane(fLane); }
+        virtual dsp_lane* clone() { return new dsp_lane(static_cast<batch_dsp*>(fBatch->clone()), fLane, true); }
+        virtual void metadata(Meta* m) { fBatch->metadata(m); }
+
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            // A lane of a shared batch_dsp is computed with the other lanes by mydsp_poly
+            assert(fLaneBuffer);
+            int numOutputs = getNumOutputs();
+            for (int frame = 0; frame < count; frame += MIX_BUFFER_SIZE) {
+                int size = std::min<int>(MIX_BUFFER_SIZE, count - frame);
+                for (int chan = 0; chan < getNumInputs(); chan++) {
+                    fInputs[chan] = inputs[chan] + frame;
+                }
+                fBatch->compute(size, fInputs, fLaneBuffer);
+                for (int chan = 0; chan < numOutputs; chan++) {
+                    memcpy(outputs[chan] + frame, fLaneBuffer[fLane * numOutputs + chan], size * sizeof(FAUSTFLOAT));
+                }
+            }
+        }
+
+};
+
 /**
  * One voice of polyphony.
  */
@@ -168,6 +322,9 @@ struct dsp_voice : public MapUI, public decorator_dsp {
     std::vector<std::string> fGatePath; // Paths of 'gate' control
     std::vector<std::string> fGainPath; // Paths of 'gain/vel|velocity' control
     std::vector<std::string> fFreqPath; // Paths of 'freq/key' control
+    std::vector<int> fGateIndex;        // Indexes of 'gate' control
+    std::vector<int> fGainIndex;        // Indexes of 'gain/vel|velocity' control
+    std::vector<int> fFreqIndex;        // Indexes of 'freq/key' control
     TransformFunction        fKeyFun;   // MIDI key to freq conversion function
     TransformFunction        fVelFun;   // MIDI velocity to gain conversion function
  
@@ -182,6 +339,10 @@ struct dsp_voice : public MapUI, public decorator_dsp {
         fDate = 0;
         fMaxRelease = dsp->getSampleRate()/2; // One 1/2 sec used in release mode to detect end of note
         extractPaths(fGatePath, fFreqPath, fGainPath);
+        // Resolved once, so that keyOn/keyOff do not look up paths
+        for (auto& it : fGatePath) fGateIndex.push_back(getParamIndex(it));
+        for (auto& it : fGainPath) fGainIndex.push_back(getParamIndex(it));
+        for (auto& it : fFreqPath) fFreqIndex.push_back(getParamIndex(it));
     }
     virtual ~dsp_voice()
     {}
@@ -221,14 +382,14 @@ struct dsp_voice : public MapUI, public decorator_dsp {
         // So that DSP state is always re-initialized
         fDSP->instanceClear();
         
-        for (size_t i = 0; i < fFreqPath.size(); i++) {
-            setParamValue(fFreqPath[i], fKeyFun(pitch));
+        for (size_t i = 0; i < fFreqIndex.size(); i++) {
+            setParamValue(fFreqIndex[i], fKeyFun(pitch));
         }
-        for (size_t i = 0; i < fGatePath.size(); i++) {
-            setParamValue(fGatePath[i], FAUSTFLOAT(1));
+        for (size_t i = 0; i < fGateIndex.size(); i++) {
+            setParamValue(fGateIndex[i], FAUSTFLOAT(1));
         }
-        for (size_t i = 0; i < fGainPath.size(); i++) {
-            setParamValue(fGainPath[i], velocity);
+        for (size_t i = 0; i < fGainIndex.size(); i++) {
+            setParamValue(fGainIndex[i], velocity);
         }
         
         fNote = pitch;
@@ -237,8 +398,8 @@ struct dsp_voice : public MapUI, public decorator_dsp {
     void keyOff(bool hard = false)
     {
         // No use of velocity for now...
-        for (size_t i = 0; i < fGatePath.size(); i++) {
-            setParamValue(fGatePath[i], FAUSTFLOAT(0));
+        for (size_t i = 0; i < fGateIndex.size(); i++) {
+            setParamValue(fGateIndex[i], FAUSTFLOAT(0));
         }
         
         if (hard) {
@@ -456,6 +617,285 @@ class dsp_poly : public decorator_dsp, public midi, public JSONControl {
 
 };
 
+#ifdef POLY_THREADS
+
+/**
+ * Counting semaphore used by the audio thread to sleep until the last voice computed by a worker is done.
+ */
+
+class dsp_voice_semaphore {
+
+    private:
+    
+    #if defined(__APPLE__)
+        semaphore_t fSem;
+    #elif defined(_WIN32)
+        HANDLE fSem;
+    #else
+        sem_t fSem;
+    #endif
+    
+    public:
+    
+    #if defined(__APPLE__)
+        dsp_voice_semaphore() { semaphore_create(mach_task_self(), &fSem, SYNC_POLICY_FIFO, 0); }
+        ~dsp_voice_semaphore() { semaphore_destroy(mach_task_self(), fSem); }
+        void post() { semaphore_signal(fSem); }
+        void wait() { while (semaphore_wait(fSem) != KERN_SUCCESS) {} }
+    #elif defined(_WIN32)
+        dsp_voice_semaphore() { fSem = CreateSemaphore(NULL, 0, LONG_MAX, NULL); }
+        ~dsp_voice_semaphore() { CloseHandle(fSem); }
+        void post() { ReleaseSemaphore(fSem, 1, NULL); }
+        void wait() { WaitForSingleObject(fSem, INFINITE); }
+    #else
+        dsp_voice_semaphore() { sem_init(&fSem, 0, 0); }
+        ~dsp_voice_semaphore() { sem_destroy(&fSem); }
+        void post() { sem_post(&fSem); }
+        void wait() { while (sem_wait(&fSem) != 0 && errno == EINTR) {} }
+    #endif
+
+};
+
+/**
+ * Parks the idle workers without missing wake-ups (like the EventCount of the -sch scheduler): a worker calls
+ * prepareWait, checks for a new cycle again, then calls either cancelWait or wait.
+ * notify only costs a fence and a load when no worker is parked.
+ */
+
+class dsp_voice_event {
+
+    private:
+    
+        std::atomic<int> fEpoch;
+        std::atomic<int> fWaiters;
+    #ifndef __linux__
+        std::mutex fMutex;
+        std::condition_variable fCond;
+    #endif
+    
+    public:
+    
+        dsp_voice_event():fEpoch(0), fWaiters(0) {}
+    
+        int prepareWait()
+        {
+            fWaiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return fEpoch.load();
+        }
+    
+        void cancelWait() { fWaiters.fetch_sub(1); }
+    
+        void wait(int epoch)
+        {
+        #ifdef __linux__
+            while (fEpoch.load() == epoch) {
+                syscall(SYS_futex, reinterpret_cast<int*>(&fEpoch), FUTEX_WAIT_PRIVATE, epoch, NULL, NULL, 0);
+            }
+        #else
+            std::unique_lock<std::mutex> lock(fMutex);
+            while (fEpoch.load() == epoch) {
+                fCond.wait(lock);
+            }
+        #endif
+            fWaiters.fetch_sub(1);
+        }
+    
+        // Wake up all parked workers
+        void notify()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (fWaiters.load(std::memory_order_relaxed) > 0) {
+            #ifdef __linux__
+                fEpoch.fetch_add(1);
+                syscall(SYS_futex, reinterpret_cast<int*>(&fEpoch), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+            #else
+                {
+                    std::lock_guard<std::mutex> lock(fMutex);
+                    fEpoch.fetch_add(1);
+                }
+                fCond.notify_all();
+            #endif
+            }
+        }
+
+};
+
+/**
+ * A fixed pool of worker threads used to compute the voices of mydsp_poly in parallel.
+ *
+ * For each audio cycle the audio thread publishes a number of jobs, then computes jobs itself
+ * with the workers. Jobs are claimed one by one with an atomic state (cycle, number of jobs, next job),
+ * so a late or sleeping worker never delays the audio thread: it only waits for the jobs already
+ * started by other threads, spinning for a while, then sleeping on a semaphore posted by the worker
+ * finishing the last job. No allocation and no lock are done on the audio thread.
+ * Idle workers spin for a while, then park on a dsp_voice_event that the audio thread notifies
+ * when it publishes a cycle.
+ * As in the work stealing scheduler, workers take the scheduling policy of the audio thread
+ * (with a priority lowered by one) after their first cycle.
+ *
+ * Jobs are not distributed in per-worker queues with work stealing: a cycle has at most a few
+ * dozen voices of similar cost, and claiming them in order from one counter already balances
+ * the load dynamically, for a single atomic operation per voice.
+ */
+
+class dsp_voice_pool {
+
+    private:
+    
+        static const int kSpinCount = 20000;    // Number of 'yield' before an idle worker parks
+        static const int kWaitSpinCount = 2000; // Number of checks before the audio thread sleeps on fDoneSem
+    
+        std::vector<std::thread> fWorkers;
+        std::function<void(int)> fJob;          // Computes the job 'i' of the current cycle
+        std::atomic<uint64_t> fState;           // cycle (32 bits) | number of jobs (16 bits) | next job (16 bits)
+        std::atomic<int> fDone;                 // Number of finished jobs in the current cycle
+        std::atomic<uint32_t> fWaitCycle;       // Cycle the audio thread sleeps (or is about to) on fDoneSem for, 0 if none
+        dsp_voice_semaphore fDoneSem;
+        dsp_voice_event fIdle;                  // Idle workers park on it
+        std::atomic<bool> fRunning;
+        uint32_t fCycle;
+    
+    #ifndef _WIN32
+        // Scheduling of the audio thread, read on its first cycle
+        int fPolicy;
+        struct sched_param fParam;
+    
+        void getRealTime()
+        {
+            if (fPolicy == -1) {
+                memset(&fParam, 0, sizeof(fParam));
+                pthread_getschedparam(pthread_self(), &fPolicy, &fParam);
+            }
+        }
+    
+        void setRealTime()
+        {
+            if (fPolicy != SCHED_OTHER) {
+                struct sched_param param = fParam;
+                param.sched_priority--;
+                pthread_setschedparam(pthread_self(), fPolicy, &param);
+            }
+        }
+    #else
+        void getRealTime() {}
+        void setRealTime() {}
+    #endif
+    
+        static uint64_t makeState(uint32_t cycle, int jobs, int next)
+        {
+            return (uint64_t(cycle) << 32) | (uint64_t(jobs) << 16) | uint64_t(next);
+        }
+    
+        // Claim and compute the remaining jobs of 'cycle'
+        void runJobs(uint32_t cycle)
+        {
+            uint64_t state = fState.load(std::memory_order_acquire);
+            while (uint32_t(state >> 32) == cycle && (state & 0xFFFF) < ((state >> 16) & 0xFFFF)) {
+                if (fState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel)) {
+                    fJob(int(state & 0xFFFF));
+                    // The thread finishing the last job wakes up the audio thread if it sleeps for this cycle
+                    // (the audio thread may already be waiting for the next cycle when this thread gets here)
+                    if (fDone.fetch_add(1) + 1 == int((state >> 16) & 0xFFFF)) {
+                        uint32_t waiting = cycle;
+                        if (fWaitCycle.compare_exchange_strong(waiting, 0)) {
+                            fDoneSem.post();
+                        }
+                    }
+                    state = fState.load(std::memory_order_acquire);
+                }
+            }
+        }
+    
+        void run()
+        {
+            uint32_t cycle = 0;
+            int idle = 0;
+            bool realtime = false;
+            while (fRunning.load(std::memory_order_acquire)) {
+                uint32_t new_cycle = uint32_t(fState.load(std::memory_order_acquire) >> 32);
+                if (new_cycle != cycle) {
+                    cycle = new_cycle;
+                    idle = 0;
+                    runJobs(cycle);
+                    if (!realtime) {
+                        setRealTime();
+                        realtime = true;
+                    }
+                } else if (idle < kSpinCount) {
+                    idle++;
+                    std::this_thread::yield();
+                } else {
+                    int epoch = fIdle.prepareWait();
+                    if (uint32_t(fState.load() >> 32) != cycle || !fRunning.load()) {
+                        fIdle.cancelWait();
+                    } else {
+                        fIdle.wait(epoch);
+                    }
+                }
+            }
+        }
+    
+    public:
+    
+        /**
+         * Constructor.
+         *
+         * @param num_threads - the number of threads computing jobs, including the audio thread
+         * @param job - the function computing a job, called with the job index
+         */
+        dsp_voice_pool(int num_threads, std::function<void(int)> job)
+        :fJob(job), fState(0), fDone(0), fWaitCycle(0), fRunning(true), fCycle(0)
+        {
+        #ifndef _WIN32
+            fPolicy = -1;
+        #endif
+            for (int i = 0; i < num_threads - 1; i++) {
+                fWorkers.push_back(std::thread(&dsp_voice_pool::run, this));
+            }
+        }
+    
+        virtual ~dsp_voice_pool()
+        {
+            fRunning.store(false);
+            fIdle.notify();
+            for (size_t i = 0; i < fWorkers.size(); i++) {
+                fWorkers[i].join();
+            }
+        }
+    
+        int getNumThreads() { return int(fWorkers.size()) + 1; }
+    
+        // Called on the audio thread : compute 'jobs' jobs and return when all of them are done
+        void compute(int jobs)
+        {
+            if (jobs == 0) return;
+            assert(jobs <= 0xFFFF);
+            getRealTime();
+            fDone.store(0, std::memory_order_relaxed);
+            if (++fCycle == 0) fCycle = 1;  // 0 means 'not waiting' in fWaitCycle
+            fState.store(makeState(fCycle, jobs, 0));
+            fIdle.notify();
+            runJobs(fCycle);
+            
+            // Wait for the jobs still computed by workers: spin for a while, then sleep
+            for (int i = 0; i < kWaitSpinCount; i++) {
+                if (fDone.load(std::memory_order_acquire) == jobs) return;
+            }
+            fWaitCycle.store(fCycle);
+            if (fDone.load() == jobs) {
+                // If the last worker already cleared fWaitCycle, it also posts the semaphore: consume it
+                uint32_t waiting = fCycle;
+                if (!fWaitCycle.compare_exchange_strong(waiting, 0)) fDoneSem.wait();
+                return;
+            }
+            fDoneSem.wait();
+        }
+    
+};
+
+#endif
+
 /**
  * Polyphonic DSP: groups a set of DSP to be played together or triggered by MIDI.
  *
@@ -470,6 +910,17 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
         FAUSTFLOAT** fMixBuffer;
         FAUSTFLOAT** fOutBuffer;
         int fDate;
+
+        std::vector<batch_dsp*> fBatchTable;    // With a batch_dsp, voice 'i' is lane 'i % lanes' of batch 'i / lanes'
+        FAUSTFLOAT** fLaneBuffer;               // Outputs of all lanes of a batch
+    
+    #ifdef POLY_THREADS
+        dsp_voice_pool* fPool;
+        std::vector<FAUSTFLOAT**> fVoiceBuffer;    // One output buffer per voice
+        std::vector<dsp_voice*> fActiveVoices;     // Voices computed in the current cycle
+        int fCount;                                // Parameters of the current cycle
+        FAUSTFLOAT** fInputs;
+    #endif
   
         FAUSTFLOAT mixCheckVoice(int count, FAUSTFLOAT** mixBuffer, FAUSTFLOAT** outBuffer)
         {
@@ -509,6 +960,109 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
                 memset(outBuffer[chan], 0, count * sizeof(FAUSTFLOAT));
             }
         }
+
+        // Compute the batches having a playing lane, and mix their lanes
+        void computeBatches(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outBuffer)
+        {
+            size_t lanes = size_t(fBatchTable[0]->getNumLanes());
+            for (size_t batch = 0; batch < fBatchTable.size(); batch++) {
+                size_t first = batch * lanes;
+                size_t last = std::min(first + lanes, fVoiceTable.size());
+                bool playing = !fVoiceControl;
+                for (size_t i = first; i < last; i++) {
+                    playing |= (fVoiceTable[i]->fNote != kFreeVoice);
+                }
+                if (!playing) continue;
+                
+                fBatchTable[batch]->compute(count, inputs, fLaneBuffer);
+                for (size_t i = first; i < last; i++) {
+                    dsp_voice* voice = fVoiceTable[i];
+                    FAUSTFLOAT** laneBuffer = &fLaneBuffer[(i - first) * getNumOutputs()];
+                    if (!fVoiceControl) {
+                        mixVoice(count, laneBuffer, outBuffer);
+                    } else if (voice->fNote != kFreeVoice) {
+                        voice->fLevel = mixCheckVoice(count, laneBuffer, outBuffer);
+                        // Check the level to possibly set the voice in kFreeVoice again
+                        voice->fRelease -= count;
+                        if ((voice->fNote == kReleaseVoice)
+                            && (voice->fRelease < 0)
+                            && (voice->fLevel < VOICE_STOP_LEVEL)) {
+                            voice->fNote = kFreeVoice;
+                        }
+                    }
+                }
+            }
+        }
+    
+    #ifdef POLY_THREADS
+        FAUSTFLOAT checkVoice(int count, FAUSTFLOAT** mixBuffer)
+        {
+            FAUSTFLOAT level = 0;
+            for (int chan = 0; chan < getNumOutputs(); chan++) {
+                FAUSTFLOAT* mixChannel = mixBuffer[chan];
+                for (int frame = 0; frame < count; frame++) {
+                    level = std::max<FAUSTFLOAT>(level, (FAUSTFLOAT)fabs(mixChannel[frame]));
+                }
+            }
+            return level;
+        }
+    
+        // Called by the pool threads : compute one active voice in its own buffer
+        void computeVoice(int job)
+        {
+            dsp_voice* voice = fActiveVoices[job];
+            voice->compute(fCount, fInputs, fVoiceBuffer[job]);
+            if (fVoiceControl) {
+                voice->fLevel = checkVoice(fCount, fVoiceBuffer[job]);
+                // Check the level to possibly set the voice in kFreeVoice again
+                voice->fRelease -= fCount;
+                if ((voice->fNote == kReleaseVoice)
+                    && (voice->fRelease < 0)
+                    && (voice->fLevel < VOICE_STOP_LEVEL)) {
+                    voice->fNote = kFreeVoice;
+                }
+            }
+        }
+    
+        void computeParallel(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            // Collect the voices to compute
+            fActiveVoices.clear();  // Capacity is kept, so no allocation
+            for (size_t i = 0; i < fVoiceTable.size(); i++) {
+                if (!fVoiceControl || fVoiceTable[i]->fNote != kFreeVoice) {
+                    fActiveVoices.push_back(fVoiceTable[i]);
+                }
+            }
+            int jobs = int(fActiveVoices.size());
+            if (jobs == 0) {
+                clear(count, outputs);
+                return;
+            }
+            
+            fCount = count;
+            fInputs = inputs;
+            fPool->compute(jobs);
+            
+            // Tree reduction of the voices buffers (in a fixed order, so that the result does not depend on the scheduling)
+            for (int stride = 1; stride < jobs; stride *= 2) {
+                for (int i = 0; i + stride < jobs; i += 2 * stride) {
+                    mixVoice(count, fVoiceBuffer[i + stride], fVoiceBuffer[i]);
+                }
+            }
+            copy(count, fVoiceBuffer[0], outputs);
+        }
+    
+        void deleteVoiceBuffers()
+        {
+            for (size_t i = 0; i < fVoiceBuffer.size(); i++) {
+                for (int chan = 0; chan < getNumOutputs(); chan++) {
+                    delete[] fVoiceBuffer[i][chan];
+                }
+                delete[] fVoiceBuffer[i];
+            }
+            fVoiceBuffer.clear();
+        }
+    #endif
     
         int getPlayingVoice(int pitch)
         {
@@ -612,6 +1166,7 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
          * Constructor.
          *
          * @param dsp - the dsp to be used for one voice. Beware: mydsp_poly will use and finally delete the pointer.
+         *              A batch_dsp (generated with the '-batch <n>' option) is used to compute <n> voices at once.
          * @param nvoices - number of polyphony voices, should be at least 1
          * @param control - whether voices will be dynamically allocated and controlled (typically by a MIDI controler).
          *                If false all voices are always running.
@@ -628,11 +1183,30 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
         : dsp_voice_group(panic, this, control, group), dsp_poly(dsp) // dsp parameter is deallocated by ~dsp_poly
         {
             fDate = 0;
+        #ifdef POLY_THREADS
+            fPool = nullptr;
+            fCount = 0;
+            fInputs = nullptr;
+        #endif
 
-            // Create voices
+            // Create voices, possibly packed in the lanes of batch_dsp instances
             assert(nvoices > 0);
+            batch_dsp* batch = dynamic_cast<batch_dsp*>(dsp);
+            fLaneBuffer = nullptr;
             for (int i = 0; i < nvoices; i++) {
-                addVoice(new dsp_voice(dsp->clone()));
+                if (batch) {
+                    int lane = i % batch->getNumLanes();
+                    if (lane == 0) fBatchTable.push_back(static_cast<batch_dsp*>(batch->clone()));
+                    addVoice(new dsp_voice(new dsp_lane(fBatchTable.back(), lane)));
+                } else {
+                    addVoice(new dsp_voice(dsp->clone()));
+                }
+            }
+            if (batch) {
+                fLaneBuffer = new FAUSTFLOAT*[batch->getNumOutputs()];
+                for (int chan = 0; chan < batch->getNumOutputs(); chan++) {
+                    fLaneBuffer[chan] = new FAUSTFLOAT[MIX_BUFFER_SIZE];
+                }
             }
 
             // Init audio output buffers
@@ -648,12 +1222,31 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
 
         virtual ~mydsp_poly()
         {
+        #ifdef POLY_THREADS
+            setNumThreads(1);
+        #endif
             for (int chan = 0; chan < getNumOutputs(); chan++) {
                 delete[] fMixBuffer[chan];
                 delete[] fOutBuffer[chan];
             }
             delete[] fMixBuffer;
             delete[] fOutBuffer;
+            if (fLaneBuffer) {
+                for (int chan = 0; chan < fDSP->getNumOutputs(); chan++) {
+                    delete[] fLaneBuffer[chan];
+                }
+                delete[] fLaneBuffer;
+            }
+            // Voices (deleted in ~dsp_voice_group) do not access their batch anymore
+            for (size_t i = 0; i < fBatchTable.size(); i++) {
+                delete fBatchTable[i];
+            }
+        }
+
+        // With a batch_dsp, the outputs of one voice
+        int getNumOutputs()
+        {
+            return (fBatchTable.size() > 0) ? fDSP->getNumOutputs() / fBatchTable[0]->getNumLanes() : fDSP->getNumOutputs();
         }
 
         // DSP API
@@ -716,17 +1309,59 @@ class mydsp_poly : public dsp_voice_group, public dsp_poly {
 
         virtual mydsp_poly* clone()
         {
-            return new mydsp_poly(fDSP->clone(), int(fVoiceTable.size()), fVoiceControl, fGroupControl);
+            mydsp_poly* poly = new mydsp_poly(fDSP->clone(), int(fVoiceTable.size()), fVoiceControl, fGroupControl);
+        #ifdef POLY_THREADS
+            poly->setNumThreads(getNumThreads());
+        #endif
+            return poly;
+        }
+    
+    #ifdef POLY_THREADS
+        /**
+         * Compute the voices with several threads (the audio thread and 'num_threads - 1' workers).
+         * Not to be called while 'compute' is running. Voices packed in a batch_dsp are always computed by the audio thread.
+         *
+         * @param num_threads - the number of threads, 1 to go back to the sequential mode
+         */
+        void setNumThreads(int num_threads)
+        {
+            delete fPool;
+            fPool = nullptr;
+            deleteVoiceBuffers();
+            if (num_threads > 1) {
+                for (size_t i = 0; i < fVoiceTable.size(); i++) {
+                    FAUSTFLOAT** buffer = new FAUSTFLOAT*[getNumOutputs()];
+                    for (int chan = 0; chan < getNumOutputs(); chan++) {
+                        buffer[chan] = new FAUSTFLOAT[MIX_BUFFER_SIZE];
+                    }
+                    fVoiceBuffer.push_back(buffer);
+                }
+                fActiveVoices.reserve(fVoiceTable.size());
+                fPool = new dsp_voice_pool(num_threads, [this](int job) { computeVoice(job); });
+            }
         }
+        
+        int getNumThreads() { return (fPool) ? fPool->getNumThreads() : 1; }
+    #endif
 
         void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
         {
             assert(count <= MIX_BUFFER_SIZE);
+            
+        #ifdef POLY_THREADS
+            if (fPool && fBatchTable.size() == 0) {
+                computeParallel(count, inputs, outputs);
+                return;
+            }
+        #endif
 
             // First clear the intermediate fOutBuffer
             clear(count, fOutBuffer);
 
-            if (fVoiceControl) {
+            if (fBatchTable.size() > 0) {
+                // Voices are computed by batches
+                computeBatches(count, inputs, fOutBuffer);
+            } else if (fVoiceControl) {
                 // Mix all playing voices
                 for (size_t i = 0; i < fVoiceTable.size(); i++) {
                     dsp_voice* voice = fVoiceTable[i];
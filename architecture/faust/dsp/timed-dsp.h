@@ -26,13 +26,17 @@
 #define __timed_dsp__
 
 #include <set>
+#include <map>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <functional>
 #include <float.h>
 #include <assert.h>
 
 #include "faust/dsp/dsp.h" 
 #include "faust/gui/GUI.h" 
 #include "faust/gui/DecoratorUI.h"
-#include "faust/gui/ring-buffer.h"
 
 namespace {
     
@@ -72,20 +76,26 @@ inline double GetCurrentTimeInUsec(void)
 }
 
 /**
- * ZoneUI : this class collect zones in a set.
+ * ZoneUI : this class collect zones in a set, only the timed ones (in GUI::getTimedZoneQueueMap()) by default.
  */
 
 struct ZoneUI : public GenericUI
 {
     
     std::set<FAUSTFLOAT*> fZoneSet;
+    bool fAllZones;
     
-    ZoneUI():GenericUI() {}
+    ZoneUI(bool all_zones = false):GenericUI(), fAllZones(all_zones) {}
     virtual ~ZoneUI() {}
     
     void insertZone(FAUSTFLOAT* zone) 
     { 
-        if (GUI::gTimedZoneMap.find(zone) != GUI::gTimedZoneMap.end()) {
+        if (fAllZones) {
+            fZoneSet.insert(zone);
+            return;
+        }
+        TimedZoneLock lock(GUI::getTimedZoneLock());
+        if (GUI::getTimedZoneQueueMap().count(zone) > 0) {
             fZoneSet.insert(zone);
         } 
     }
@@ -128,17 +138,39 @@ struct ZoneUI : public GenericUI
  * Timed signal processor that allows to handle the decorated DSP by 'slices'
  * that is, calling the 'compute' method several times and changing control
  * parameters between slices.
+ *
+ * Timed zones write their index in 'fQueue' when they receive a value, so that only the zones
+ * with values are merged in date order using a heap: slicing costs O(values * log(zones)) and
+ * nothing when no value is received. The zone values are kept in TimedZoneQueue objects owned by
+ * the timed_dsp, so that the audio thread neither reads the global maps nor values of deleted UIs.
+ *
+ * 'fZones', 'fQueue' and the heap are sized once for all the DSP zones in the constructor, and
+ * buildUserInterface only publishes the queues of the newly timed zones: it can be called while
+ * the audio thread is computing (like when a MIDI or OSC UI is added later on).
  */
 
 class timed_dsp : public decorator_dsp {
 
     protected:
+    
+        struct TimedZone {
+            FAUSTFLOAT* fZone;
+            std::atomic<TimedZoneQueue*> fQueue;    // The zone values, nullptr if the zone is not timed
+            bool fQueued;                           // Whether the zone is in the heap
+        };
+        
+        typedef std::pair<double, int> DatedZone;   // Date of the next value, zone index
         
         double fDateUsec;       // Compute call date in usec
         double fOffsetUsec;     // Compute call offset in usec
         bool fFirstCallback;
         ZoneUI fZoneUI;
     
+        std::vector<TimedZone> fZones;
+        std::map<FAUSTFLOAT*, int> fZoneIndex;
+        std::vector<DatedZone> fHeap;
+        TimedQueue<int>* fQueue;
+    
         FAUSTFLOAT** fInputsSlice;
         FAUSTFLOAT** fOutputsSlice;
     
@@ -159,39 +191,49 @@ class timed_dsp : public decorator_dsp {
         {
             return std::max<double>(0., (double(getSampleRate()) * (usec - fDateUsec)) / 1000000.);
         }
-        
-        ztimedmap::iterator getNextControl(DatedControl& res)
+    
+        // Add the zone to the heap if it has a value
+        void pushZone(int index)
         {
-            DatedControl date1(DBL_MAX, 0);
-            ztimedmap::iterator it1, it2 = GUI::gTimedZoneMap.end();
-            std::set<FAUSTFLOAT*>::iterator it3;
-              
-            // Find date of next audio slice to compute
-            for (it3 = fZoneUI.fZoneSet.begin(); it3 != fZoneUI.fZoneSet.end(); it3++) {
-                // If value list is not empty, get the date and keep the minimal one
-                it1 = GUI::gTimedZoneMap.find(*it3);
-                if (it1 != GUI::gTimedZoneMap.end()) { // Check if zone still in global GUI::gTimedZoneMap (since MidiUI may have been desallocated)
-                    DatedControl date2;
-                    if (ringbuffer_peek((*it1).second, (char*)&date2, sizeof(DatedControl)) == sizeof(DatedControl) 
-                        && date2.fDate < date1.fDate) {
-                        it2 = it1;
-                        date1 = date2;
-                    }
+            DatedControl control;
+            if (fZones[index].fQueue.load(std::memory_order_acquire)->fValues.peek(control)) {
+                fZones[index].fQueued = true;
+                fHeap.push_back(DatedZone(control.fDate, index));
+                std::push_heap(fHeap.begin(), fHeap.end(), std::greater<DatedZone>());
+            }
+        }
+    
+        // Add the zones which received values since the last call to the heap
+        void readQueue()
+        {
+            int index;
+            while (fQueue->pop(index)) {
+                // Cleared before reading the values, so that a value written in the meantime notifies again
+                fZones[index].fQueue.load(std::memory_order_acquire)->fNotified.exchange(false);
+                if (!fZones[index].fQueued) {
+                    pushZone(index);
                 }
             }
-            
-            res = date1;
-            return it2;
         }
         
         virtual void computeAux(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs, bool convert_ts)
         {
             int slice, offset = 0;
-            ztimedmap::iterator it;
-            DatedControl next_control;
+            
+            readQueue();
              
             // Do audio computation "slice" by "slice"
-            while ((it = getNextControl(next_control)) != GUI::gTimedZoneMap.end()) {
+            while (fHeap.size() > 0) {
+                
+                // Get the zone with the next value
+                std::pop_heap(fHeap.begin(), fHeap.end(), std::greater<DatedZone>());
+                int index = fHeap.back().second;
+                TimedZone& zone = fZones[index];
+                fHeap.pop_back();
+                zone.fQueued = false;
+                
+                DatedControl next_control;
+                zone.fQueue.load(std::memory_order_acquire)->fValues.pop(next_control);
                 
                 // If needed, convert next_control in samples from begining of the buffer, possible moving to 0 (if negative)
                 if (convert_ts) {
@@ -204,11 +246,10 @@ class timed_dsp : public decorator_dsp {
                 offset += slice;
                
                 // Update control
-                ringbuffer_t* control_values = (*it).second;
-                *((*it).first) = next_control.fValue;
+                *zone.fZone = next_control.fValue;
                 
-                // Move ringbuffer pointer
-                ringbuffer_read_advance(control_values, sizeof(DatedControl));
+                // Keep the zone in the heap if it has other values
+                pushZone(index);
             } 
             
             // Compute last audio slice
@@ -222,9 +263,36 @@ class timed_dsp : public decorator_dsp {
         {
             fInputsSlice = new FAUSTFLOAT*[dsp->getNumInputs()];
             fOutputsSlice = new FAUSTFLOAT*[dsp->getNumOutputs()];
+            // Any zone of the DSP can be timed later on: size everything for all of them
+            ZoneUI all_zones(true);
+            fDSP->buildUserInterface(&all_zones);
+            fZones = std::vector<TimedZone>(all_zones.fZoneSet.size());
+            int index = 0;
+            for (auto& it : all_zones.fZoneSet) {
+                fZones[index].fZone = it;
+                fZones[index].fQueue = nullptr;
+                fZones[index].fQueued = false;
+                fZoneIndex[it] = index++;
+            }
+            fQueue = new TimedQueue<int>(std::max<size_t>(1, fZones.size()));
+            fHeap.reserve(fZones.size());
         }
         virtual ~timed_dsp() 
         {
+            // Unregister the zones, that UIs can then no longer write
+            {
+                TimedZoneLock lock(GUI::getTimedZoneLock());
+                for (auto& it : fZones) {
+                    if (it.fQueue.load()) {
+                        GUI::getTimedZoneQueueMap()[it.fZone]->setQueue(nullptr);
+                        GUI::releaseTimedZoneSlot(it.fZone);
+                    }
+                }
+            }
+            for (auto& it : fZones) {
+                delete it.fQueue.load();
+            }
+            delete fQueue;
             delete [] fInputsSlice;
             delete [] fOutputsSlice;
         }
@@ -237,8 +305,24 @@ class timed_dsp : public decorator_dsp {
         virtual void buildUserInterface(UI* ui_interface)   
         { 
             fDSP->buildUserInterface(ui_interface); 
-            // Only keep zones that are in GUI::gTimedZoneMap
+            // Only keep zones that are in GUI::getTimedZoneQueueMap()
             fDSP->buildUserInterface(&fZoneUI);
+            // Publish the queues of the zones not yet registered (nothing is resized, see the class comment)
+            TimedZoneLock lock(GUI::getTimedZoneLock());
+            for (auto& it : fZoneUI.fZoneSet) {
+                std::map<FAUSTFLOAT*, int>::iterator index = fZoneIndex.find(it);
+                if (index == fZoneIndex.end() || fZones[(*index).second].fQueue.load()) continue;
+                TimedZoneSlot* slot = GUI::acquireTimedZoneSlot(it);
+                if (slot->fQueue.load()) {
+                    // Already used by another timed_dsp
+                    GUI::releaseTimedZoneSlot(it);
+                    continue;
+                }
+                TimedZoneQueue* queue = new TimedZoneQueue(fQueue, (*index).second);
+                // Published to the audio thread before any UI can write the zone index in 'fQueue'
+                fZones[(*index).second].fQueue.store(queue, std::memory_order_release);
+                slot->setQueue(queue);
+            }
         }
     
         virtual timed_dsp* clone()
@@ -0,0 +1,604 @@
+/************************** BEGIN vecmath.h **************************/
+/************************************************************************
+ FAUST Architecture File
+ Copyright (C) 2026 GRAME, Centre National de Creation Musicale
+ ---------------------------------------------------------------------
+ This Architecture section is free software; you can redistribute it
+ and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 3 of
+ the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+ EXCEPTION : As a special exception, you may create a larger work
+ that contains this FAUST architecture section and distribute
+ that work under terms of your choice, so long as this FAUST
+ architecture section is not modified.
+
+ Polynomial and rational approximations taken from the Cephes library:
+ http://www.netlib.org/cephes/
+ ************************************************************************/
+
+#ifndef __vecmath__
+#define __vecmath__
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ Array versions of the math functions, called once per vector by the code generated with the -vm option:
+
+    vec_expf(count, x, r) computes r[i] = expf(x[i]) for i in [0, count[
+    vec_powf(count, x, y, r) computes r[i] = powf(x[i], y[i]) for i in [0, count[
+
+ The per-sample functions are branch-free so that the loops are vectorized by the C/C++ compiler (SSE, AVX, NEON...).
+ On x86-64 Linux with GCC, versions for AVX-512, AVX2 and the default target are compiled and selected at load time
+ (define VECMATH_NO_DISPATCH to only use the target given on the command line).
+
+ Accuracy contract, maximum error in ulp (units in the last place) of the result, as measured against libm:
+
+    function        float           double              domain
+    exp, exp2       1               2                   the result can be denormal, overflows to inf
+    exp10           2               2
+    log             1               1                   x < 0 gives NaN, x = 0 gives -inf
+    log2, log10     2               2
+    sin, cos        2               2                   |x| < 1e8 (the result is only in [-1, 1] above)
+    tan             3               3                   |x| < 1e8
+    tanh            2               2
+    pow             1               2 + |y*log2(x)|/512 x < 0 gives NaN unless y is an integer, pow(x, 0) and pow(1, y) are 1
+
+ NaN inputs give NaN (except for pow). The accuracy is only guaranteed if the range reductions are not
+ reassociated by the C/C++ compiler (so without -ffast-math or -fassociative-math).
+*/
+
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) && !defined(VECMATH_NO_DISPATCH)
+#define VECMATH_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define VECMATH_DISPATCH
+#endif
+
+#if defined(__clang__)
+#define VECMATH_LOOP _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__)
+#define VECMATH_LOOP _Pragma("GCC ivdep")
+#else
+#define VECMATH_LOOP
+#endif
+
+// Bits manipulation
+
+static inline float vm_int_as_float(int32_t i) { float f; memcpy(&f, &i, sizeof(float)); return f; }
+static inline int32_t vm_float_as_int(float f) { int32_t i; memcpy(&i, &f, sizeof(float)); return i; }
+static inline double vm_int_as_double(int64_t i) { double d; memcpy(&d, &i, sizeof(double)); return d; }
+static inline int64_t vm_double_as_int(double d) { int64_t i; memcpy(&i, &d, sizeof(double)); return i; }
+
+/*
+ Selections are done on the bits so that both values are always computed: the C/C++ compiler
+ does not have to speculate floating point operations to remove the branches (which it refuses
+ to do with the default -ftrapping-math).
+*/
+static inline float vm_selectf(int c, float a, float b)
+{
+    int32_t m = -(int32_t)(c != 0);
+    return vm_int_as_float((vm_float_as_int(a) & m) | (vm_float_as_int(b) & ~m));
+}
+static inline double vm_select(int c, double a, double b)
+{
+    int64_t m = -(int64_t)(c != 0);
+    return vm_int_as_double((vm_double_as_int(a) & m) | (vm_double_as_int(b) & ~m));
+}
+
+// Absolute value and sign change of x if c is true
+static inline float vm_fabsf(float x) { return vm_int_as_float(vm_float_as_int(x) & 0x7fffffff); }
+static inline double vm_fabs(double x) { return vm_int_as_double(vm_double_as_int(x) & 0x7fffffffffffffffLL); }
+static inline float vm_negf(int c, float x) { return vm_int_as_float((int32_t)((uint32_t)vm_float_as_int(x) ^ ((uint32_t)(c != 0) << 31))); }
+static inline double vm_neg(int c, double x) { return vm_int_as_double((int64_t)((uint64_t)vm_double_as_int(x) ^ ((uint64_t)(c != 0) << 63))); }
+
+// NaN and infinity tests
+static inline int vm_isnanf(float x) { return (vm_float_as_int(x) & 0x7fffffff) > 0x7f800000; }
+static inline int vm_isnan(double x) { return x != x; }
+static inline int vm_isfinitef(float x) { return (vm_float_as_int(x) & 0x7fffffff) < 0x7f800000; }
+static inline int vm_isfinite(double x) { return vm_fabs(x) < HUGE_VAL; }
+
+// 2^n for n in [-126, 127]
+static inline float vm_pow2f(int n) { return vm_int_as_float((int32_t)(n + 127) << 23); }
+
+// 2^n for n in [-1022, 1023]
+static inline double vm_pow2(int n) { return vm_int_as_double((int64_t)(n + 1023) << 52); }
+
+// Round to the nearest integer, for |x| < 2^31
+static inline int vm_roundf(float x) { return (int)(x + vm_int_as_float(0x3f000000 | (vm_float_as_int(x) & 0x80000000))); }
+static inline int vm_round(double x) { return (int)(x + vm_int_as_double(0x3fe0000000000000LL | (vm_double_as_int(x) & (int64_t)0x8000000000000000ULL))); }
+
+// x clamped in [lo, hi], NaN giving lo
+static inline float vm_clampf(float x, float lo, float hi) { return vm_selectf(x > lo, vm_selectf(x < hi, x, hi), lo); }
+static inline double vm_clamp(double x, double lo, double hi) { return vm_select(x > lo, vm_select(x < hi, x, hi), lo); }
+
+/*
+ Exponentials: x = n*log(2) + r, exp(x) = 2^n * exp(r) with |r| <= log(2)/2.
+ 2^n is applied in two steps so that denormal results and overflows are correctly rounded.
+*/
+
+static inline float vm_expf_core(float r, int n)
+{
+    float p = 1.9875691500E-4f;
+    p = p * r + 1.3981999507E-3f;
+    p = p * r + 8.3334519073E-3f;
+    p = p * r + 4.1665795894E-2f;
+    p = p * r + 1.6666665459E-1f;
+    p = p * r + 5.0000001201E-1f;
+    p = p * (r * r) + r + 1.0f;
+    int n1 = n / 2;
+    return (p * vm_pow2f(n1)) * vm_pow2f(n - n1);
+}
+
+static inline float vm_expf(float x)
+{
+    float xc = vm_clampf(x, -104.0f, 89.0f);
+    int n = vm_roundf(xc * 1.44269504088896341f);
+    float fn = (float)n;
+    float r = (xc - fn * 0.693359375f) - fn * -2.12194440e-4f;
+    float res = vm_expf_core(r, n);
+    return vm_selectf(vm_isnanf(x), x, res);
+}
+
+static inline float vm_exp2f(float x)
+{
+    float xc = vm_clampf(x, -151.0f, 129.0f);
+    int n = vm_roundf(xc);
+    float res = vm_expf_core((xc - (float)n) * 0.693147180559945309f, n);
+    return vm_selectf(vm_isnanf(x), x, res);
+}
+
+static inline float vm_exp10f(float x)
+{
+    float xc = vm_clampf(x, -46.0f, 39.0f);
+    int n = vm_roundf(xc * 3.32192809488736234787f);
+    float fn = (float)n;
+    float r = ((xc - fn * 0.30078125f) - fn * 2.48745663981195213739E-4f) * 2.30258509299404568402f;
+    float res = vm_expf_core(r, n);
+    return vm_selectf(vm_isnanf(x), x, res);
+}
+
+static inline double vm_exp_core(double r, int n)
+{
+    double rr = r * r;
+    double px = r * ((1.26177193074810590878E-4 * rr + 3.02994407707441961300E-2) * rr + 9.99999999999999999910E-1);
+    double qx = ((3.00198505138664455042E-6 * rr + 2.52448340349684104192E-3) * rr + 2.27265548208155028766E-1) * rr
+        + 2.00000000000000000009E0;
+    double p = 1.0 + 2.0 * (px / (qx - px));
+    int n1 = n / 2;
+    return (p * vm_pow2(n1)) * vm_pow2(n - n1);
+}
+
+static inline double vm_exp(double x)
+{
+    double xc = vm_clamp(x, -746.0, 710.0);
+    int n = vm_round(xc * 1.4426950408889634073599);
+    double fn = (double)n;
+    double r = (xc - fn * 6.93145751953125E-1) - fn * 1.42860682030941723212E-6;
+    double res = vm_exp_core(r, n);
+    return vm_select(vm_isnan(x), x, res);
+}
+
+static inline double vm_exp2(double x)
+{
+    double xc = vm_clamp(x, -1076.0, 1025.0);
+    int n = vm_round(xc);
+    double res = vm_exp_core((xc - (double)n) * 6.9314718055994530942E-1, n);
+    return vm_select(vm_isnan(x), x, res);
+}
+
+static inline double vm_exp10(double x)
+{
+    double xc = vm_clamp(x, -325.0, 309.0);
+    int n = vm_round(xc * 3.32192809488736234787);
+    double fn = (double)n;
+    double r = ((xc - fn * 3.01025390625000000000E-1) - fn * 4.60503898119521373889E-6) * 2.30258509299404568402;
+    double res = vm_exp_core(r, n);
+    return vm_select(vm_isnan(x), x, res);
+}
+
+/*
+ Logarithms: x = 2^e * (1 + f) with 1 + f in [sqrt(1/2), sqrt(2)[, log(x) = e*log(2) + log(1 + f).
+*/
+
+static inline float vm_splitf(float x, float* e)
+{
+    int denormal = x < 1.17549435e-38f;
+    int32_t bits = vm_float_as_int(vm_selectf(denormal, x * 8388608.0f, x));
+    int ex = ((bits >> 23) & 0xff) - 126;
+    float m = vm_int_as_float((bits & 0x007fffff) | 0x3f000000);
+    int small = m < 0.707106781186547524f;
+    *e = (float)(ex - small - (denormal ? 23 : 0));
+    return vm_selectf(small, m + m, m) - 1.0f;
+}
+
+// log(1 + f) - f
+static inline float vm_log1pf_core(float f)
+{
+    float z = f * f;
+    float y = 7.0376836292E-2f;
+    y = y * f - 1.1514610310E-1f;
+    y = y * f + 1.1676998740E-1f;
+    y = y * f - 1.2420140846E-1f;
+    y = y * f + 1.4249322787E-1f;
+    y = y * f - 1.6668057665E-1f;
+    y = y * f + 2.0000714765E-1f;
+    y = y * f - 2.4999993993E-1f;
+    y = y * f + 3.3333331174E-1f;
+    return y * f * z - 0.5f * z;
+}
+
+static inline float vm_log_specialf(float x, float res)
+{
+    res = vm_selectf(x == 0.0f, -HUGE_VALF, res);
+    res = vm_selectf(x == HUGE_VALF, x, res);
+    res = vm_selectf(x < 0.0f, NAN, res);
+    return vm_selectf(vm_isnanf(x), x, res);
+}
+
+static inline float vm_logf(float x)
+{
+    float e;
+    float f = vm_splitf(x, &e);
+    float res = (f + (vm_log1pf_core(f) + e * -2.12194440e-4f)) + e * 0.693359375f;
+    return vm_log_specialf(x, res);
+}
+
+static inline float vm_log2f(float x)
+{
+    float e;
+    float f = vm_splitf(x, &e);
+    float y = vm_log1pf_core(f);
+    float res = ((y * 0.44269504088896340736f + f * 0.44269504088896340736f) + y + f) + e;
+    return vm_log_specialf(x, res);
+}
+
+static inline float vm_log10f(float x)
+{
+    float e;
+    float f = vm_splitf(x, &e);
+    float l = f + vm_log1pf_core(f);
+    float res = (l * 0.434294481903251827651f + e * 2.48745663981195213739E-4f) + e * 0.30078125f;
+    return vm_log_specialf(x, res);
+}
+
+static inline double vm_split(double x, double* e)
+{
+    int denormal = x < 2.2250738585072014e-308;
+    int64_t bits = vm_double_as_int(vm_select(denormal, x * 4503599627370496.0, x));
+    int ex = (int)((bits >> 52) & 0x7ff) - 1022;
+    double m = vm_int_as_double((bits & 0x000fffffffffffffLL) | 0x3fe0000000000000LL);
+    int small = m < 0.70710678118654752440;
+    *e = (double)(ex - small - (denormal ? 52 : 0));
+    return vm_select(small, m + m, m) - 1.0;
+}
+
+// log(1 + f) - f
+static inline double vm_log1p_core(double f)
+{
+    double z = f * f;
+    double p = ((((1.01875663804580931796E-4 * f + 4.97494994976747001425E-1) * f + 4.70579119878881725854E0) * f
+        + 1.44989225341610930846E1) * f + 1.79368678507819816313E1) * f + 7.70838733755885391666E0;
+    double q = ((((f + 1.12873587189167450590E1) * f + 4.52279145837532221105E1) * f + 8.29875266912776603211E1) * f
+        + 7.11544750618563894466E1) * f + 2.31251620126765340583E1;
+    return f * (z * p / q) - 0.5 * z;
+}
+
+static inline double vm_log_special(double x, double res)
+{
+    res = vm_select(x == 0.0, -HUGE_VAL, res);
+    res = vm_select(x == HUGE_VAL, x, res);
+    res = vm_select(x < 0.0, NAN, res);
+    return vm_select(vm_isnan(x), x, res);
+}
+
+static inline double vm_log(double x)
+{
+    double e;
+    double f = vm_split(x, &e);
+    double res = (f + (vm_log1p_core(f) + e * -2.121944400546905827679e-4)) + e * 0.693359375;
+    return vm_log_special(x, res);
+}
+
+static inline double vm_log2(double x)
+{
+    double e;
+    double f = vm_split(x, &e);
+    double y = vm_log1p_core(f);
+    double res = ((y * 0.44269504088896340735992 + f * 0.44269504088896340735992) + y + f) + e;
+    return vm_log_special(x, res);
+}
+
+static inline double vm_log10(double x)
+{
+    double e;
+    double f = vm_split(x, &e);
+    double y = vm_log1p_core(f);
+    double res = ((y * 4.3429448190325182765e-1 + f * 4.3429448190325182765e-1) + e * 4.60503898119521373889E-6)
+        + e * 3.01025390625000000000E-1;
+    return vm_log_special(x, res);
+}
+
+/*
+ Trigonometric functions: |x| = j*pi/4 + z with j even and |z| <= pi/4. The reduction is done
+ in double precision for the float versions too.
+*/
+
+static inline double vm_reduce(double ax, int* j)
+{
+    int jj = (int)(vm_clamp(ax, 0.0, 1e9) * 1.27323954473516268615);
+    jj = (jj + 1) & ~1;
+    double y = (double)jj;
+    *j = jj;
+    return ((ax - y * 7.85398125648498535156E-1) - y * 3.77489470793079817668E-8) - y * 2.69515142907905952645E-15;
+}
+
+static inline float vm_sinf_core(float z, float zz)
+{
+    return ((-1.9515295891E-4f * zz + 8.3321608736E-3f) * zz - 1.6666654611E-1f) * zz * z + z;
+}
+
+static inline float vm_cosf_core(float zz)
+{
+    return ((2.443315711809948E-005f * zz - 1.388731625493765E-003f) * zz + 4.166664568298827E-002f) * zz * zz
+        - 0.5f * zz + 1.0f;
+}
+
+static inline float vm_sinf(float x)
+{
+    int j;
+    float z = (float)vm_reduce(vm_fabsf(x), &j);
+    float zz = z * z;
+    float res = vm_selectf(j & 2, vm_cosf_core(zz), vm_sinf_core(z, zz));
+    res = vm_negf(((j & 4) != 0) != (x < 0.0f), res);
+    return vm_selectf(vm_isfinitef(x), res, NAN);
+}
+
+static inline float vm_cosf(float x)
+{
+    int j;
+    float z = (float)vm_reduce(vm_fabsf(x), &j);
+    float zz = z * z;
+    float res = vm_selectf(j & 2, vm_sinf_core(z, zz), vm_cosf_core(zz));
+    res = vm_negf((j + 2) & 4, res);
+    return vm_selectf(vm_isfinitef(x), res, NAN);
+}
+
+static inline float vm_tanf(float x)
+{
+    int j;
+    float z = (float)vm_reduce(vm_fabsf(x), &j);
+    float zz = z * z;
+    float res = (((((9.38540185543E-3f * zz + 3.11992232697E-3f) * zz + 2.44301354525E-2f) * zz + 5.34112807005E-2f) * zz
+        + 1.33387994085E-1f) * zz + 3.33331568548E-1f) * zz * z + z;
+    res = vm_selectf(j & 2, -1.0f / res, res);
+    res = vm_negf(x < 0.0f, res);
+    return vm_selectf(vm_isfinitef(x), res, NAN);
+}
+
+static inline double vm_sin_core(double z, double zz)
+{
+    return z + z * zz * (((((1.58962301576546568060E-10 * zz - 2.50507477628578072866E-8) * zz
+        + 2.75573136213857245213E-6) * zz - 1.98412698295895385996E-4) * zz + 8.33333333332211858878E-3) * zz
+        - 1.66666666666666307295E-1);
+}
+
+static inline double vm_cos_core(double zz)
+{
+    return 1.0 - 0.5 * zz + zz * zz * (((((-1.13585365213876817300E-11 * zz + 2.08757008419747316778E-9) * zz
+        - 2.75573141792967388112E-7) * zz + 2.48015872888517045348E-5) * zz - 1.38888888888730564116E-3) * zz
+        + 4.16666666666665929218E-2);
+}
+
+static inline double vm_sin(double x)
+{
+    int j;
+    double z = vm_reduce(vm_fabs(x), &j);
+    double zz = z * z;
+    double res = vm_select(j & 2, vm_cos_core(zz), vm_sin_core(z, zz));
+    res = vm_neg(((j & 4) != 0) != (x < 0.0), res);
+    return vm_select(vm_isfinite(x), res, NAN);
+}
+
+static inline double vm_cos(double x)
+{
+    int j;
+    double z = vm_reduce(vm_fabs(x), &j);
+    double zz = z * z;
+    double res = vm_select(j & 2, vm_sin_core(z, zz), vm_cos_core(zz));
+    res = vm_neg((j + 2) & 4, res);
+    return vm_select(vm_isfinite(x), res, NAN);
+}
+
+static inline double vm_tan(double x)
+{
+    int j;
+    double z = vm_reduce(vm_fabs(x), &j);
+    double zz = z * z;
+    double p = (-1.30936939181383777646E4 * zz + 1.15351664838587416140E6) * zz - 1.79565251976484877988E7;
+    double q = (((zz + 1.36812963470692954678E4) * zz - 1.32089234440210967447E6) * zz + 2.50083801823357915839E7) * zz
+        - 5.38695755929454629881E7;
+    double res = z + z * (zz * p / q);
+    res = vm_select(j & 2, -1.0 / res, res);
+    res = vm_neg(x < 0.0, res);
+    return vm_select(vm_isfinite(x), res, NAN);
+}
+
+static inline float vm_tanhf(float x)
+{
+    float ax = vm_fabsf(x);
+    float big = vm_negf(x < 0.0f, 1.0f - 2.0f / (vm_expf(ax + ax) + 1.0f));
+    float z = x * x;
+    float small = ((((-5.70498872745E-3f * z + 2.06390887954E-2f) * z - 5.37397155531E-2f) * z + 1.33314422036E-1f) * z
+        - 3.33332819422E-1f) * z * x + x;
+    return vm_selectf(ax >= 0.625f, big, small);
+}
+
+static inline double vm_tanh(double x)
+{
+    double ax = vm_fabs(x);
+    double big = vm_neg(x < 0.0, 1.0 - 2.0 / (vm_exp(ax + ax) + 1.0));
+    double z = x * x;
+    double p = (-9.64399179425052238628E-1 * z - 9.92877231001918586564E1) * z - 1.61468768441708447952E3;
+    double q = ((z + 1.12811678491632931402E2) * z + 2.23548839060100448583E3) * z + 4.84406305325125486048E3;
+    double small = x + x * z * p / q;
+    return vm_select(ax >= 0.625, big, small);
+}
+
+/*
+ Power: pow(x, y) = exp(y*log(|x|)). The float version is computed in double precision. Since the absolute error
+ of y*log(|x|) is the relative error of the result, the double version computes log(|x|) and its product by y in
+ double-double precision (hi + lo), the lo part being added to the reduced argument of exp.
+*/
+
+static inline double vm_pow_sign(double x, double y, double res)
+{
+    // Negative x: the sign depends on the parity of y, NaN if y is not an integer (|y| >= 2^30 is taken as even)
+    double yc = vm_clamp(y, -1073741824.0, 1073741824.0);
+    int integer = (vm_fabs(y) >= 1073741824.0) | ((double)(int)yc == y);
+    double h = yc * 0.5;
+    int odd = (double)(int)h != h;
+    res = vm_select(x < 0.0, vm_select(integer, vm_neg(odd, res), NAN), res);
+    return vm_select((y == 0.0) | (x == 1.0), 1.0, res);
+}
+
+static inline float vm_powf(float x, float y)
+{
+    return (float)vm_pow_sign(x, y, vm_exp((double)y * vm_log(vm_fabs(x))));
+}
+
+// a*b = hi + lo with an error below 2^-100*|a*b| (Dekker's product, fma not being vectorized on all targets), for
+// |a*b| < 2^1000. The operands are split by masking their low bits, so that contracted multiply-adds give the same result.
+static inline double vm_two_prod(double a, double b, double* lo)
+{
+    double ah = vm_int_as_double(vm_double_as_int(a) & (int64_t)0xfffffffff8000000ULL);
+    double al = a - ah;
+    double bh = vm_int_as_double(vm_double_as_int(b) & (int64_t)0xfffffffff8000000ULL);
+    double bl = b - bh;
+    double hi = a * b;
+    *lo = ((ah * bh - hi) + ah * bl + al * bh) + al * bl;
+    return hi;
+}
+
+// log(x) = hi + lo for finite x > 0, with log(1 + f) = 2*atanh(s), s = f/(2 + f) and |s| < 0.172
+static inline double vm_log_dd(double x, double* lo)
+{
+    double e;
+    double f = vm_split(x, &e);
+    // s = sh + sl
+    double d = 2.0 + f;
+    double dl = f - (d - 2.0);
+    double sh = f / d;
+    double pl;
+    double ph = vm_two_prod(sh, d, &pl);
+    double sl = (((f - ph) - pl) - sh * dl) / d;
+    // 2*atanh(s) - 2*s = 2/3*s^3 + s^5*P(s^2), the first term q + ql being in double-double
+    double ssl;
+    double ss = vm_two_prod(sh, sh, &ssl);
+    double cl;
+    double c = vm_two_prod(sh, ss, &cl);
+    cl += sh * ssl;
+    double ql;
+    double q = vm_two_prod(c, 6.6666666666666663E-1, &ql);
+    ql += cl * 6.6666666666666663E-1 + c * 3.7007434154172218E-17;
+    double t = 8.6956521739130432E-2;
+    t = t * ss + 9.5238095238095233E-2;
+    t = t * ss + 1.0526315789473684E-1;
+    t = t * ss + 1.1764705882352941E-1;
+    t = t * ss + 1.3333333333333333E-1;
+    t = t * ss + 1.5384615384615385E-1;
+    t = t * ss + 1.8181818181818182E-1;
+    t = t * ss + 2.2222222222222221E-1;
+    t = t * ss + 2.8571428571428570E-1;
+    t = t * ss + 4.0000000000000002E-1;
+    double tail = ((c * ss) * t + ql) + (sl + sl) * (1.0 + ss);
+    // e*log(2) + 2*s + q + tail, e*0.693359375 being exact
+    double a = e * 0.693359375;
+    double b = sh + sh;
+    double h1 = a + b;
+    double bv = h1 - a;
+    double hi = h1 + q;
+    double l = ((a - (h1 - bv)) + (b - bv)) + (q - (hi - h1)) + (tail + e * -2.121944400546905827679e-4);
+    double res = hi + l;
+    *lo = l - (res - hi);
+    return res;
+}
+
+// exp(x + lo) with |lo| <= ulp(x)
+static inline double vm_exp_dd(double x, double lo)
+{
+    double xc = vm_clamp(x, -746.0, 710.0);
+    int n = vm_round(xc * 1.4426950408889634073599);
+    double fn = (double)n;
+    double r = ((xc - fn * 6.93145751953125E-1) - fn * 1.42860682030941723212E-6) + vm_select(xc == x, lo, 0.0);
+    double res = vm_exp_core(r, n);
+    return vm_select(vm_isnan(x), x, res);
+}
+
+static inline double vm_pow(double x, double y)
+{
+    double ax = vm_fabs(x);
+    double ll;
+    double lh = vm_log_dd(ax, &ll);
+    // y*log(|x|) = th + tl, y being clamped so that the product does not overflow (y*log(|x|) is out of the exp range above)
+    double yc = vm_clamp(y, -1e250, 1e250);
+    double tl;
+    double th = vm_two_prod(yc, lh, &tl);
+    tl += yc * ll;
+    // 0, inf and NaN x or y go through the IEEE product, tl being then ignored by vm_exp_dd
+    double ls = vm_log_special(ax, lh);
+    th = vm_select(vm_isfinite(ls) & (yc == y), th, y * ls);
+    return vm_pow_sign(x, y, vm_exp_dd(th, tl));
+}
+
+// Array versions
+
+#define VECMATH_FUN1(name, fun, type)                                                 \
+VECMATH_DISPATCH static inline void name(int count, const type* x, type* r)           \
+{                                                                                     \
+    VECMATH_LOOP                                                                      \
+    for (int i = 0; i < count; i++) { r[i] = fun(x[i]); }                             \
+}
+
+#define VECMATH_FUN2(name, fun, type)                                                 \
+VECMATH_DISPATCH static inline void name(int count, const type* x, const type* y, type* r)\
+{                                                                                     \
+    VECMATH_LOOP                                                                      \
+    for (int i = 0; i < count; i++) { r[i] = fun(x[i], y[i]); }                       \
+}
+
+VECMATH_FUN1(vec_expf, vm_expf, float)
+VECMATH_FUN1(vec_exp2f, vm_exp2f, float)
+VECMATH_FUN1(vec_exp10f, vm_exp10f, float)
+VECMATH_FUN1(vec_logf, vm_logf, float)
+VECMATH_FUN1(vec_log2f, vm_log2f, float)
+VECMATH_FUN1(vec_log10f, vm_log10f, float)
+VECMATH_FUN1(vec_sinf, vm_sinf, float)
+VECMATH_FUN1(vec_cosf, vm_cosf, float)
+VECMATH_FUN1(vec_tanf, vm_tanf, float)
+VECMATH_FUN1(vec_tanhf, vm_tanhf, float)
+VECMATH_FUN2(vec_powf, vm_powf, float)
+
+VECMATH_FUN1(vec_exp, vm_exp, double)
+VECMATH_FUN1(vec_exp2, vm_exp2, double)
+VECMATH_FUN1(vec_exp10, vm_exp10, double)
+VECMATH_FUN1(vec_log, vm_log, double)
+VECMATH_FUN1(vec_log2, vm_log2, double)
+VECMATH_FUN1(vec_log10, vm_log10, double)
+VECMATH_FUN1(vec_sin, vm_sin, double)
+VECMATH_FUN1(vec_cos, vm_cos, double)
+VECMATH_FUN1(vec_tan, vm_tan, double)
+VECMATH_FUN1(vec_tanh, vm_tanh, double)
+VECMATH_FUN2(vec_pow, vm_pow, double)
+
+#endif
+/**************************  END  vecmath.h **************************/
@@ -34,6 +34,7 @@
 #include "faust/gui/meta.h"
 #include "faust/gui/UI.h"
 #include "faust/gui/PathBuilder.h"
+#include "faust/gui/PathHash.h"
 #include "faust/gui/ValueConverter.h"
 
 class APIUI : public PathBuilder, public Meta, public UI
@@ -51,6 +52,7 @@ class APIUI : public PathBuilder, public Meta, public UI
         std::vector<std::string> fLabels;
         std::map<std::string, int> fPathMap;
         std::map<std::string, int> fLabelMap;
+        PathHash fPathHash;         // perfect hash of fPathMap and fLabelMap, built when the UI is complete
         std::vector<ValueConverter*> fConversion;
         std::vector<FAUSTFLOAT*> fZone;
         std::vector<FAUSTFLOAT> fInit;
@@ -176,6 +178,24 @@ class APIUI : public PathBuilder, public Meta, public UI
             fMetaData.push_back(fCurrentMetadata);
             fCurrentMetadata.clear();
         }
+    
+        // Paths take precedence on labels
+        void buildPathHash()
+        {
+            std::vector<std::string> keys;
+            std::vector<int> values;
+            for (auto& it : fPathMap) {
+                keys.push_back(it.first);
+                values.push_back(it.second);
+            }
+            for (auto& it : fLabelMap) {
+                if (fPathMap.find(it.first) == fPathMap.end()) {
+                    keys.push_back(it.first);
+                    values.push_back(it.second);
+                }
+            }
+            fPathHash.build(keys, values);
+        }
 
         int getZoneIndex(std::vector<ZoneControl*>* table, int p, int val)
         {
@@ -264,7 +284,12 @@ class APIUI : public PathBuilder, public Meta, public UI
         virtual void openTabBox(const char* label) { pushLabel(label); }
         virtual void openHorizontalBox(const char* label) { pushLabel(label); }
         virtual void openVerticalBox(const char* label) { pushLabel(label); }
-        virtual void closeBox() { popLabel(); }
+        virtual void closeBox()
+        {
+            popLabel();
+            // The UI is complete: hash its paths and labels
+            if (fControlsLevel.empty()) buildPathHash();
+        }
 
         // -- active widgets
 
@@ -344,15 +369,10 @@ class APIUI : public PathBuilder, public Meta, public UI
 		// Simple API part
 		//-------------------------------------------------------------------------------
 		int getParamsCount() { return fNumParameters; }
-        int getParamIndex(const char* path)
+        // Only reads the hash built by closeBox, so can be called on any thread (returns -1 before the UI is built)
+        int getParamIndex(const char* path) const
         {
-            if (fPathMap.find(path) != fPathMap.end()) {
-                return fPathMap[path];
-            } else if (fLabelMap.find(path) != fLabelMap.end()) {
-                return fLabelMap[path];
-            } else {
-                return -1;
-            }
+            return fPathHash.find(path);
         }
         const char* getParamAddress(int p) { return fPaths[p].c_str(); }
         const char* getParamLabel(int p) { return fLabels[p].c_str(); }
@@ -385,6 +405,43 @@ class APIUI : public PathBuilder, public Meta, public UI
         double value2ratio(int p, double r)	{ return fConversion[p]->faust2ui(r); }
         double ratio2value(int p, double r)	{ return fConversion[p]->ui2faust(r); }
     
+        /**
+         * Set several parameters at once, with indexes resolved once with getParamIndex.
+         *
+         * @param p - the UI parameter indexes
+         * @param v - the values
+         * @param count - the number of parameters
+         *
+         */
+        void setParamValues(const int* p, const FAUSTFLOAT* v, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                *fZone[p[i]] = v[i];
+            }
+        }
+    
+        void getParamValues(const int* p, FAUSTFLOAT* v, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                v[i] = *fZone[p[i]];
+            }
+        }
+    
+        /**
+         * Set several parameters at once from ratios in [0..1], converted with their scale.
+         *
+         * @param p - the UI parameter indexes
+         * @param r - the ratios
+         * @param count - the number of parameters
+         *
+         */
+        void setParamRatios(const int* p, const double* r, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                *fZone[p[i]] = fConversion[p[i]]->ui2faust(r[i]);
+            }
+        }
+    
         /**
          * Return the control type (kAcc, kGyr, or -1) for a given parameter
          *
@@ -1241,6 +1241,7 @@ void GTKUI::addVerticalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT
     }
     
     checkForTooltip(zone, pb);
+    setZonePolled(zone, true);
 }
 
 void GTKUI::addHorizontalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT lo, FAUSTFLOAT hi)
@@ -1260,6 +1261,7 @@ void GTKUI::addHorizontalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOA
     }
     
     checkForTooltip(zone, pb);
+    setZonePolled(zone, true);
 }
 
 // ------------------------------ Num Display -----------------------------------
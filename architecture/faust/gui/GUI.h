@@ -28,6 +28,9 @@
 #include <list>
 #include <map>
 #include <vector>
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
@@ -40,12 +43,17 @@
 #include "faust/gui/UI.h"
 #include "faust/gui/ValueConverter.h"
 #include "faust/gui/MetaDataUI.h"
-#include "faust/gui/ring-buffer.h"
 
 /*******************************************************************************
  * GUI : Abstract Graphic User Interface
  * Provides additional mechanisms to synchronize widgets and zones. Widgets
  * should both reflect the value of a zone and allow to change this value.
+ * Zones changed with modifyZone (or signaled with GUI::notifyZone) are written
+ * in a process-wide lock-free log, that each GUI reads in its own thread. The
+ * zones written without notification (like bargraphs written by the DSP) are
+ * found by sweeping a bounded number of zones at each update, and are then
+ * polled at each update, so that updateAllGuis only reflects the zones that
+ * have changed.
  ******************************************************************************/
 
 class uiItem;
@@ -78,6 +86,14 @@ static void deleteClist(clist* cl);
 struct clist : public std::list<uiItemBase*>
 {
     
+    FAUSTFLOAT* fZone;
+    FAUSTFLOAT fLast;               // Last reflected value
+    bool fPolled;                   // Zone compared with fLast at each update
+    bool fSwept;                    // Zone compared with fLast in turn, and polled once found changed
+    
+    clist(FAUSTFLOAT* zone):fZone(zone), fLast(*zone), fPolled(false), fSwept(true)
+    {}
+    
     virtual ~clist()
     {
         deleteClist(this);
@@ -89,7 +105,230 @@ static void createUiCallbackItem(GUI* ui, FAUSTFLOAT* zone, uiCallback foo, void
 
 typedef std::map<FAUSTFLOAT*, clist*> zmap;
 
-typedef std::map<FAUSTFLOAT*, ringbuffer_t*> ztimedmap;
+/**
+ *  For timestamped control
+ */
+
+struct DatedControl {
+    
+    double fDate;
+    FAUSTFLOAT fValue;
+    
+    DatedControl(double d = 0., FAUSTFLOAT v = FAUSTFLOAT(0)):fDate(d), fValue(v) {}
+    
+};
+
+/**
+ * Bounded lock-free queue with several writers and one reader (D. Vyukov's bounded queue):
+ * each cell sequence number tells whether the cell is free for the writer or written for the reader.
+ */
+
+template <typename T>
+struct TimedQueue {
+    
+    struct Cell {
+        std::atomic<size_t> fSeq;
+        T fValue;
+    };
+    
+    Cell* fCells;
+    size_t fMask;
+    std::atomic<size_t> fWrite;
+    size_t fRead;   // Only used by the reader
+    
+    // 'size' is rounded up to a power of two
+    TimedQueue(size_t size):fWrite(0), fRead(0)
+    {
+        size_t capacity = 1;
+        while (capacity < size) capacity <<= 1;
+        fCells = new Cell[capacity];
+        fMask = capacity - 1;
+        for (size_t i = 0; i < capacity; i++) {
+            fCells[i].fSeq.store(i, std::memory_order_relaxed);
+        }
+    }
+    virtual ~TimedQueue() { delete [] fCells; }
+    
+    // Can be called by several threads, returns false if the queue is full
+    bool push(const T& value)
+    {
+        size_t pos = fWrite.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell* cell = &fCells[pos & fMask];
+            intptr_t diff = intptr_t(cell->fSeq.load(std::memory_order_acquire)) - intptr_t(pos);
+            if (diff == 0) {
+                if (fWrite.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell->fValue = value;
+                    cell->fSeq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = fWrite.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    // Reader only: read the next value without removing it, returns false if there is none
+    bool peek(T& value)
+    {
+        Cell* cell = &fCells[fRead & fMask];
+        if (cell->fSeq.load(std::memory_order_acquire) != fRead + 1) return false;
+        value = cell->fValue;
+        return true;
+    }
+    
+    // Reader only: read and remove the next value, returns false if there is none
+    bool pop(T& value)
+    {
+        Cell* cell = &fCells[fRead & fMask];
+        if (cell->fSeq.load(std::memory_order_acquire) != fRead + 1) return false;
+        value = cell->fValue;
+        cell->fSeq.store(fRead + fMask + 1, std::memory_order_release);
+        fRead++;
+        return true;
+    }
+    
+};
+
+#define TIMED_ZONE_VALUES 512   // Number of values a timed zone can hold until the timed_dsp reads them
+
+/**
+ * For timestamped control: a zone used by a timed_dsp, that owns it. The zone values are written
+ * in 'fValues', and the zone index is written once in 'fQueue' until the timed_dsp reads the values,
+ * so that 'fQueue' (sized for all the timed_dsp zones) is never full.
+ */
+
+struct TimedZoneQueue {
+    
+    TimedQueue<DatedControl> fValues;
+    TimedQueue<int>* fQueue;        // Queue of the timed_dsp
+    int fIndex;                     // Index of the zone in the timed_dsp
+    std::atomic<bool> fNotified;    // Whether 'fIndex' is in 'fQueue' and not yet read
+    
+    TimedZoneQueue(TimedQueue<int>* queue, int index):fValues(TIMED_ZONE_VALUES), fQueue(queue), fIndex(index), fNotified(false) {}
+    virtual ~TimedZoneQueue() {}
+    
+};
+
+/**
+ * The queue of a timed zone seen by the uiTimedItem objects writing its values, so that modifyZone finds it
+ * without lock. Shared by the items and the timed_dsp using the zone, and reference counted under GUI::getTimedZoneLock().
+ */
+
+struct TimedZoneSlot {
+    
+    std::atomic<TimedZoneQueue*> fQueue;    // Queue of the timed_dsp using the zone, or nullptr
+    std::atomic<int> fWriters;              // Number of modifyZone calls using 'fQueue'
+    int fRefs;
+    
+    TimedZoneSlot():fQueue(nullptr), fWriters(0), fRefs(0) {}
+    
+    // Once returned, no modifyZone call uses the previous queue anymore, which can then be deleted
+    void setQueue(TimedZoneQueue* queue)
+    {
+        fQueue.store(queue);
+        while (fWriters.load() > 0) {}
+    }
+    
+    void write(const DatedControl& value)
+    {
+        // 'fWriters' is incremented before reading 'fQueue', and 'setQueue' writes 'fQueue' before waiting
+        // for 'fWriters' (sequentially consistent): either the writer sees the new queue, or setQueue waits for it.
+        fWriters++;
+        TimedZoneQueue* queue = fQueue.load();
+        if (queue) {
+            if (!queue->fValues.push(value)) {
+                std::cerr << "TimedQueue::push error DatedControl : value dropped" << std::endl;
+            }
+            // Notify the timed_dsp once, it then reads all the zone values (cannot fail, see TimedZoneQueue)
+            if (!queue->fNotified.exchange(true)) {
+                queue->fQueue->push(queue->fIndex);
+            }
+        }
+        // Otherwise no timed_dsp uses the zone, and the value is dropped
+        fWriters--;
+    }
+    
+};
+
+typedef std::map<FAUSTFLOAT*, TimedZoneSlot*> ztimedqueuemap;
+
+/**
+ * Scoped spin lock on the timed zone maps: they are only changed when timed items and timed_dsp are created
+ * or deleted, so the lock is short and rarely contended. std::atomic_flag is also available on the targets
+ * without std::mutex (like Teensy).
+ */
+
+struct TimedZoneLock {
+    
+    std::atomic_flag& fFlag;
+    
+    TimedZoneLock(std::atomic_flag& flag):fFlag(flag)
+    {
+        while (fFlag.test_and_set(std::memory_order_acquire)) {}
+    }
+    ~TimedZoneLock()
+    {
+        fFlag.clear(std::memory_order_release);
+    }
+    
+};
+
+/**
+ * Process-wide log of the zones changed with modifyZone or GUI::notifyZone. Written lock-free by any thread,
+ * and read by each GUI at its own pace, so that writers never access the GUIs. A GUI that is lapped by
+ * the writers refreshes all its zones.
+ * Write numbers are size_t and compared modulo their range, so that 32-bit targets without 64-bit atomics
+ * (like Cortex-M) can use the log.
+ */
+
+struct ZoneLog {
+    
+    static const size_t kSize = 4096;           // Power of 2
+    
+    struct Entry {
+        std::atomic<size_t> fSeq;               // Write number + 1, once fZone is written
+        std::atomic<FAUSTFLOAT*> fZone;
+    };
+    
+    Entry fEntries[kSize];
+    std::atomic<size_t> fWrite;                 // Number of writes
+    
+    ZoneLog():fWrite(0)
+    {
+        for (size_t i = 0; i < kSize; i++) {
+            fEntries[i].fSeq.store(0);
+            fEntries[i].fZone.store(nullptr);
+        }
+    }
+    
+    void push(FAUSTFLOAT* z)
+    {
+        size_t n = fWrite.fetch_add(1, std::memory_order_relaxed);
+        Entry& e = fEntries[n & (kSize - 1)];
+        e.fZone.store(z, std::memory_order_release);
+        e.fSeq.store(n + 1, std::memory_order_release);
+    }
+    
+    /**
+     * Read the zone written at 'n'.
+     *
+     * @return 1 if read in 'z', 0 if not yet written, -1 if overwritten by a later write.
+     */
+    int read(size_t n, FAUSTFLOAT*& z)
+    {
+        Entry& e = fEntries[n & (kSize - 1)];
+        std::ptrdiff_t diff = std::ptrdiff_t(e.fSeq.load(std::memory_order_acquire) - (n + 1));
+        if (diff < 0) return 0;
+        if (diff > 0) return -1;
+        z = e.fZone.load(std::memory_order_acquire);
+        // A later write to the same entry may have changed fZone before fSeq
+        return (fWrite.load(std::memory_order_acquire) - n > kSize) ? -1 : 1;
+    }
+    
+};
 
 class GUI : public UI
 {
@@ -98,11 +337,90 @@ class GUI : public UI
      
         static std::list<GUI*> fGuiList;
         zmap fZoneMap;
+        std::vector<clist*> fPolledZones;   // Zones compared at each update
+        std::vector<clist*> fSweptZones;    // Zones compared in turn, all of them in kSweepUpdates updates
+        size_t fSweepIndex;
+        size_t fLogRead;                    // Next write of the zone log to read
+        bool fRefresh;                      // Whether all zones are reflected at the next update
         bool fStopped;
+    
+        static const size_t kSweepMin = 64;         // Zones compared per update, at least
+        static const size_t kSweepUpdates = 16;     // Updates to compare all the swept zones, at most
+    
+        static ZoneLog& getZoneLog()
+        {
+            static ZoneLog gZoneLog;
+            return gZoneLog;
+        }
+    
+        void updateZone(clist* cl)
+        {
+            FAUSTFLOAT v = *cl->fZone;
+            cl->fLast = v;
+            for (auto& c : *cl) {
+                if (c->cache() != v) c->reflectZone();
+            }
+        }
+    
+        void refreshAllZones()
+        {
+            for (auto& it : fZoneMap) {
+                updateZone(it.second);
+            }
+        }
+    
+        void removeZone(std::vector<clist*>& zones, clist* cl)
+        {
+            zones.erase(std::find(zones.begin(), zones.end(), cl));
+        }
+    
+        // Reflect the zones written in the log since the last update
+        void readZoneLog()
+        {
+            ZoneLog& log = getZoneLog();
+            size_t write = log.fWrite.load(std::memory_order_acquire);
+            while (fLogRead != write) {
+                FAUSTFLOAT* z = nullptr;
+                int res = (write - fLogRead > ZoneLog::kSize) ? -1 : log.read(fLogRead, z);
+                if (res == 0) {
+                    // Not yet written, read at the next update
+                    return;
+                } else if (res < 0) {
+                    // Lapped by the writers
+                    fLogRead = log.fWrite.load(std::memory_order_acquire);
+                    fRefresh = true;
+                    return;
+                }
+                fLogRead++;
+                zmap::iterator it = fZoneMap.find(z);
+                if (it != fZoneMap.end()) updateZone(it->second);
+            }
+        }
+    
+        // Compare the next swept zones, the ones found changed are polled from now on
+        void sweepZones()
+        {
+            size_t sweep_size = (fSweptZones.size() + kSweepUpdates - 1) / kSweepUpdates;
+            if (sweep_size < kSweepMin) sweep_size = kSweepMin;
+            for (size_t i = 0; i < sweep_size && fSweptZones.size() > 0; i++) {
+                if (fSweepIndex >= fSweptZones.size()) fSweepIndex = 0;
+                clist* cl = fSweptZones[fSweepIndex];
+                if (*cl->fZone != cl->fLast) {
+                    updateZone(cl);
+                    cl->fSwept = false;
+                    cl->fPolled = true;
+                    fPolledZones.push_back(cl);
+                    fSweptZones[fSweepIndex] = fSweptZones.back();
+                    fSweptZones.pop_back();
+                } else {
+                    fSweepIndex++;
+                }
+            }
+        }
         
      public:
             
-        GUI():fStopped(false)
+        GUI():fSweepIndex(0), fLogRead(getZoneLog().fWrite.load()), fRefresh(false), fStopped(false)
         {	
             fGuiList.push_back(this);
         }
@@ -121,23 +439,74 @@ class GUI : public UI
         
         void registerZone(FAUSTFLOAT* z, uiItemBase* c)
         {
-            if (fZoneMap.find(z) == fZoneMap.end()) fZoneMap[z] = new clist();
+            if (fZoneMap.find(z) == fZoneMap.end()) {
+                clist* cl = new clist(z);
+                fZoneMap[z] = cl;
+                fSweptZones.push_back(cl);
+            }
+            // New items are reflected at the next update
+            fRefresh = true;
             fZoneMap[z]->push_back(c);
         }
  
         void updateZone(FAUSTFLOAT* z)
         {
-            FAUSTFLOAT v = *z;
-            clist* cl = fZoneMap[z];
-            for (auto& c : *cl) {
-                if (c->cache() != v) c->reflectZone();
-            }
+            zmap::iterator it = fZoneMap.find(z);
+            if (it != fZoneMap.end()) updateZone(it->second);
         }
     
         void updateAllZones()
         {
-            for (auto& m : fZoneMap) {
-                updateZone(m.first);
+            // Zones signaled as changed
+            readZoneLog();
+            if (fRefresh) {
+                fRefresh = false;
+                refreshAllZones();
+                return;
+            }
+            // Zones written without notification
+            for (auto& it : fPolledZones) {
+                if (*it->fZone != it->fLast) updateZone(it);
+            }
+            sweepZones();
+        }
+    
+        /**
+         * Signal that a zone has been changed by external code: it will be reflected at the next update of all GUIs.
+         * Can be called from any thread, does not access the GUIs.
+         *
+         * @param z - the zone
+         */
+        static void notifyZone(FAUSTFLOAT* z)
+        {
+            getZoneLog().push(z);
+        }
+    
+        /**
+         * By default, zones are compared in turn, a part of them per update, and are compared at each update
+         * once found changed without notification. Passive zones (bargraphs), written by the DSP at each cycle,
+         * are set polled by the GUIs when their widget is added. Zones only changed with modifyZone
+         * or signaled with notifyZone do not have to be compared at all.
+         *
+         * @param z - the zone
+         * @param polled - whether the zone is compared at each update (true), or never (false)
+         */
+        void setZonePolled(FAUSTFLOAT* z, bool polled)
+        {
+            zmap::iterator it = fZoneMap.find(z);
+            if (it == fZoneMap.end()) return;
+            clist* cl = it->second;
+            if (cl->fSwept) {
+                removeZone(fSweptZones, cl);
+                cl->fSwept = false;
+            }
+            if (cl->fPolled != polled) {
+                if (polled) {
+                    fPolledZones.push_back(cl);
+                } else {
+                    removeZone(fPolledZones, cl);
+                }
+                cl->fPolled = polled;
             }
         }
     
@@ -194,8 +563,41 @@ class GUI : public UI
 
         virtual void declare(FAUSTFLOAT*, const char*, const char*) {}
     
-        // Static global for timed zones, shared between all UI that will set timed values
-        static ztimedmap gTimedZoneMap;
+        // Static global for the timed zones, shared between all UI that will set timed values,
+        // and their queues set by timed_dsp
+        static ztimedqueuemap& getTimedZoneQueueMap()
+        {
+            static ztimedqueuemap timed_zone_queue_map;
+            return timed_zone_queue_map;
+        }
+    
+        // Protects getTimedZoneQueueMap(), taken when timed items and timed_dsp are created or deleted,
+        // never when values are written or read
+        static std::atomic_flag& getTimedZoneLock()
+        {
+            static std::atomic_flag timed_zone_lock = ATOMIC_FLAG_INIT;
+            return timed_zone_lock;
+        }
+    
+        // The slot of a timed zone, to be called with getTimedZoneLock() and released with releaseTimedZoneSlot
+        static TimedZoneSlot* acquireTimedZoneSlot(FAUSTFLOAT* zone)
+        {
+            ztimedqueuemap& slot_map = getTimedZoneQueueMap();
+            ztimedqueuemap::iterator it = slot_map.find(zone);
+            TimedZoneSlot* slot = (it != slot_map.end()) ? (*it).second : (slot_map[zone] = new TimedZoneSlot());
+            slot->fRefs++;
+            return slot;
+        }
+    
+        static void releaseTimedZoneSlot(FAUSTFLOAT* zone)
+        {
+            ztimedqueuemap& slot_map = getTimedZoneQueueMap();
+            ztimedqueuemap::iterator it = slot_map.find(zone);
+            if (it != slot_map.end() && --(*it).second->fRefs == 0) {
+                delete (*it).second;
+                slot_map.erase(it);
+            }
+        }
 
 };
 
@@ -229,6 +631,7 @@ class uiTypedItem : public uiItemBase
             if (*fZone != v) {
                 *fZone = v;
                 fGUI->updateZone(fZone);
+                GUI::notifyZone(fZone);
             }
         }
     
@@ -254,6 +657,7 @@ class uiItem : public uiTypedItem<FAUSTFLOAT> {
 			if (*fZone != v) {
 				*fZone = v;
 				fGUI->updateZone(fZone);
+				GUI::notifyZone(fZone);
 			}
 		}
 
@@ -328,19 +732,6 @@ class uiCallbackItem : public uiItem {
         }
 };
 
-/**
- *  For timestamped control
- */
-
-struct DatedControl {
-    
-    double fDate;
-    FAUSTFLOAT fValue;
-    
-    DatedControl(double d = 0., FAUSTFLOAT v = FAUSTFLOAT(0)):fDate(d), fValue(v) {}
-    
-};
-
 /**
  * Base class for timed items
  */
@@ -350,7 +741,7 @@ class uiTimedItem : public uiItem
     
     protected:
         
-        bool fDelete;
+        TimedZoneSlot* fSlot;
         
     public:
     
@@ -358,30 +749,20 @@ class uiTimedItem : public uiItem
         
         uiTimedItem(GUI* ui, FAUSTFLOAT* zone):uiItem(ui, zone)
         {
-            if (GUI::gTimedZoneMap.find(fZone) == GUI::gTimedZoneMap.end()) {
-                GUI::gTimedZoneMap[fZone] = ringbuffer_create(8192);
-                fDelete = true;
-            } else {
-                fDelete = false;
-            }
+            TimedZoneLock lock(GUI::getTimedZoneLock());
+            fSlot = GUI::acquireTimedZoneSlot(fZone);
         }
         
         virtual ~uiTimedItem()
         {
-            ztimedmap::iterator it;
-            if (fDelete && ((it = GUI::gTimedZoneMap.find(fZone)) != GUI::gTimedZoneMap.end())) {
-                ringbuffer_free((*it).second);
-                GUI::gTimedZoneMap.erase(it);
-            }
+            TimedZoneLock lock(GUI::getTimedZoneLock());
+            GUI::releaseTimedZoneSlot(fZone);
         }
         
+        // Lock-free, written in the zone values of the timed_dsp using the zone
         virtual void modifyZone(double date, FAUSTFLOAT v)
         {
-            size_t res;
-            DatedControl dated_val(date, v);
-            if ((res = ringbuffer_write(GUI::gTimedZoneMap[fZone], (const char*)&dated_val, sizeof(DatedControl))) != sizeof(DatedControl)) {
-                std::cerr << "ringbuffer_write error DatedControl" << std::endl;
-            }
+            fSlot->write(DatedControl(date, v));
         }
     
 };
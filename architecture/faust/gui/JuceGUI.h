@@ -1902,6 +1902,7 @@ class JuceGUI : public GUI, public MetaDataUI, public juce::Component
             } else {
                 fCurrentBox->add(new uiVUMeter (this, zone, kWidth, kHeight, juce::String(label), min, max, juce::String(fUnit[zone]), juce::String(fTooltip[zone]), type, false));
             }
+            setZonePolled(zone, true);
         }
         
     public:
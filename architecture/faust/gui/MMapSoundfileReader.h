@@ -0,0 +1,699 @@
+/************************** BEGIN MMapSoundfileReader.h **************************/
+/************************************************************************
+ FAUST Architecture File
+ Copyright (C) 2026 GRAME, Centre National de Creation Musicale
+ ---------------------------------------------------------------------
+ This Architecture section is free software; you can redistribute it
+ and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 3 of
+ the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+ EXCEPTION : As a special exception, you may create a larger work
+ that contains this FAUST architecture section and distribute
+ that work under terms of your choice, so long as this FAUST
+ architecture section is not modified.
+ ************************************************************************/
+
+#ifndef __MMapSoundfileReader__
+#define __MMapSoundfileReader__
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "faust/gui/Soundfile.h"
+
+/*
+ Soundfiles are decoded once in a cache file of raw non-interleaved FAUSTFLOAT samples, laid out like
+ the Soundfile buffers, which is then memory-mapped: the DSP code directly reads the mapped pages,
+ so that loading a cached soundfile is immediate and only the pages actually read use memory.
+
+ Soundfiles are shared by all instances in the process, identified by their files path, size
+ and modification date, the driver sample rate and the FAUSTFLOAT type.
+
+ A background thread reads pages ahead of the read positions, so that the audio thread does not wait for the disk.
+ It follows the DSP code by watching (with 'mincore') the pages it brings in memory: a page newly in memory
+ followed by pages still on disk is taken as a read position. Hosts knowing where a part will be played
+ can also give it with 'setReadPosition'.
+*/
+
+#define MMAP_SOUNDFILE_MAGIC    0x444e5346  // 'FSND'
+#define MMAP_SOUNDFILE_VERSION  1
+#define MAX_PREFETCH_STREAMS    16          // Number of read positions followed in each soundfile
+#define PREFETCH_PERIOD         10          // in ms
+#define PREFETCH_TOUCH          16384       // Frames mapped ahead of a read position
+#define PREFETCH_AHEAD          131072      // Frames read in the page cache ahead of a read position
+#define PREFETCH_HEAD           8192        // Frames read in the page cache at the start of each part
+#define SOUNDFILE_CACHE_SIZE    1024        // Maximum size of the cache files in MB, unless FAUST_SOUNDFILE_CACHE_SIZE is set
+
+// The cache file header, followed by the channels at 'fDataOffset'
+struct MMapSoundfileHeader {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fSampleSize;   // sizeof(FAUSTFLOAT)
+    uint32_t fChannels;     // number of real channels
+    uint64_t fHash;         // hash of the soundfile key
+    uint64_t fDataOffset;   // in bytes, page aligned
+    uint64_t fStride;       // distance between channels in frames, page aligned
+    int32_t fLength[MAX_SOUNDFILE_PARTS];
+    int32_t fSR[MAX_SOUNDFILE_PARTS];
+    int32_t fOffset[MAX_SOUNDFILE_PARTS];
+
+    size_t getSize() { return fDataOffset + size_t(fChannels) * fStride * sizeof(FAUSTFLOAT); }
+
+    // Check a header read from a file of 'file_size' bytes, so that no buffer or part is outside of the file
+    bool isValid(uint64_t hash, uint64_t file_size)
+    {
+        uint64_t page_size = sysconf(_SC_PAGESIZE);
+        if (fMagic != MMAP_SOUNDFILE_MAGIC || fVersion != MMAP_SOUNDFILE_VERSION
+            || fSampleSize != sizeof(FAUSTFLOAT) || fHash != hash
+            || fChannels == 0 || fStride == 0
+            || fDataOffset < sizeof(MMapSoundfileHeader) || fDataOffset % page_size != 0 || fDataOffset > file_size
+            || fStride > (file_size - fDataOffset) / sizeof(FAUSTFLOAT) / fChannels
+            || getSize() != file_size) {
+            return false;
+        }
+        for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+            if (fLength[part] < 0 || fOffset[part] < 0 || fSR[part] <= 0
+                || uint64_t(fOffset[part]) + uint64_t(fLength[part]) > fStride) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/*
+ A Soundfile whose buffers are in a memory-mapped cache file (or in anonymous memory if the cache cannot be written).
+ */
+
+struct MMapSoundfile : public Soundfile {
+
+    // A read position, estimated from the last given one assuming the part is played at its sample rate
+    struct Stream {
+        int fPart;      // -1 if unused
+        int fStart;
+        int fAdvised;   // Frames read in the page cache up to this one
+        int fTouched;   // Frames mapped up to this one
+        std::chrono::steady_clock::time_point fDate;
+    };
+
+    std::string fKey;
+    int fRefs;
+    char* fMap;
+    size_t fMapSize;
+    size_t fPageSize;
+    std::atomic<int> fHints[MAX_SOUNDFILE_PARTS];   // Last given read position + 1 of each part, 0 if none
+    Stream fStreams[MAX_PREFETCH_STREAMS];
+    std::vector<unsigned char> fResident[MAX_SOUNDFILE_PARTS];  // Pages of each part in memory at the last scan
+
+    MMapSoundfile(const std::string& key, char* map, size_t map_size, int max_chan)
+    :fKey(key), fRefs(1), fMap(map), fMapSize(map_size), fPageSize(sysconf(_SC_PAGESIZE))
+    {
+        MMapSoundfileHeader* header = reinterpret_cast<MMapSoundfileHeader*>(fMap);
+        fChannels = header->fChannels;
+        fBuffers = new FAUSTFLOAT*[max_chan];
+        for (int chan = 0; chan < max_chan; chan++) {
+            fBuffers[chan] = reinterpret_cast<FAUSTFLOAT*>(fMap + header->fDataOffset) + (chan % fChannels) * header->fStride;
+        }
+        for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+            fLength[part] = header->fLength[part];
+            fSR[part] = header->fSR[part];
+            fOffset[part] = header->fOffset[part];
+            fHints[part] = 0;
+        }
+        for (int i = 0; i < MAX_PREFETCH_STREAMS; i++) {
+            fStreams[i].fPart = -1;
+        }
+    }
+
+    ~MMapSoundfile()
+    {
+        munmap(fMap, fMapSize);
+        // The buffers are in the map
+        fChannels = 0;
+    }
+
+    // Lock-free, can be called from the audio thread
+    void setReadPosition(int part, int frame)
+    {
+        if (part >= 0 && part < MAX_SOUNDFILE_PARTS) {
+            fHints[part] = std::max<int>(0, frame) + 1;
+        }
+    }
+
+    // Apply 'advice', or touch the pages if 'advice' is -1, on the frames [from, to[ of 'part' in all channels
+    void mapFrames(int part, int from, int to, int advice)
+    {
+        if (from >= to) return;
+        for (int chan = 0; chan < fChannels; chan++) {
+            char* begin = reinterpret_cast<char*>(&fBuffers[chan][fOffset[part] + from]);
+            char* end = reinterpret_cast<char*>(&fBuffers[chan][fOffset[part] + to]);
+            begin -= uintptr_t(begin) % fPageSize;
+            if (advice >= 0) {
+                madvise(begin, end - begin, advice);
+            } else {
+                volatile char sum = 0;
+                for (char* page = begin; page < end; page += fPageSize) {
+                    sum += *page;
+                }
+            }
+        }
+    }
+
+    void prefetchHeads()
+    {
+        for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+            mapFrames(part, 0, std::min<int>(PREFETCH_HEAD, fLength[part]), MADV_WILLNEED);
+        }
+    }
+
+    Stream* startStream(int part, int frame, std::chrono::steady_clock::time_point date)
+    {
+        // Use a free stream, or the oldest one
+        Stream* stream = &fStreams[0];
+        for (int i = 0; i < MAX_PREFETCH_STREAMS; i++) {
+            if (fStreams[i].fPart < 0) { stream = &fStreams[i]; break; }
+            if (fStreams[i].fDate < stream->fDate) stream = &fStreams[i];
+        }
+        stream->fPart = part;
+        stream->fStart = frame;
+        stream->fAdvised = frame;
+        stream->fTouched = frame;
+        stream->fDate = date;
+        return stream;
+    }
+
+    // If the frames [from, to[ of 'part' have been read by 'prefetchHeads' or by a stream
+    bool isStreamed(int part, int from, int to)
+    {
+        if (to <= PREFETCH_HEAD) return true;
+        for (int i = 0; i < MAX_PREFETCH_STREAMS; i++) {
+            if (fStreams[i].fPart == part && from <= fStreams[i].fAdvised && to >= fStreams[i].fStart) return true;
+        }
+        return false;
+    }
+
+    /*
+     Start a stream on each run of pages brought in memory since the last scan and followed by pages still on disk,
+     and not read by the prefetch itself: the DSP code has faulted in the run, that the kernel has read around.
+     The stream starts at the start of the run, and reads ahead from its end.
+     */
+    void followReads(std::chrono::steady_clock::time_point date)
+    {
+        std::vector<unsigned char> resident, channel;
+        for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+            // Channels have the same page alignment
+            char* first = reinterpret_cast<char*>(&fBuffers[0][fOffset[part]]);
+            char* begin = first - uintptr_t(first) % fPageSize;
+            size_t size = reinterpret_cast<char*>(&fBuffers[0][fOffset[part] + fLength[part]]) - begin;
+            size_t pages = (size + fPageSize - 1) / fPageSize;
+            resident.assign(pages, 0);
+            channel.resize(pages);
+            for (int chan = 0; chan < fChannels; chan++) {
+                char* chan_begin = begin + (reinterpret_cast<char*>(fBuffers[chan]) - reinterpret_cast<char*>(fBuffers[0]));
+            #ifdef __APPLE__
+                if (mincore(chan_begin, size, reinterpret_cast<char*>(channel.data())) != 0) return;
+            #else
+                if (mincore(chan_begin, size, channel.data()) != 0) return;
+            #endif
+                for (size_t page = 0; page < pages; page++) {
+                    resident[page] |= channel[page] & 1;
+                }
+            }
+            // The first scan only records the pages already in memory
+            std::vector<unsigned char>& previous = fResident[part];
+            for (size_t page = 0; previous.size() == pages && page < pages; page++) {
+                if (!resident[page] || previous[page]) continue;
+                size_t end = page;
+                while (end < pages && resident[end] && !previous[end]) end++;
+                if (end < pages && !resident[end]) {
+                    int from = std::max<int>(0, int((begin + page * fPageSize - first) / int(sizeof(FAUSTFLOAT))));
+                    int to = int((begin + end * fPageSize - first) / sizeof(FAUSTFLOAT));
+                    if (!isStreamed(part, from, to)) {
+                        Stream* stream = startStream(part, from, date);
+                        stream->fAdvised = to;
+                    }
+                }
+                page = end;
+            }
+            previous.swap(resident);
+        }
+    }
+
+    // Called by the prefetch thread
+    void prefetch(std::chrono::steady_clock::time_point date)
+    {
+        followReads(date);
+        for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+            int hint = fHints[part].exchange(0);
+            if (hint > 0) startStream(part, hint - 1, date);
+        }
+        for (int i = 0; i < MAX_PREFETCH_STREAMS; i++) {
+            Stream& stream = fStreams[i];
+            if (stream.fPart < 0) continue;
+            int length = fLength[stream.fPart];
+            double elapsed = std::chrono::duration<double>(date - stream.fDate).count();
+            int pos = stream.fStart + int(elapsed * fSR[stream.fPart]);
+            if (pos >= length) {
+                stream.fPart = -1;
+                continue;
+            }
+            // Asynchronously read the next frames in the page cache
+            if (stream.fAdvised - pos < PREFETCH_AHEAD / 2) {
+                int end = std::min<int>(pos + PREFETCH_AHEAD, length);
+                mapFrames(stream.fPart, std::max<int>(stream.fAdvised, pos), end, MADV_WILLNEED);
+                stream.fAdvised = end;
+            }
+            // Map the frames about to be read, so that the audio thread does not fault
+            int end = std::min<int>(pos + PREFETCH_TOUCH, length);
+            mapFrames(stream.fPart, std::max<int>(stream.fTouched, pos), end, -1);
+            stream.fTouched = std::max<int>(stream.fTouched, end);
+        }
+    }
+
+};
+
+/*
+ The process-wide table of the loaded soundfiles, and the prefetch thread.
+ */
+
+struct MMapSoundfileCache {
+
+    std::map<std::string, MMapSoundfile*> fSoundfiles;
+    std::mutex fMutex;
+    std::condition_variable fCond;
+    std::thread fThread;
+    bool fStop;
+
+    MMapSoundfileCache():fStop(false) {}
+
+    virtual ~MMapSoundfileCache()
+    {
+        stop();
+        for (auto& it : fSoundfiles) {
+            delete it.second;
+        }
+    }
+
+    /*
+     The table is never deleted, so that soundfiles can still be released during static destruction,
+     but the prefetch thread is stopped and joined at exit.
+     */
+    static MMapSoundfileCache& getCache()
+    {
+        static MMapSoundfileCache* cache = new MMapSoundfileCache();
+        static struct Stopper {
+            ~Stopper() { cache->stop(); }
+        } stopper;
+        return *cache;
+    }
+
+    // Stop and join the prefetch thread (that is not restarted)
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStop = true;
+            fCond.notify_one();
+        }
+        if (fThread.joinable()) fThread.join();
+    }
+
+    // To be called with 'fMutex' locked
+    MMapSoundfile* acquire(const std::string& key)
+    {
+        auto it = fSoundfiles.find(key);
+        if (it == fSoundfiles.end()) return nullptr;
+        it->second->fRefs++;
+        return it->second;
+    }
+
+    // To be called with 'fMutex' locked
+    void unref(MMapSoundfile* soundfile)
+    {
+        if (--soundfile->fRefs == 0) {
+            fSoundfiles.erase(soundfile->fKey);
+            delete soundfile;
+        }
+    }
+
+    // Add a new soundfile, or return the one loaded by another thread in the meantime
+    MMapSoundfile* add(MMapSoundfile* soundfile)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        MMapSoundfile* loaded = acquire(soundfile->fKey);
+        if (loaded) {
+            delete soundfile;
+            return loaded;
+        }
+        fSoundfiles[soundfile->fKey] = soundfile;
+        if (!fThread.joinable() && !fStop) fThread = std::thread(&MMapSoundfileCache::run, this);
+        fCond.notify_one();
+        return soundfile;
+    }
+
+    // Return false if 'soundfile' is not in the table
+    bool release(Soundfile* soundfile)
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (auto& it : fSoundfiles) {
+            if (it.second == soundfile) {
+                unref(it.second);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run()
+    {
+        std::vector<MMapSoundfile*> soundfiles;
+        std::unique_lock<std::mutex> lock(fMutex);
+        while (!fStop) {
+            if (fSoundfiles.empty()) {
+                fCond.wait(lock);
+                continue;
+            }
+            // Prefetch (disk I/O) is done without the lock, the references keep the soundfiles alive
+            soundfiles.clear();
+            for (auto& it : fSoundfiles) {
+                it.second->fRefs++;
+                soundfiles.push_back(it.second);
+            }
+            lock.unlock();
+            std::chrono::steady_clock::time_point date = std::chrono::steady_clock::now();
+            for (auto& it : soundfiles) {
+                it->prefetch(date);
+            }
+            lock.lock();
+            for (auto& it : soundfiles) {
+                unref(it);
+            }
+            if (!fStop) fCond.wait_for(lock, std::chrono::milliseconds(PREFETCH_PERIOD));
+        }
+    }
+
+};
+
+/*
+ A soundfile reader using a decoding reader (like LibsndfileReader) to create the cache files,
+ to be used as MMapSoundfileReader<LibsndfileReader>.
+ */
+
+template <class READER>
+struct MMapSoundfileReader : public READER {
+
+    std::string fCacheDir;
+
+    /**
+     * Create the reader.
+     *
+     * @param cache_dir - the directory of the cache files, by default FAUST_SOUNDFILE_CACHE, TMPDIR or /tmp
+     */
+    MMapSoundfileReader(const std::string& cache_dir = "")
+    {
+        const char* faust_cache = getenv("FAUST_SOUNDFILE_CACHE");
+        const char* tmp_dir = getenv("TMPDIR");
+        fCacheDir = (cache_dir != "") ? cache_dir : (faust_cache ? faust_cache : (tmp_dir ? tmp_dir : "/tmp"));
+    }
+
+    /**
+     * Give the position the DSP is reading at in a part, so that the next pages are read ahead
+     * before the DSP code brings them in memory itself.
+     * The position is then assumed to advance at the part sample rate until the end of the part.
+     * Lock-free, can be called from the audio thread.
+     *
+     * @param soundfile - a soundfile created by this reader
+     * @param part - the part number
+     * @param frame - the read position in the part
+     */
+    static void setReadPosition(Soundfile* soundfile, int part, int frame)
+    {
+        static_cast<MMapSoundfile*>(soundfile)->setReadPosition(part, frame);
+    }
+
+    Soundfile* createSoundfile(const std::vector<std::string>& path_name_list, int max_chan)
+    {
+        MMapSoundfileCache& cache = MMapSoundfileCache::getCache();
+        std::string key = getKey(path_name_list, max_chan);
+        {
+            std::lock_guard<std::mutex> lock(cache.fMutex);
+            MMapSoundfile* soundfile = cache.acquire(key);
+            if (soundfile) return soundfile;
+        }
+
+        try {
+            uint64_t hash = getHash(key);
+            char* map = nullptr;
+            size_t size = 0;
+            if (hasFiles(path_name_list)) {
+                std::stringstream file_name;
+                file_name << fCacheDir << "/faust-" << std::hex << hash << ".fsnd";
+                if (!mapCache(file_name.str(), hash, map, size)) {
+                    if (writeCache(file_name.str(), hash, path_name_list, max_chan)) {
+                        mapCache(file_name.str(), hash, map, size);
+                    }
+                }
+            }
+            // Silence, or the cache cannot be used: decode in anonymous memory
+            if (!map) {
+                MMapSoundfileHeader header;
+                setLayout(header, hash, path_name_list);
+                size = header.getSize();
+                map = static_cast<char*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+                if (map == MAP_FAILED) {
+                    std::cerr << "ERROR : cannot allocate " << size << " bytes for the soundfile" << std::endl;
+                    return nullptr;
+                }
+                try {
+                    fillMap(map, header, path_name_list, max_chan);
+                } catch (...) {
+                    munmap(map, size);
+                    throw;
+                }
+            }
+            MMapSoundfile* soundfile = new MMapSoundfile(key, map, size, max_chan);
+            soundfile->prefetchHeads();
+            return cache.add(soundfile);
+
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void destroySoundfile(Soundfile* soundfile)
+    {
+        if (!MMapSoundfileCache::getCache().release(soundfile)) {
+            delete soundfile;
+        }
+    }
+
+    protected:
+
+        static bool hasFiles(const std::vector<std::string>& path_name_list)
+        {
+            for (size_t i = 0; i < path_name_list.size(); i++) {
+                if (path_name_list[i] != "__empty_sound__") return true;
+            }
+            return false;
+        }
+
+        std::string getKey(const std::vector<std::string>& path_name_list, int max_chan)
+        {
+            std::stringstream key;
+            key << sizeof(FAUSTFLOAT) << " " << this->fDriverSR << " " << max_chan;
+            for (size_t i = 0; i < path_name_list.size(); i++) {
+                key << "\n";
+                if (path_name_list[i] == "__empty_sound__") {
+                    key << path_name_list[i];
+                } else {
+                    char* real_path = realpath(path_name_list[i].c_str(), nullptr);
+                    key << ((real_path) ? real_path : path_name_list[i].c_str());
+                    free(real_path);
+                    struct stat info;
+                    if (stat(path_name_list[i].c_str(), &info) == 0) {
+                        key << " " << info.st_size << " " << info.st_mtime;
+                    }
+                }
+            }
+            return key.str();
+        }
+
+        // FNV-1a
+        static uint64_t getHash(const std::string& key)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < key.size(); i++) {
+                hash = (hash ^ uint8_t(key[i])) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        static uint64_t pageAlign(uint64_t size)
+        {
+            uint64_t page_size = sysconf(_SC_PAGESIZE);
+            return ((size + page_size - 1) / page_size) * page_size;
+        }
+
+        void setLayout(MMapSoundfileHeader& header, uint64_t hash, const std::vector<std::string>& path_name_list)
+        {
+            int channels, length;
+            this->getParamsFiles(path_name_list, channels, length);
+            memset(&header, 0, sizeof(MMapSoundfileHeader));
+            header.fMagic = MMAP_SOUNDFILE_MAGIC;
+            header.fVersion = MMAP_SOUNDFILE_VERSION;
+            header.fSampleSize = sizeof(FAUSTFLOAT);
+            header.fChannels = channels;
+            header.fHash = hash;
+            header.fDataOffset = pageAlign(sizeof(MMapSoundfileHeader));
+            header.fStride = pageAlign(uint64_t(length) * sizeof(FAUSTFLOAT)) / sizeof(FAUSTFLOAT);
+        }
+
+        // Decode the files in the zeroed 'map' of 'header.getSize()' bytes
+        void fillMap(char* map, MMapSoundfileHeader& header, const std::vector<std::string>& path_name_list, int max_chan)
+        {
+            Soundfile soundfile;
+            soundfile.fBuffers = new FAUSTFLOAT*[max_chan];
+            for (uint32_t chan = 0; chan < header.fChannels; chan++) {
+                soundfile.fBuffers[chan] = reinterpret_cast<FAUSTFLOAT*>(map + header.fDataOffset) + chan * header.fStride;
+            }
+            soundfile.fChannels = header.fChannels;
+            try {
+                this->readFiles(&soundfile, path_name_list, max_chan);
+            } catch (...) {
+                // The buffers are in the map
+                soundfile.fChannels = 0;
+                throw;
+            }
+            soundfile.fChannels = 0;
+            for (int part = 0; part < MAX_SOUNDFILE_PARTS; part++) {
+                header.fLength[part] = soundfile.fLength[part];
+                header.fSR[part] = soundfile.fSR[part];
+                header.fOffset[part] = soundfile.fOffset[part];
+            }
+            memcpy(map, &header, sizeof(MMapSoundfileHeader));
+        }
+
+        // Map a valid cache file
+        static bool mapCache(const std::string& file_name, uint64_t hash, char*& map, size_t& size)
+        {
+            int fd = open(file_name.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat info;
+            MMapSoundfileHeader header;
+            bool valid = (fstat(fd, &info) == 0)
+                && (pread(fd, &header, sizeof(MMapSoundfileHeader), 0) == ssize_t(sizeof(MMapSoundfileHeader)))
+                && header.isValid(hash, uint64_t(info.st_size));
+            if (valid) {
+                size = header.getSize();
+                map = static_cast<char*>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+                valid = (map != MAP_FAILED);
+                if (!valid) map = nullptr;
+            }
+            if (valid) {
+                // The modification date is used as the 'last use' date for eviction
+                futimens(fd, nullptr);
+            }
+            close(fd);
+            return valid;
+        }
+
+        // Decode the files in a temporary sparse file, renamed when complete so that other processes only see complete files
+        bool writeCache(const std::string& file_name, uint64_t hash, const std::vector<std::string>& path_name_list, int max_chan)
+        {
+            // The name is unique among the threads of all processes sharing the cache directory
+            std::stringstream tmp_name;
+            tmp_name << file_name << "." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+            int fd = open(tmp_name.str().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                std::cerr << "WARNING : cannot create soundfile cache '" << tmp_name.str() << "'" << std::endl;
+                return false;
+            }
+            MMapSoundfileHeader header;
+            setLayout(header, hash, path_name_list);
+            size_t size = header.getSize();
+            char* map = nullptr;
+            if (ftruncate(fd, size) == 0) {
+                map = static_cast<char*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+                if (map == MAP_FAILED) map = nullptr;
+            }
+            close(fd);
+            if (!map) {
+                std::cerr << "WARNING : cannot write soundfile cache '" << tmp_name.str() << "'" << std::endl;
+                unlink(tmp_name.str().c_str());
+                return false;
+            }
+            try {
+                fillMap(map, header, path_name_list, max_chan);
+            } catch (...) {
+                munmap(map, size);
+                unlink(tmp_name.str().c_str());
+                throw;
+            }
+            bool res = (msync(map, size, MS_SYNC) == 0);
+            munmap(map, size);
+            res = res && (rename(tmp_name.str().c_str(), file_name.c_str()) == 0);
+            if (!res) unlink(tmp_name.str().c_str());
+            if (res) evictCache(file_name);
+            return res;
+        }
+
+        // LRU eviction of the cache files, the new one 'file_name' being always kept
+        // (files still mapped by running processes stay valid until they are unmapped)
+        void evictCache(const std::string& file_name)
+        {
+            const char* size_str = getenv("FAUST_SOUNDFILE_CACHE_SIZE");
+            uint64_t max_size = uint64_t((size_str) ? std::max(1, atoi(size_str)) : SOUNDFILE_CACHE_SIZE) << 20;
+
+            std::vector<std::pair<time_t, std::pair<std::string, uint64_t> > > entries;
+            uint64_t total_size = 0;
+            if (DIR* dir = opendir(fCacheDir.c_str())) {
+                while (struct dirent* ent = readdir(dir)) {
+                    std::string name = ent->d_name;
+                    if (name.compare(0, 6, "faust-") != 0 || name.compare(name.size() - 5, 5, ".fsnd") != 0) continue;
+                    std::string entry = fCacheDir + "/" + name;
+                    struct stat info;
+                    if (stat(entry.c_str(), &info) != 0) continue;
+                    total_size += uint64_t(info.st_size);
+                    if (entry != file_name) {
+                        entries.push_back(std::make_pair(info.st_mtime, std::make_pair(entry, uint64_t(info.st_size))));
+                    }
+                }
+                closedir(dir);
+            }
+            std::sort(entries.begin(), entries.end());
+            for (size_t i = 0; i < entries.size() && total_size > max_size; i++) {
+                if (unlink(entries[i].second.first.c_str()) == 0) total_size -= entries[i].second.second;
+            }
+        }
+
+};
+
+#endif
+/**************************  END  MMapSoundfileReader.h **************************/
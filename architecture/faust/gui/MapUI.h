@@ -31,10 +31,15 @@
 
 #include "faust/gui/UI.h"
 #include "faust/gui/PathBuilder.h"
+#include "faust/gui/PathHash.h"
 
 /*******************************************************************************
  * MapUI : Faust User Interface
  * This class creates a map of complete hierarchical path and zones for each UI items.
+ * Parameters can also be addressed by their index (in the path order) resolved once
+ * with getParamIndex, then set or read in O(1), possibly in batch.
+ * The index is built when the UI is complete (when its top box is closed), lookups then only read it,
+ * so they can be done on any thread.
  ******************************************************************************/
 
 class MapUI : public UI, public PathBuilder
@@ -48,6 +53,40 @@ class MapUI : public UI, public PathBuilder
         // Label zone map
         std::map<std::string, FAUSTFLOAT*> fLabelZoneMap;
     
+        // Zones in the path order, and perfect hash of paths and labels to their index
+        std::vector<std::string> fPaths;
+        std::vector<FAUSTFLOAT*> fZones;
+        PathHash fPathHash;
+    
+        void addZone(const char* label, FAUSTFLOAT* zone)
+        {
+            fPathZoneMap[buildPath(label)] = zone;
+            fLabelZoneMap[label] = zone;
+        }
+    
+        void buildIndex()
+        {
+            fPaths.clear();
+            fZones.clear();
+            std::map<FAUSTFLOAT*, int> indexes;
+            for (auto& it : fPathZoneMap) {
+                indexes[it.second] = int(fZones.size());
+                fPaths.push_back(it.first);
+                fZones.push_back(it.second);
+            }
+            // Paths take precedence on labels
+            std::vector<std::string> keys = fPaths;
+            std::vector<int> values;
+            for (size_t i = 0; i < fPaths.size(); i++) values.push_back(int(i));
+            for (auto& it : fLabelZoneMap) {
+                if (fPathZoneMap.find(it.first) == fPathZoneMap.end()) {
+                    keys.push_back(it.first);
+                    values.push_back(indexes[it.second]);
+                }
+            }
+            fPathHash.build(keys, values);
+        }
+    
     public:
         
         MapUI() {}
@@ -69,45 +108,40 @@ class MapUI : public UI, public PathBuilder
         void closeBox()
         {
             popLabel();
+            // The UI is complete: index its zones
+            if (fControlsLevel.empty()) buildIndex();
         }
         
         // -- active widgets
         void addButton(const char* label, FAUSTFLOAT* zone)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         void addCheckButton(const char* label, FAUSTFLOAT* zone)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         void addVerticalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT fmin, FAUSTFLOAT fmax, FAUSTFLOAT step)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         void addHorizontalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT fmin, FAUSTFLOAT fmax, FAUSTFLOAT step)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         void addNumEntry(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT fmin, FAUSTFLOAT fmax, FAUSTFLOAT step)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         
         // -- passive widgets
         void addHorizontalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT fmin, FAUSTFLOAT fmax)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
         void addVerticalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT fmin, FAUSTFLOAT fmax)
         {
-            fPathZoneMap[buildPath(label)] = zone;
-            fLabelZoneMap[label] = zone;
+            addZone(label, zone);
         }
     
         // -- soundfiles
@@ -120,21 +154,50 @@ class MapUI : public UI, public PathBuilder
         // set/get
         void setParamValue(const std::string& path, FAUSTFLOAT value)
         {
-            if (fPathZoneMap.find(path) != fPathZoneMap.end()) {
-                *fPathZoneMap[path] = value;
-            } else if (fLabelZoneMap.find(path) != fLabelZoneMap.end()) {
-                *fLabelZoneMap[path] = value;
-            }
+            int index = getParamIndex(path);
+            if (index >= 0) *fZones[index] = value;
         }
         
         FAUSTFLOAT getParamValue(const std::string& path)
         {
-            if (fPathZoneMap.find(path) != fPathZoneMap.end()) {
-                return *fPathZoneMap[path];
-            } else if (fLabelZoneMap.find(path) != fLabelZoneMap.end()) {
-                return *fLabelZoneMap[path];
-            } else {
-                return FAUSTFLOAT(0);
+            int index = getParamIndex(path);
+            return (index >= 0) ? *fZones[index] : FAUSTFLOAT(0);
+        }
+    
+        /**
+         * Return the index of a parameter, to be resolved once and used with the index based functions.
+         *
+         * @param path - the complete path or the label of the parameter
+         *
+         * @return the index (in the path order), or -1 if the parameter does not exist.
+         */
+        int getParamIndex(const std::string& path) const
+        {
+            return fPathHash.find(path);
+        }
+    
+        // set/get with an index (no check)
+        void setParamValue(int index, FAUSTFLOAT value) { *fZones[index] = value; }
+        FAUSTFLOAT getParamValue(int index) { return *fZones[index]; }
+    
+        /**
+         * Set several parameters at once.
+         *
+         * @param indexes - the parameter indexes (as returned by getParamIndex)
+         * @param values - the values
+         * @param count - the number of parameters
+         */
+        void setParamValues(const int* indexes, const FAUSTFLOAT* values, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                *fZones[indexes[i]] = values[i];
+            }
+        }
+    
+        void getParamValues(const int* indexes, FAUSTFLOAT* values, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                values[i] = *fZones[indexes[i]];
             }
         }
     
@@ -145,13 +208,7 @@ class MapUI : public UI, public PathBuilder
         
         std::string getParamAddress(int index)
         {
-            if (index < 0 || index > int(fPathZoneMap.size())) {
-                return "";
-            } else {
-                auto it = fPathZoneMap.begin();
-                while (index-- > 0 && it++ != fPathZoneMap.end()) {}
-                return it->first;
-            }
+            return (index < 0 || index >= int(fPaths.size())) ? "" : fPaths[index];
         }
     
         std::string getParamAddress(FAUSTFLOAT* zone)
@@ -164,24 +221,13 @@ class MapUI : public UI, public PathBuilder
     
         FAUSTFLOAT* getParamZone(const std::string& str)
         {
-            if (fPathZoneMap.find(str) != fPathZoneMap.end()) {
-                return fPathZoneMap[str];
-            }
-            if (fLabelZoneMap.find(str) != fLabelZoneMap.end()) {
-                return fLabelZoneMap[str];
-            }
-            return nullptr;
+            int index = getParamIndex(str);
+            return (index >= 0) ? fZones[index] : nullptr;
         }
     
         FAUSTFLOAT* getParamZone(int index)
         {
-            if (index < 0 || index > int(fPathZoneMap.size())) {
-                return nullptr;
-            } else {
-                auto it = fPathZoneMap.begin();
-                while (index-- > 0 && it++ != fPathZoneMap.end()) {}
-                return it->second;
-            }
+            return (index < 0 || index >= int(fZones.size())) ? nullptr : fZones[index];
         }
     
         static bool endsWith(const std::string& str, const std::string& end)
@@ -768,10 +768,12 @@ class MidiUI : public GUI, public midi, public MetaDataUI {
         virtual void addHorizontalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT min, FAUSTFLOAT max) 
         {
             addGenericZone(zone, min, max, false);
+            setZonePolled(zone, true);
         }
         virtual void addVerticalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT min, FAUSTFLOAT max)
         {
             addGenericZone(zone, min, max, false);
+            setZonePolled(zone, true);
         }
 
         // -- metadata declarations
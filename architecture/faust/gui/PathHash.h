@@ -0,0 +1,144 @@
+/************************** BEGIN PathHash.h **************************/
+/************************************************************************
+ FAUST Architecture File
+ Copyright (C) 2003-2020 GRAME, Centre National de Creation Musicale
+ ---------------------------------------------------------------------
+ This Architecture section is free software; you can redistribute it
+ and/or modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 3 of
+ the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+ EXCEPTION : As a special exception, you may create a larger work
+ that contains this FAUST architecture section and distribute
+ that work under terms of your choice, so long as this FAUST
+ architecture section is not modified.
+ ************************************************************************/
+
+#ifndef FAUST_PATHHASH_H
+#define FAUST_PATHHASH_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * PathHash : a minimal perfect hash table of the UI paths (and labels).
+ * Built once the UI is built (hash and displace : keys are grouped in buckets,
+ * each bucket gets a seed placing all its keys in free slots), a lookup then
+ * costs two string hashes and one comparison, whatever the number of items.
+ * Unknown keys return -1.
+ ******************************************************************************/
+
+class PathHash
+{
+
+    private:
+
+        std::vector<std::string> fKeys;     // key of each slot
+        std::vector<int> fValues;           // value of each slot
+        std::vector<int> fSeeds;            // seed of each bucket (or -slot-1 for single key buckets)
+
+        static uint32_t hash(uint32_t seed, const char* key, size_t len)
+        {
+            // FNV-1a, then mixed so that all bits depend on the seed
+            uint32_t h = 2166136261u ^ (seed * 16777619u);
+            for (size_t i = 0; i < len; i++) {
+                h = (h ^ uint8_t(key[i])) * 16777619u;
+            }
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35u;
+            h ^= h >> 16;
+            return h;
+        }
+
+    public:
+
+        PathHash() {}
+
+        /**
+         * Build the table.
+         *
+         * @param keys - the keys, all different
+         * @param values - the value of each key
+         */
+        void build(const std::vector<std::string>& keys, const std::vector<int>& values)
+        {
+            size_t size = keys.size();
+            fKeys.assign(size, "");
+            fValues.assign(size, -1);
+            fSeeds.assign(size, 0);
+            if (size == 0) return;
+
+            // Buckets of keys, the largest ones placed first
+            std::vector<std::vector<int> > buckets(size);
+            for (size_t k = 0; k < size; k++) {
+                buckets[hash(0, keys[k].c_str(), keys[k].size()) % size].push_back(int(k));
+            }
+            std::vector<int> order(size);
+            for (size_t b = 0; b < size; b++) order[b] = int(b);
+            std::sort(order.begin(), order.end(), [&buckets](int b1, int b2) { return buckets[b1].size() > buckets[b2].size(); });
+
+            std::vector<bool> used(size, false);
+            size_t b = 0;
+            for (; b < size && buckets[order[b]].size() > 1; b++) {
+                std::vector<int>& bucket = buckets[order[b]];
+                std::vector<size_t> slots;
+                for (uint32_t seed = 1;; seed++) {
+                    slots.clear();
+                    for (auto& k : bucket) {
+                        size_t slot = hash(seed, keys[k].c_str(), keys[k].size()) % size;
+                        if (used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) break;
+                        slots.push_back(slot);
+                    }
+                    if (slots.size() == bucket.size()) {
+                        fSeeds[order[b]] = int(seed);
+                        break;
+                    }
+                }
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    used[slots[i]] = true;
+                    fKeys[slots[i]] = keys[bucket[i]];
+                    fValues[slots[i]] = values[bucket[i]];
+                }
+            }
+
+            // Single key buckets directly take the remaining free slots
+            size_t slot = 0;
+            for (; b < size && buckets[order[b]].size() == 1; b++) {
+                while (used[slot]) slot++;
+                int k = buckets[order[b]][0];
+                used[slot] = true;
+                fKeys[slot] = keys[k];
+                fValues[slot] = values[k];
+                fSeeds[order[b]] = -int(slot) - 1;
+            }
+        }
+
+        int find(const char* key, size_t len) const
+        {
+            size_t size = fKeys.size();
+            if (size == 0) return -1;
+            int seed = fSeeds[hash(0, key, len) % size];
+            size_t slot = (seed < 0) ? size_t(-seed - 1) : hash(uint32_t(seed), key, len) % size;
+            const std::string& found = fKeys[slot];
+            return (found.size() == len && memcmp(found.c_str(), key, len) == 0) ? fValues[slot] : -1;
+        }
+        int find(const char* key) const { return find(key, strlen(key)); }
+        int find(const std::string& key) const { return find(key.c_str(), key.size()); }
+
+};
+
+#endif  // FAUST_PATHHASH_H
+/**************************  END  PathHash.h **************************/
@@ -1845,6 +1845,7 @@ public:
         }
         closeBox();
         clearMetadata();
+        setZonePolled(zone, true);
     }
     
     virtual void addVerticalBargraph(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT min, FAUSTFLOAT max)
@@ -1875,6 +1876,7 @@ public:
         }
         closeBox();
         clearMetadata();
+        setZonePolled(zone, true);
     }
 };
 
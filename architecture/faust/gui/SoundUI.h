@@ -49,6 +49,10 @@ WaveReader gReader;
 #elif defined(MEMORY_READER)
 #include "faust/gui/MemoryReader.h"
 MemoryReader gReader;
+#elif defined(MMAP_READER)
+#include "faust/gui/LibsndfileReader.h"
+#include "faust/gui/MMapSoundfileReader.h"
+MMapSoundfileReader<LibsndfileReader> gReader;
 #else
 #include "faust/gui/LibsndfileReader.h"
 LibsndfileReader gReader;
@@ -105,7 +109,7 @@ class SoundUI : public GenericUI
         {   
             // Delete all soundfiles
             for (auto& it : fSoundfileMap) {
-                delete it.second;
+                fSoundReader->destroySoundfile(it.second);
             }
         }
 
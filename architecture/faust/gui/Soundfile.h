@@ -146,6 +146,54 @@ class SoundfileReader {
         }
     }
     
+    // Compute total length and channels max of all files, completed with empty parts
+    void getParamsFiles(const std::vector<std::string>& path_name_list, int& cur_chan, int& total_length)
+    {
+        cur_chan = 1; // At least one buffer
+        total_length = 0;
+        
+        for (int i = 0; i < int(path_name_list.size()); i++) {
+            int chan, length;
+            if (path_name_list[i] == "__empty_sound__") {
+                length = BUFFER_SIZE;
+                chan = 1;
+            } else {
+                getParamsFile(path_name_list[i], chan, length);
+            }
+            cur_chan = std::max<int>(cur_chan, chan);
+            total_length += length;
+        }
+        
+        // Complete with empty parts
+        total_length += (MAX_SOUNDFILE_PARTS - path_name_list.size()) * BUFFER_SIZE;
+    }
+    
+    // Read all files in the 'soundfile' buffers allocated for 'getParamsFiles' values
+    void readFiles(Soundfile* soundfile, const std::vector<std::string>& path_name_list, int max_chan)
+    {
+        // Init offset
+        int offset = 0;
+        
+        // Read all files
+        for (int i = 0; i < int(path_name_list.size()); i++) {
+            if (path_name_list[i] == "__empty_sound__") {
+                emptyFile(soundfile, i, offset);
+            } else {
+                readFile(soundfile, path_name_list[i], i, offset, max_chan);
+            }
+        }
+        
+        // Complete with empty parts
+        for (int i = int(path_name_list.size()); i < MAX_SOUNDFILE_PARTS; i++) {
+            emptyFile(soundfile, i, offset);
+        }
+        
+        // Share the same buffers for all other channels so that we have max_chan channels available
+        for (int chan = soundfile->fChannels; chan < max_chan; chan++) {
+            soundfile->fBuffers[chan] = soundfile->fBuffers[chan % soundfile->fChannels];
+        }
+    }
+    
     bool isResampling(int sample_rate) { return (fDriverSR > 0 && fDriverSR != sample_rate); }
  
     // To be implemented by subclasses
@@ -220,59 +268,38 @@ class SoundfileReader {
     
     void setSampleRate(int sample_rate) { fDriverSR = sample_rate; }
    
-    Soundfile* createSoundfile(const std::vector<std::string>& path_name_list, int max_chan)
+    /**
+     * Create a soundfile from a list of sound resources, all parts being loaded in memory.
+     *
+     * @param path_name_list - the list of resources path names, as returned by checkFiles
+     * @param max_chan - the number of channels to be accessed by the DSP code
+     *
+     * @return the soundfile on success, otherwise a null pointer.
+     */
+    virtual Soundfile* createSoundfile(const std::vector<std::string>& path_name_list, int max_chan)
     {
         try {
-            int cur_chan = 1; // At least one buffer
-            int total_length = 0;
-            
-            // Compute total length and channels max of all files
-            for (int i = 0; i < int(path_name_list.size()); i++) {
-                int chan, length;
-                if (path_name_list[i] == "__empty_sound__") {
-                    length = BUFFER_SIZE;
-                    chan = 1;
-                } else {
-                    getParamsFile(path_name_list[i], chan, length);
-                }
-                cur_chan = std::max<int>(cur_chan, chan);
-                total_length += length;
-            }
-           
-            // Complete with empty parts
-            total_length += (MAX_SOUNDFILE_PARTS - path_name_list.size()) * BUFFER_SIZE;
+            int cur_chan, total_length;
+            getParamsFiles(path_name_list, cur_chan, total_length);
             
             // Create the soundfile
             Soundfile* soundfile = createSoundfile(cur_chan, total_length, max_chan);
             
-            // Init offset
-            int offset = 0;
-            
             // Read all files
-            for (int i = 0; i < int(path_name_list.size()); i++) {
-                if (path_name_list[i] == "__empty_sound__") {
-                    emptyFile(soundfile, i, offset);
-                } else {
-                    readFile(soundfile, path_name_list[i], i, offset, max_chan);
-                }
-            }
-            
-            // Complete with empty parts
-            for (int i = int(path_name_list.size()); i < MAX_SOUNDFILE_PARTS; i++) {
-                emptyFile(soundfile, i, offset);
-            }
-            
-            // Share the same buffers for all other channels so that we have max_chan channels available
-            for (int chan = cur_chan; chan < max_chan; chan++) {
-                soundfile->fBuffers[chan] = soundfile->fBuffers[chan % cur_chan];
-            }
-            
+            readFiles(soundfile, path_name_list, max_chan);
             return soundfile;
             
         } catch (...) {
             return nullptr;
         }
     }
+    
+    /**
+     * Delete a soundfile created with createSoundfile.
+     *
+     * @param soundfile - the soundfile
+     */
+    virtual void destroySoundfile(Soundfile* soundfile) { delete soundfile; }
 
     // Check if all soundfiles exist and return their real path_name
     std::vector<std::string> checkFiles(const std::vector<std::string>& sound_directories,
@@ -29,6 +29,7 @@
 #include <string>
 #include <algorithm>
 #include <assert.h>
+#include <string.h>
 
 class MapUI;
 
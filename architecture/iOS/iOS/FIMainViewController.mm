@@ -47,7 +47,6 @@ MidiUI* midiinterface = NULL;
 // global static fields
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 @implementation FIMainViewController
 
@@ -103,7 +103,6 @@ using namespace std;
 dsp* DSP;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 //-------------------------------------------------------------------------
 // 									MAIN
@@ -79,7 +79,6 @@ using namespace std;
 /*******************BEGIN ARCHITECTURE SECTION (part 2/2)***************/
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /******************************************************************************
 *******************************************************************************
@@ -87,6 +87,5 @@ static void stopJACKClients(const std::vector<audio*>& chain)
 
 // Globals
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 
@@ -98,7 +98,6 @@ static void osc_compute_callback(void* arg)
 dsp* DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /******************************************************************************
  *******************************************************************************
@@ -659,4 +659,3 @@ void FaustPlugInAudioProcessorEditor::resized()
 
 // Globals
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
@@ -409,5 +409,4 @@ START_JUCE_APPLICATION (FaustAudioApplication)
 
 // Globals
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
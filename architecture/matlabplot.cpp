@@ -76,7 +76,6 @@ using namespace std;
 dsp* DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 #define kFrames 512
 
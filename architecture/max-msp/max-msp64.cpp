@@ -142,7 +142,6 @@ using namespace std;
 #include "faust/dsp/poly-dsp.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 static t_class* faust_class;
 
@@ -87,7 +87,6 @@ using namespace std;
 dsp* DSP;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 //-------------------------------------------------------------------------
 // 									MAIN
@@ -65,7 +65,6 @@
 mydsp DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /******************************************************************************
 *******************************************************************************
@@ -64,7 +64,6 @@
 mydsp DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 /******************************************************************************
 *******************************************************************************
@@ -189,6 +189,7 @@ class Message
         \param addr the address
     */
     void				setAddress(const std::string& addr)		{ fAddress = addr; }
+    void				setAddress(const char* addr)			{ fAddress = addr; }
     /*!
         \brief print the message
         \param out the output stream
@@ -29,6 +29,7 @@
 
 #include "faust/osc/MessageProcessor.h"
 #include "faust/osc/smartpointer.h"
+#include "faust/gui/PathHash.h"
 
 namespace oscfaust
 {
@@ -49,15 +50,24 @@ typedef class SMARTP<MessageDriven>	SMessageDriven;
 	The principle of the dispatch is the following:
 	- first the processMessage() method should be called on the top level node
 	- next processMessage call propose 
+	
+	Addresses without wildcard are directly dispatched along the tree, using
+	a hash table of the subnodes names built once in each node.
 */
 class MessageDriven : public MessageProcessor, public smartable
 {
 	std::string						fName;			///< the node name
 	std::string						fOSCPrefix;		///< the node OSC address prefix (OSCAddress = fOSCPrefix + '/' + fName)
 	std::vector<SMessageDriven>		fSubNodes;		///< the subnodes of the current node
+	PathHash						fIndex;			///< the subnodes names hash table
+	bool							fIndexed;		///< fIndex is up to date
+	bool							fDuplicates;	///< some subnodes have the same name
+
+	void			buildIndex();
+	void			dispatch(const Message* msg, const char* addrTail);
 
 	protected:
-				 MessageDriven(const char *name, const char *oscprefix) : fName (name), fOSCPrefix(oscprefix) {}
+				 MessageDriven(const char *name, const char *oscprefix) : fName (name), fOSCPrefix(oscprefix), fIndexed(false), fDuplicates(false) {}
 		virtual ~MessageDriven() {}
 
 	public:
@@ -117,7 +127,7 @@ class MessageDriven : public MessageProcessor, public smartable
 		*/
 		virtual void	get(unsigned long ipdest, const std::string& what) const {}
 
-		void			add(SMessageDriven node)	{ fSubNodes.push_back (node); }
+		void			add(SMessageDriven node)	{ fSubNodes.push_back (node); fIndexed = false; }
 		const char*		getName() const				{ return fName.c_str(); }
 		std::string		getOSCAddress() const;
 		int				size() const				{ return (int)fSubNodes.size (); }
@@ -21,13 +21,26 @@
 
 */
 
+#include <string.h>
+
 #include "OSCRegexp.h"
 
 namespace oscfaust
 {
 
 //--------------------------------------------------------------------------
-OSCRegexp::OSCRegexp(const char* oscre) : fRegexp (OSCRe2Re(oscre).c_str()) {}
+OSCRegexp::OSCRegexp(const char* oscre) : fIsLiteral(isLiteral(oscre))
+{
+	// literal expressions are simply compared
+	if (fIsLiteral) fLiteral = oscre;
+	else fRegexp.Compile(OSCRe2Re(oscre).c_str());
+}
+
+//--------------------------------------------------------------------------
+bool OSCRegexp::isLiteral (const char* re)
+{
+	return strpbrk(re, "*?[]{}.()+^$|\\") == 0;
+}
 
 //--------------------------------------------------------------------------
 // translates an OSC regexp into a regexp
@@ -53,7 +66,7 @@ std::string OSCRegexp::OSCRe2Re (const char* re)
 //--------------------------------------------------------------------------
 bool OSCRegexp::match (const char* str) const
 {
-	return fRegexp.MatchExact(str) != 0;
+	return fIsLiteral ? (fLiteral == str) : (fRegexp.MatchExact(str) != 0);
 }
 
 }
@@ -39,6 +39,8 @@ namespace oscfaust
 class OSCRegexp
 {
 	CRegexpT<char>	fRegexp;
+	std::string		fLiteral;		///< the expression when it has no special character
+	bool			fIsLiteral;
 	
 	static std::string OSCRe2Re (const char* oscre); // translates an OSC regexp into a regexp
 	public:
@@ -46,6 +48,9 @@ class OSCRegexp
 		virtual ~OSCRegexp() {}
 		
 		bool match (const char* str) const;
+		
+		/// \brief true when the expression has no OSC wildcard nor regexp special character, i.e. only matches itself
+		static bool isLiteral (const char* oscre);
 };
 
 }
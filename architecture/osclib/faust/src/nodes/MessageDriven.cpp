@@ -22,6 +22,9 @@
 */
 
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <string.h>
 
 #include "faust/osc/Message.h"
 #include "faust/osc/MessageDriven.h"
@@ -35,16 +38,121 @@ namespace oscfaust
 {
 
 static const char * kGetMsg = "get";
+#define kMaxRegexps	256
+
+//--------------------------------------------------------------------------
+// compiled regular expressions are kept, each listener thread has its own cache
+// of at most kMaxRegexps entries (only trimmed between messages, since the dispatch
+// keeps pointers to its entries: when full during a message, the new expressions
+// are only kept until the end of the message)
+class RegexpCache
+{
+	map<string, OSCRegexp*> fRegexps;
+	vector<OSCRegexp*> fTemps;
+	int fDepth;
+	public:
+		RegexpCache() : fDepth(0) {}
+		~RegexpCache() { clear(); }
+		void clear()
+		{
+			for (map<string, OSCRegexp*>::iterator i = fRegexps.begin(); i != fRegexps.end(); i++) delete i->second;
+			fRegexps.clear();
+			for (size_t i = 0; i < fTemps.size(); i++) delete fTemps[i];
+			fTemps.clear();
+		}
+		const OSCRegexp* get(const string& oscre)
+		{
+			map<string, OSCRegexp*>::iterator i = fRegexps.find(oscre);
+			if (i != fRegexps.end()) return i->second;
+			OSCRegexp* r = new OSCRegexp(oscre.c_str());
+			if (fRegexps.size() < kMaxRegexps) fRegexps[oscre] = r;
+			else fTemps.push_back(r);
+			return r;
+		}
+		void enter()	{ if ((fDepth++ == 0) && (fRegexps.size() >= kMaxRegexps)) clear(); }
+		void leave()
+		{
+			if (--fDepth == 0) {
+				for (size_t i = 0; i < fTemps.size(); i++) delete fTemps[i];
+				fTemps.clear();
+			}
+		}
+};
+
+static RegexpCache& regexpCache()
+{
+	static thread_local RegexpCache cache;
+	return cache;
+}
 
 //--------------------------------------------------------------------------
 void MessageDriven::processMessage(const Message* msg)
 {
-	const string addr = msg->address();
+	const string& addr = msg->address();
+
+	// addresses without wildcard are directly dispatched
+	if ((addr[0] == '/') && OSCRegexp::isLiteral(addr.c_str())) {
+		const char* first = addr.c_str() + 1;
+		const char* tail = strchr(first, '/');
+		size_t len = tail ? size_t(tail - first) : addr.size() - 1;
+		if ((len == fName.size()) && (fName.compare(0, len, first, len) == 0)) {
+			if (tail) dispatch(msg, tail);
+			else accept(msg);
+		}
+		return;
+	}
 
-	// create a regular expression
-	OSCRegexp r(OSCAddress::addressFirst(addr).c_str());
+	// get a regular expression
+	RegexpCache& cache = regexpCache();
+	cache.enter();
+	const OSCRegexp* r = cache.get(OSCAddress::addressFirst(addr));
 	// and call propose with this regexp and with the dest osc address tail
-	propose(msg, &r, OSCAddress::addressTail(addr));
+	propose(msg, r, OSCAddress::addressTail(addr));
+	cache.leave();
+}
+
+//--------------------------------------------------------------------------
+void MessageDriven::buildIndex()
+{
+	vector<string> names;
+	vector<int> indexes;
+	fDuplicates = false;
+	for (size_t i = 0; i < fSubNodes.size(); i++) {
+		if (find(names.begin(), names.end(), fSubNodes[i]->name()) == names.end()) {
+			names.push_back(fSubNodes[i]->name());
+			indexes.push_back(int(i));
+		} else {
+			fDuplicates = true;
+		}
+	}
+	fIndex.build(names, indexes);
+	fIndexed = true;
+}
+
+//--------------------------------------------------------------------------
+// dispatch a message with a literal address tail to the subnodes
+void MessageDriven::dispatch(const Message* msg, const char* addrTail)
+{
+	if (!fIndexed) buildIndex();
+	const char* first = addrTail + 1;
+	const char* tail = strchr(first, '/');
+	size_t len = tail ? size_t(tail - first) : strlen(first);
+	
+	int i = fIndex.find(first, len);
+	if (i < 0) return;
+	if (fDuplicates) {
+		// all the subnodes with the same name
+		for (size_t j = size_t(i); j < fSubNodes.size(); j++) {
+			MessageDriven* node = fSubNodes[j];
+			if ((node->name().size() == len) && (node->name().compare(0, len, first, len) == 0)) {
+				if (tail) node->dispatch(msg, tail);
+				else node->accept(msg);
+			}
+		}
+	} else {
+		if (tail) fSubNodes[i]->dispatch(msg, tail);
+		else fSubNodes[i]->accept(msg);
+	}
 }
 
 //--------------------------------------------------------------------------
@@ -91,10 +199,11 @@ void MessageDriven::propose(const Message* msg, const OSCRegexp* r, const string
 		if (addrTail.empty()) {			// it matches and the tail is empty
 			accept(msg);				// then call accept()
 		} else {						// it matches but the tail is not empty
-			OSCRegexp rtail (OSCAddress::addressFirst(addrTail).c_str());
+			const OSCRegexp* rtail = regexpCache().get(OSCAddress::addressFirst(addrTail));
+			string tail = OSCAddress::addressTail(addrTail);
 			for (vector<SMessageDriven>::iterator i = fSubNodes.begin(); i != fSubNodes.end(); i++) {
 				// then propagate propose() to subnodes with a new regexp and a new tail
-				(*i)->propose(msg, &rtail, OSCAddress::addressTail(addrTail));
+				(*i)->propose(msg, rtail, tail);
 			}
 		}
 	}
@@ -78,7 +78,9 @@ void OSCListener::run()
 //--------------------------------------------------------------------------
 void OSCListener::ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& src)
 {
-    Message msg = Message(m.AddressPattern());
+    Message& msg = fMsg;
+    msg.setAddress(m.AddressPattern());
+    msg.params().clear();
     msg.setSrcIP(src.address);
     if (fSetDest && (src.address != kLocalhost)) {
         oscout.setAddress(src.address);
@@ -27,6 +27,7 @@
 
 #include "faust/osc/smartpointer.h"
 #include "faust/osc/MessageProcessor.h"
+#include "faust/osc/Message.h"
 
 // oscpack include files
 #include "ip/UdpSocket.h"
@@ -52,6 +53,7 @@ class OSCListener : public osc::OscPacketListener, public smartable
 	bool	fRunning;
 	bool	fSetDest;
 	int		fPort;
+	Message	fMsg;				///< reused for each incoming message (bundle elements are parsed in place by oscpack)
 
 	public:
 		static SMARTP<OSCListener> create(MessageProcessor* mp, int port, const char* bindAddress=0)
@@ -69,7 +69,6 @@
 #include "faust/audio/dummy-audio.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int main(int argc, char* argv[])
 {
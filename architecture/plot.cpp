@@ -75,7 +75,6 @@ using namespace std;
 mydsp DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 #define kFrames 512
 	
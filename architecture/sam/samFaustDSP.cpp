@@ -57,7 +57,6 @@
 #include "samFaustDSP.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 // constructor
 samFaustDSP::samFaustDSP(int sampleRate, int bufferSize, int numInputs, int numOutputs)
@@ -24,6 +24,8 @@
  ************************************************************************/
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include <assert.h>
 #include <pthread.h>
 #include <stdio.h>
@@ -31,12 +33,25 @@
 #include <string.h>
 #include <semaphore.h>
 #include <sys/types.h>
-#include <sys/sysctl.h>
 #include <sys/stat.h>
-#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <math.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#include <sys/sysctl.h>
+#endif
 
 // For AVOIDDENORMALS
 #include "faust/dsp/dsp.h"
@@ -60,12 +75,12 @@ static int GetPID()
 #define LAST_TASK_INDEX 1
 
 #define MASTER_THREAD 0
-#define MAX_STEAL_DUR 50                        // in usec
-#define DEFAULT_CLOCKS_PER_SEC 2500000000       // in cycles (2,5 Ghz)
+#define MAX_STEAL_DUR 50                        // in usec, spinning duration before an idle worker parks
+#define TINY_TASK_DUR 1000                      // in nsec, cheaper tasks are not published to thieves
+#define MIN_PARALLEL_WORK 20                    // in usec, DAG iteration cost under which a single thread is used
 #define JACK_SCHED_POLICY SCHED_FIFO
-#define KDSPMESURE 50
-
-#define MEAN_TRESHOLD 0.1f   // in percentage
+#define KDSPMESURE 50                           // number of cycles between two adaptations of the number of threads
+#define CACHE_LINE_SIZE 64
 
 #ifdef __ICC
     #define INLINE __forceinline
@@ -105,15 +120,6 @@ static int GetPID()
   (at your option) any later version.
 
   This program is distributed in the hope that it will be useful,
-static int GetPID()
-{
-#ifdef WIN32
-    return _getpid();
-#else
-    return getpid();
-#endif
-}
-
   but WITHOUT ANY WARRANTY; without even the implied warranty of
   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
   GNU General Public License for more details.
@@ -279,108 +285,6 @@ inline bool Semaphore::try_wait()
 #include <libkern/OSAtomic.h>
 #endif
 
-static void Yield();
-
-/**
- * Returns the number of clock cycles elapsed since the last reset
- * of the processor
- */
-static INLINE UInt64 DSP_rdtsc(void)
-{
-	union {
-		UInt32 i32[2];
-		UInt64 i64;
-	} count;
-	
-	__asm__ __volatile__("rdtsc" : "=a" (count.i32[0]), "=d" (count.i32[1]));
-    return count.i64;
-}
-
-#if defined(__i386__) || defined(__x86_64__)
-
-#define LOCK "lock ; "
-
-static INLINE void NOP(void)
-{
-    /*
-    #ifndef __APPLE__
-	__asm__ __volatile__("nop \n\t");
-    #endif
-    */
-}
-
-static INLINE char CAS1(volatile void* addr, volatile int value, int newvalue)
-{
-    return __sync_bool_compare_and_swap((int*)addr, value, newvalue);
-}
-
-static INLINE int atomic_xadd(volatile int* atomic, int val) 
-{ 
-     return __sync_add_and_fetch(atomic, val);
-} 
-
-#endif
-
-/*
-static INLINE int INC_ATOMIC(volatile int* val)
-{
-    int actual;
-    do {
-        actual = *val;
-    } while (!CAS1(val, actual, actual + 1));
-    return actual;
-}
-
-static INLINE int DEC_ATOMIC(volatile int* val)
-{
-    int actual;
-    do {
-        actual = *val;
-    } while (!CAS1(val, actual, actual - 1));
-    return actual;
-}
-*/
-
-static INLINE int INC_ATOMIC(volatile int* val)
-{
-    return atomic_xadd(val, 1);
-}
- 
-static INLINE int DEC_ATOMIC(volatile int* val)
-{
-    return atomic_xadd(val, -1);
-}
- 
-// To be used in lock-free queue
-struct AtomicCounter 
-{
-    union {
-        struct {
-            short fHead;	
-            short fTail;	
-        } scounter;
-        int fValue;
-    } info;
-    
-    INLINE AtomicCounter()
-	{
-        info.fValue = 0;
-    }
-      
- 	INLINE AtomicCounter& operator=(AtomicCounter& obj)
-    {
-        info.fValue = obj.info.fValue;
-        return *this;
-    }
-    
-	INLINE AtomicCounter& operator=(volatile AtomicCounter& obj)
-	{
-        info.fValue = obj.info.fValue;
-        return *this;
-    }
-    
-};
-
 /* use 512KB stack per thread - the default is way too high to be feasible
  * with mlockall() on many systems */
 #define THREAD_STACK 524288
@@ -561,17 +465,6 @@ static void SetRealTime()
     SetThreadToPriority(pthread_self(), 96, true, gPeriod, gComputation, gConstraint);
 }
 
-static void CancelThread(pthread_t fThread)
-{
-    mach_port_t machThread = pthread_mach_thread_np(fThread);
-    thread_terminate(machThread);
-}
-
-static void Yield()
-{
-    //sched_yield();
-}
-
 int get_max_cpu()
 {
     int physical_count = 0;
@@ -584,10 +477,18 @@ int get_max_cpu()
 
 #endif
 
+struct CPUInfo {
+    int fCPU;
+    int fNode;
+    int fPackage;
+    int fCore;
+    int fSibling;   // rank of the hardware thread in its core
+};
+
 #ifdef __linux__
 
 static int faust_sched_policy = -1;
-static struct sched_param faust_rt_param; 
+static struct sched_param faust_rt_param;
 
 void GetRealTime()
 {
@@ -603,29 +504,123 @@ static void SetRealTime()
     pthread_setschedparam(pthread_self(), faust_sched_policy, &faust_rt_param);
 }
 
-static void CancelThread(pthread_t fThread)
+static void get_affinity(pthread_t thread) {}
+
+// 'tag' is a CPU number here, as given by get_cpu_order
+static void set_affinity(pthread_t thread, int tag)
 {
-    pthread_cancel(fThread);
-    pthread_join(fThread, NULL);
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(tag, &cpu_set);
+    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpu_set);
 }
 
-static void Yield()
+int get_max_cpu()
 {
-    pthread_yield();
+    // CPUs the process is allowed to run on (taskset, cgroups...)
+    cpu_set_t cpu_set;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) {
+        return CPU_COUNT(&cpu_set);
+    } else {
+        return sysconf(_SC_NPROCESSORS_ONLN);
+    }
 }
 
-// TODO
-static UInt64 GetMicroSeconds(void)
-{	
-    return 0;
+static int read_cpu_topology(int cpu, const char* name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE* file = fopen(path, "r");
+    int res = 0;
+    if (file) {
+        if (fscanf(file, "%d", &res) != 1) res = 0;
+        fclose(file);
+    }
+    return res;
 }
 
-static void get_affinity(pthread_t thread) {}
-static void set_affinity(pthread_t thread, int tag) {}
+static int read_cpu_node(int cpu)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    int node = 0;
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir))) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &node) == 1) {
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return node;
+}
 
-int get_max_cpu()
+/*
+    Allowed CPUs, in the order threads are placed on them: first the CPU the calling thread runs on,
+    then one hardware thread per physical core on the same NUMA node, then the other nodes,
+    and the remaining hyperthreads last.
+*/
+static void get_cpu_order(std::vector<CPUInfo>& order)
+{
+    cpu_set_t cpu_set;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) != 0) {
+        return;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpu_set)) {
+            CPUInfo info;
+            info.fCPU = cpu;
+            info.fNode = read_cpu_node(cpu);
+            info.fPackage = read_cpu_topology(cpu, "physical_package_id");
+            info.fCore = read_cpu_topology(cpu, "core_id");
+            info.fSibling = 0;
+            for (size_t i = 0; i < order.size(); i++) {
+                if (order[i].fPackage == info.fPackage && order[i].fCore == info.fCore) info.fSibling++;
+            }
+            order.push_back(info);
+        }
+    }
+
+    int cur_cpu = sched_getcpu();
+    int cur_node = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i].fCPU == cur_cpu) cur_node = order[i].fNode;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [cur_cpu, cur_node](const CPUInfo& a, const CPUInfo& b) {
+        if ((a.fCPU == cur_cpu) != (b.fCPU == cur_cpu)) return a.fCPU == cur_cpu;
+        if (a.fSibling != b.fSibling) return a.fSibling < b.fSibling;
+        if ((a.fNode == cur_node) != (b.fNode == cur_node)) return a.fNode == cur_node;
+        return a.fNode < b.fNode;
+    });
+}
+
+/*
+    Idle threads are parked on a futex.
+*/
+static INLINE void futex_wait(std::atomic<int>* addr, int value)
 {
-    return sysconf(_SC_NPROCESSORS_ONLN);
+    syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static INLINE void futex_wake(std::atomic<int>* addr, int count)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+#endif
+
+#ifndef __linux__
+
+// Without topology information, threads are placed using affinity tags
+static void get_cpu_order(std::vector<CPUInfo>& order)
+{
+    for (int cpu = 0; cpu < get_max_cpu(); cpu++) {
+        CPUInfo info = { cpu + 1, 0, 0, cpu, 0 };
+        order.push_back(info);
+    }
 }
 
 #endif
@@ -641,424 +636,454 @@ static INLINE int Range(int min, int max, int val)
     }
 }
 
+static INLINE int GetEnv(const char* name, int def)
+{
+    return getenv(name) ? int(strtol(getenv(name), NULL, 10)) : def;
+}
+
+static INLINE uint64_t GetNanoSeconds()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// To be used in spinning loops
+static INLINE void Pause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
 #if defined(LLVM_50) || defined(LLVM_40) || defined(LLVM_39) || defined(LLVM_38) || defined(LLVM_37) || defined(LLVM_36) || defined(LLVM_35) || defined(LLVM_34)
     extern "C" void computeThreadExternal(void* dsp, int num_thread) __attribute__((weak_import));
 #else
     void computeThreadExternal(void* dsp, int num_thread);
 #endif
 
-class DynThreadAdapter {
-    
+/**
+ * Parks threads without missing wake-ups: a thread calls PrepareWait, checks its wake-up
+ * condition again, then calls either CancelWait or Wait.
+ * Notify only costs a fence and a load when no thread is parked.
+ */
+class EventCount
+{
     private:
-        
-        UInt64 fTiming[KDSPMESURE];
-        UInt64 fStart;
-        UInt64 fStop;
-        int fCounter;
-        float fOldMean;
-        int fOldfDynamicNumThreads;
-        bool fDynAdapt;
-        
-        INLINE float ComputeMean()
+
+        std::atomic<int> fEpoch;
+        std::atomic<int> fWaiters;
+    #ifndef __linux__
+        std::mutex fMutex;
+        std::condition_variable fCond;
+    #endif
+
+    public:
+
+        EventCount():fEpoch(0), fWaiters(0)
+        {}
+
+        INLINE int PrepareWait()
         {
-            float mean = 0;
-            for (int i = 0; i < KDSPMESURE; i++) {
-                mean += float(fTiming[i]);
-            }
-            mean /= float(KDSPMESURE);
-            return mean;
+            fWaiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return fEpoch.load();
         }
-    
-    public :
-    
-        DynThreadAdapter():fCounter(0), fOldMean(1000000000.f), fOldfDynamicNumThreads(1)
+
+        INLINE void CancelWait()
         {
-            memset(fTiming, 0, sizeof(long long int ) * KDSPMESURE);
-            fDynAdapt = getenv("OMP_DYN_THREAD") ? strtol(getenv("OMP_DYN_THREAD"), NULL, 10) : false;
+            fWaiters.fetch_sub(1);
         }
-        
-        INLINE void StartMeasure()
+
+        void Wait(int epoch)
         {
-            if (fDynAdapt) {
-                //fStart = DSP_rdtsc();
-                fStart = GetMicroSeconds();
+        #ifdef __linux__
+            while (fEpoch.load() == epoch) {
+                futex_wait(&fEpoch, epoch);
             }
+        #else
+            std::unique_lock<std::mutex> lock(fMutex);
+            while (fEpoch.load() == epoch) {
+                fCond.wait(lock);
+            }
+        #endif
+            fWaiters.fetch_sub(1);
         }
-         
-        INLINE void StopMeasure(int staticthreadnum, int& dynthreadnum)
+
+        INLINE void Notify(bool all)
         {
-            if (!fDynAdapt) {
-                return;
-            }
-            
-            //fStop = DSP_rdtsc();
-            fStop = GetMicroSeconds();
-            fCounter = (fCounter + 1) % KDSPMESURE;
-            if (fCounter == 0) {
-                float mean = ComputeMean();
-                // Recompute dynthreadnum is timing différence is sufficient...
-                //printf("mean = %f fOldMean = %f\n", mean, fOldMean);
-                if (fabs(mean - fOldMean) / fOldMean > MEAN_TRESHOLD) {
-                    if (mean > fOldMean) { // Worse...
-                        if (fOldfDynamicNumThreads > dynthreadnum) {
-                            fOldfDynamicNumThreads = dynthreadnum;
-                            dynthreadnum += 1;
-                        } else {
-                            fOldfDynamicNumThreads = dynthreadnum;
-                            dynthreadnum -= 1;
-                        }
-                     } else { // Better...
-                        if (fOldfDynamicNumThreads > dynthreadnum) {
-                            fOldfDynamicNumThreads = dynthreadnum;
-                            dynthreadnum -= 1;
-                        } else {
-                            fOldfDynamicNumThreads = dynthreadnum;
-                            dynthreadnum += 1;
-                        }
-                    }
-                    fOldMean = mean;
-                    dynthreadnum = Range(1, staticthreadnum, dynthreadnum);
-                    //printf("dynthreadnum = %d\n", dynthreadnum);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (fWaiters.load(std::memory_order_relaxed) > 0) {
+            #ifdef __linux__
+                fEpoch.fetch_add(1);
+                futex_wake(&fEpoch, all ? INT_MAX : 1);
+            #else
+                {
+                    std::lock_guard<std::mutex> lock(fMutex);
+                    fEpoch.fetch_add(1);
+                }
+                if (all) {
+                    fCond.notify_all();
+                } else {
+                    fCond.notify_one();
                 }
+            #endif
             }
-            // And keep computation time
-            fTiming[fCounter] = fStop - fStart; 
         }
+
 };
 
-#define Value(e) (e).info.fValue
+/**
+ * Chase-Lev work stealing deque: the owner thread pushes and pops at the bottom,
+ * other threads steal at the top. Tasks too cheap to be worth a steal are kept
+ * in a separate list only seen by the owner.
+ */
+class TaskQueue
+{
+    private:
 
-#define Head(e) (e).info.scounter.fHead
-#define IncHead(e) (e).info.scounter.fHead++
-#define DecHead(e) (e).info.scounter.fHead--
+        std::atomic<int>* fTaskList;    // size is a power of two
+        int fMask;
+        int* fLocalList;
+        int fLocalSize;
 
-#define Tail(e) (e).info.scounter.fTail
-#define IncTail(e) (e).info.scounter.fTail++
-#define DecTail(e) (e).info.scounter.fTail--
+        char fPad0[CACHE_LINE_SIZE];
+        std::atomic<int64_t> fTop;
+        char fPad1[CACHE_LINE_SIZE];
+        std::atomic<int64_t> fBottom;
+        char fPad2[CACHE_LINE_SIZE];
 
-class TaskQueue 
-{
-    private:
-    
-        int* fTaskList;
-        int fTaskQueueSize;
-        volatile AtomicCounter fCounter;
-        
-        UInt64 fStealingStart;
-        UInt64 fMaxStealing;
-     
     public:
-  
-        INLINE TaskQueue()
+
+        TaskQueue():fTaskList(NULL), fMask(0), fLocalList(NULL), fLocalSize(0), fTop(0), fBottom(0)
         {}
-        
-        INLINE void Init(int task_queue_size)
-        {
-            fTaskQueueSize = task_queue_size;
-            fTaskList = new int[fTaskQueueSize];
-            for (int i = 0; i < fTaskQueueSize; i++) {
-                fTaskList[i] = -1;
-            }
-            fStealingStart = 0;
-             
-            int clock_per_microsec = (getenv("CLOCKSPERSEC") 
-                ? strtoll(getenv("CLOCKSPERSEC"), NULL, 10) 
-                : DEFAULT_CLOCKS_PER_SEC) / 1000000;
-                
-            fMaxStealing = getenv("OMP_STEALING_DUR") 
-                ? strtoll(getenv("OMP_STEALING_DUR"), NULL, 10) * clock_per_microsec 
-                : MAX_STEAL_DUR * clock_per_microsec;
-        }
-        
-        INLINE ~TaskQueue()
+
+        ~TaskQueue()
         {
             delete[] fTaskList;
+            delete[] fLocalList;
         }
-         
-        INLINE void InitOne()
+
+        void Init(int task_queue_size)
         {
-            for (int i = 0; i < fTaskQueueSize; i++) {
-                fTaskList[i] = -1;
+            // A task is queued at most once in each DAG iteration
+            int size = 1;
+            while (size < task_queue_size) {
+                size <<= 1;
             }
-            fCounter.info.fValue = 0;
-            fStealingStart = 0;
+            fTaskList = new std::atomic<int>[size];
+            fMask = size - 1;
+            fLocalList = new int[task_queue_size];
+            InitOne();
         }
-        
-        INLINE void PushHead(int item)
+
+        // To be called when no thread is running
+        void InitOne()
         {
-            fTaskList[Head(fCounter)] = item;
-            IncHead(fCounter);
+            fTop.store(0);
+            fBottom.store(0);
+            fLocalSize = 0;
         }
-        
-        INLINE int PopHead()
+
+        INLINE void PushHead(int item)
         {
-            AtomicCounter old_val;
-            AtomicCounter new_val;
-            
-            do {
-                old_val = fCounter;
-                new_val = old_val;
-                if (Head(old_val) == Tail(old_val)) {
-                    return WORK_STEALING_INDEX;
-                } else {
-                    DecHead(new_val);
-                }
-            } while (!CAS1(&fCounter, Value(old_val), Value(new_val)));
-            
-            return fTaskList[Head(old_val) - 1];
+            int64_t b = fBottom.load(std::memory_order_relaxed);
+            fTaskList[b & fMask].store(item, std::memory_order_relaxed);
+            fBottom.store(b + 1, std::memory_order_release);
         }
-        
-        INLINE int PopTail()
-        {   
-            AtomicCounter old_val;
-            AtomicCounter new_val;
-
-            do {
-                old_val = fCounter;
-                new_val = old_val;
-                if (Head(old_val) == Tail(old_val)) {
-                    return WORK_STEALING_INDEX;
-                } else {
-                    IncTail(new_val);
-                }
-            } while (!CAS1(&fCounter, Value(old_val), Value(new_val)));
 
-            return fTaskList[Tail(old_val)];
+        INLINE void PushLocal(int item)
+        {
+            fLocalList[fLocalSize++] = item;
         }
 
-		INLINE void MeasureStealingDur()
-		{
-            // Takes first timestamp
-            if (fStealingStart == 0) {
-                fStealingStart = DSP_rdtsc();
-            } else if ((DSP_rdtsc() - fStealingStart) > fMaxStealing) {
-                Yield();
-            }
-		}
-
-		INLINE void ResetStealingDur()
-		{
-            fStealingStart = 0;
-		}
-           
-        static INLINE int GetNextTask(TaskQueue* task_queue_list, int cur_thread, int num_threads)
+        // Owner side
+        INLINE int PopHead()
         {
-            int tasknum;
-            for (int i = 0; i < num_threads; i++) {
-                if ((tasknum = task_queue_list[i].PopTail()) != WORK_STEALING_INDEX) {
-                #ifdef __linux__
-                    //if (cur_thread != MASTER_THREAD)
-                        task_queue_list[cur_thread].ResetStealingDur();
-                #endif
-                    return tasknum;    // Task is found
+            if (fLocalSize > 0) {
+                return fLocalList[--fLocalSize];
+            }
+
+            int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+            fBottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = fTop.load(std::memory_order_relaxed);
+
+            int item = WORK_STEALING_INDEX;
+            if (t <= b) {
+                item = fTaskList[b & fMask].load(std::memory_order_relaxed);
+                if (t == b) {
+                    // Last item: race with thieves
+                    if (!fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        item = WORK_STEALING_INDEX;
+                    }
+                    fBottom.store(b + 1, std::memory_order_relaxed);
                 }
+            } else {
+                fBottom.store(b + 1, std::memory_order_relaxed);
             }
-            //NOP();
-        #ifdef __linux__
-			//if (cur_thread != MASTER_THREAD)
-                task_queue_list[cur_thread].MeasureStealingDur();
-        #endif
-            return WORK_STEALING_INDEX;    // Otherwise will try "workstealing" again next cycle...
+            return item;
         }
-         
-        INLINE void InitTaskList(int task_list_size, int* task_list, int thread_num, int cur_thread)
+
+        // Thief side
+        INLINE int PopTail()
         {
-            int task_slice = task_list_size / thread_num;
-            int task_slice_rest = task_list_size % thread_num;
-            
-            // cur_thread takes it's slice of tasks
-            for (int index = 0; index < task_slice; index++) {
-                PushHead(task_list[cur_thread * task_slice + index]);
-            }
-            
-            // Thread 0 takes remaining ready tasks 
-            if (cur_thread == 0) {
-                for (int index = 0; index < task_slice_rest; index++) {
-                    PushHead(task_list[thread_num * task_slice + index]);
+            int64_t t = fTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = fBottom.load(std::memory_order_acquire);
+
+            if (t < b) {
+                int item = fTaskList[t & fMask].load(std::memory_order_relaxed);
+                if (fTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return item;
                 }
             }
+            return WORK_STEALING_INDEX;
         }
-        
-        static INLINE void InitAll(TaskQueue* task_queue_list, int num_threads)
+
+        INLINE bool CanSteal()
         {
-            for (int i = 0; i < num_threads; i++) {
-                task_queue_list[i].InitOne();
-            }
+            return fBottom.load(std::memory_order_relaxed) > fTop.load(std::memory_order_relaxed);
         }
-     
+
 };
 
-class TaskGraph 
+class TaskGraph
 {
     private:
-    
-        volatile int* fTaskList;
+
+        std::atomic<int>* fTaskList;    // number of inputs still to be computed
         int fTaskQueueSize;
-        
+
     public:
-    
+
         TaskGraph(int task_queue_size)
         {
             fTaskQueueSize = task_queue_size;
-            fTaskList = new int[fTaskQueueSize];
+            fTaskList = new std::atomic<int>[fTaskQueueSize];
             for (int i = 0; i < fTaskQueueSize; i++) {
-                fTaskList[i] = 0;
-            } 
+                fTaskList[i].store(0);
+            }
         }
-        
-        INLINE ~TaskGraph()
+
+        ~TaskGraph()
         {
             delete[] fTaskList;
         }
 
         INLINE void InitTask(int task, int val)
         {
-            fTaskList[task] = val;
+            fTaskList[task].store(val, std::memory_order_release);
         }
-        
+
+        // Returns true when the last input of 'task' has been computed
+        INLINE bool ActivateTask(int task)
+        {
+            return fTaskList[task].fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+
         void Display()
         {
             for (int i = 0; i < fTaskQueueSize; i++) {
-                printf("Task = %d activation = %d\n", i, fTaskList[i]);
-            } 
+                printf("Task = %d activation = %d\n", i, fTaskList[i].load());
+            }
         }
-          
-        INLINE void ActivateOutputTask(TaskQueue& queue, int task, int* tasknum)
+
+};
+
+/**
+ * Task costs and task graph, learned while running.
+ * The cost of a task is the time between the moment the scheduler hands it to a thread
+ * and the moment this thread comes back to the scheduler, so it includes the tasks directly
+ * chained by the generated code. Edges are recorded when a task activates another one.
+ * Costs and edges are written by the threads running the DAG, and read by the adaptation
+ * thread which computes the critical path, so they are all atomic.
+ */
+class TaskCostModel
+{
+    private:
+
+        int fTaskQueueSize;
+        std::atomic<int>* fCost;    // moving average in nsec, -1 when unknown
+        std::atomic<char>* fEdges;  // fEdges[from * fTaskQueueSize + to]
+        int64_t* fPath;             // longest path from each task, -1 when not yet computed (only used by GetCriticalPath)
+
+        int64_t LongestPath(int task)
         {
-            if (DEC_ATOMIC(&fTaskList[task]) == 0) {
-                if (*tasknum == WORK_STEALING_INDEX) {
-                    *tasknum = task;
-                } else {
-                    queue.PushHead(task);
+            if (fPath[task] >= 0) {
+                return fPath[task];
+            }
+            fPath[task] = 0;    // breaks cycles
+            int64_t next = 0;
+            for (int i = 0; i < fTaskQueueSize; i++) {
+                if (fEdges[task * fTaskQueueSize + i].load(std::memory_order_relaxed)) {
+                    next = std::max(next, LongestPath(i));
                 }
-            }    
-        }
-          
-        INLINE void ActivateOutputTask(TaskQueue& queue, int task)
-        {   
-            if (DEC_ATOMIC(&fTaskList[task]) == 0) {
-                queue.PushHead(task);
             }
+            fPath[task] = std::max(0, fCost[task].load(std::memory_order_relaxed)) + next;
+            return fPath[task];
         }
-         
-        INLINE void ActivateOneOutputTask(TaskQueue& queue, int task, int* tasknum)
-        {   
-            if (DEC_ATOMIC(&fTaskList[task]) == 0) {
-                *tasknum = task;
-            } else {
-                *tasknum = queue.PopHead(); 
+
+    public:
+
+        TaskCostModel(int task_queue_size):fTaskQueueSize(task_queue_size)
+        {
+            fCost = new std::atomic<int>[fTaskQueueSize];
+            for (int i = 0; i < fTaskQueueSize; i++) {
+                fCost[i].store(-1);
             }
+            fEdges = new std::atomic<char>[fTaskQueueSize * fTaskQueueSize];
+            for (int i = 0; i < fTaskQueueSize * fTaskQueueSize; i++) {
+                fEdges[i].store(0);
+            }
+            fPath = new int64_t[fTaskQueueSize];
         }
-        
-        INLINE void GetReadyTask(TaskQueue& queue, int* tasknum)
+
+        ~TaskCostModel()
         {
-            if (*tasknum == WORK_STEALING_INDEX) {
-                *tasknum = queue.PopHead();
-            }
+            delete[] fCost;
+            delete[] fEdges;
+            delete[] fPath;
         }
-        
-};
 
-class DSPThread;
+        INLINE void AddCost(int task, uint64_t duration)
+        {
+            int cost = fCost[task].load(std::memory_order_relaxed);
+            int dur = int(std::min<uint64_t>(duration, INT_MAX));
+            fCost[task].store((cost < 0) ? dur : cost + (dur - cost) / 8, std::memory_order_relaxed);
+        }
 
-class DSPThreadPool {
-    
-    private:
-    
-        DSPThread** fThreadPool;
-        int fThreadCount; 
-        volatile int fCurThreadCount;
-      
-    public:
-        
-        DSPThreadPool(int thread_pool_size);
-        ~DSPThreadPool();
-    
-        void StartAll(int num_thread, bool realtime, void* dsp);
-       
-        void StopAll();
-      
-        void SignalAll(int num_thread);
-        
-        void SignalOne()
+        INLINE bool IsTiny(int task, int tiny_cost)
+        {
+            int cost = fCost[task].load(std::memory_order_relaxed);
+            return (cost >= 0) && (cost < tiny_cost);
+        }
+
+        INLINE void AddEdge(int from, int to)
+        {
+            std::atomic<char>& edge = fEdges[from * fTaskQueueSize + to];
+            if (!edge.load(std::memory_order_relaxed)) {
+                edge.store(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Cost of one DAG iteration on a single thread
+        int64_t GetWork()
         {
-            DEC_ATOMIC(&fCurThreadCount);
+            int64_t work = 0;
+            for (int i = 0; i < fTaskQueueSize; i++) {
+                work += std::max(0, fCost[i].load(std::memory_order_relaxed));
+            }
+            return work;
         }
 
-        bool IsFinished()
+        // Cost of one DAG iteration with an unlimited number of threads, in O(tasks^2): not to be called by the audio threads
+        int64_t GetCriticalPath()
         {
-            return (fCurThreadCount == 0);
+            for (int i = 0; i < fTaskQueueSize; i++) {
+                fPath[i] = -1;
+            }
+            int64_t path = 0;
+            for (int i = 0; i < fTaskQueueSize; i++) {
+                path = std::max(path, LongestPath(i));
+            }
+            return path;
         }
 
 };
 
+struct ThreadState
+{
+    int fCurTask;               // task handed by the scheduler and still running, or WORK_STEALING_INDEX
+    uint64_t fTaskStart;
+    uint64_t fIdleStart;        // 0 when running a task
+    uint64_t fSpinStart;
+    uint64_t fCycleStart;
+
+    std::vector<int> fVictims;  // other threads, the ones on the same NUMA node first
+    int fNearVictims;
+    int fVictimIndex;
+
+    // Statistics
+    uint64_t fTasks;
+    uint64_t fSteals;
+    uint64_t fFailedSteals;
+    uint64_t fParks;
+    uint64_t fIdleTime;
+    uint64_t fCycleTime;
+
+    char fPad[CACHE_LINE_SIZE];
+
+    ThreadState()
+        :fCurTask(WORK_STEALING_INDEX), fTaskStart(0), fIdleStart(0), fSpinStart(0), fCycleStart(0),
+        fNearVictims(0), fVictimIndex(0),
+        fTasks(0), fSteals(0), fFailedSteals(0), fParks(0), fIdleTime(0), fCycleTime(0)
+    {}
+};
+
+class WorkStealingScheduler;
+
 class DSPThread {
 
     private:
-    
+
         pthread_t fThread;
-        DSPThreadPool* fThreadPool;
+        WorkStealingScheduler* fScheduler;
         Semaphore fSemaphore;
         bool fRealTime;
         int fNumThread;
-        void* fDSP;
-        
+
         static void* ThreadHandler(void* arg)
         {
             DSPThread* thread = static_cast<DSPThread*>(arg);
-            
+
             AVOIDDENORMALS;
             get_affinity(thread->fThread);
 
             // One "dummy" cycle to setup thread
             if (thread->fRealTime) {
-                thread->Run();
+                if (!thread->Run()) {
+                    return NULL;
+                }
                 SetRealTime();
             }
-                      
-            while (true) {
-                thread->Run();
-            }
-            
+
+            while (thread->Run()) {}
             return NULL;
         }
-    
-    public: 
-    
-        DSPThread(int num_thread, DSPThreadPool* pool, void* dsp)
-            :fThreadPool(pool), fSemaphore(0), fRealTime(false), fNumThread(num_thread), fDSP(dsp) 
+
+    public:
+
+        DSPThread(int num_thread, WorkStealingScheduler* scheduler)
+            :fScheduler(scheduler), fSemaphore(0), fRealTime(false), fNumThread(num_thread)
         {}
 
         virtual ~DSPThread()
         {}
-        
-        void Run()
-        {
-            fSemaphore.wait();
-            computeThreadExternal(fDSP, fNumThread + 1);
-            //fThreadPool->SignalOne();
-        }
-                
+
+        // Returns false when the thread has to quit
+        bool Run();
+
         void Signal()
         {
             fSemaphore.post();
         }
-        
-        int Start(bool realtime)
+
+        int Start(bool realtime, int cpu)
         {
             pthread_attr_t attributes;
             struct sched_param rt_param;
             pthread_attr_init(&attributes);
-            
+
             int priority = 60; // TODO
             int res;
-            
+
             if (realtime) {
                 fRealTime = true;
             }else {
                 fRealTime = getenv("OMP_REALTIME") ? strtol(getenv("OMP_REALTIME"), NULL, 10) : true;
             }
-                                   
+
             if ((res = pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_JOINABLE))) {
                 printf("Cannot request joinable thread creation for real-time thread res = %d err = %s\n", res, strerror(errno));
                 return -1;
@@ -1070,17 +1095,17 @@ class DSPThread {
             }
 
             if (realtime) {
-                
+
                 if ((res = pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED))) {
                     printf("Cannot request explicit scheduling for RT thread res = %d err = %s\n", res, strerror(errno));
                     return -1;
                 }
-            
+
                 if ((res = pthread_attr_setschedpolicy(&attributes, JACK_SCHED_POLICY))) {
                     printf("Cannot set RR scheduling class for RT thread res = %d err = %s\n", res, strerror(errno));
                     return -1;
                 }
-                
+
                 memset(&rt_param, 0, sizeof(rt_param));
                 rt_param.sched_priority = priority;
 
@@ -1090,220 +1115,568 @@ class DSPThread {
                 }
 
             } else {
-                
+
                 if ((res = pthread_attr_setinheritsched(&attributes, PTHREAD_INHERIT_SCHED))) {
                     printf("Cannot request explicit scheduling for RT thread res = %d err = %s\n", res, strerror(errno));
                     return -1;
                 }
             }
-         
+
             if ((res = pthread_attr_setstacksize(&attributes, THREAD_STACK))) {
                 printf("Cannot set thread stack size res = %d err = %s\n", res, strerror(errno));
                 return -1;
             }
-            
+
             if ((res = pthread_create(&fThread, &attributes, ThreadHandler, this))) {
-                printf("Cannot create thread res = %d err = %s\n", res, strerror(errno));
-                return -1;
+                // Real-time scheduling may not be allowed, so try again with the default one
+                if (!realtime || (res = pthread_attr_setinheritsched(&attributes, PTHREAD_INHERIT_SCHED))
+                    || (res = pthread_create(&fThread, &attributes, ThreadHandler, this))) {
+                    printf("Cannot create thread res = %d err = %s\n", res, strerror(errno));
+                    return -1;
+                }
             }
-            
+
             // Set affinity
-            set_affinity(fThread, fNumThread + 1);
+            if (cpu >= 0) {
+                set_affinity(fThread, cpu);
+            }
 
             pthread_attr_destroy(&attributes);
             return 0;
         }
-        
+
         void Stop()
         {
-            CancelThread(fThread);
+            Signal();
+            pthread_join(fThread, NULL);
         }
 
 };
 
-DSPThreadPool::DSPThreadPool(int thread_pool_size)
-{
-    fThreadPool = new DSPThread*[thread_pool_size];
-    for (int i = 0; i < thread_pool_size; i++) {
-        fThreadPool[i] = NULL;
-    }
-    fThreadCount = 0;
-    fCurThreadCount = 0;
-}
-
-DSPThreadPool::~DSPThreadPool()
-{
-    StopAll();
-    
-    for (int i = 0; i < fThreadCount; i++) {
-        delete(fThreadPool[i]);
-        fThreadPool[i] = NULL;
-    }
-    
-    fThreadCount = 0;
-    delete[] fThreadPool;
-}
-
-void DSPThreadPool::StartAll(int num_thread, bool realtime, void* dsp)
-{
-    if (fThreadCount == 0) {  // Protection for multiple call...  (like LADSPA plug-ins in Ardour)
-        for (int i = 0; i < num_thread; i++) {
-            fThreadPool[i] = new DSPThread(i, this, dsp);
-            fThreadPool[i]->Start(realtime);
-            fThreadCount++;
-        }
-    }
-}
-
-void DSPThreadPool::StopAll()
-{
-    for (int i = 0; i < fThreadCount; i++) {
-        fThreadPool[i]->Stop();
-    }
-}
-
-void DSPThreadPool::SignalAll(int num_thread)
-{
-    fCurThreadCount = num_thread;
-     
-    for (int i = 0; i < num_thread; i++) {  // Important : use local num here...
-        fThreadPool[i]->Signal();
-    }
-}
-
 /*
     Public C++ interface
+
+    The master thread (the one calling 'compute') and the worker threads run 'computeThread',
+    which asks the scheduler for tasks. Idle threads spin for OMP_STEALING_DUR usec, then park until
+    a task can be stolen or the last DAG iteration is done. The number of threads used (at most OMP_NUM_THREADS)
+    is adapted every KDSPMESURE cycles from the measured work and critical path of the DAG, unless OMP_DYN_THREAD=0.
+    The critical path is computed by a separate non real-time thread, and used at the next adaptation.
+    Workers are pinned on CPUs unless OMP_AFFINITY=0, and statistics are printed when the scheduler
+    is deleted if OMP_STATS=1.
 */
 
 class WorkStealingScheduler {
 
     private:
-    
-        DSPThreadPool* fThreadPool;
+
+        DSPThread** fThreadPool;
+        int fThreadCount;
+        void* fDSP;
+
         TaskQueue* fTaskQueueList;
         TaskGraph* fTaskGraph;
-        
-        DynThreadAdapter fDynThreadAdapter;
-        
+        TaskCostModel* fCostModel;
+        ThreadState* fThreadState;
+        std::vector<CPUInfo> fCPUOrder;
+
+        EventCount fIdleThreads;
+        EventCount fJoin;
+        std::atomic<int> fRunningThreads;
+        std::atomic<bool> fCycleDone;
+        std::atomic<bool> fLastTaskDone;    // a worker has left 'computeThread', so the last DAG iteration is done
+        std::atomic<bool> fStopped;
+
+        pthread_t fAdaptThread;
+        bool fAdaptRunning;
+        EventCount fAdaptEvent;
+        std::atomic<bool> fAdaptRequest;    // set by the master thread, cleared by the adaptation thread
+        std::atomic<int> fAdaptNumThreads;  // number of threads computed by the adaptation thread, 0 until computed
+
         int fDynamicNumThreads;
         int fStaticNumThreads;
-        
+
+        bool fAdaptive;
+        bool fAffinity;
+        bool fStats;
+        uint64_t fMaxSpin;              // in nsec
+        int fTinyTask;                  // in nsec
+        uint64_t fMinParallelWork;      // in nsec
+
         int* fReadyTaskList;
         int fReadyTaskListSize;
         int fReadyTaskListIndex;
-    
+
+        uint64_t fCycleStart;
+        uint64_t fCycles;
+        uint64_t fCycleTime;
+
+        const CPUInfo* GetCPU(int thread)
+        {
+            return (fCPUOrder.size() > 0) ? &fCPUOrder[thread % fCPUOrder.size()] : NULL;
+        }
+
+        void InitVictims()
+        {
+            for (int i = 0; i < fStaticNumThreads; i++) {
+                ThreadState& state = fThreadState[i];
+                const CPUInfo* cpu = GetCPU(i);
+                for (int near = 1; near >= 0; near--) {
+                    for (int j = 0; j < fStaticNumThreads; j++) {
+                        const CPUInfo* victim_cpu = GetCPU(j);
+                        bool same_node = !cpu || !victim_cpu || (cpu->fNode == victim_cpu->fNode);
+                        if (j != i && same_node == bool(near)) {
+                            state.fVictims.push_back(j);
+                            state.fNearVictims += near;
+                        }
+                    }
+                }
+                state.fVictimIndex = i;
+            }
+        }
+
+        INLINE void SwitchTask(ThreadState& state, int task, uint64_t now)
+        {
+            if (state.fCurTask != WORK_STEALING_INDEX) {
+                fCostModel->AddCost(state.fCurTask, now - state.fTaskStart);
+            }
+            state.fCurTask = task;
+            state.fTaskStart = now;
+            if (task != WORK_STEALING_INDEX) {
+                state.fTasks++;
+                if (state.fIdleStart) {
+                    state.fIdleTime += now - state.fIdleStart;
+                    state.fIdleStart = 0;
+                }
+            } else if (!state.fIdleStart) {
+                state.fIdleStart = now;
+                state.fSpinStart = now;
+            }
+        }
+
+        INLINE void BeginCycle(ThreadState& state, uint64_t now)
+        {
+            state.fCurTask = WORK_STEALING_INDEX;
+            state.fIdleStart = now;
+            state.fSpinStart = now;
+            state.fCycleStart = now;
+        }
+
+        INLINE void EndCycle(ThreadState& state, uint64_t now)
+        {
+            SwitchTask(state, WORK_STEALING_INDEX, now);
+            state.fIdleTime += now - state.fIdleStart;
+            state.fIdleStart = 0;
+            state.fCycleTime += now - state.fCycleStart;
+        }
+
+        INLINE void RecordEdge(int cur_thread, int task)
+        {
+            int cur_task = fThreadState[cur_thread].fCurTask;
+            if (cur_task != WORK_STEALING_INDEX) {
+                fCostModel->AddEdge(cur_task, task);
+            }
+        }
+
+        INLINE void PushTask(int cur_thread, int task)
+        {
+            if (fDynamicNumThreads == 1 || fCostModel->IsTiny(task, fTinyTask)) {
+                // Merged with the current task
+                fTaskQueueList[cur_thread].PushLocal(task);
+            } else {
+                fTaskQueueList[cur_thread].PushHead(task);
+                fIdleThreads.Notify(false);
+            }
+        }
+
+        INLINE int Steal(ThreadState& state)
+        {
+            int num_victims = int(state.fVictims.size());
+            for (int i = 0; i < num_victims; i++) {
+                // Rotating start among the near victims to spread thieves
+                int index = (i < state.fNearVictims) ? (state.fVictimIndex + i) % state.fNearVictims : i;
+                int victim = state.fVictims[index];
+                if (victim < fDynamicNumThreads) {
+                    int task = fTaskQueueList[victim].PopTail();
+                    if (task != WORK_STEALING_INDEX) {
+                        state.fSteals++;
+                        return task;
+                    }
+                }
+            }
+            state.fVictimIndex++;
+            state.fFailedSteals++;
+            return WORK_STEALING_INDEX;
+        }
+
+        bool CanSteal()
+        {
+            for (int i = 0; i < fDynamicNumThreads; i++) {
+                if (fTaskQueueList[i].CanSteal()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // The last DAG iteration is done, or nothing is left to wait for
+        bool IsCycleFinished(int cur_thread)
+        {
+            return fCycleDone.load() || fLastTaskDone.load()
+                || (cur_thread == MASTER_THREAD && fRunningThreads.load() == 0);
+        }
+
+        void Park(int cur_thread, ThreadState& state)
+        {
+            int epoch = fIdleThreads.PrepareWait();
+            if (IsCycleFinished(cur_thread) || CanSteal()) {
+                fIdleThreads.CancelWait();
+                return;
+            }
+            state.fParks++;
+            fIdleThreads.Wait(epoch);
+            state.fSpinStart = GetNanoSeconds();
+        }
+
+        // Called by the master thread: use the last computed number of threads, and ask for a new one
+        void Adapt()
+        {
+            int num_threads = fAdaptNumThreads.load(std::memory_order_relaxed);
+            if (num_threads > 0) {
+                fDynamicNumThreads = num_threads;
+            }
+            fAdaptRequest.store(true);
+            fAdaptEvent.Notify(false);
+        }
+
+        // Number of threads from the learned work and critical path of one DAG iteration
+        void ComputeNumThreads()
+        {
+            int64_t work = fCostModel->GetWork();
+            int64_t path = fCostModel->GetCriticalPath();
+            if (path > 0) {
+                int num_threads = (uint64_t(work) < fMinParallelWork)
+                    ? 1
+                    : Range(1, fStaticNumThreads, int(double(work) / double(path) + 0.5));
+                fAdaptNumThreads.store(num_threads, std::memory_order_relaxed);
+            }
+        }
+
+        static void* AdaptHandler(void* arg)
+        {
+            WorkStealingScheduler* scheduler = static_cast<WorkStealingScheduler*>(arg);
+            while (true) {
+                int epoch = scheduler->fAdaptEvent.PrepareWait();
+                if (scheduler->fStopped.load()) {
+                    scheduler->fAdaptEvent.CancelWait();
+                    break;
+                } else if (scheduler->fAdaptRequest.exchange(false)) {
+                    scheduler->fAdaptEvent.CancelWait();
+                    scheduler->ComputeNumThreads();
+                } else {
+                    scheduler->fAdaptEvent.Wait(epoch);
+                }
+            }
+            return NULL;
+        }
+
+        void PrintStats()
+        {
+            int64_t work = fCostModel->GetWork();
+            int64_t path = fCostModel->GetCriticalPath();
+            fprintf(stderr, "Scheduler : %d thread(s) used out of %d, %llu cycles, mean cycle = %.3f usec\n",
+                    fDynamicNumThreads, fStaticNumThreads, (unsigned long long)fCycles,
+                    (fCycles > 0) ? double(fCycleTime) / double(fCycles) / 1000. : 0.);
+            fprintf(stderr, "Scheduler : DAG iteration work = %.3f usec, critical path = %.3f usec, parallelism = %.2f\n",
+                    double(work) / 1000., double(path) / 1000., (path > 0) ? double(work) / double(path) : 0.);
+            for (int i = 0; i < fStaticNumThreads; i++) {
+                ThreadState& state = fThreadState[i];
+                fprintf(stderr, "Scheduler : thread %d tasks = %llu steals = %llu failed steals = %llu parks = %llu busy = %.3f ms idle = %.3f ms\n",
+                        i, (unsigned long long)state.fTasks, (unsigned long long)state.fSteals,
+                        (unsigned long long)state.fFailedSteals, (unsigned long long)state.fParks,
+                        double(state.fCycleTime - state.fIdleTime) / 1e6, double(state.fIdleTime) / 1e6);
+            }
+        }
+
     public:
-    
+
         WorkStealingScheduler(int task_queue_size, int init_task_list_size)
         {
-            fStaticNumThreads = get_max_cpu();
-            fDynamicNumThreads = getenv("OMP_NUM_THREADS") ? atoi(getenv("OMP_NUM_THREADS")) : fStaticNumThreads;
-            
-            fThreadPool = new DSPThreadPool(fStaticNumThreads);
+            fStaticNumThreads = std::max(1, GetEnv("OMP_NUM_THREADS", get_max_cpu()));
+            fDynamicNumThreads = fStaticNumThreads;
+            fAdaptive = GetEnv("OMP_DYN_THREAD", 1);
+            fAffinity = GetEnv("OMP_AFFINITY", 1);
+            fStats = GetEnv("OMP_STATS", 0);
+            fMaxSpin = uint64_t(GetEnv("OMP_STEALING_DUR", MAX_STEAL_DUR)) * 1000;
+            fTinyTask = GetEnv("OMP_TINY_TASK_DUR", TINY_TASK_DUR);
+            fMinParallelWork = uint64_t(GetEnv("OMP_MIN_WORK_DUR", MIN_PARALLEL_WORK)) * 1000;
+
+            fThreadPool = new DSPThread*[fStaticNumThreads];
+            fThreadCount = 0;
+            fDSP = NULL;
+
             fTaskGraph = new TaskGraph(task_queue_size);
+            fCostModel = new TaskCostModel(task_queue_size);
             fTaskQueueList = new TaskQueue[fStaticNumThreads];
             for (int i = 0; i < fStaticNumThreads; i++) {
                 fTaskQueueList[i].Init(task_queue_size);
             }
-            
+            fThreadState = new ThreadState[fStaticNumThreads];
+            get_cpu_order(fCPUOrder);
+            InitVictims();
+
+            fRunningThreads = 0;
+            fCycleDone = false;
+            fLastTaskDone = false;
+            fStopped = false;
+
+            fAdaptRunning = false;
+            fAdaptRequest = false;
+            fAdaptNumThreads = 0;
+
             fReadyTaskListSize = init_task_list_size;
             fReadyTaskList = new int[fReadyTaskListSize];
             fReadyTaskListIndex = 0;
+
+            fCycleStart = 0;
+            fCycles = 0;
+            fCycleTime = 0;
         }
-        
+
         ~WorkStealingScheduler()
         {
-            delete fThreadPool;
+            StopAll();
+            if (fStats) {
+                PrintStats();
+            }
+            delete[] fThreadPool;
             delete fTaskGraph;
+            delete fCostModel;
             delete[] fTaskQueueList;
+            delete[] fThreadState;
             delete[] fReadyTaskList;
         }
-        
+
         void AddReadyTask(int task_num)
         {
             fReadyTaskList[fReadyTaskListIndex++] = task_num;
         }
-        
+
         void StartAll(void* dsp)
         {
-            fThreadPool->StartAll(fStaticNumThreads - 1, true, dsp);
+            if (fThreadCount == 0) {  // Protection for multiple call...  (like LADSPA plug-ins in Ardour)
+                fDSP = dsp;
+                for (int i = 0; i < fStaticNumThreads - 1; i++) {
+                    const CPUInfo* cpu = GetCPU(i + 1);
+                    fThreadPool[i] = new DSPThread(i, this);
+                    if (fThreadPool[i]->Start(true, (fAffinity && cpu) ? cpu->fCPU : -1) < 0) {
+                        delete fThreadPool[i];
+                        break;
+                    }
+                    fThreadCount++;
+                }
+                // Use the threads that could be started
+                fStaticNumThreads = fThreadCount + 1;
+                fDynamicNumThreads = std::min(fDynamicNumThreads, fStaticNumThreads);
+                // The critical path is computed outside of the audio threads
+                if (fAdaptive && fStaticNumThreads > 1) {
+                    fAdaptRunning = (pthread_create(&fAdaptThread, NULL, AdaptHandler, this) == 0);
+                }
+            }
         }
-        
+
         void StopAll()
         {
-            fThreadPool->StopAll();
+            fStopped = true;
+            for (int i = 0; i < fThreadCount; i++) {
+                fThreadPool[i]->Stop();
+                delete fThreadPool[i];
+            }
+            fThreadCount = 0;
+            if (fAdaptRunning) {
+                fAdaptEvent.Notify(true);
+                pthread_join(fAdaptThread, NULL);
+                fAdaptRunning = false;
+            }
+        }
+
+        bool IsStopped()
+        {
+            return fStopped;
         }
-          
+
         void SignalAll()
         {
             GetRealTime();
-            fDynThreadAdapter.StartMeasure();
-            fThreadPool->SignalAll(fDynamicNumThreads - 1);
+            fCycleStart = GetNanoSeconds();
+            BeginCycle(fThreadState[MASTER_THREAD], fCycleStart);
+            fCycleDone = false;
+            fLastTaskDone = false;
+            fRunningThreads = fDynamicNumThreads - 1;
+            for (int i = 0; i < fDynamicNumThreads - 1; i++) {  // Important : use local num here...
+                fThreadPool[i]->Signal();
+            }
         }
-        
+
         void SyncAll()
         {
-            //while (!fThreadPool->IsFinished()) {}
-            fDynThreadAdapter.StopMeasure(fStaticNumThreads, fDynamicNumThreads);
+            uint64_t now = GetNanoSeconds();
+            EndCycle(fThreadState[MASTER_THREAD], now);
+
+            // Wait for the workers to leave 'computeThread', so that the next cycle can reset the queues
+            if (fRunningThreads > 0) {
+                fCycleDone = true;
+                fIdleThreads.Notify(true);
+                while (fRunningThreads > 0) {
+                    if (GetNanoSeconds() - now < fMaxSpin) {
+                        Pause();
+                    } else {
+                        int epoch = fJoin.PrepareWait();
+                        if (fRunningThreads == 0) {
+                            fJoin.CancelWait();
+                        } else {
+                            fJoin.Wait(epoch);
+                        }
+                    }
+                }
+            }
+
+            fCycles++;
+            fCycleTime += GetNanoSeconds() - fCycleStart;
+            if (fAdaptRunning && (fCycles % KDSPMESURE) == 0) {
+                Adapt();
+            }
         }
-        
+
+        // Called by the worker threads for each cycle
+        void RunThread(int num_thread)
+        {
+            ThreadState& state = fThreadState[num_thread];
+            BeginCycle(state, GetNanoSeconds());
+            computeThreadExternal(fDSP, num_thread);
+            EndCycle(state, GetNanoSeconds());
+            // Wake up the threads parked in the last DAG iteration, including the master thread
+            fLastTaskDone = true;
+            fIdleThreads.Notify(true);
+            if (fRunningThreads.fetch_sub(1) == 1) {
+                fJoin.Notify(true);
+            }
+        }
+
         void PushHead(int cur_thread, int task_num)
         {
-            fTaskQueueList[cur_thread].PushHead(task_num);
+            RecordEdge(cur_thread, task_num);
+            PushTask(cur_thread, task_num);
         }
-          
+
+        // Returns a task, or WORK_STEALING_INDEX once the last DAG iteration is done (or without running workers
+        // for the master thread): the generated code only reads the DSP index when holding a task or after
+        // the last iteration, so that it never races with the last task updating it
         int GetNextTask(int cur_thread)
         {
-            return TaskQueue::GetNextTask(fTaskQueueList, cur_thread, fDynamicNumThreads);
+            ThreadState& state = fThreadState[cur_thread];
+            uint64_t now = GetNanoSeconds();
+
+            int task = fTaskQueueList[cur_thread].PopHead();
+            if (task == WORK_STEALING_INDEX) {
+                SwitchTask(state, task, now);
+                while (true) {
+                    if (fDynamicNumThreads > 1) {
+                        task = Steal(state);
+                    }
+                    if (task != WORK_STEALING_INDEX || IsCycleFinished(cur_thread)) {
+                        break;
+                    }
+                    if (GetNanoSeconds() - state.fSpinStart > fMaxSpin) {
+                        Park(cur_thread, state);
+                    } else {
+                        Pause();
+                    }
+                }
+                now = GetNanoSeconds();
+            }
+            SwitchTask(state, task, now);
+            return task;
         }
-        
+
         void InitTask(int task_num, int count)
         {
             fTaskGraph->InitTask(task_num, count);
         }
-        
+
         void ActivateOutputTask(int cur_thread, int task, int* task_num)
         {
-            fTaskGraph->ActivateOutputTask(fTaskQueueList[cur_thread], task, task_num);
+            RecordEdge(cur_thread, task);
+            if (fTaskGraph->ActivateTask(task)) {
+                if (*task_num == WORK_STEALING_INDEX) {
+                    *task_num = task;
+                } else {
+                    PushTask(cur_thread, task);
+                }
+            }
         }
-        
+
         void ActivateOutputTask(int cur_thread, int task)
         {
-            fTaskGraph->ActivateOutputTask(fTaskQueueList[cur_thread], task);
+            RecordEdge(cur_thread, task);
+            if (fTaskGraph->ActivateTask(task)) {
+                PushTask(cur_thread, task);
+            }
         }
-        
+
         void ActivateOneOutputTask(int cur_thread, int task, int* task_num)
         {
-            fTaskGraph->ActivateOneOutputTask(fTaskQueueList[cur_thread], task, task_num);
+            RecordEdge(cur_thread, task);
+            if (fTaskGraph->ActivateTask(task)) {
+                *task_num = task;
+                SwitchTask(fThreadState[cur_thread], task, GetNanoSeconds());
+            } else {
+                *task_num = GetNextTask(cur_thread);
+            }
         }
-                
+
         void GetReadyTask(int cur_thread, int* task_num)
         {
-            fTaskGraph->GetReadyTask(fTaskQueueList[cur_thread], task_num);
+            if (*task_num == WORK_STEALING_INDEX) {
+                *task_num = GetNextTask(cur_thread);
+            } else {
+                SwitchTask(fThreadState[cur_thread], *task_num, GetNanoSeconds());
+            }
         }
-        
+
         void InitTaskList(int cur_thread)
         {
-            TaskQueue::InitAll(fTaskQueueList, fDynamicNumThreads);
             if (cur_thread == -1) {
-                // Dispatch on all WSQ
-                for (int i = 0; i < fDynamicNumThreads; i++) {
-                    fTaskQueueList[i].InitTaskList(fReadyTaskListSize, fReadyTaskList, fDynamicNumThreads, i);
+                // Called before 'SignalAll' when no worker is running: dispatch on all WSQ
+                for (int i = 0; i < fStaticNumThreads; i++) {
+                    fTaskQueueList[i].InitOne();
+                }
+                for (int i = 0; i < fReadyTaskListSize; i++) {
+                    PushTask(i % fDynamicNumThreads, fReadyTaskList[i]);
                 }
             } else {
                 // Otherwise push all ready tasks in cur_thread WSQ
                 for (int i = 0; i < fReadyTaskListSize; i++) {
-                    fTaskQueueList[cur_thread].PushHead(fReadyTaskList[i]);
+                    PushTask(cur_thread, fReadyTaskList[i]);
                 }
             }
         }
 
 };
 
+bool DSPThread::Run()
+{
+    fSemaphore.wait();
+    if (fScheduler->IsStopped()) {
+        return false;
+    }
+    fScheduler->RunThread(fNumThread + 1);
+    return true;
+}
+
 /*
 C scheduler interface
 */
-    
+
 #ifdef _WIN32
 #define EXPORT __declspec(dllexport) __attribute__((always_inline))
 #else
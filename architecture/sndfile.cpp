@@ -105,7 +105,6 @@ long loptrm(int* argcP, char* argv[], const char* longname, const char* shortnam
 mydsp DSP;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 #define kFrames 512
 
@@ -35,7 +35,6 @@
 using namespace std;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 #define FAUST_FILE        "faust.soul"
 #define FAUST_PATCH_FILE  "faust.soulpatch"
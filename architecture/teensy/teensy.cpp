@@ -91,7 +91,6 @@ unsigned __exidx_end;
 
 #if MIDICTRL
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 #endif
 
 AudioFaust::AudioFaust() : AudioStream(FAUST_INPUTS, new audio_block_t*[FAUST_INPUTS])
@@ -41,7 +41,6 @@
 
 #if MIDICTRL
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 #endif
 
 AudioFaust::AudioFaust() : teensyaudio()
@@ -112,7 +112,6 @@ class unitypolydsp : public decorator_dsp
 };
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 extern "C"
 {
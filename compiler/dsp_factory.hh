@@ -25,6 +25,7 @@
 #include <string.h>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "exception.hh"
 #include "export.hh"
@@ -175,4 +176,10 @@ dsp_factory_base* compileFaustFactory(int argc, const char* argv[], const char*
 std::string expandDSP(int argc, const char* argv[], const char* name, const char* input, std::string& sha_key,
                       std::string& error_msg);
 
+// Timed passes of the last compilation done by the calling thread with '-time' (Chrome trace JSON format)
+std::string getLastCompilationTrace();
+
+// Library files imported by the last compilation done by the calling thread
+std::vector<std::string> getLastCompilationLibraries();
+
 #endif
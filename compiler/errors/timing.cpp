@@ -20,73 +20,153 @@
  ************************************************************************/
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <vector>
 #ifndef _WIN32
-#include <sys/time.h>
+#include <sys/resource.h>
 #endif
 #include "Text.hh"
 #include "compatibility.hh"
+#include "garbageable.hh"
 #include "global.hh"
 #include "timing.hh"
+#include "tree.hh"
+
+// A timed pass
+struct TimingEvent {
+    string      fName;
+    int         fDepth;
+    double      fStart;     // In seconds, since the first recorded pass
+    double      fDuration;  // In seconds
+    size_t      fTrees;     // Number of created trees
+    size_t      fBytes;     // Memory allocated for Garbageable objects
+    long        fMaxRSS;    // Increase of the peak resident set size (in KB)
+};
 
 // Timing can be used outside of the scope of 'gGlobal'
-bool     gTimingSwitch;
-int      gTimingIndex;
-double   gStartTime[1024];
-double   gEndTime[1024];
-ostream* gTimingLog = 0;
+thread_local bool                     gTimingSwitch;
+thread_local vector<TimingEvent>      gTimingEvents;
+thread_local vector<size_t>           gTimingStack;  // Indexes of the started passes
+thread_local unique_ptr<ofstream>     gTimingLog;
+thread_local chrono::steady_clock::time_point gTimingOrigin;
 
-#ifndef _WIN32
-double mysecond()
+static double mysecond()
 {
-    struct timeval  tp;
-    struct timezone tzp;
-    gettimeofday(&tp, &tzp);
-    return ((double)tp.tv_sec + (double)tp.tv_usec * 1.e-6);
+    return chrono::duration<double>(chrono::steady_clock::now() - gTimingOrigin).count();
 }
 
-#else
-double mysecond()
+// Peak resident set size of the process in KB (0 when not available)
+static long maxRSS()
 {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
     return 0;
 }
-#endif
 
-void startTiming(const char* msg)
+// The textual report is not displayed when the passes are written in a trace file
+static bool timingText()
 {
-    // timing
-    gTimingLog = (getenv("FAUST_TIMING")) ? new ofstream("FAUST_TIMING_LOG", ios::app) : NULL;
-    if (gTimingLog) {
+    return !(gGlobal && gGlobal->gTimingFile != "");
+}
+
+static ostream* timingLog()
+{
+    // The log file is opened once per thread
+    if (!gTimingLog && getenv("FAUST_TIMING")) {
+        gTimingLog = unique_ptr<ofstream>(new ofstream("FAUST_TIMING_LOG", ios::app));
         *gTimingLog << endl;
     }
+    return gTimingLog.get();
+}
 
+void startTiming(const char* msg)
+{
     if (gTimingSwitch) {
-        faustassert(gTimingIndex < 1023);
-        if (gTimingLog) {
-            tab(gTimingIndex, *gTimingLog);
-            *gTimingLog << "start " << msg << endl;
-        } else {
-            tab(gTimingIndex, cerr);
+        if (gTimingEvents.empty()) {
+            gTimingOrigin = chrono::steady_clock::now();
+        }
+        ostream* log = timingLog();
+        if (log) {
+            tab(int(gTimingStack.size()), *log);
+            *log << "start " << msg << endl;
+        } else if (timingText()) {
+            tab(int(gTimingStack.size()), cerr);
             cerr << "start " << msg << endl;
         }
-        gStartTime[gTimingIndex++] = mysecond();
+        TimingEvent event = {msg, int(gTimingStack.size()), 0., 0., CTree::serialCounter(),
+                             global::gObjectArena.allocatedBytes(), maxRSS()};
+        gTimingStack.push_back(gTimingEvents.size());
+        gTimingEvents.push_back(event);
+        gTimingEvents.back().fStart = mysecond();
     }
 }
 
 void endTiming(const char* msg)
 {
     if (gTimingSwitch) {
-        faustassert(gTimingIndex > 0);
-        gEndTime[--gTimingIndex] = mysecond();
-        if (gTimingLog) {
-            *gTimingLog << msg << "\t" << gEndTime[gTimingIndex] - gStartTime[gTimingIndex] << endl;
-            gTimingLog->flush();
-        } else {
-            tab(gTimingIndex, cerr);
-            cerr << "end " << msg << " (duration : " << gEndTime[gTimingIndex] - gStartTime[gTimingIndex] << ")"
-                 << endl;
+        faustassert(gTimingStack.size() > 0);
+        TimingEvent& event = gTimingEvents[gTimingStack.back()];
+        gTimingStack.pop_back();
+        event.fDuration = mysecond() - event.fStart;
+        event.fTrees    = CTree::serialCounter() - event.fTrees;
+        event.fBytes    = global::gObjectArena.allocatedBytes() - event.fBytes;
+        event.fMaxRSS   = maxRSS() - event.fMaxRSS;
+        ostream* log    = timingLog();
+        if (log) {
+            *log << msg << "\t" << event.fDuration << endl;
+            log->flush();
+        } else if (timingText()) {
+            tab(int(gTimingStack.size()), cerr);
+            cerr << "end " << msg << " (duration : " << event.fDuration << ", trees : " << event.fTrees
+                 << ", allocated : " << event.fBytes << " bytes, max RSS : +" << event.fMaxRSS << " KB)" << endl;
+        }
+    }
+}
+
+void resetTiming()
+{
+    gTimingEvents.clear();
+    gTimingStack.clear();
+}
+
+static string jsonString(const char* str)
+{
+    stringstream res;
+    res << '"';
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            res << '\\' << *c;
+        } else if ((unsigned char)*c >= 32) {
+            res << *c;
         }
     }
+    res << '"';
+    return res.str();
+}
+
+void writeTimingTrace(ostream& out)
+{
+    // Complete events ("ph" : "X"), times are in microseconds
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < gTimingEvents.size(); i++) {
+        const TimingEvent& event = gTimingEvents[i];
+        out << ((i == 0) ? "\n" : ",\n");
+        out << "{\"name\":" << jsonString(event.fName.c_str()) << ",\"cat\":\"faust\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << int64_t(event.fStart * 1e6) << ",\"dur\":" << int64_t(event.fDuration * 1e6)
+            << ",\"args\":{\"depth\":" << event.fDepth << ",\"trees\":" << event.fTrees
+            << ",\"allocated\":" << event.fBytes << ",\"maxRSSDelta\":" << event.fMaxRSS << "}}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"maxRSS\":" << maxRSS() << "}}" << endl;
 }
@@ -22,10 +22,19 @@
 #ifndef __TIMING__
 #define __TIMING__
 
+#include <ostream>
+
 // use startTiming("foo") and endTiming("foo") to measure the execution time of a portion of code
-// edit timing.cpp de unactivate the code
+// (active with the '-time' option). Nested passes also record the number of created trees,
+// the memory allocated for Garbageable objects and the increase of the peak resident set size.
 
 void startTiming(const char* msg);
 void endTiming(const char* msg);
 
+// Forget the passes recorded by the current thread
+void resetTiming();
+
+// Write the passes recorded by the current thread as a Chrome trace (JSON) document
+void writeTimingTrace(std::ostream& out);
+
 #endif
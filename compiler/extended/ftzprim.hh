@@ -44,7 +44,7 @@ const char* FTZPattern[4][3] = {
 
 class FtzPrim : public xtended {
    private:
-    static int freshnum;  // counter for fTempFTZxxx fresh variables
+    static thread_local int freshnum;  // counter for fTempFTZxxx fresh variables
 
    public:
     FtzPrim() : xtended("ftz") {}
@@ -182,4 +182,4 @@ class FtzPrim : public xtended {
     }
 };
 
-int FtzPrim::freshnum = 0;
+thread_local int FtzPrim::freshnum = 0;
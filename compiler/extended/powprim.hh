@@ -109,6 +109,7 @@ class PowPrim : public xtended {
             container->pushGlobalDeclare(InstBuilder::genDeclareFunInst(faust_power_name,
                                                                         InstBuilder::genFunTyped(named_args, InstBuilder::genBasicTyped(result_type),
                                                                                                  FunTyped::kLocal), block));
+            container->addPureFunction(faust_power_name);
             
             list<ValueInst*> truncated_args;
             truncated_args.push_back((*args.begin()));
@@ -24,9 +24,50 @@
 
 #include <stdio.h>
 #include <new>
+#include <vector>
 
 #include "exception.hh"
 
+// Bump allocator for Garbageable objects: objects are allocated in large chunks, destroyed in reverse allocation
+// order and released in bulk by Garbageable::cleanup
+
+class GarbageableArena {
+   private:
+    // Placed before each object, padded to keep objects aligned
+    struct Header {
+        Header* fPrev;   // Previously allocated object
+        size_t  fFlags;  // Block size (without header) and kDeleted/kArray flags in the low bits
+    };
+
+    static const size_t kAlign     = 16;
+    static const size_t kHeader    = (sizeof(Header) + kAlign - 1) & ~(kAlign - 1);
+    static const size_t kChunkSize = 1 << 20;
+    static const size_t kMaxReuse  = 512;  // Blocks released by an explicit delete are reused up to this size
+
+    static const size_t kDeleted = 1;
+    static const size_t kArray   = 2;
+
+    std::vector<char*> fChunks;
+    char*              fCurrent;
+    char*              fEnd;
+    Header*            fLast;
+    Header*            fFreeBlocks[kMaxReuse / kAlign + 1];
+    size_t             fAllocated;  // Total size of the allocated blocks (for profiling)
+
+    static Header* getHeader(void* ptr) { return reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeader); }
+    static void*   getObject(Header* header) { return reinterpret_cast<char*>(header) + kHeader; }
+
+   public:
+    GarbageableArena();
+    ~GarbageableArena();
+
+    void* allocate(size_t size, bool array);
+    void  release(void* ptr, bool cleanup);
+    void  cleanup();
+
+    size_t allocatedBytes() const { return fAllocated; }
+};
+
 // To be inherited by all garbageable classes
 
 class Garbageable {
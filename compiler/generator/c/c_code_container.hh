@@ -58,6 +58,9 @@ class CCodeContainer : public virtual CodeContainer {
         } else {
             addIncludeFile("<math.h>");
         }
+        if (gGlobal->gVectorMath) {
+            addIncludeFile("\"faust/dsp/vecmath.h\"");
+        }
 
         // For malloc/free
         addIncludeFile("<stdlib.h>");
@@ -54,6 +54,7 @@ CodeContainer::CodeContainer()
       fInitInstructions(InstBuilder::genBlockInst()),
       fResetUserInterfaceInstructions(InstBuilder::genBlockInst()),
       fClearInstructions(InstBuilder::genBlockInst()),
+      fClearLaneInstructions(InstBuilder::genBlockInst()),
       fPostInitInstructions(InstBuilder::genBlockInst()),
       fAllocateInstructions(InstBuilder::genBlockInst()),
       fDestroyInstructions(InstBuilder::genBlockInst()),
@@ -281,6 +282,7 @@ ValueInst* CodeContainer::pushFunction(const string& name, Typed::VarType result
         named_args.push_back(InstBuilder::genNamedTyped("dummy" + to_string(i), InstBuilder::genBasicTyped(types[i])));
     }
     pushGlobalDeclare(InstBuilder::genDeclareFunInst(name, InstBuilder::genFunTyped(named_args, InstBuilder::genBasicTyped(result))));
+    addPureFunction(name);
     return InstBuilder::genFunCallInst(name, args);
 }
 
@@ -370,11 +372,369 @@ void CodeContainer::generateDAGLoop(BlockInst* block, DeclareVarInst* count)
     }
 }
 
+/*
+ Control-rate values ("Slow" variables of the compute block) are kept in "_cache" struct fields, and only
+ recomputed when one of the controls they depend on has changed since the previous 'compute' call,
+ or after 'instanceConstants' (which sets the 'fControlsDirty' flag). The compute block starts with:
+
+ if (fControlsDirty | (fHslider0 != fHslider0_cache) | ...) {
+    fControlsDirty = 0;
+    fHslider0_cache = fHslider0;
+    ...
+    fSlow0_cache = <value>;
+    ...
+ }
+
+ and "Slow" variables are then simply loaded from their cache: float fSlow0 = fSlow0_cache;
+*/
+void CodeContainer::cacheControls()
+{
+    // One sample modes have their own control function
+    if (gGlobal->gOneSample || gGlobal->gOneSampleControl) return;
+
+    // Struct fields written in 'compute' cannot be read by cached values
+    StoredVarCollector compute_stores;
+    generateComputeBlock(&compute_stores);
+    generatePostComputeBlock(&compute_stores);
+    transformDAG(&compute_stores);
+
+    // Controls and constants computed in 'instanceConstants'
+    ControlZoneCollector controls;
+    generateUserInterface(&controls);
+    StoredVarCollector constants;
+    generateInit(&constants);
+
+    map<string, Typed*> fields;
+    set<string>         field_names;
+    for (const auto& it : fDeclarationInstructions->fCode) {
+        DeclareVarInst* dec = dynamic_cast<DeclareVarInst*>(it);
+        if (!dec || dec->fAddress->getAccess() != Address::kStruct || !dynamic_cast<BasicTyped*>(dec->fType)) continue;
+        string name = dec->fAddress->getName();
+        if ((controls.fZones.count(name) || constants.fNames.count(name)) && !compute_stores.fNames.count(name)) {
+            fields[name] = dec->fType;
+            field_names.insert(name);
+        }
+    }
+
+    // Select cachable "Slow" variables, in declaration order
+    set<string>           cached;
+    set<string>           read_controls;
+    list<DeclareVarInst*> slow_vars;
+    for (const auto& it : fComputeBlockInstructions->fCode) {
+        DeclareVarInst* dec = dynamic_cast<DeclareVarInst*>(it);
+        if (!dec || !dec->fValue || dec->fAddress->getAccess() != Address::kStack ||
+            !dynamic_cast<BasicTyped*>(dec->fType) || dec->fAddress->getName().find("Slow") == string::npos) {
+            continue;
+        }
+        ControlDependencies dependencies(cached, field_names, fPureFunctions);
+        dec->fValue->accept(&dependencies);
+        if (dependencies.fCachable) {
+            cached.insert(dec->fAddress->getName());
+            slow_vars.push_back(dec);
+            for (const auto& name : dependencies.fReads) {
+                if (controls.fZones.count(name)) read_controls.insert(name);
+            }
+        }
+    }
+
+    if (slow_vars.size() == 0) return;
+
+    BasicCloneVisitor    cloner;
+    ControlCacheRewriter rewriter(cached);
+
+    pushDeclare(InstBuilder::genDecStructVar("fControlsDirty", InstBuilder::genInt32Typed()));
+    pushPostInitMethod(InstBuilder::genStoreStructVar("fControlsDirty", InstBuilder::genInt32NumInst(1)));
+
+    // Compare controls with their cached value
+    ValueInst* cond      = InstBuilder::genLoadStructVar("fControlsDirty");
+    BlockInst* recompute = InstBuilder::genBlockInst();
+    recompute->pushBackInst(InstBuilder::genStoreStructVar("fControlsDirty", InstBuilder::genInt32NumInst(0)));
+    for (const auto& name : read_controls) {
+        string cache = name + "_cache";
+        pushDeclare(InstBuilder::genDecStructVar(cache, fields[name]->clone(&cloner)));
+        cond = InstBuilder::genOr(
+            cond, InstBuilder::genNotEqual(InstBuilder::genLoadStructVar(name), InstBuilder::genLoadStructVar(cache)));
+        recompute->pushBackInst(InstBuilder::genStoreStructVar(cache, InstBuilder::genLoadStructVar(name)));
+    }
+
+    // Recompute cached values, and replace their declaration by a load of the cache
+    for (const auto& dec : slow_vars) {
+        string cache = dec->fAddress->getName() + "_cache";
+        pushDeclare(InstBuilder::genDecStructVar(cache, dec->fType->clone(&cloner)));
+        recompute->pushBackInst(InstBuilder::genStoreStructVar(cache, dec->fValue->clone(&rewriter)));
+        dec->fValue = InstBuilder::genLoadStructVar(cache);
+    }
+
+    fComputeBlockInstructions->pushFrontInst(InstBuilder::genIfInst(cond, recompute));
+}
+
+/*
+ Compute 'gBatchSize' independent instances in lockstep (-batch mode). The struct fields written after
+ 'instanceConstants' (controls, recursions, delay lines...) get one copy per lane, the fields shared by all
+ lanes (sample rate, constants, tables) are kept. IOTA is also shared: once a lane is cleared, its delay lines
+ only contain zeros whatever the IOTA value. Code using lane fields is moved in loops on the lanes, and in the
+ sample loop the lane loop is the innermost one, so that it can be vectorized. Output 'chan' of lane 'lane'
+ is written in outputs[lane * numOutputs + chan], inputs are shared.
+*/
+void CodeContainer::batchInstances()
+{
+    int lanes = gGlobal->gBatchSize;
+
+    // Fields written after 'instanceConstants'
+    StoredVarCollector stores;
+    generateResetUserInterface(&stores);
+    generateClear(&stores);
+    fPostInitInstructions->accept(&stores);
+    generateComputeBlock(&stores);
+    generatePostComputeBlock(&stores);
+    transformDAG(&stores);
+    ControlZoneCollector controls;
+    generateUserInterface(&controls);
+
+    map<string, int> lane_vars;
+    auto             genLaneTyped = [&](const string& name, Typed* type, int size) {
+        Typed* lane_type                 = InstBuilder::genArrayTyped(type, size * lanes);
+        gGlobal->gVarTypeTable[name] = lane_type;
+        return lane_type;
+    };
+
+    for (const auto& it : fDeclarationInstructions->fCode) {
+        DeclareVarInst* dec = dynamic_cast<DeclareVarInst*>(it);
+        if (!dec || dec->fAddress->getAccess() != Address::kStruct) continue;
+        string name = dec->fAddress->getName();
+        if (name == "IOTA" || (!stores.fNames.count(name) && !controls.fZones.count(name))) continue;
+        ArrayTyped* array_type = dynamic_cast<ArrayTyped*>(dec->fType);
+        if (dynamic_cast<BasicTyped*>(dec->fType)) {
+            lane_vars[name] = 0;
+            dec->fType      = genLaneTyped(name, dec->fType, 1);
+        } else if (array_type && array_type->fSize > 0 && dynamic_cast<BasicTyped*>(array_type->fType)) {
+            lane_vars[name] = array_type->fSize;
+            dec->fType      = genLaneTyped(name, array_type->fType, array_type->fSize);
+        } else {
+            throw faustexception("ERROR : '-batch' option cannot be used with field '" + name + "'\n");
+        }
+    }
+
+    set<string> outputs;
+    for (int chan = 0; chan < fNumOutputs; chan++) {
+        outputs.insert(subst("output$0", T(chan)));
+    }
+
+    LaneRewriter loop_rewriter(lane_vars, outputs, lanes, Address::kLoop);
+
+    auto accessLanes = [&](StatementInst* inst) {
+        VarAccessChecker checker(lane_vars);
+        inst->accept(&checker);
+        return checker.fFound;
+    };
+    auto genLaneLoop = [&](BlockInst* block) {
+        ForLoopInst* loop = InstBuilder::genForLoopInst("lane", 0, lanes);
+        for (const auto& it : block->fCode) {
+            loop->pushBackInst(it->clone(&loop_rewriter));
+        }
+        return loop;
+    };
+    auto genLaneBlock = [&](BlockInst* block) {
+        BlockInst* res = InstBuilder::genBlockInst();
+        if (block->fCode.size() > 0) {
+            res->pushBackInst(genLaneLoop(block));
+        }
+        return res;
+    };
+
+    // 'instanceConstants' usually only sets shared fields
+    if (accessLanes(fInitInstructions)) {
+        fInitInstructions = genLaneBlock(fInitInstructions);
+    }
+    if (accessLanes(fPostInitInstructions)) {
+        fPostInitInstructions = genLaneBlock(fPostInitInstructions);
+    }
+    fResetUserInterfaceInstructions = genLaneBlock(fResetUserInterfaceInstructions);
+
+    // Clear of all lanes, and of a single lane (that must not reset the shared IOTA)
+    BlockInst* lane_clear   = InstBuilder::genBlockInst();
+    BlockInst* shared_clear = InstBuilder::genBlockInst();
+    for (const auto& it : fClearInstructions->fCode) {
+        (accessLanes(it) ? lane_clear : shared_clear)->pushBackInst(it);
+    }
+    fClearInstructions = genLaneBlock(lane_clear);
+    fClearInstructions->merge(shared_clear);
+    LaneRewriter arg_rewriter(lane_vars, outputs, lanes, Address::kFunArgs);
+    for (const auto& it : lane_clear->fCode) {
+        fClearLaneInstructions->pushBackInst(it->clone(&arg_rewriter));
+    }
+
+    // Control-rate values depending on lane fields are computed for each lane
+    BlockInst*   compute      = InstBuilder::genBlockInst();
+    ForLoopInst* control_loop = InstBuilder::genForLoopInst("lane", 0, lanes);
+    BlockInst*   output_lanes = InstBuilder::genBlockInst();
+    for (const auto& it : fComputeBlockInstructions->fCode) {
+        DeclareVarInst* dec  = dynamic_cast<DeclareVarInst*>(it);
+        string          name = (dec) ? dec->fAddress->getName() : "";
+        if (dec && dec->fAddress->getAccess() == Address::kStack && outputs.count(name)) {
+            int         chan     = std::atoi(name.substr(6).c_str());
+            ArrayTyped* ptr_type = dynamic_cast<ArrayTyped*>(dec->fType);
+            faustassert(ptr_type);
+            ValueInst* index = InstBuilder::genAdd(InstBuilder::genMul(loop_rewriter.getLane(), InstBuilder::genInt32NumInst(fNumOutputs)),
+                                                   InstBuilder::genInt32NumInst(chan));
+            lane_vars[name]  = 0;
+            compute->pushBackInst(InstBuilder::genDecStackVar(name, genLaneTyped(name, dec->fType, 1)));
+            control_loop->pushBackInst(
+                InstBuilder::genStoreArrayStackVar(name, loop_rewriter.getLane(), InstBuilder::genLoadArrayFunArgsVar("outputs", index)));
+            output_lanes->pushBackInst(InstBuilder::genDecStackVar(
+                name + "_lanes", genLaneTyped(name + "_lanes", ptr_type->fType, 1)));
+        } else if (dec && dec->fAddress->getAccess() == Address::kStack && dec->fValue && accessLanes(dec)) {
+            ValueInst* value = dec->fValue->clone(&loop_rewriter);
+            lane_vars[name]  = 0;
+            compute->pushBackInst(InstBuilder::genDecStackVar(name, genLaneTyped(name, dec->fType, 1)));
+            control_loop->pushBackInst(InstBuilder::genStoreArrayStackVar(name, loop_rewriter.getLane(), value));
+        } else if (accessLanes(it)) {
+            control_loop->pushBackInst(it->clone(&loop_rewriter));
+        } else {
+            compute->pushBackInst(it);
+        }
+    }
+    if (control_loop->fCode->fCode.size() > 0) {
+        compute->pushBackInst(control_loop);
+    }
+    compute->merge(output_lanes);
+    fComputeBlockInstructions = compute;
+    if (accessLanes(fPostComputeBlockInstructions)) {
+        fPostComputeBlockInstructions = genLaneBlock(fPostComputeBlockInstructions);
+    }
+
+    // Sample loop: all lanes are computed, then their outputs are written, then shared fields (IOTA) are updated
+    BlockInst*       sample = InstBuilder::genBlockInst();
+    BlockInst*       shared = InstBuilder::genBlockInst();
+    map<string, int> shared_vars;
+    for (BlockInst* block : {fCurLoop->fPreInst, fCurLoop->fComputeInst, fCurLoop->fPostInst}) {
+        for (const auto& it : block->fCode) {
+            StoreVarInst* store = dynamic_cast<StoreVarInst*>(it);
+            if (store && store->fAddress->getAccess() == Address::kStruct && !accessLanes(it)) {
+                shared_vars[store->fAddress->getName()] = 0;
+                shared->pushBackInst(it);
+            } else {
+                // Shared fields can only be updated at the end of the sample
+                VarAccessChecker checker(shared_vars);
+                it->accept(&checker);
+                faustassert(!checker.fFound);
+                sample->pushBackInst(it);
+            }
+        }
+    }
+    fCurLoop->fPreInst     = InstBuilder::genBlockInst();
+    fCurLoop->fComputeInst = InstBuilder::genBlockInst();
+    fCurLoop->fComputeInst->pushBackInst(genLaneLoop(sample));
+    if (fNumOutputs > 0) {
+        ForLoopInst* output_loop = InstBuilder::genForLoopInst("lane", 0, lanes);
+        for (const auto& name : outputs) {
+            Address* address = InstBuilder::genIndexedAddress(
+                InstBuilder::genIndexedAddress(InstBuilder::genNamedAddress(name, Address::kStack), loop_rewriter.getLane()),
+                fCurLoop->getLoopIndex());
+            output_loop->pushBackInst(
+                InstBuilder::genStoreVarInst(address, InstBuilder::genLoadArrayStackVar(name + "_lanes", loop_rewriter.getLane())));
+        }
+        fCurLoop->fComputeInst->pushBackInst(output_loop);
+    }
+    fCurLoop->fPostInst = shared;
+
+    // UI zones are the ones of the first lane
+    fUserInterfaceInstructions = static_cast<BlockInst*>(fUserInterfaceInstructions->clone(&loop_rewriter));
+
+    vector<int> output_rates = fOutputRates;
+    for (int l = 1; l < lanes; l++) {
+        fOutputRates.insert(fOutputRates.end(), output_rates.begin(), output_rates.end());
+    }
+    fNumOutputs *= lanes;
+}
+
+/*
+ Cost-model driven loop fusion (-fl mode): a loop only used by another one is fused in it when the estimated gain
+ (loop overhead, task activation, intermediate vectors no longer read back from memory) is higher than the loss
+ (vectorization, parallelism). The intermediate vectors then only accessed at the index of a single loop are
+ kept in registers. Decisions are printed with '-d'.
+*/
+// Intermediate vectors are the 'vsize' arrays declared on the stack of 'compute'
+static map<string, Typed*> collectVectors(BlockInst* block)
+{
+    map<string, Typed*> vectors;
+    for (auto& it : block->fCode) {
+        DeclareVarInst* dec  = dynamic_cast<DeclareVarInst*>(it);
+        ArrayTyped*     type = (dec) ? dynamic_cast<ArrayTyped*>(dec->fType) : nullptr;
+        if (type && !dec->fValue && dec->fAddress->getAccess() == Address::kStack &&
+            type->fSize == gGlobal->gVecSize) {
+            vectors[dec->fAddress->getName()] = type->fType;
+        }
+    }
+    return vectors;
+}
+
+void CodeContainer::fuseLoops()
+{
+    map<string, Typed*> vectors = collectVectors(fComputeBlockInstructions);
+
+    // Vectors also accessed outside of the loops stay in memory
+    LoopVarCollector collector("");
+    fComputeBlockInstructions->accept(&collector);
+    fPostComputeBlockInstructions->accept(&collector);
+    for (auto& it : collector.fAccesses) {
+        if (it.second > 1) vectors.erase(it.first);
+    }
+
+    ostream* dump = (gGlobal->gDetailsSwitch) ? &cout : nullptr;
+    CodeLoop::fuseLoops(fCurLoop, vectors, gGlobal->gOpenMPSwitch || gGlobal->gSchedulerSwitch, dump);
+
+    set<string> scalars;
+    CodeLoop::scalarizeVectors(fCurLoop, vectors, scalars, dump);
+
+    // Remove the declarations of the vectors kept in registers
+    fComputeBlockInstructions->fCode.remove_if([&scalars](StatementInst* inst) {
+        DeclareVarInst* dec = dynamic_cast<DeclareVarInst*>(inst);
+        return dec && scalars.find(dec->fAddress->getName()) != scalars.end();
+    });
+}
+
+/*
+ Vector math (-vm mode): the math functions of the non recursive loops are computed once per vector by the
+ functions of 'faust/dsp/vecmath.h', on the arguments and results kept in vectors. Decisions are printed with '-d'.
+*/
+void CodeContainer::vectorizeMath()
+{
+    map<string, Typed*>   vectors = collectVectors(fComputeBlockInstructions);
+    list<DeclareVarInst*> decls;
+    ostream*              dump = (gGlobal->gDetailsSwitch) ? &cout : nullptr;
+    CodeLoop::vectorizeMath(fCurLoop, vectors, decls, gGlobal->gOpenMPSwitch, dump);
+    for (auto& it : decls) {
+        fComputeBlockInstructions->pushBackInst(it);
+    }
+}
+
 void CodeContainer::processFIR(void)
 {
     // Possibly add "fSamplingRate" field
     generateSR();
 
+    // Possibly only recompute control-rate values when controls have changed
+    if (gGlobal->gCacheControls) {
+        cacheControls();
+    }
+
+    // Possibly compute several instances in lockstep
+    if (gGlobal->gBatchSize > 1) {
+        batchInstances();
+    }
+
+    // Possibly fuse loops (used by VectorCodeContainer, OpenMPCodeContainer and WSSCodeContainer)
+    if (gGlobal->gFuseLoops) {
+        fuseLoops();
+    }
+
+    // Possibly compute math functions once per vector (used by VectorCodeContainer, OpenMPCodeContainer and
+    // WSSCodeContainer)
+    if (gGlobal->gVectorMath) {
+        vectorizeMath();
+    }
+
     // Possibly groups tasks (used by VectorCodeContainer, OpenMPCodeContainer and WSSCodeContainer)
     if (gGlobal->gGroupTaskSwitch) {
         CodeLoop::computeUseCount(fCurLoop);
@@ -76,6 +76,7 @@ class CodeContainer : public virtual Garbageable {
     BlockInst* fInitInstructions;
     BlockInst* fResetUserInterfaceInstructions;
     BlockInst* fClearInstructions;
+    BlockInst* fClearLaneInstructions;  // Clear of a single lane in -batch mode
     BlockInst* fPostInitInstructions;
 
     // To be used in allocate method (or constructor)
@@ -104,6 +105,8 @@ class CodeContainer : public virtual Garbageable {
     set<string> fIncludeFileSet;
     set<string> fLibrarySet;
 
+    set<string> fPureFunctions;  // functions of the primitives, without side effects
+
     // DAG of loops
     CodeLoop* fCurLoop;
 
@@ -174,6 +177,11 @@ class CodeContainer : public virtual Garbageable {
     }
 
     BlockInst* inlineSubcontainersFunCalls(BlockInst* block);
+
+    void cacheControls();
+    void batchInstances();
+    void fuseLoops();
+    void vectorizeMath();
     
    public:
     CodeContainer();
@@ -397,6 +405,8 @@ class CodeContainer : public virtual Garbageable {
     ValueInst* pushFunction(const string& name, Typed::VarType result, vector<Typed::VarType>& types,
                             const list<ValueInst*>& args);
 
+    void addPureFunction(const string& name) { fPureFunctions.insert(name); }
+
     void generateExtGlobalDeclarations(InstVisitor* visitor)
     {
         if (fExtGlobalDeclarationInstructions->fCode.size() > 0) {
@@ -443,6 +453,13 @@ class CodeContainer : public virtual Garbageable {
         }
     }
 
+    void generateClearLane(InstVisitor* visitor)
+    {
+        if (fClearLaneInstructions->fCode.size() > 0) {
+            fClearLaneInstructions->accept(visitor);
+        }
+    }
+
     void generateStaticInit(InstVisitor* visitor)
     {
         if (fStaticInitInstructions->fCode.size() > 0) {
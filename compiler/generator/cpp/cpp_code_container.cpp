@@ -29,7 +29,7 @@
 
 using namespace std;
 
-map<string, bool> CPPInstVisitor::gFunctionSymbolTable;
+thread_local map<string, bool> CPPInstVisitor::gFunctionSymbolTable;
 
 dsp_factory_base* CPPCodeContainer::produceFactory()
 {
@@ -77,7 +77,8 @@ CodeContainer* CPPCodeContainer::createContainer(const string& name, const strin
     } else {
         container = (gGlobal->gOneSample)
             ? new CPPScalarOneSampleCodeContainer(name, super, numInputs, numOutputs, dst, kInt)
-            : new CPPScalarCodeContainer(name, super, numInputs, numOutputs, dst, kInt);
+            : new CPPScalarCodeContainer(name, (gGlobal->gBatchSize > 1 && super == "dsp") ? "batch_dsp" : super,
+                                         numInputs, numOutputs, dst, kInt);
     }
 
     return container;
@@ -429,6 +430,25 @@ void CPPCodeContainer::produceClass()
     *fOut << "}";
     tab(n + 1, *fOut);
 
+    if (gGlobal->gBatchSize > 1) {
+        tab(n + 1, *fOut);
+        *fOut << "virtual void instanceClearLane(int lane) {";
+        tab(n + 2, *fOut);
+        fCodeProducer.Tab(n + 2);
+        generateClearLane(&fCodeProducer);
+        back(1, *fOut);
+        *fOut << "}";
+        tab(n + 1, *fOut);
+
+        tab(n + 1, *fOut);
+        *fOut << "virtual int getNumLanes() {";
+        tab(n + 2, *fOut);
+        *fOut << "return " << gGlobal->gBatchSize << ";";
+        tab(n + 1, *fOut);
+        *fOut << "}";
+        tab(n + 1, *fOut);
+    }
+
     // TEST
     /*
     // Start inline
@@ -60,6 +60,9 @@ class CPPCodeContainer : public virtual CodeContainer {
             addIncludeFile("<cmath>");
             addIncludeFile("<algorithm>");
         }
+        if (gGlobal->gVectorMath) {
+            addIncludeFile("\"faust/dsp/vecmath.h\"");
+        }
     }
 
     virtual ~CPPCodeContainer() {}
@@ -22,15 +22,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
 
 #include "Text.hh"
 #include "compatibility.hh"
 #include "dsp_aux.hh"
 #include "dsp_factory.hh"
-#include "lock_api.hh"
 #include "libfaust.h"
 
 #ifdef WIN32
@@ -225,7 +234,6 @@ Same DSP code and same normalized compilation options will generate the same SHA
 EXPORT string expandDSPFromString(const string& name_app, const string& dsp_content, int argc, const char* argv[],
                                   string& sha_key, string& error_msg)
 {
-    LOCK_API
     if (dsp_content == "") {
         error_msg = "Unable to read file";
         return "";
@@ -267,7 +275,6 @@ EXPORT bool generateAuxFilesFromFile(const string& filename, int argc, const cha
 EXPORT bool generateAuxFilesFromString(const string& name_app, const string& dsp_content, int argc, const char* argv[],
                                        string& error_msg)
 {
-    LOCK_API
     if (dsp_content == "") {
         error_msg = "Unable to read file";
         return false;
@@ -291,12 +298,150 @@ EXPORT bool generateAuxFilesFromString(const string& name_app, const string& dsp
     }
 }
 
+EXPORT string getCompilationTrace()
+{
+    return getLastCompilationTrace();
+}
+
 string sha1FromDSP(const string& name_app, const string& dsp_content, int argc, const char* argv[], string& sha_key)
 {
     sha_key = generateSHA1(name_app + dsp_content + reorganizeCompilationOptions(argc, argv));
     return dsp_content;
 }
 
+// Persistent DSP factory cache
+
+#define CACHE_EXTENSION ".fcache"
+#define CACHE_DEFAULT_SIZE 256
+
+string dsp_factory_cache::getDirectory()
+{
+#if defined(_WIN32) || defined(EMCC)
+    return "";
+#else
+    const char* dir = getenv("FAUST_DSP_CACHE");
+    return (dir && dir[0]) ? string(dir) : "";
+#endif
+}
+
+string dsp_factory_cache::getKey(const string& name_app, const string& dsp_content, int argc, const char* argv[],
+                                 const string& target)
+{
+    if (getDirectory() == "") return "";
+
+    // Imports are resolved in the library search path and the current directory
+    const char* lib_path = getenv("FAUST_LIB_PATH");
+    char        cwd[4096];
+    string      dirs = string((lib_path) ? lib_path : "") + ":" + string((getcwd(cwd, sizeof(cwd))) ? cwd : "");
+
+    string sha_key;
+    sha1FromDSP(name_app, dsp_content, argc, argv, sha_key);
+    return generateSHA1(sha_key + dirs + target + FAUSTVERSION);
+}
+
+// The 'date size' stamp of a file, or "" if it cannot be accessed
+static string getStamp(const string& path)
+{
+#ifndef _WIN32
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) return to_string(st.st_mtime) + " " + to_string(st.st_size);
+#endif
+    return "";
+}
+
+bool dsp_factory_cache::read(const string& key, string& code)
+{
+    string dir = getDirectory();
+    if (dir == "" || key == "") return false;
+
+    string   path = dir + "/" + key + CACHE_EXTENSION;
+    ifstream reader(path.c_str(), ios::in | ios::binary);
+    if (!reader.is_open()) return false;
+
+    // The entry starts with the number of libraries, then a 'path' line and a 'date size' line for each of them
+    int libraries = -1;
+    reader >> libraries;
+    reader.ignore(1);
+    for (int i = 0; i < libraries && reader.good(); i++) {
+        string library, stamp;
+        getline(reader, library);
+        getline(reader, stamp);
+        if (stamp != getStamp(library)) return false;
+    }
+    if (libraries < 0 || !reader.good()) return false;
+    code.assign(istreambuf_iterator<char>(reader), istreambuf_iterator<char>());
+    if (reader.bad() || code == "") return false;
+
+#ifndef _WIN32
+    // The modification time is used as the 'last use' date for eviction
+    utime(path.c_str(), nullptr);
+#endif
+    return true;
+}
+
+void dsp_factory_cache::write(const string& key, time_t date, const string& code)
+{
+    string dir = getDirectory();
+    if (dir == "" || key == "" || code == "") return;
+
+#ifndef _WIN32
+    // A library modified during the compilation may not have been read in its final state
+    vector<string> libraries = getLastCompilationLibraries();
+    vector<string> stamps;
+    for (const auto& library : libraries) {
+        struct stat st;
+        if (stat(library.c_str(), &st) != 0 || st.st_mtime >= date) return;
+        stamps.push_back(getStamp(library));
+    }
+
+    // Write in a temporary file then rename it, so that a concurrent reader never sees a partial entry
+    // (the name is unique among the threads of all processes sharing the cache directory)
+    string path = dir + "/" + key + CACHE_EXTENSION;
+    string tmp  = path + "." + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    {
+        ofstream writer(tmp.c_str(), ios::out | ios::binary);
+        if (!writer.is_open()) return;
+        writer << libraries.size() << "\n";
+        for (size_t i = 0; i < libraries.size(); i++) {
+            writer << libraries[i] << "\n" << stamps[i] << "\n";
+        }
+        writer << code;
+        if (!writer.good()) {
+            writer.close();
+            remove(tmp.c_str());
+            return;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return;
+    }
+
+    // LRU eviction (the new entry is always kept)
+    const char* size_str = getenv("FAUST_DSP_CACHE_SIZE");
+    size_t      max_size = (size_str) ? size_t(max(1, atoi(size_str))) : CACHE_DEFAULT_SIZE;
+
+    vector<pair<time_t, string>> entries;
+    if (DIR* dirp = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(dirp)) {
+            string name = ent->d_name;
+            if (endWith(name, CACHE_EXTENSION)) {
+                struct stat st;
+                string      entry = dir + "/" + name;
+                if (entry != path && stat(entry.c_str(), &st) == 0) entries.push_back(make_pair(st.st_mtime, entry));
+            }
+        }
+        closedir(dirp);
+    }
+    if (entries.size() >= max_size) {
+        sort(entries.begin(), entries.end());
+        for (size_t i = 0; i < entries.size() + 1 - max_size; i++) {
+            remove(entries[i].second.c_str());
+        }
+    }
+#endif
+}
+
 // External C libfaust API
 
 #ifdef __cplusplus
@@ -342,6 +487,11 @@ EXPORT bool generateCAuxFilesFromString(const char* name_app, const char* dsp_co
     return res;
 }
 
+EXPORT const char* getCCompilationTrace()
+{
+    return strdup(getCompilationTrace().c_str());
+}
+
 EXPORT void generateCSHA1(const char* data, char* sha_key)
 {
     strncpy(sha_key, generateSHA1(data).c_str(), 64);
@@ -24,9 +24,11 @@
 
 #include <string.h>
 #include <cassert>
+#include <ctime>
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifdef WIN32
@@ -180,22 +182,35 @@ template <class T>
 struct dsp_factory_table : public std::map<T, std::list<dsp*> > {
     typedef typename std::map<T, std::list<dsp*> >::iterator factory_iterator;
 
+    // Factories indexed by their SHA key (the SHA key has to be set before calling 'setFactory')
+    std::unordered_map<std::string, factory_iterator> fSHAKeys;
+
     dsp_factory_table() {}
     virtual ~dsp_factory_table() {}
 
     bool getFactory(const std::string& sha_key, factory_iterator& res)
     {
-        for (factory_iterator it = this->begin(); it != this->end(); it++) {
-            if ((*it).first->getSHAKey() == sha_key) {
-                res = it;
-                return true;
-            }
+        auto it = fSHAKeys.find(sha_key);
+        if (it != fSHAKeys.end()) {
+            res = (*it).second;
+            return true;
+        } else {
+            return false;
         }
+    }
 
-        return false;
+    void setFactory(T factory)
+    {
+        factory_iterator it = this->insert(std::pair<T, std::list<dsp*> >(factory, std::list<dsp*>())).first;
+        std::string      sha_key = factory->getSHAKey();
+        if (sha_key != "") fSHAKeys.insert(std::make_pair(sha_key, it));
     }
 
-    void setFactory(T factory) { this->insert(std::pair<T, std::list<dsp*> >(factory, std::list<dsp*>())); }
+    void removeSHAKey(factory_iterator it)
+    {
+        auto it1 = fSHAKeys.find((*it).first->getSHAKey());
+        if (it1 != fSHAKeys.end() && (*it1).second == it) fSHAKeys.erase(it1);
+    }
 
     bool addDSP(T factory, dsp* dsp)
     {
@@ -264,6 +279,7 @@ struct dsp_factory_table : public std::map<T, std::list<dsp*> > {
                     delete it1;
                 }
                 // Last use, remove from the global table, pointer will be deleted
+                removeSHAKey(it);
                 this->erase(factory);
                 return true;
             } else {
@@ -287,6 +303,7 @@ struct dsp_factory_table : public std::map<T, std::list<dsp*> > {
             }
         }
         // Then clear the table thus finally deleting all ref = 1 smart pointers
+        fSHAKeys.clear();
         this->clear();
     }
 };
@@ -294,6 +311,33 @@ struct dsp_factory_table : public std::map<T, std::list<dsp*> > {
 // Compute SHA1 key from name_app, dsp_content and compialtions arguments, and returns the dsp_content
 std::string sha1FromDSP(const std::string& name_app, const std::string& dsp_content, int argc, const char* argv[], std::string& sha_key);
 
+//----------------------------------------------------------------
+// Persistent DSP factory cache
+//----------------------------------------------------------------
+
+/*
+ Opt-in on-disk cache of compiled factories, activated by setting the FAUST_DSP_CACHE environment variable
+ to an existing directory. Each entry is a file named by a SHA key computed from the DSP name and code,
+ the compilation options, the library search path, the backend/target and the compiler version, so that
+ looking an entry up does not need to parse the DSP. The entry starts with the modification date and size
+ of the libraries imported by the compilation, and is only used if they are unchanged. When more than
+ FAUST_DSP_CACHE_SIZE entries (default 256) are present, the least recently used ones are removed.
+*/
+struct dsp_factory_cache {
+    // Return the cache directory, or "" if the cache is not activated
+    static std::string getDirectory();
+
+    // Compute the cache key of a DSP, or return "" if the cache is not activated
+    static std::string getKey(const std::string& name_app, const std::string& dsp_content, int argc,
+                              const char* argv[], const std::string& target);
+
+    // Read the code kept for 'key', return false if not found or if one of its libraries has changed
+    static bool read(const std::string& key, std::string& code);
+
+    // Keep 'code' compiled at 'date' with the libraries of the last compilation, and remove the least recently used entries
+    static void write(const std::string& key, time_t date, const std::string& code);
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -146,6 +146,340 @@ struct VariableMover {
     }
 };
 
+// Collect the names of all written variables
+struct StoredVarCollector : public DispatchVisitor {
+    set<string> fNames;
+
+    using DispatchVisitor::visit;
+
+    void visit(StoreVarInst* inst)
+    {
+        fNames.insert(inst->fAddress->getName());
+        DispatchVisitor::visit(inst);
+    }
+};
+
+// Collect the zones of input controls (buttons, sliders and nentries)
+struct ControlZoneCollector : public DispatchVisitor {
+    set<string> fZones;
+
+    using DispatchVisitor::visit;
+
+    void visit(AddButtonInst* inst) { fZones.insert(inst->fZone); }
+    void visit(AddSliderInst* inst) { fZones.insert(inst->fZone); }
+};
+
+/*
+ Check that a control-rate value can be cached between 'compute' calls: it can only read already cached
+ stack variables, scalar struct fields not written in 'compute' and static tables, and only call pure functions
+ (the math functions of the primitives and the math foreign functions). The read struct fields are collected.
+*/
+struct ControlDependencies : public DispatchVisitor {
+    const set<string>& fCached;
+    const set<string>& fFields;
+    const set<string>& fPure;
+    set<string>        fReads;
+    bool               fCachable;
+
+    using DispatchVisitor::visit;
+
+    void visit(LoadVarInst* inst)
+    {
+        Address::AccessType access = inst->fAddress->getAccess();
+        string              name   = inst->fAddress->getName();
+
+        if (dynamic_cast<IndexedAddress*>(inst->fAddress)) {
+            fCachable &= bool(access & (Address::kStaticStruct | Address::kGlobal));
+            // Check the index
+            DispatchVisitor::visit(inst);
+        } else if (access & Address::kStack) {
+            fCachable &= fCached.find(name) != fCached.end();
+        } else if (access & Address::kStruct) {
+            fCachable &= fFields.find(name) != fFields.end();
+            fReads.insert(name);
+        } else {
+            fCachable &= bool(access & Address::kStaticStruct);
+        }
+    }
+
+    void visit(LoadVarAddressInst* inst) { fCachable = false; }
+
+    void visit(FunCallInst* inst)
+    {
+        // Other functions (foreign functions, methods...) may have side effects or read a state
+        fCachable &= !inst->fMethod &&
+                     (fPure.find(inst->fName) != fPure.end() || gGlobal->isMathForeignFunction(inst->fName));
+        DispatchVisitor::visit(inst);
+    }
+
+    ControlDependencies(const set<string>& cached, const set<string>& fields, const set<string>& pure)
+        : fCached(cached), fFields(fields), fPure(pure), fCachable(true)
+    {
+    }
+};
+
+// Rewrite access of cached stack variables as access of their "_cache" struct field
+struct ControlCacheRewriter : public BasicCloneVisitor {
+    const set<string>& fCached;
+
+    ControlCacheRewriter(const set<string>& cached) : fCached(cached) {}
+
+    virtual Address* visit(NamedAddress* named)
+    {
+        if (named->fAccess == Address::kStack && fCached.find(named->fName) != fCached.end()) {
+            return InstBuilder::genNamedAddress(named->fName + "_cache", Address::kStruct);
+        } else {
+            return BasicCloneVisitor::visit(named);
+        }
+    }
+};
+
+// Check whether some of the given variables are accessed
+struct VarAccessChecker : public DispatchVisitor {
+    const map<string, int>& fNames;
+    bool                    fFound;
+
+    using DispatchVisitor::visit;
+
+    void visit(NamedAddress* named) { fFound |= fNames.find(named->fName) != fNames.end(); }
+
+    VarAccessChecker(const map<string, int>& names) : fNames(names), fFound(false) {}
+};
+
+/*
+ Rewrite the code of one instance as the code of the 'lane' instance of a batch of 'fLanes' instances
+ (used in -batch mode). The lane variables (name => size of the array in one instance, 0 for scalars)
+ become arrays: scalars are indexed by the lane, and the lane is the innermost dimension of arrays,
+ so that the same element of all lanes is contiguous. Stores in the "output" buffers are rewritten
+ as stores in their "_lanes" stack array, and UI zones become the zone of the first lane.
+*/
+struct LaneRewriter : public BasicCloneVisitor {
+    const map<string, int>& fLaneVars;
+    const set<string>&      fOutputs;
+    int                     fLanes;
+    Address::AccessType     fLaneAccess;
+
+    LaneRewriter(const map<string, int>& vars, const set<string>& outputs, int lanes, Address::AccessType access)
+        : fLaneVars(vars), fOutputs(outputs), fLanes(lanes), fLaneAccess(access)
+    {
+    }
+
+    ValueInst* getLane() { return InstBuilder::genLoadVarInst(InstBuilder::genNamedAddress("lane", fLaneAccess)); }
+
+    string getZone(const string& zone) { return (fLaneVars.find(zone) != fLaneVars.end()) ? zone + "[0]" : zone; }
+
+    virtual Address* visit(NamedAddress* named)
+    {
+        auto it = fLaneVars.find(named->fName);
+        if (it == fLaneVars.end()) {
+            return BasicCloneVisitor::visit(named);
+        } else if (it->second > 0) {
+            // Arrays are only accessed as a whole to be filled (by 'rwtable')
+            throw faustexception("ERROR : '-batch' option cannot be used with 'rwtable' (" + named->fName + ")\n");
+        } else {
+            return InstBuilder::genIndexedAddress(BasicCloneVisitor::visit(named), getLane());
+        }
+    }
+
+    virtual Address* visit(IndexedAddress* indexed)
+    {
+        NamedAddress* named = dynamic_cast<NamedAddress*>(indexed->fAddress);
+        auto          it    = (named) ? fLaneVars.find(named->fName) : fLaneVars.end();
+        if (it == fLaneVars.end() || it->second == 0) {
+            return BasicCloneVisitor::visit(indexed);
+        }
+        // index * lanes + lane, simplified when the index is a constant
+        ValueInst*    index = indexed->fIndex->clone(this);
+        Int32NumInst* num   = dynamic_cast<Int32NumInst*>(index);
+        if (num && num->fNum == 0) {
+            index = getLane();
+        } else if (num) {
+            index = InstBuilder::genAdd(InstBuilder::genInt32NumInst(num->fNum * fLanes), getLane());
+        } else {
+            index = InstBuilder::genAdd(InstBuilder::genMul(index, InstBuilder::genInt32NumInst(fLanes)), getLane());
+        }
+        return InstBuilder::genIndexedAddress(BasicCloneVisitor::visit(named), index);
+    }
+
+    virtual StatementInst* visit(StoreVarInst* inst)
+    {
+        IndexedAddress* indexed = dynamic_cast<IndexedAddress*>(inst->fAddress);
+        if (indexed && fOutputs.find(indexed->getName()) != fOutputs.end()) {
+            return InstBuilder::genStoreArrayStackVar(indexed->getName() + "_lanes", getLane(),
+                                                      inst->fValue->clone(this));
+        } else {
+            return BasicCloneVisitor::visit(inst);
+        }
+    }
+
+    virtual StatementInst* visit(AddMetaDeclareInst* inst)
+    {
+        return new AddMetaDeclareInst(getZone(inst->fZone), inst->fKey, inst->fValue);
+    }
+    virtual StatementInst* visit(AddButtonInst* inst)
+    {
+        return new AddButtonInst(inst->fLabel, getZone(inst->fZone), inst->fType);
+    }
+    virtual StatementInst* visit(AddSliderInst* inst)
+    {
+        return new AddSliderInst(inst->fLabel, getZone(inst->fZone), inst->fInit, inst->fMin, inst->fMax, inst->fStep,
+                                 inst->fType);
+    }
+    virtual StatementInst* visit(AddBargraphInst* inst)
+    {
+        return new AddBargraphInst(inst->fLabel, getZone(inst->fZone), inst->fMin, inst->fMax, inst->fType);
+    }
+    virtual StatementInst* visit(AddSoundfileInst* inst)
+    {
+        throw faustexception("ERROR : '-batch' option cannot be used with soundfiles\n");
+    }
+};
+
+/*
+ Collect the variables accessed in the code of a loop (used in -fl mode): the number of accesses
+ of each variable, the number of accesses of arrays indexed by the loop index, and the number of stores in arrays.
+*/
+struct LoopVarCollector : public DispatchVisitor {
+    string           fLoopIndex;
+    map<string, int> fAccesses;
+    map<string, int> fIndexed;
+    map<string, int> fStored;
+
+    using DispatchVisitor::visit;
+
+    LoopVarCollector(const string& index) : fLoopIndex(index) {}
+
+    bool isLoopIndex(ValueInst* index)
+    {
+        LoadVarInst* load = dynamic_cast<LoadVarInst*>(index);
+        return load && load->fAddress->getAccess() == Address::kLoop && load->fAddress->getName() == fLoopIndex;
+    }
+
+    void visit(NamedAddress* named) { fAccesses[named->fName]++; }
+
+    void visit(IndexedAddress* indexed)
+    {
+        if (isLoopIndex(indexed->fIndex)) {
+            fIndexed[indexed->getName()]++;
+        }
+        DispatchVisitor::visit(indexed);
+    }
+
+    void visit(StoreVarInst* inst)
+    {
+        if (dynamic_cast<IndexedAddress*>(inst->fAddress)) {
+            fStored[inst->fAddress->getName()]++;
+        }
+        DispatchVisitor::visit(inst);
+    }
+};
+
+/*
+ Keep intermediate vectors in registers (used in -fl mode): the 'vec[i] = exp' store becomes
+ the declaration of a stack variable, and the 'vec[i]' loads become loads of this variable.
+ The vectors are given with the declaration of their scalar variable (without value).
+*/
+struct VectorScalarizer : public BasicCloneVisitor {
+    const map<string, DeclareVarInst*>& fScalars;
+
+    VectorScalarizer(const map<string, DeclareVarInst*>& scalars) : fScalars(scalars) {}
+
+    virtual ValueInst* visit(LoadVarInst* inst)
+    {
+        auto it = fScalars.find(inst->fAddress->getName());
+        if (it != fScalars.end() && dynamic_cast<IndexedAddress*>(inst->fAddress)) {
+            return InstBuilder::genLoadStackVar(it->second->fAddress->getName());
+        } else {
+            return BasicCloneVisitor::visit(inst);
+        }
+    }
+
+    virtual StatementInst* visit(StoreVarInst* inst)
+    {
+        auto it = fScalars.find(inst->fAddress->getName());
+        if (it != fScalars.end() && dynamic_cast<IndexedAddress*>(inst->fAddress)) {
+            return InstBuilder::genDecStackVar(it->second->fAddress->getName(), it->second->fType->clone(this),
+                                               inst->fValue->clone(this));
+        } else {
+            return BasicCloneVisitor::visit(inst);
+        }
+    }
+};
+
+/*
+ Extract the calls of the vector math library functions (used in -vm mode): each call becomes the load of its
+ result vector at the loop index. The calls are collected with their rewritten arguments, nested calls first.
+*/
+struct MathCallExtractor : public BasicCloneVisitor {
+    struct Call {
+        string           fName;    // FIR function name
+        string           fResult;  // result vector
+        list<ValueInst*> fArgs;
+        set<int>         fNested;  // calls in the arguments
+    };
+
+    const map<string, int>& fArities;  // extracted functions with their number of arguments
+    string                  fLoopIndex;
+    vector<Call>            fCalls;
+    set<int>                fOuter;  // calls not nested in another one
+    vector<set<int>*>       fStack;
+
+    MathCallExtractor(const map<string, int>& arities, const string& index) : fArities(arities), fLoopIndex(index) {}
+
+    virtual ValueInst* visit(FunCallInst* inst)
+    {
+        auto it = fArities.find(inst->fName);
+        if (it == fArities.end() || int(inst->fArgs.size()) != it->second) {
+            return BasicCloneVisitor::visit(inst);
+        }
+        Call call;
+        call.fName   = inst->fName;
+        call.fResult = "f" + gGlobal->getFreshID("Zec");
+        fStack.push_back(&call.fNested);
+        for (auto& arg : inst->fArgs) {
+            call.fArgs.push_back(arg->clone(this));
+        }
+        fStack.pop_back();
+        ((fStack.empty()) ? fOuter : *fStack.back()).insert(int(fCalls.size()));
+        fCalls.push_back(call);
+        return InstBuilder::genLoadArrayStackVar(call.fResult, InstBuilder::genLoadLoopVar(fLoopIndex));
+    }
+};
+
+/*
+ Keep loop scalars in vectors (used in -vm mode, the reverse of VectorScalarizer): the declaration of the scalar
+ becomes a 'vec[i] = exp' store, and its loads become 'vec[i]' loads.
+*/
+struct ScalarVectorizer : public BasicCloneVisitor {
+    const map<string, string>& fVectors;
+    string                     fLoopIndex;
+
+    ScalarVectorizer(const map<string, string>& vectors, const string& index) : fVectors(vectors), fLoopIndex(index)
+    {
+    }
+
+    virtual ValueInst* visit(LoadVarInst* inst)
+    {
+        auto it = fVectors.find(inst->fAddress->getName());
+        if (it != fVectors.end() && dynamic_cast<NamedAddress*>(inst->fAddress)) {
+            return InstBuilder::genLoadArrayStackVar(it->second, InstBuilder::genLoadLoopVar(fLoopIndex));
+        } else {
+            return BasicCloneVisitor::visit(inst);
+        }
+    }
+
+    virtual StatementInst* visit(DeclareVarInst* inst)
+    {
+        auto it = fVectors.find(inst->fAddress->getName());
+        if (it != fVectors.end()) {
+            return InstBuilder::genStoreArrayStackVar(it->second, InstBuilder::genLoadLoopVar(fLoopIndex),
+                                                      inst->fValue->clone(this));
+        } else {
+            return BasicCloneVisitor::visit(inst);
+        }
+    }
+};
+
 // Remove all variable declarations marked as "Address::kLink"
 struct RemoverCloneVisitor : public BasicCloneVisitor {
     // Rewrite Declare as a no-op (DropInst)
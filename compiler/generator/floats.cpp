@@ -38,11 +38,11 @@
 //          2: double precision float
 //          3: long double precision float
 
-static const char* mathsuffix[4];  // suffix for math functions
-static const char* numsuffix[4];   // suffix for numeric constants
-static const char* floatname[4];   // float types
-static const char* castname[4];    // float castings
-static double      floatmin[4];    // minimum float values before denormals
+static thread_local const char* mathsuffix[4];  // suffix for math functions
+static thread_local const char* numsuffix[4];   // suffix for numeric constants
+static thread_local const char* floatname[4];   // float types
+static thread_local const char* castname[4];    // float castings
+static thread_local double      floatmin[4];    // minimum float values before denormals
 
 void initFaustFloat()
 {
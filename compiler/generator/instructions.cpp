@@ -28,7 +28,7 @@
 #include "fir_to_fir.hh"
 
 // Used when inlining functions
-std::stack<BlockInst*> BasicCloneVisitor::fBlockStack;
+thread_local std::stack<BlockInst*> BasicCloneVisitor::fBlockStack;
 
 DeclareStructTypeInst* isStructType(const string& name)
 {
@@ -1278,7 +1278,7 @@ struct WhileLoopInst : public StatementInst {
 class BasicCloneVisitor : public CloneVisitor {
    protected:
     // Used when inlining functions
-    static std::stack<BlockInst*> fBlockStack;
+    static thread_local std::stack<BlockInst*> fBlockStack;
 
    public:
     BasicCloneVisitor() {}
@@ -1403,8 +1403,12 @@ class BasicCloneVisitor : public CloneVisitor {
     // Loop
     virtual StatementInst* visit(ForLoopInst* inst)
     {
-        return new ForLoopInst(inst->fInit->clone(this), inst->fEnd->clone(this), inst->fIncrement->clone(this),
-                               static_cast<BlockInst*>(inst->fCode->clone(this)), inst->fIsRecursive);
+        // The loop variable declaration has to be cloned first (function arguments evaluation order is unspecified)
+        StatementInst* init      = inst->fInit->clone(this);
+        ValueInst*     end       = inst->fEnd->clone(this);
+        StatementInst* increment = inst->fIncrement->clone(this);
+        BlockInst*     code      = static_cast<BlockInst*>(inst->fCode->clone(this));
+        return new ForLoopInst(init, end, increment, code, inst->fIsRecursive);
     }
 
     virtual StatementInst* visit(SimpleForLoopInst* inst)
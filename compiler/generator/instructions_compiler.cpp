@@ -44,7 +44,7 @@
 
 using namespace std;
 
-ostream* Printable::fOut = &cout;
+thread_local ostream* Printable::fOut = &cout;
 
 static inline BasicTyped* genBasicFIRTyped(int sig_type)
 {
@@ -236,10 +236,11 @@ class InstComplexityVisitor : public DispatchVisitor {
         fLoop += visitor.fLoop;
     }
 
+    // Rough estimation in cycles: arithmetic and memory accesses cost one cycle,
+    // calls a few ones and mathematical functions (sin, exp, pow...) a lot more
     int cost()
     {
-        // A polynom based on measured values
-        return 0;
+        return fLoad + fStore + fBinop + fCast + 2 * fSelect + 5 * fLoop + 5 * (fFunCall - fMathop) + 20 * fMathop;
     }
 };
 
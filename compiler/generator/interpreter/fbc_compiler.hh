@@ -24,6 +24,12 @@
 
 //#define MIR_BUILD 1
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "TMutex.h"
 #include "fbc_interpreter.hh"
 #ifdef MIR_BUILD
 #include "fbc_mir_compiler.hh"
@@ -31,33 +37,116 @@
 #include "fbc_llvm_compiler.hh"
 #endif
 
+/*
+ Compiled blocks shared by all instances of a factory.
+
+ The 'DSP' compute block can be compiled in a background thread (tiered mode, activated with the
+ FAUST_INTERP_TIERED environment variable): instances start with the interpreter, and switch to the
+ compiled code at the next buffer boundary once it is published in fComputeDSP. Since the compiled
+ code works on the same heaps than the interpreter, the DSP state is kept.
+*/
+template <class T>
+struct FBCCompiledBlocks {
+    std::atomic<FBCExecuteFun<T>*> fComputeDSP;  // Compiled 'DSP' compute block, or nullptr
+    std::once_flag                 fStarted;
+    std::thread                    fThread;
+
+    FBCCompiledBlocks() : fComputeDSP(nullptr) {}
+
+    virtual ~FBCCompiledBlocks()
+    {
+        if (fThread.joinable()) fThread.join();
+        delete fComputeDSP.load();
+    }
+
+    // The backend compilers share global state, so compilations are serialized
+    static TLockAble* getCompileLock()
+    {
+        static TLockAble gCompileLock;
+        return &gCompileLock;
+    }
+
+    static FBCExecuteFun<T>* compileBlock(FBCBlockInstruction<T>* block)
+    {
+        TLock lock(getCompileLock());
+    #ifdef MIR_BUILD
+        // Run with interp/MIR compiler
+        return new FBCMIRCompiler<T>(block);
+    #elif LLVM_BUILD
+        // Run with interp/LLVM compiler
+        return new FBCLLVMCompiler<T>(block);
+    #else
+        return nullptr;
+    #endif
+    }
+
+    // Compile the 'DSP' compute block once, synchronously or in the background
+    void compileComputeDSP(FBCBlockInstruction<T>* block)
+    {
+        std::call_once(fStarted, [this, block]() {
+            if (getenv("FAUST_INTERP_TIERED")) {
+                fThread = std::thread([this, block]() { fComputeDSP.store(compileBlock(block), std::memory_order_release); });
+            } else {
+                fComputeDSP.store(compileBlock(block), std::memory_order_release);
+            }
+        });
+    }
+};
+
 // FBC compiler
 template <class T>
 class FBCCompiler : public FBCInterpreter<T,0> {
    public:
-    typedef typename std::map<FBCBlockInstruction<T>*, FBCExecuteFun<T>*>           CompiledBlocksType;
-    typedef typename std::map<FBCBlockInstruction<T>*, FBCExecuteFun<T>*>::iterator CompiledBlocksTypeIT;
+    typedef FBCCompiledBlocks<T> CompiledBlocksType;
 
-    FBCCompiler(interpreter_dsp_factory_aux<T,0>* factory, CompiledBlocksType* map) : FBCInterpreter<T,0>(factory)
+    FBCCompiler(interpreter_dsp_factory_aux<T,0>* factory, CompiledBlocksType* blocks) : FBCInterpreter<T,0>(factory)
     {
-        fCompiledBlocks = map;
+        fCompiledBlocks = blocks;
+
+        // FBC blocks compilation (possibly in the background)
+        fCompiledBlocks->compileComputeDSP(factory->fComputeDSPBlock);
+    }
 
-        // FBC blocks compilation
-        //CompileBlock(factory->fComputeBlock);
-        CompileBlock(factory->fComputeDSPBlock);
+    virtual ~FBCCompiler()
+    {
+        for (auto& it : fBlocks) {
+            delete it.second;
+        }
     }
 
-    virtual ~FBCCompiler() {}
+    // Compiled blocks read the static tables in the instance heap
+    virtual bool sharesStaticHeap() { return false; }
 
-    void ExecuteBlock(FBCBlockInstruction<T>* block, bool compile)
+    virtual void PrepareBlock(FBCBlockInstruction<T>* block)
     {
-        if (compile && fCompiledBlocks->find(block) == fCompiledBlocks->end()) {
-            CompileBlock(block);
+        removeCompiledBlock(block);
+        FBCInterpreter<T,0>::PrepareBlock(block);
+    }
+
+    virtual void CompileBlock(FBCBlockInstruction<T>* block)
+    {
+        removeCompiledBlock(block);
+        FBCExecuteFun<T>* fun = CompiledBlocksType::compileBlock(block);
+        if (fun) fBlocks[block] = fun;
+    }
+
+    void ExecuteBlock(FBCBlockInstruction<T>* block)
+    {
+        // The 'DSP' compute block is executed by the compiled code as soon as it is available
+        if (block == this->fFactory->fComputeDSPBlock) {
+            FBCExecuteFun<T>* fun = fCompiledBlocks->fComputeDSP.load(std::memory_order_acquire);
+            if (fun) {
+                fun->Execute(this->fIntHeap, this->fRealHeap, this->fInputs, this->fOutputs);
+            } else {
+                FBCInterpreter<T,0>::ExecuteBlock(block);
+            }
+            return;
         }
 
-        // The 'DSP' compute block only is compiled..
-        if (fCompiledBlocks->find(block) != fCompiledBlocks->end()) {
-            ((*fCompiledBlocks)[block])->Execute(this->fIntHeap, this->fRealHeap, this->fInputs, this->fOutputs);
+        // Instance specific blocks are only compiled in CompileBlock, fBlocks is read-only here
+        auto it = fBlocks.find(block);
+        if (it != fBlocks.end()) {
+            (*it).second->Execute(this->fIntHeap, this->fRealHeap, this->fInputs, this->fOutputs);
         } else {
             FBCInterpreter<T,0>::ExecuteBlock(block);
         }
@@ -66,18 +155,16 @@ class FBCCompiler : public FBCInterpreter<T,0> {
    protected:
     CompiledBlocksType* fCompiledBlocks;
 
-    void CompileBlock(FBCBlockInstruction<T>* block)
+    // Instance specific compiled blocks, only changed out of the audio thread
+    std::map<FBCBlockInstruction<T>*, FBCExecuteFun<T>*> fBlocks;
+
+    // A new block may reuse the address of a deleted one
+    void removeCompiledBlock(FBCBlockInstruction<T>* block)
     {
-        if (fCompiledBlocks->find(block) == fCompiledBlocks->end()) {
-        #ifdef MIR_BUILD
-            // Run with interp/MIR compiler
-            (*fCompiledBlocks)[block] = new FBCMIRCompiler<T>(block);
-        #elif LLVM_BUILD
-            // Run with interp/LLVM compiler
-            (*fCompiledBlocks)[block] = new FBCLLVMCompiler<T>(block);
-        #endif
-        } else {
-            // std::cout << "FBCCompiler: reuse compiled block" << std::endl;
+        auto it = fBlocks.find(block);
+        if (it != fBlocks.end()) {
+            delete it->second;
+            fBlocks.erase(it);
         }
     }
 };
@@ -29,11 +29,22 @@ template <class T>
 struct FBCExecutor {
     
     virtual void ExecuteBuildUserInterface(FIRUserInterfaceBlockInstruction<T>* block, UITemplate* glue) {};
-    virtual void ExecuteBlock(FBCBlockInstruction<T>* block, bool compile = false) {};
+    virtual void ExecuteBlock(FBCBlockInstruction<T>* block) {};
+    // Called out of the audio thread on instance specific blocks, before they are executed
+    virtual void PrepareBlock(FBCBlockInstruction<T>* block) {};
+    // Called out of the audio thread on instance specific blocks to be executed by compiled code (if available)
+    virtual void CompileBlock(FBCBlockInstruction<T>* block) {};
+
+    // Static tables read in the memory shared by the factory instances (only by flat blocks)
+    virtual void setStaticHeap(int* int_heap, T* real_heap) {}
+    virtual bool sharesStaticHeap() { return false; }
 
     virtual void setIntValue(int offset, int value) {}
     virtual int  getIntValue(int offset) { return -1; }
 
+    virtual int* getIntHeap() { return nullptr; }
+    virtual T*   getRealHeap() { return nullptr; }
+
     virtual void setInput(int offset, T* buffer) {}
     virtual void setOutput(int offset, T* buffer) {}
 
@@ -31,6 +31,7 @@
 
 #include "exception.hh"
 #include "fbc_executor.hh"
+#include "fbc_vec_interpreter.hh"
 #include "interpreter_bytecode.hh"
 
 /*
@@ -71,8 +72,50 @@ class FBCInterpreter : public FBCExecutor<T> {
     T** fInputs;
     T** fOutputs;
 
+    // Static tables shared by the factory instances
+    int* fStaticIntHeap;
+    T*   fStaticRealHeap;
+
     std::map<int, long long> fRealStats;
 
+    // Currently executed block
+    FBCFlatBlock<T>* fFlatBlock;
+
+    // Flat blocks this executor runs: the factory ones (shared) and the instance specific ones (owned)
+    struct FlatBlockEntry {
+        FBCBlockInstruction<T>* fBlock;
+        FBCFlatBlock<T>*        fFlatBlock;
+        bool                    fOwned;
+    };
+    std::vector<FlatBlockEntry> fFlatBlocks;
+
+    // Blocks are all prepared out of the audio thread, so this lookup never allocates
+    FBCFlatBlock<T>* getFlatBlock(FBCBlockInstruction<T>* block)
+    {
+        for (auto& it : fFlatBlocks) {
+            if (it.fBlock == block) return it.fFlatBlock;
+        }
+        throw faustexception("ERROR : interpreter block executed without being prepared\n");
+    }
+
+    void addFlatBlock(FBCBlockInstruction<T>* block)
+    {
+        // A new block may reuse the address of a deleted one
+        for (size_t i = 0; i < fFlatBlocks.size(); i++) {
+            if (fFlatBlocks[i].fBlock == block) {
+                if (fFlatBlocks[i].fOwned) delete fFlatBlocks[i].fFlatBlock;
+                fFlatBlocks.erase(fFlatBlocks.begin() + i);
+                break;
+            }
+        }
+        FBCFlatBlock<T>* flat_block = fFactory->findFlatBlock(block);
+        if (flat_block) {
+            fFlatBlocks.push_back({block, flat_block, false});
+        } else {
+            fFlatBlocks.push_back({block, new FBCFlatBlock<T>(block), true});
+        }
+    }
+
     /*
      Keeps the latest TRACE_STACK_SIZE executed instructions, to be displayed when an error occurs.
      */
@@ -107,9 +150,9 @@ class FBCInterpreter : public FBCExecutor<T> {
             }
         }
 
-        void traceInstruction(InstructionIT it)
+        void traceInstruction(FBCFlatBlock<T>* block, FlatInstructionIT it)
         {
-            (*it)->write(&fMessage, false, false, false);  // Last param = false means no recursion in branches
+            block->write(&fMessage, it);
             push(fMessage.str());
             fMessage.str("");
         }
@@ -117,10 +160,10 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     InterpreterTrace fTraceContext;
 
-    inline void traceInstruction(InstructionIT it)
+    inline void traceInstruction(FlatInstructionIT it)
     {
         if (TRACE >= 4) {
-            fTraceContext.traceInstruction(it);
+            fTraceContext.traceInstruction(fFlatBlock, it);
         }
     }
 
@@ -145,7 +188,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
-    inline void warningOverflow(InstructionIT it)
+    inline void warningOverflow(FlatInstructionIT it)
     {
         if (TRACE >= 6) return;
 
@@ -161,7 +204,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
-    inline void checkDivZero(InstructionIT it, T val)
+    inline void checkDivZero(FlatInstructionIT it, T val)
     {
         if (TRACE >= 6) return;
 
@@ -177,7 +220,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
-    inline T checkRealAux(InstructionIT it, T val)
+    inline T checkRealAux(FlatInstructionIT it, T val)
     {
         if (TRACE >= 6) return val;
 
@@ -219,7 +262,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         return val;
     }
 
-    inline int assertAudioBuffer(InstructionIT it, int index)
+    inline int assertAudioBuffer(FlatInstructionIT it, int index)
     {
         if (TRACE >= 6) return index;
 
@@ -236,20 +279,20 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
 
-    inline int assertIntHeap(InstructionIT it, int index, int size = -1)
+    inline int assertIntHeap(FlatInstructionIT it, int index, int size = -1)
     {
         if (TRACE >= 4 &&
-            ((index < 0) || (index >= fFactory->fIntHeapSize) || (size > 0 && (index >= ((*it)->fOffset1 + size))))) {
+            ((index < 0) || (index >= fFactory->fIntHeapSize) || (size > 0 && (index >= (it->fOffset1 + size))))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
             if (size > 0) {
                 std::cout << "assertIntHeap array: fIntHeapSize ";
-                std::cout << fFactory->fIntHeapSize << " index " << (index - (*it)->fOffset1);
+                std::cout << fFactory->fIntHeapSize << " index " << (index - it->fOffset1);
                 std::cout << " size " << size;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             } else {
                 std::cout << "assertIntHeap scalar: fIntHeapSize ";
                 std::cout << fFactory->fIntHeapSize << " index " << index;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             }
             fTraceContext.write(&std::cout);
             std::cout << "-------- Interpreter crash trace end --------\n\n";
@@ -260,20 +303,20 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
 
-    inline int assertRealHeap(InstructionIT it, int index, int size = -1)
+    inline int assertRealHeap(FlatInstructionIT it, int index, int size = -1)
     {
         if (TRACE >= 4 &&
-            ((index < 0) || (index >= fFactory->fRealHeapSize) || (size > 0 && (index >= ((*it)->fOffset1 + size))))) {
+            ((index < 0) || (index >= fFactory->fRealHeapSize) || (size > 0 && (index >= (it->fOffset1 + size))))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
             if (size > 0) {
                 std::cout << "assertRealHeap array: fIntHeapSize ";
-                std::cout << fFactory->fRealHeapSize << " index " << (index - (*it)->fOffset1);
+                std::cout << fFactory->fRealHeapSize << " index " << (index - it->fOffset1);
                 std::cout << " size " << size;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             } else {
                 std::cout << "assertRealHeap scalar: fIntHeapSize ";
                 std::cout << fFactory->fRealHeapSize << " index " << index;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             }
             fTraceContext.write(&std::cout);
             std::cout << "-------- Interpreter crash trace end --------\n\n";
@@ -284,7 +327,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
 
-    inline int assertSoundHeap(InstructionIT it, int index, int size = -1)
+    inline int assertSoundHeap(FlatInstructionIT it, int index, int size = -1)
     {
         if (TRACE >= 4 && ((index < 0) || (index >= fFactory->fSoundHeapSize) || (size > 0 && index >= size))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
@@ -300,24 +343,24 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
 
-    inline int assertLoadIntHeap(InstructionIT it, int index, int size = -1)
+    inline int assertLoadIntHeap(FlatInstructionIT it, int index, int size = -1)
     {
         if ((TRACE >= 4) &&
             ((index < 0)
              || (index >= fFactory->fIntHeapSize)
-             || (size > 0 && (index >= ((*it)->fOffset1 + size)))
+             || (size > 0 && (index >= (it->fOffset1 + size)))
              || (fIntHeap[index] == DUMMY_INT))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
             if (size > 0) {
                 std::cout << "assertLoadIntHeap array: fIntHeapSize ";
-                std::cout << fFactory->fIntHeapSize << " index " << (index - (*it)->fOffset1);
+                std::cout << fFactory->fIntHeapSize << " index " << (index - it->fOffset1);
                 std::cout << " size " << size;
                 std::cout << " value " << fIntHeap[index];
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             } else {
                 std::cout << "assertLoadIntHeap scalar: fIntHeapSize ";
                 std::cout << fFactory->fIntHeapSize << " index " << index;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             }
             fTraceContext.write(&std::cout);
             std::cout << "-------- Interpreter crash trace end --------\n\n";
@@ -328,24 +371,24 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
 
-    inline int assertLoadRealHeap(InstructionIT it, int index, int size = -1)
+    inline int assertLoadRealHeap(FlatInstructionIT it, int index, int size = -1)
     {
         if ((TRACE >= 4) &&
             ((index < 0)
              || (index >= fFactory->fRealHeapSize)
-             || (size > 0 && (index >= ((*it)->fOffset1 + size)))
+             || (size > 0 && (index >= (it->fOffset1 + size)))
              || (fRealHeap[index] == T(DUMMY_REAL)))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
             if (size > 0) {
                 std::cout << "assertLoadRealHeap array: fRealHeapSize ";
-                std::cout << fFactory->fRealHeapSize << " index " << (index - (*it)->fOffset1);
+                std::cout << fFactory->fRealHeapSize << " index " << (index - it->fOffset1);
                 std::cout << " size " << size;
                 std::cout << " value " << fRealHeap[index];
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             } else {
                 std::cout << "assertLoadRealHeap scalar: fRealHeapSize ";
                 std::cout << fFactory->fRealHeapSize << " index " << index;
-                std::cout << " name " << (*it)->fName << std::endl;
+                std::cout << " name " << fFlatBlock->getName(it) << std::endl;
             }
             fTraceContext.write(&std::cout);
             std::cout << "-------- Interpreter crash trace end --------\n\n";
@@ -356,7 +399,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         return index;
     }
     
-    inline void assertIndex(InstructionIT it, int index, int size = -1)
+    inline void assertIndex(FlatInstructionIT it, int index, int size = -1)
     {
         if ((TRACE >= 4) && ((index < 0) || (index >= size))) {
             std::cout << "-------- Interpreter crash trace start --------" << std::endl;
@@ -370,7 +413,7 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
-    inline T checkReal(InstructionIT it, T val) { return (TRACE > 0) ? checkRealAux(it, val) : val; }
+    inline T checkReal(FlatInstructionIT it, T val) { return (TRACE > 0) ? checkRealAux(it, val) : val; }
 
 #define pushInt(val) (int_stack[int_stack_index++] = val)
 #define popInt() (int_stack[--int_stack_index])
@@ -456,7 +499,14 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
-    virtual void ExecuteBlock(FBCBlockInstruction<T>* block, bool compile = false)
+    virtual void ExecuteBlock(FBCBlockInstruction<T>* block)
+    {
+        ExecuteFlatBlock(getFlatBlock(block));
+    }
+
+    virtual void PrepareBlock(FBCBlockInstruction<T>* block) { addFlatBlock(block); }
+
+    void ExecuteFlatBlock(FBCFlatBlock<T>* block)
     {
         static void* fDispatchTable[] = {
 
@@ -555,7 +605,15 @@ class FBCInterpreter : public FBCExecutor<T> {
             &&do_kLoop, &&do_kReturn,
 
             // Select/if
-            &&do_kIf, &&do_kSelectReal, &&do_kSelectInt, &&do_kCondBranch
+            &&do_kIf, &&do_kSelectReal, &&do_kSelectInt, &&do_kCondBranch,
+
+            // Superinstructions
+            &&do_kMultAddRealHeap, &&do_kMultAddRealHeapStore, &&do_kMultAddRealStack, &&do_kAddRealStore,
+            &&do_kSubRealStore, &&do_kMultRealStore, &&do_kAddRealStackStore, &&do_kSubRealStackStore,
+            &&do_kMultRealStackStore, &&do_kLoadIndexedRealMask, &&do_kStoreIndexedRealMask,
+
+            // Flat bytecode only
+            &&do_kLoadIndexedStaticReal, &&do_kLoadIndexedStaticInt
 
         };
 
@@ -567,37 +625,37 @@ class FBCInterpreter : public FBCExecutor<T> {
         T             real_stack[512];
         int           int_stack[512];
         Soundfile*    sound_stack[512];
-        InstructionIT address_stack[64];
+        FlatInstructionIT address_stack[64];
 
-#define dispatchFirstScal()                   \
-    {                                         \
-        goto *fDispatchTable[(*it)->fOpcode]; \
+#define dispatchFirstScal()                \
+    {                                      \
+        goto *fDispatchTable[it->fOpcode]; \
     }
-#define dispatchNextScal()                    \
-    {                                         \
-        traceInstruction(it);                 \
-        it++;                                 \
-        goto *fDispatchTable[(*it)->fOpcode]; \
+#define dispatchNextScal()                 \
+    {                                      \
+        traceInstruction(it);              \
+        it++;                              \
+        goto *fDispatchTable[it->fOpcode]; \
     }
 
-#define dispatchBranch1Scal()                        \
-    {                                                \
-        it = (*it)->fBranch1->fInstructions.begin(); \
-        dispatchFirstScal();                         \
+#define dispatchBranch1Scal() \
+    {                         \
+        it += it->fBranch1;   \
+        dispatchFirstScal();  \
     }
-#define dispatchBranch2Scal()                        \
-    {                                                \
-        it = (*it)->fBranch2->fInstructions.begin(); \
-        dispatchFirstScal();                         \
+#define dispatchBranch2Scal() \
+    {                         \
+        it += it->fBranch2;   \
+        dispatchFirstScal();  \
     }
 
-#define pushBranch1Scal()                                  \
-    {                                                      \
-        pushAddr_((*it)->fBranch1->fInstructions.begin()); \
+#define pushBranch1Scal()             \
+    {                                 \
+        pushAddr_(it + it->fBranch1); \
     }
-#define pushBranch2Scal()                                  \
-    {                                                      \
-        pushAddr_((*it)->fBranch2->fInstructions.begin()); \
+#define pushBranch2Scal()             \
+    {                                 \
+        pushAddr_(it + it->fBranch2); \
     }
 
 #define dispatchReturnScal() \
@@ -611,47 +669,49 @@ class FBCInterpreter : public FBCExecutor<T> {
     }
 #define emptyReturnScal() (addr_stack_index == 0)
 
-        // Check block coherency
-        block->check();
+        // Side tables used by kBlockStoreReal/kBlockStoreInt
+        const T*   real_table = block->fRealTable.data();
+        const int* int_table  = block->fIntTable.data();
 
-        InstructionIT it = block->fInstructions.begin();
+        fFlatBlock           = block;
+        FlatInstructionIT it = block->begin();
         dispatchFirstScal();
 
     // Number operations
     do_kRealValue : {
-        pushReal(it, (*it)->fRealValue);
+        pushReal(it, it->fRealValue);
         dispatchNextScal();
     }
 
     do_kInt32Value : {
-        pushInt((*it)->fIntValue);
+        pushInt(it->fIntValue);
         dispatchNextScal();
     }
 
     // Memory operations
     do_kLoadReal : {
         if (TRACE > 0) {
-            pushReal(it, fRealHeap[assertLoadRealHeap(it, (*it)->fOffset1)]);
+            pushReal(it, fRealHeap[assertLoadRealHeap(it, it->fOffset1)]);
         } else {
-            pushReal(it, fRealHeap[(*it)->fOffset1]);
+            pushReal(it, fRealHeap[it->fOffset1]);
         }
         dispatchNextScal();
     }
 
     do_kLoadInt : {
         if (TRACE > 0) {
-            pushInt(fIntHeap[assertLoadIntHeap(it, (*it)->fOffset1)]);
+            pushInt(fIntHeap[assertLoadIntHeap(it, it->fOffset1)]);
         } else {
-            pushInt(fIntHeap[(*it)->fOffset1]);
+            pushInt(fIntHeap[it->fOffset1]);
         }
         dispatchNextScal();
     }
 
     do_kLoadSound : {
         if (TRACE > 0) {
-            pushSound(fSoundHeap[assertSoundHeap(it, (*it)->fOffset1)]);
+            pushSound(fSoundHeap[assertSoundHeap(it, it->fOffset1)]);
         } else {
-            pushSound(fSoundHeap[(*it)->fOffset1]);
+            pushSound(fSoundHeap[it->fOffset1]);
         }
         dispatchNextScal();
     }
@@ -659,9 +719,9 @@ class FBCInterpreter : public FBCExecutor<T> {
     do_kLoadSoundField : {
         /*
         if (TRACE > 0) {
-            pushSound(fSoundHeap[assertSoundHeap(it, (*it)->fOffset1)]);
+            pushSound(fSoundHeap[assertSoundHeap(it, it->fOffset1)]);
         } else {
-            pushSound(fSoundHeap[(*it)->fOffset1]);
+            pushSound(fSoundHeap[it->fOffset1]);
         }
         dispatchNextScal();
         */
@@ -669,18 +729,18 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kStoreReal : {
         if (TRACE > 0) {
-            fRealHeap[assertRealHeap(it, (*it)->fOffset1)] = popReal(it);
+            fRealHeap[assertRealHeap(it, it->fOffset1)] = popReal(it);
         } else {
-            fRealHeap[(*it)->fOffset1] = popReal(it);
+            fRealHeap[it->fOffset1] = popReal(it);
         }
         dispatchNextScal();
     }
 
     do_kStoreInt : {
         if (TRACE > 0) {
-            fIntHeap[assertIntHeap(it, (*it)->fOffset1)] = popInt();
+            fIntHeap[assertIntHeap(it, it->fOffset1)] = popInt();
         } else {
-            fIntHeap[(*it)->fOffset1] = popInt();
+            fIntHeap[it->fOffset1] = popInt();
         }
         dispatchNextScal();
     }
@@ -688,9 +748,9 @@ class FBCInterpreter : public FBCExecutor<T> {
     do_kStoreSound : {
         /*
         if (TRACE > 0) {
-            fSoundHeap[assertSoundHeap(it, (*it)->fOffset1)] = popSound();
+            fSoundHeap[assertSoundHeap(it, it->fOffset1)] = popSound();
         } else {
-            fSoundHeap[(*it)->fOffset1] = popSound();
+            fSoundHeap[it->fOffset1] = popSound();
         }
         */
         dispatchNextScal();
@@ -699,18 +759,18 @@ class FBCInterpreter : public FBCExecutor<T> {
     // Directly store a value
     do_kStoreRealValue : {
         if (TRACE > 0) {
-            fRealHeap[assertRealHeap(it, (*it)->fOffset1)] = (*it)->fRealValue;
+            fRealHeap[assertRealHeap(it, it->fOffset1)] = it->fRealValue;
         } else {
-            fRealHeap[(*it)->fOffset1] = (*it)->fRealValue;
+            fRealHeap[it->fOffset1] = it->fRealValue;
         }
         dispatchNextScal();
     }
 
     do_kStoreIntValue : {
         if (TRACE > 0) {
-            fIntHeap[assertIntHeap(it, (*it)->fOffset1)] = (*it)->fIntValue;
+            fIntHeap[assertIntHeap(it, it->fOffset1)] = it->fIntValue;
         } else {
-            fIntHeap[(*it)->fOffset1] = (*it)->fIntValue;
+            fIntHeap[it->fOffset1] = it->fIntValue;
         }
         dispatchNextScal();
     }
@@ -719,10 +779,10 @@ class FBCInterpreter : public FBCExecutor<T> {
         int offset = popInt();
         if (TRACE > 0) {
             // DEBUG
-            // assertIndex(it, offset, (*it)->fOffset2);
-            pushReal(it, fRealHeap[assertLoadRealHeap(it, (*it)->fOffset1 + offset, (*it)->fOffset2)]);
+            // assertIndex(it, offset, it->fOffset2);
+            pushReal(it, fRealHeap[assertLoadRealHeap(it, it->fOffset1 + offset, it->fOffset2)]);
         } else {
-            pushReal(it, fRealHeap[(*it)->fOffset1 + offset]);
+            pushReal(it, fRealHeap[it->fOffset1 + offset]);
         }
         dispatchNextScal();
     }
@@ -731,10 +791,10 @@ class FBCInterpreter : public FBCExecutor<T> {
         int offset = popInt();
         if (TRACE > 0) {
             // DEBUG
-            // assertIndex(it, offset, (*it)->fOffset2);
-            pushInt(fIntHeap[assertLoadIntHeap(it, (*it)->fOffset1 + offset, (*it)->fOffset2)]);
+            // assertIndex(it, offset, it->fOffset2);
+            pushInt(fIntHeap[assertLoadIntHeap(it, it->fOffset1 + offset, it->fOffset2)]);
         } else {
-            pushInt(fIntHeap[(*it)->fOffset1 + offset]);
+            pushInt(fIntHeap[it->fOffset1 + offset]);
         }
         dispatchNextScal();
     }
@@ -743,10 +803,10 @@ class FBCInterpreter : public FBCExecutor<T> {
         int offset = popInt();
         if (TRACE > 0) {
             // DEBUG
-            // assertIndex(it, offset, (*it)->fOffset2);
-            fRealHeap[assertRealHeap(it, (*it)->fOffset1 + offset, (*it)->fOffset2)] = popReal(it);
+            // assertIndex(it, offset, it->fOffset2);
+            fRealHeap[assertRealHeap(it, it->fOffset1 + offset, it->fOffset2)] = popReal(it);
         } else {
-            fRealHeap[(*it)->fOffset1 + offset] = popReal(it);
+            fRealHeap[it->fOffset1 + offset] = popReal(it);
         }
         dispatchNextScal();
     }
@@ -755,77 +815,73 @@ class FBCInterpreter : public FBCExecutor<T> {
         int offset = popInt();
         if (TRACE > 0) {
             // DEBUG
-            // assertIndex(it, offset, (*it)->fOffset2);
-            fIntHeap[assertIntHeap(it, (*it)->fOffset1 + offset, (*it)->fOffset2)] = popInt();
+            // assertIndex(it, offset, it->fOffset2);
+            fIntHeap[assertIntHeap(it, it->fOffset1 + offset, it->fOffset2)] = popInt();
         } else {
-            fIntHeap[(*it)->fOffset1 + offset] = popInt();
+            fIntHeap[it->fOffset1 + offset] = popInt();
         }
         dispatchNextScal();
     }
 
     do_kBlockStoreReal : {
-        FIRBlockStoreRealInstruction<T>* inst = static_cast<FIRBlockStoreRealInstruction<T>*>(*it);
-        assertInterp(inst);
-        for (int i = 0; i < inst->fOffset2; i++) {
-            fRealHeap[inst->fOffset1 + i] = inst->fNumTable[i];
+        for (int i = 0; i < it->fOffset2; i++) {
+            fRealHeap[it->fOffset1 + i] = real_table[it->fIntValue + i];
         }
         dispatchNextScal();
     }
 
     do_kBlockStoreInt : {
-        FIRBlockStoreIntInstruction<T>* inst = static_cast<FIRBlockStoreIntInstruction<T>*>(*it);
-        assertInterp(inst);
-        for (int i = 0; i < inst->fOffset2; i++) {
-            fIntHeap[inst->fOffset1 + i] = inst->fNumTable[i];
+        for (int i = 0; i < it->fOffset2; i++) {
+            fIntHeap[it->fOffset1 + i] = int_table[it->fIntValue + i];
         }
         dispatchNextScal();
     }
 
     do_kMoveReal : {
-        fRealHeap[(*it)->fOffset1] = fRealHeap[(*it)->fOffset2];
+        fRealHeap[it->fOffset1] = fRealHeap[it->fOffset2];
         dispatchNextScal();
     }
 
     do_kMoveInt : {
-        fIntHeap[(*it)->fOffset1] = fIntHeap[(*it)->fOffset2];
+        fIntHeap[it->fOffset1] = fIntHeap[it->fOffset2];
         dispatchNextScal();
     }
 
     do_kPairMoveReal : {
-        fRealHeap[(*it)->fOffset1] = fRealHeap[(*it)->fOffset1 - 1];
-        fRealHeap[(*it)->fOffset2] = fRealHeap[(*it)->fOffset2 - 1];
+        fRealHeap[it->fOffset1] = fRealHeap[it->fOffset1 - 1];
+        fRealHeap[it->fOffset2] = fRealHeap[it->fOffset2 - 1];
         dispatchNextScal();
     }
 
     do_kPairMoveInt : {
-        fIntHeap[(*it)->fOffset1] = fIntHeap[(*it)->fOffset1 - 1];
-        fIntHeap[(*it)->fOffset2] = fIntHeap[(*it)->fOffset2 - 1];
+        fIntHeap[it->fOffset1] = fIntHeap[it->fOffset1 - 1];
+        fIntHeap[it->fOffset2] = fIntHeap[it->fOffset2 - 1];
         dispatchNextScal();
     }
 
     do_kBlockPairMoveReal : {
-        for (int i = (*it)->fOffset1; i < (*it)->fOffset2; i += 2) {
+        for (int i = it->fOffset1; i < it->fOffset2; i += 2) {
             fRealHeap[i + 1] = fRealHeap[i];
         }
         dispatchNextScal();
     }
 
     do_kBlockPairMoveInt : {
-        for (int i = (*it)->fOffset1; i < (*it)->fOffset2; i += 2) {
+        for (int i = it->fOffset1; i < it->fOffset2; i += 2) {
             fIntHeap[i + 1] = fIntHeap[i];
         }
         dispatchNextScal();
     }
 
     do_kBlockShiftReal : {
-        for (int i = (*it)->fOffset1; i > (*it)->fOffset2; i -= 1) {
+        for (int i = it->fOffset1; i > it->fOffset2; i -= 1) {
             fRealHeap[i] = fRealHeap[i - 1];
         }
         dispatchNextScal();
     }
 
     do_kBlockShiftInt : {
-        for (int i = (*it)->fOffset1; i > (*it)->fOffset2; i -= 1) {
+        for (int i = it->fOffset1; i > it->fOffset2; i -= 1) {
             fIntHeap[i] = fIntHeap[i - 1];
         }
         dispatchNextScal();
@@ -834,28 +890,28 @@ class FBCInterpreter : public FBCExecutor<T> {
     // Input/output access
     do_kLoadInput : {
         if (TRACE > 0) {
-            pushReal(it, fInputs[(*it)->fOffset1][assertAudioBuffer(it, popInt())]);
+            pushReal(it, fInputs[it->fOffset1][assertAudioBuffer(it, popInt())]);
         } else {
             /*
             int index = popInt();
-            pushReal(it, fInputs[(*it)->fOffset1][index]);
+            pushReal(it, fInputs[it->fOffset1][index]);
             std::cout << "do_kLoadInput " << index << std::endl;
             */
-            pushReal(it, fInputs[(*it)->fOffset1][popInt()]);
+            pushReal(it, fInputs[it->fOffset1][popInt()]);
         }
         dispatchNextScal();
     }
 
     do_kStoreOutput : {
         if (TRACE > 0) {
-            fOutputs[(*it)->fOffset1][assertAudioBuffer(it, popInt())] = popReal(it);
+            fOutputs[it->fOffset1][assertAudioBuffer(it, popInt())] = popReal(it);
         } else {
             /*
             int index = popInt();
             std::cout << "do_kStoreOutput " << index << std::endl;
-            fOutputs[(*it)->fOffset1][index] = popReal(it);
+            fOutputs[it->fOffset1][index] = popReal(it);
             */
-            fOutputs[(*it)->fOffset1][popInt()] = popReal(it);
+            fOutputs[it->fOffset1][popInt()] = popReal(it);
         }
         dispatchNextScal();
     }
@@ -867,7 +923,7 @@ class FBCInterpreter : public FBCExecutor<T> {
     }
 
     do_kCastRealHeap : {
-        pushReal(it, T(fIntHeap[(*it)->fOffset1]));
+        pushReal(it, T(fIntHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
@@ -886,13 +942,13 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kCastIntHeap : {
         if (TRACE >= 3) {
-            T val = fRealHeap[(*it)->fOffset1];
+            T val = fRealHeap[it->fOffset1];
             if (val > std::numeric_limits<int>::max() || val < std::numeric_limits<int>::min()) {
                 fRealStats[CAST_INT_OVERFLOW]++;
             }
             pushInt(int(val));
         } else {
-            pushInt(int(fRealHeap[(*it)->fOffset1]));
+            pushInt(int(fRealHeap[it->fOffset1]));
         }
         dispatchNextScal();
     }
@@ -1150,141 +1206,141 @@ class FBCInterpreter : public FBCExecutor<T> {
         //-----------------------------------------------------
 
     do_kAddRealHeap : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] + fRealHeap[(*it)->fOffset2]);
+        pushReal(it, fRealHeap[it->fOffset1] + fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kAddIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] + fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] + fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kSubRealHeap : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] - fRealHeap[(*it)->fOffset2]);
+        pushReal(it, fRealHeap[it->fOffset1] - fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kSubIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] - fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] - fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kMultRealHeap : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] * fRealHeap[(*it)->fOffset2]);
+        pushReal(it, fRealHeap[it->fOffset1] * fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kMultIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] * fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] * fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kDivRealHeap : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] / fRealHeap[(*it)->fOffset2]);
+        pushReal(it, fRealHeap[it->fOffset1] / fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kDivIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] / fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] / fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kRemRealHeap : {
-        pushReal(it, std::remainder(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::remainder(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kRemIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] % fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] % fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     // Shift operation
     do_kLshIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] << fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] << fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kRshIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] >> fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] >> fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     // Comparaison Int
     do_kGTIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] > fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] > fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kLTIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] < fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] < fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kGEIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] >= fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] >= fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kLEIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] <= fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] <= fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kEQIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] == fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] == fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kNEIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] != fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] != fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     // Comparaison Real
     do_kGTRealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] > fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] > fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kLTRealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] < fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] < fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kGERealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] >= fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] >= fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kLERealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] <= fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] <= fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kEQRealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] == fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] == fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kNERealHeap : {
-        pushInt(fRealHeap[(*it)->fOffset1] != fRealHeap[(*it)->fOffset2]);
+        pushInt(fRealHeap[it->fOffset1] != fRealHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     // Logical operations
     do_kANDIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] & fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] & fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kORIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] | fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] | fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
     do_kXORIntHeap : {
-        pushInt(fIntHeap[(*it)->fOffset1] ^ fIntHeap[(*it)->fOffset2]);
+        pushInt(fIntHeap[it->fOffset1] ^ fIntHeap[it->fOffset2]);
         dispatchNextScal();
     }
 
@@ -1294,167 +1350,167 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kAddRealStack : {
         T v1 = popReal(it);
-        pushReal(it, fRealHeap[(*it)->fOffset1] + v1);
+        pushReal(it, fRealHeap[it->fOffset1] + v1);
         dispatchNextScal();
     }
 
     do_kAddIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] + v1);
+        pushInt(fIntHeap[it->fOffset1] + v1);
         dispatchNextScal();
     }
 
     do_kSubRealStack : {
         T v1 = popReal(it);
-        pushReal(it, fRealHeap[(*it)->fOffset1] - v1);
+        pushReal(it, fRealHeap[it->fOffset1] - v1);
         dispatchNextScal();
     }
 
     do_kSubIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] - v1);
+        pushInt(fIntHeap[it->fOffset1] - v1);
         dispatchNextScal();
     }
 
     do_kMultRealStack : {
         T v1 = popReal(it);
-        pushReal(it, fRealHeap[(*it)->fOffset1] * v1);
+        pushReal(it, fRealHeap[it->fOffset1] * v1);
         dispatchNextScal();
     }
 
     do_kMultIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] * v1);
+        pushInt(fIntHeap[it->fOffset1] * v1);
         dispatchNextScal();
     }
 
     do_kDivRealStack : {
         T v1 = popReal(it);
-        pushReal(it, fRealHeap[(*it)->fOffset1] / v1);
+        pushReal(it, fRealHeap[it->fOffset1] / v1);
         dispatchNextScal();
     }
 
     do_kDivIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] / v1);
+        pushInt(fIntHeap[it->fOffset1] / v1);
         dispatchNextScal();
     }
 
     do_kRemRealStack : {
         T v1 = popReal(it);
-        pushReal(it, std::remainder(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::remainder(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kRemIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] % v1);
+        pushInt(fIntHeap[it->fOffset1] % v1);
         dispatchNextScal();
     }
 
     // Shift operation
     do_kLshIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] << v1);
+        pushInt(fIntHeap[it->fOffset1] << v1);
         dispatchNextScal();
     }
 
     do_kRshIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] >> v1);
+        pushInt(fIntHeap[it->fOffset1] >> v1);
         dispatchNextScal();
     }
 
     // Comparaison Int
     do_kGTIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] > v1);
+        pushInt(fIntHeap[it->fOffset1] > v1);
         dispatchNextScal();
     }
 
     do_kLTIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] < v1);
+        pushInt(fIntHeap[it->fOffset1] < v1);
         dispatchNextScal();
     }
 
     do_kGEIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] >= v1);
+        pushInt(fIntHeap[it->fOffset1] >= v1);
         dispatchNextScal();
     }
 
     do_kLEIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] <= v1);
+        pushInt(fIntHeap[it->fOffset1] <= v1);
         dispatchNextScal();
     }
 
     do_kEQIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] == v1);
+        pushInt(fIntHeap[it->fOffset1] == v1);
         dispatchNextScal();
     }
 
     do_kNEIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] != v1);
+        pushInt(fIntHeap[it->fOffset1] != v1);
         dispatchNextScal();
     }
 
     // Comparaison Real
     do_kGTRealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] > v1);
+        pushInt(fRealHeap[it->fOffset1] > v1);
         dispatchNextScal();
     }
 
     do_kLTRealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] < v1);
+        pushInt(fRealHeap[it->fOffset1] < v1);
         dispatchNextScal();
     }
 
     do_kGERealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] >= v1);
+        pushInt(fRealHeap[it->fOffset1] >= v1);
         dispatchNextScal();
     }
 
     do_kLERealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] <= v1);
+        pushInt(fRealHeap[it->fOffset1] <= v1);
         dispatchNextScal();
     }
 
     do_kEQRealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] == v1);
+        pushInt(fRealHeap[it->fOffset1] == v1);
         dispatchNextScal();
     }
 
     do_kNERealStack : {
         T v1 = popReal(it);
-        pushInt(fRealHeap[(*it)->fOffset1] != v1);
+        pushInt(fRealHeap[it->fOffset1] != v1);
         dispatchNextScal();
     }
 
     // Logical operations
     do_kANDIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] & v1);
+        pushInt(fIntHeap[it->fOffset1] & v1);
         dispatchNextScal();
     }
 
     do_kORIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] | v1);
+        pushInt(fIntHeap[it->fOffset1] | v1);
         dispatchNextScal();
     }
 
     do_kXORIntStack : {
         int v1 = popInt();
-        pushInt(fIntHeap[(*it)->fOffset1] ^ v1);
+        pushInt(fIntHeap[it->fOffset1] ^ v1);
         dispatchNextScal();
     }
 
@@ -1464,167 +1520,167 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kAddRealStackValue : {
         T v1 = popReal(it);
-        pushReal(it, (*it)->fRealValue + v1);
+        pushReal(it, it->fRealValue + v1);
         dispatchNextScal();
     }
 
     do_kAddIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue + v1);
+        pushInt(it->fIntValue + v1);
         dispatchNextScal();
     }
 
     do_kSubRealStackValue : {
         T v1 = popReal(it);
-        pushReal(it, (*it)->fRealValue - v1);
+        pushReal(it, it->fRealValue - v1);
         dispatchNextScal();
     }
 
     do_kSubIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue - v1);
+        pushInt(it->fIntValue - v1);
         dispatchNextScal();
     }
 
     do_kMultRealStackValue : {
         T v1 = popReal(it);
-        pushReal(it, (*it)->fRealValue * v1);
+        pushReal(it, it->fRealValue * v1);
         dispatchNextScal();
     }
 
     do_kMultIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue * v1);
+        pushInt(it->fIntValue * v1);
         dispatchNextScal();
     }
 
     do_kDivRealStackValue : {
         T v1 = popReal(it);
-        pushReal(it, (*it)->fRealValue / v1);
+        pushReal(it, it->fRealValue / v1);
         dispatchNextScal();
     }
 
     do_kDivIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue / v1);
+        pushInt(it->fIntValue / v1);
         dispatchNextScal();
     }
 
     do_kRemRealStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::remainder((*it)->fRealValue, v1));
+        pushReal(it, std::remainder(it->fRealValue, v1));
         dispatchNextScal();
     }
 
     do_kRemIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue % v1);
+        pushInt(it->fIntValue % v1);
         dispatchNextScal();
     }
 
     // Shift operation
     do_kLshIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue << v1);
+        pushInt(it->fIntValue << v1);
         dispatchNextScal();
     }
 
     do_kRshIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue >> v1);
+        pushInt(it->fIntValue >> v1);
         dispatchNextScal();
     }
 
     // Comparaison Int
     do_kGTIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue > v1);
+        pushInt(it->fIntValue > v1);
         dispatchNextScal();
     }
 
     do_kLTIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue < v1);
+        pushInt(it->fIntValue < v1);
         dispatchNextScal();
     }
 
     do_kGEIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue >= v1);
+        pushInt(it->fIntValue >= v1);
         dispatchNextScal();
     }
 
     do_kLEIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue <= v1);
+        pushInt(it->fIntValue <= v1);
         dispatchNextScal();
     }
 
     do_kEQIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue == v1);
+        pushInt(it->fIntValue == v1);
         dispatchNextScal();
     }
 
     do_kNEIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue != v1);
+        pushInt(it->fIntValue != v1);
         dispatchNextScal();
     }
 
     // Comparaison Real
     do_kGTRealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue > v1);
+        pushInt(it->fRealValue > v1);
         dispatchNextScal();
     }
 
     do_kLTRealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue < v1);
+        pushInt(it->fRealValue < v1);
         dispatchNextScal();
     }
 
     do_kGERealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue >= v1);
+        pushInt(it->fRealValue >= v1);
         dispatchNextScal();
     }
 
     do_kLERealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue <= v1);
+        pushInt(it->fRealValue <= v1);
         dispatchNextScal();
     }
 
     do_kEQRealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue == v1);
+        pushInt(it->fRealValue == v1);
         dispatchNextScal();
     }
 
     do_kNERealStackValue : {
         T v1 = popReal(it);
-        pushInt((*it)->fRealValue != v1);
+        pushInt(it->fRealValue != v1);
         dispatchNextScal();
     }
 
     // Logical operations
     do_kANDIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue & v1);
+        pushInt(it->fIntValue & v1);
         dispatchNextScal();
     }
 
     do_kORIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue | v1);
+        pushInt(it->fIntValue | v1);
         dispatchNextScal();
     }
 
     do_kXORIntStackValue : {
         int v1 = popInt();
-        pushInt((*it)->fIntValue ^ v1);
+        pushInt(it->fIntValue ^ v1);
         dispatchNextScal();
     }
 
@@ -1633,141 +1689,141 @@ class FBCInterpreter : public FBCExecutor<T> {
         //------------------------------------------------------
 
     do_kAddRealValue : {
-        pushReal(it, (*it)->fRealValue + fRealHeap[(*it)->fOffset1]);
+        pushReal(it, it->fRealValue + fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kAddIntValue : {
-        pushInt((*it)->fIntValue + fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue + fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kSubRealValue : {
-        pushReal(it, (*it)->fRealValue - fRealHeap[(*it)->fOffset1]);
+        pushReal(it, it->fRealValue - fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kSubIntValue : {
-        pushInt((*it)->fIntValue - fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue - fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kMultRealValue : {
-        pushReal(it, (*it)->fRealValue * fRealHeap[(*it)->fOffset1]);
+        pushReal(it, it->fRealValue * fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kMultIntValue : {
-        pushInt((*it)->fIntValue * fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue * fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kDivRealValue : {
-        pushReal(it, (*it)->fRealValue / fRealHeap[(*it)->fOffset1]);
+        pushReal(it, it->fRealValue / fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kDivIntValue : {
-        pushInt((*it)->fIntValue / fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue / fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kRemRealValue : {
-        pushReal(it, std::remainder((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::remainder(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kRemIntValue : {
-        pushInt((*it)->fIntValue % fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue % fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     // Shift operation
     do_kLshIntValue : {
-        pushInt((*it)->fIntValue << fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue << fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kRshIntValue : {
-        pushInt((*it)->fIntValue >> fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue >> fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     // Comparaison Int
     do_kGTIntValue : {
-        pushInt((*it)->fIntValue > fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue > fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kLTIntValue : {
-        pushInt((*it)->fIntValue < fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue < fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kGEIntValue : {
-        pushInt((*it)->fIntValue >= fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue >= fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kLEIntValue : {
-        pushInt((*it)->fIntValue <= fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue <= fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kEQIntValue : {
-        pushInt((*it)->fIntValue == fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue == fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kNEIntValue : {
-        pushInt((*it)->fIntValue != fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue != fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     // Comparaison Real
     do_kGTRealValue : {
-        pushInt((*it)->fRealValue > fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue > fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kLTRealValue : {
-        pushInt((*it)->fRealValue < fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue < fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kGERealValue : {
-        pushInt((*it)->fRealValue >= fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue >= fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kLERealValue : {
-        pushInt((*it)->fRealValue <= fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue <= fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kEQRealValue : {
-        pushInt((*it)->fRealValue == fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue == fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kNERealValue : {
-        pushInt((*it)->fRealValue != fRealHeap[(*it)->fOffset1]);
+        pushInt(it->fRealValue != fRealHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     // Logical operations
     do_kANDIntValue : {
-        pushInt((*it)->fIntValue & fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue & fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kORIntValue : {
-        pushInt((*it)->fIntValue | fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue | fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
     do_kXORIntValue : {
-        pushInt((*it)->fIntValue ^ fIntHeap[(*it)->fOffset1]);
+        pushInt(it->fIntValue ^ fIntHeap[it->fOffset1]);
         dispatchNextScal();
     }
 
@@ -1777,85 +1833,85 @@ class FBCInterpreter : public FBCExecutor<T> {
         //----------------------------------------------------
 
     do_kSubRealValueInvert : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] - (*it)->fRealValue);
+        pushReal(it, fRealHeap[it->fOffset1] - it->fRealValue);
         dispatchNextScal();
     }
 
     do_kSubIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] - (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] - it->fIntValue);
         dispatchNextScal();
     }
 
     do_kDivRealValueInvert : {
-        pushReal(it, fRealHeap[(*it)->fOffset1] / (*it)->fRealValue);
+        pushReal(it, fRealHeap[it->fOffset1] / it->fRealValue);
         dispatchNextScal();
     }
 
     do_kDivIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] / (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] / it->fIntValue);
         dispatchNextScal();
     }
 
     do_kRemRealValueInvert : {
-        pushReal(it, std::remainder(fRealHeap[(*it)->fOffset1], (*it)->fRealValue));
+        pushReal(it, std::remainder(fRealHeap[it->fOffset1], it->fRealValue));
         dispatchNextScal();
     }
 
     do_kRemIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] % (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] % it->fIntValue);
         dispatchNextScal();
     }
 
     // Shift operation
     do_kLshIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] << (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] << it->fIntValue);
         dispatchNextScal();
     }
 
     do_kRshIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] >> (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] >> it->fIntValue);
         dispatchNextScal();
     }
 
     // Comparaison Int
     do_kGTIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] > (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] > it->fIntValue);
         dispatchNextScal();
     }
 
     do_kLTIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] < (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] < it->fIntValue);
         dispatchNextScal();
     }
 
     do_kGEIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] >= (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] >= it->fIntValue);
         dispatchNextScal();
     }
 
     do_kLEIntValueInvert : {
-        pushInt(fIntHeap[(*it)->fOffset1] <= (*it)->fIntValue);
+        pushInt(fIntHeap[it->fOffset1] <= it->fIntValue);
         dispatchNextScal();
     }
 
     // Comparaison Real
     do_kGTRealValueInvert : {
-        pushInt(fRealHeap[(*it)->fOffset1] > (*it)->fRealValue);
+        pushInt(fRealHeap[it->fOffset1] > it->fRealValue);
         dispatchNextScal();
     }
 
     do_kLTRealValueInvert : {
-        pushInt(fRealHeap[(*it)->fOffset1] < (*it)->fRealValue);
+        pushInt(fRealHeap[it->fOffset1] < it->fRealValue);
         dispatchNextScal();
     }
 
     do_kGERealValueInvert : {
-        pushInt(fRealHeap[(*it)->fOffset1] >= (*it)->fRealValue);
+        pushInt(fRealHeap[it->fOffset1] >= it->fRealValue);
         dispatchNextScal();
     }
 
     do_kLERealValueInvert : {
-        pushInt(fRealHeap[(*it)->fOffset1] <= (*it)->fRealValue);
+        pushInt(fRealHeap[it->fOffset1] <= it->fRealValue);
         dispatchNextScal();
     }
 
@@ -2000,112 +2056,112 @@ class FBCInterpreter : public FBCExecutor<T> {
         ///-----------------------------------
 
     do_kAbsHeap : {
-        pushInt(std::abs(fIntHeap[(*it)->fOffset1]));
+        pushInt(std::abs(fIntHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kAbsfHeap : {
-        pushReal(it, std::fabs(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::fabs(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kAcosfHeap : {
-        pushReal(it, std::acos(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::acos(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
         
     do_kAcoshfHeap : {
-        pushReal(it, std::acosh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::acosh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kAsinfHeap : {
-        pushReal(it, std::asin(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::asin(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
         
     do_kAsinhfHeap : {
-        pushReal(it, std::asinh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::asinh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kAtanfHeap : {
-        pushReal(it, std::atan(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::atan(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
         
     do_kAtanhfHeap : {
-        pushReal(it, std::atanh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::atanh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kCeilfHeap : {
-        pushReal(it, std::ceil(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::ceil(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kCosfHeap : {
-        pushReal(it, std::cos(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::cos(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kCoshfHeap : {
-        pushReal(it, std::cosh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::cosh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kExpfHeap : {
-        pushReal(it, std::exp(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::exp(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kFloorfHeap : {
-        pushReal(it, std::floor(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::floor(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kLogfHeap : {
-        pushReal(it, std::log(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::log(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kLog10fHeap : {
-        pushReal(it, std::log10(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::log10(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
         
     do_kRintfHeap : {
-        pushReal(it, std::rint(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::rint(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
    
     do_kRoundfHeap : {
-        pushReal(it, std::round(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::round(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kSinfHeap : {
-        pushReal(it, std::sin(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::sin(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kSinhfHeap : {
-        pushReal(it, std::sinh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::sinh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kSqrtfHeap : {
-        pushReal(it, std::sqrt(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::sqrt(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kTanfHeap : {
-        pushReal(it, std::tan(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::tan(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kTanhfHeap : {
-        pushReal(it, std::tanh(fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::tanh(fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
@@ -2167,37 +2223,37 @@ class FBCInterpreter : public FBCExecutor<T> {
         //-------------------------------------
 
     do_kAtan2fHeap : {
-        pushReal(it, std::atan2(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::atan2(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kFmodfHeap : {
-        pushReal(it, std::fmod(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::fmod(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kPowfHeap : {
-        pushReal(it, std::pow(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::pow(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kMaxHeap : {
-        pushInt(std::max(fIntHeap[(*it)->fOffset1], fIntHeap[(*it)->fOffset2]));
+        pushInt(std::max(fIntHeap[it->fOffset1], fIntHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kMaxfHeap : {
-        pushReal(it, std::max(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::max(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kMinHeap : {
-        pushInt(std::min(fIntHeap[(*it)->fOffset1], fIntHeap[(*it)->fOffset2]));
+        pushInt(std::min(fIntHeap[it->fOffset1], fIntHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
     do_kMinfHeap : {
-        pushReal(it, std::min(fRealHeap[(*it)->fOffset1], fRealHeap[(*it)->fOffset2]));
+        pushReal(it, std::min(fRealHeap[it->fOffset1], fRealHeap[it->fOffset2]));
         dispatchNextScal();
     }
 
@@ -2207,43 +2263,43 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kAtan2fStack : {
         T v1 = popReal(it);
-        pushReal(it, std::atan2(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::atan2(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kFmodfStack : {
         T v1 = popReal(it);
-        pushReal(it, std::fmod(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::fmod(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kPowfStack : {
         T v1 = popReal(it);
-        pushReal(it, std::pow(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::pow(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kMaxStack : {
         int v1 = popInt();
-        pushInt(std::max(fIntHeap[(*it)->fOffset1], v1));
+        pushInt(std::max(fIntHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kMaxfStack : {
         T v1 = popReal(it);
-        pushReal(it, std::max(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::max(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kMinStack : {
         int v1 = popInt();
-        pushInt(std::min(fIntHeap[(*it)->fOffset1], v1));
+        pushInt(std::min(fIntHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
     do_kMinfStack : {
         T v1 = popReal(it);
-        pushReal(it, std::min(fRealHeap[(*it)->fOffset1], v1));
+        pushReal(it, std::min(fRealHeap[it->fOffset1], v1));
         dispatchNextScal();
     }
 
@@ -2253,43 +2309,43 @@ class FBCInterpreter : public FBCExecutor<T> {
 
     do_kAtan2fStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::atan2((*it)->fRealValue, v1));
+        pushReal(it, std::atan2(it->fRealValue, v1));
         dispatchNextScal();
     }
 
     do_kFmodfStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::fmod((*it)->fRealValue, v1));
+        pushReal(it, std::fmod(it->fRealValue, v1));
         dispatchNextScal();
     }
 
     do_kPowfStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::pow((*it)->fRealValue, v1));
+        pushReal(it, std::pow(it->fRealValue, v1));
         dispatchNextScal();
     }
 
     do_kMaxStackValue : {
         int v1 = popInt();
-        pushInt(std::max((*it)->fIntValue, v1));
+        pushInt(std::max(it->fIntValue, v1));
         dispatchNextScal();
     }
 
     do_kMaxfStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::max((*it)->fRealValue, v1));
+        pushReal(it, std::max(it->fRealValue, v1));
         dispatchNextScal();
     }
 
     do_kMinStackValue : {
         int v1 = popInt();
-        pushInt(std::min((*it)->fIntValue, v1));
+        pushInt(std::min(it->fIntValue, v1));
         dispatchNextScal();
     }
 
     do_kMinfStackValue : {
         T v1 = popReal(it);
-        pushReal(it, std::min((*it)->fRealValue, v1));
+        pushReal(it, std::min(it->fRealValue, v1));
         dispatchNextScal();
     }
 
@@ -2298,37 +2354,37 @@ class FBCInterpreter : public FBCExecutor<T> {
         //-------------------------------------
 
     do_kAtan2fValue : {
-        pushReal(it, std::atan2((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::atan2(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kFmodfValue : {
-        pushReal(it, std::fmod((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::fmod(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kPowfValue : {
-        pushReal(it, std::pow((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::pow(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kMaxValue : {
-        pushInt(std::max((*it)->fIntValue, fIntHeap[(*it)->fOffset1]));
+        pushInt(std::max(it->fIntValue, fIntHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kMaxfValue : {
-        pushReal(it, std::max((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::max(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kMinValue : {
-        pushInt(std::min((*it)->fIntValue, fIntHeap[(*it)->fOffset1]));
+        pushInt(std::min(it->fIntValue, fIntHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
     do_kMinfValue : {
-        pushReal(it, std::min((*it)->fRealValue, fRealHeap[(*it)->fOffset1]));
+        pushReal(it, std::min(it->fRealValue, fRealHeap[it->fOffset1]));
         dispatchNextScal();
     }
 
@@ -2337,17 +2393,17 @@ class FBCInterpreter : public FBCExecutor<T> {
         //-------------------------------------------------------------------
 
     do_kAtan2fValueInvert : {
-        pushReal(it, std::atan2(fRealHeap[(*it)->fOffset1], (*it)->fRealValue));
+        pushReal(it, std::atan2(fRealHeap[it->fOffset1], it->fRealValue));
         dispatchNextScal();
     }
 
     do_kFmodfValueInvert : {
-        pushReal(it, std::fmod(fRealHeap[(*it)->fOffset1], (*it)->fRealValue));
+        pushReal(it, std::fmod(fRealHeap[it->fOffset1], it->fRealValue));
         dispatchNextScal();
     }
 
     do_kPowfValueInvert : {
-        pushReal(it, std::pow(fRealHeap[(*it)->fOffset1], (*it)->fRealValue));
+        pushReal(it, std::pow(fRealHeap[it->fOffset1], it->fRealValue));
         dispatchNextScal();
     }
 
@@ -2370,12 +2426,12 @@ class FBCInterpreter : public FBCExecutor<T> {
 
         if (popInt()) {
             // Execute new block
-            assertInterp((*it)->fBranch1);
+            assertInterp(it->fBranch1);
             dispatchBranch1Scal();
             // No value (If)
         } else {
             // Execute new block
-            assertInterp((*it)->fBranch2);
+            assertInterp(it->fBranch2);
             dispatchBranch2Scal();
             // No value (If)
         }
@@ -2387,12 +2443,12 @@ class FBCInterpreter : public FBCExecutor<T> {
 
         if (popInt()) {
             // Execute new block
-            assertInterp((*it)->fBranch1);
+            assertInterp(it->fBranch1);
             dispatchBranch1Scal();
             // Real value
         } else {
             // Execute new block
-            assertInterp((*it)->fBranch2);
+            assertInterp(it->fBranch2);
             dispatchBranch2Scal();
             // Real value
         }
@@ -2404,12 +2460,12 @@ class FBCInterpreter : public FBCExecutor<T> {
 
         if (popInt()) {
             // Execute new block
-            assertInterp((*it)->fBranch1);
+            assertInterp(it->fBranch1);
             dispatchBranch1Scal();
             // Int value
         } else {
             // Execute new block
-            assertInterp((*it)->fBranch2);
+            assertInterp(it->fBranch2);
             dispatchBranch2Scal();
             // Int value
         }
@@ -2418,7 +2474,7 @@ class FBCInterpreter : public FBCExecutor<T> {
     do_kCondBranch : {
         // If condition is true, just branch back on the block beginning
         if (popInt()) {
-            assertInterp((*it)->fBranch1);
+            assertInterp(it->fBranch1);
             dispatchBranch1Scal();
         } else {
             // Just continue after 'loop block' (do the final 'return')
@@ -2426,16 +2482,151 @@ class FBCInterpreter : public FBCExecutor<T> {
         }
     }
 
+        //-------------------
+        // Superinstructions
+        //-------------------
+
+        // 'heap' * 'heap' + 'stack'
+    do_kMultAddRealHeap : {
+        T v1 = popReal(it);
+        pushReal(it, fRealHeap[it->fOffset1] * fRealHeap[it->fOffset2] + v1);
+        dispatchNextScal();
+    }
+
+        // 'heap' * 'heap' + 'stack' stored in 'heap' (typically one-pole recursion)
+    do_kMultAddRealHeapStore : {
+        T v1 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fIntValue)] = fRealHeap[it->fOffset1] * fRealHeap[it->fOffset2] + v1;
+        } else {
+            fRealHeap[it->fIntValue] = fRealHeap[it->fOffset1] * fRealHeap[it->fOffset2] + v1;
+        }
+        dispatchNextScal();
+    }
+
+        // 'heap' + 'heap' * 'stack'
+    do_kMultAddRealStack : {
+        T v1 = popReal(it);
+        pushReal(it, fRealHeap[it->fOffset2] + fRealHeap[it->fOffset1] * v1);
+        dispatchNextScal();
+    }
+
+        // 'stack' OP 'stack' stored in 'heap'
+    do_kAddRealStore : {
+        T v1 = popReal(it);
+        T v2 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset1)] = v1 + v2;
+        } else {
+            fRealHeap[it->fOffset1] = v1 + v2;
+        }
+        dispatchNextScal();
+    }
+
+    do_kSubRealStore : {
+        T v1 = popReal(it);
+        T v2 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset1)] = v1 - v2;
+        } else {
+            fRealHeap[it->fOffset1] = v1 - v2;
+        }
+        dispatchNextScal();
+    }
+
+    do_kMultRealStore : {
+        T v1 = popReal(it);
+        T v2 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset1)] = v1 * v2;
+        } else {
+            fRealHeap[it->fOffset1] = v1 * v2;
+        }
+        dispatchNextScal();
+    }
+
+        // 'heap' OP 'stack' stored in 'heap'
+    do_kAddRealStackStore : {
+        T v1 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset2)] = fRealHeap[it->fOffset1] + v1;
+        } else {
+            fRealHeap[it->fOffset2] = fRealHeap[it->fOffset1] + v1;
+        }
+        dispatchNextScal();
+    }
+
+    do_kSubRealStackStore : {
+        T v1 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset2)] = fRealHeap[it->fOffset1] - v1;
+        } else {
+            fRealHeap[it->fOffset2] = fRealHeap[it->fOffset1] - v1;
+        }
+        dispatchNextScal();
+    }
+
+    do_kMultRealStackStore : {
+        T v1 = popReal(it);
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset2)] = fRealHeap[it->fOffset1] * v1;
+        } else {
+            fRealHeap[it->fOffset2] = fRealHeap[it->fOffset1] * v1;
+        }
+        dispatchNextScal();
+    }
+
+        // Delay line read : heap[base + ('stack' & mask)]
+    do_kLoadIndexedRealMask : {
+        int offset = popInt() & it->fIntValue;
+        if (TRACE > 0) {
+            pushReal(it, fRealHeap[assertLoadRealHeap(it, it->fOffset1 + offset, it->fOffset2)]);
+        } else {
+            pushReal(it, fRealHeap[it->fOffset1 + offset]);
+        }
+        dispatchNextScal();
+    }
+
+        // Delay line write : heap[base + ('heap' & mask)] = 'stack' (the array size is not kept, only the heap size is checked)
+    do_kStoreIndexedRealMask : {
+        int offset = fIntHeap[it->fOffset2] & it->fIntValue;
+        if (TRACE > 0) {
+            fRealHeap[assertRealHeap(it, it->fOffset1 + offset)] = popReal(it);
+        } else {
+            fRealHeap[it->fOffset1 + offset] = popReal(it);
+        }
+        dispatchNextScal();
+    }
+
+    do_kLoadIndexedStaticReal : {
+        int offset = popInt();
+        pushReal(it, fStaticRealHeap[it->fOffset1 + offset]);
+        dispatchNextScal();
+    }
+
+    do_kLoadIndexedStaticInt : {
+        int offset = popInt();
+        pushInt(fStaticIntHeap[it->fOffset1 + offset]);
+        dispatchNextScal();
+    }
+
     do_kLoop : {
+        // Vectorized loop
+        if (TRACE == 0 && it->fOffset1 >= 0) {
+            FBCVecLoop<T>* vec_loop = block->fVecLoops[it->fOffset1];
+            vec_loop->fExecute(vec_loop, fIntHeap, fRealHeap, fInputs, fOutputs);
+            dispatchNextScal();
+        }
+
         // Keep next instruction
         saveReturnScal();
 
         // Push branch2 (loop content)
-        assertInterp((*it)->fBranch2);
+        assertInterp(it->fBranch2);
         pushBranch2Scal();
 
         // And start branch1 loop variable declaration block
-        assertInterp((*it)->fBranch1);
+        assertInterp(it->fBranch1);
         dispatchBranch1Scal();
     }
 
@@ -2455,7 +2646,18 @@ class FBCInterpreter : public FBCExecutor<T> {
                 << " count_offset " << count_offset << std::endl;
         */
 
-        fFactory = factory;
+        fFactory        = factory;
+        fFlatBlock      = nullptr;
+        fStaticIntHeap  = nullptr;
+        fStaticRealHeap = nullptr;
+
+        // The factory blocks are shared when flattened in optimize(), otherwise flattened for this executor
+        addFlatBlock(fFactory->fStaticInitBlock);
+        addFlatBlock(fFactory->fInitBlock);
+        addFlatBlock(fFactory->fResetUIBlock);
+        addFlatBlock(fFactory->fClearBlock);
+        addFlatBlock(fFactory->fComputeBlock);
+        addFlatBlock(fFactory->fComputeDSPBlock);
 
         if (fFactory->getMemoryManager()) {
             fRealHeap  = static_cast<T*>(fFactory->allocate(sizeof(T) * fFactory->fRealHeapSize));
@@ -2476,11 +2678,22 @@ class FBCInterpreter : public FBCExecutor<T> {
         // std::cout << "fIntHeapSize = " << fFactory->fIntHeapSize << std::endl;
 
         // Initialise HEAP with special values to detect incorrect Load access
+        // (except the shared static tables that are never accessed in the instance heap)
         for (int i = 0; i < fFactory->fRealHeapSize; i++) {
-            fRealHeap[i] = T(DUMMY_REAL);
+            auto shared = fFactory->fSharedRealRanges.find(i);
+            if (shared != fFactory->fSharedRealRanges.end()) {
+                i += shared->second - 1;
+            } else {
+                fRealHeap[i] = T(DUMMY_REAL);
+            }
         }
         for (int i = 0; i < fFactory->fIntHeapSize; i++) {
-            fIntHeap[i] = DUMMY_INT;
+            auto shared = fFactory->fSharedIntRanges.find(i);
+            if (shared != fFactory->fSharedIntRanges.end()) {
+                i += shared->second - 1;
+            } else {
+                fIntHeap[i] = DUMMY_INT;
+            }
         }
 
         fRealStats[INTEGER_OVERFLOW]  = 0;
@@ -2506,6 +2719,9 @@ class FBCInterpreter : public FBCExecutor<T> {
             delete[] fInputs;
             delete[] fOutputs;
         }
+        for (auto& it : fFlatBlocks) {
+            if (it.fOwned) delete it.fFlatBlock;
+        }
         if (TRACE > 0) {
             printStats();
         }
@@ -2530,6 +2746,16 @@ class FBCInterpreter : public FBCExecutor<T> {
     void setIntValue(int offset, int value) { fIntHeap[offset] = value; }
     int  getIntValue(int offset) { return fIntHeap[offset]; }
 
+    int* getIntHeap() { return fIntHeap; }
+    T*   getRealHeap() { return fRealHeap; }
+
+    void setStaticHeap(int* int_heap, T* real_heap)
+    {
+        fStaticIntHeap  = int_heap;
+        fStaticRealHeap = real_heap;
+    }
+    virtual bool sharesStaticHeap() { return true; }
+
     virtual void setInput(int input, T* buffer) { fInputs[input] = buffer; }
     virtual void setOutput(int output, T* buffer) { fOutputs[output] = buffer; }
 };
@@ -56,7 +56,7 @@ class FBCMIRCompiler : public FBCExecuteFun<T> {
     
     std::map<std::string, int> fIDCounters;
     std::map<std::string, MIR_item_t> fFunProto;
-    static std::map<std::string, void*> gMathLib;
+    static thread_local std::map<std::string, void*> gMathLib;
     std::string fIdent;
     
     MIR_context_t fContext;
@@ -1117,6 +1117,6 @@ class FBCMIRCompiler : public FBCExecuteFun<T> {
 };
 
 template <class T>
-std::map<std::string, void*> FBCMIRCompiler<T>::gMathLib;
+thread_local std::map<std::string, void*> FBCMIRCompiler<T>::gMathLib;
 
 #endif
@@ -340,6 +340,23 @@ struct FBCInstruction {
         kSelectInt,
         kCondBranch,
 
+        // Superinstructions (fused common idioms, generated at opt level 7)
+        kMultAddRealHeap,
+        kMultAddRealHeapStore,
+        kMultAddRealStack,
+        kAddRealStore,
+        kSubRealStore,
+        kMultRealStore,
+        kAddRealStackStore,
+        kSubRealStackStore,
+        kMultRealStackStore,
+        kLoadIndexedRealMask,
+        kStoreIndexedRealMask,
+
+        // Flat bytecode only: table reads in the static memory shared by the factory instances
+        kLoadIndexedStaticReal,
+        kLoadIndexedStaticInt,
+
         // User Interface
         kOpenVerticalBox,
         kOpenHorizontalBox,
@@ -384,7 +401,10 @@ struct FBCInstruction {
                 (opt == kLog10f) || (opt == kRintf) || (opt == kRoundf) || (opt == kSinf) || (opt == kSinhf) || (opt == kSqrtf) ||
                 (opt == kTanf) || (opt == kTanhf)
 
-                || (opt == kAtan2f) || (opt == kFmodf) || (opt == kPowf) || (opt == kMaxf) || (opt == kMinf));
+                || (opt == kAtan2f) || (opt == kFmodf) || (opt == kPowf) || (opt == kMaxf) || (opt == kMinf)
+
+                || (opt == kMultAddRealHeap) || (opt == kMultAddRealStack) || (opt == kLoadIndexedRealMask)
+                || (opt == kLoadIndexedStaticReal));
     }
 
     static bool isMath(Opcode opt) { return (opt >= kAddReal) && (opt <= kXORInt); }
@@ -478,6 +498,14 @@ static std::string gFBCInstructionTable[] = {
     // Select/if
     "kIf", "kSelectReal", "kSelectInt", "kCondBranch",
 
+    // Superinstructions
+    "kMultAddRealHeap", "kMultAddRealHeapStore", "kMultAddRealStack", "kAddRealStore", "kSubRealStore",
+    "kMultRealStore", "kAddRealStackStore", "kSubRealStackStore", "kMultRealStackStore", "kLoadIndexedRealMask",
+    "kStoreIndexedRealMask",
+
+    // Flat bytecode only
+    "kLoadIndexedStaticReal", "kLoadIndexedStaticInt",
+
     // User Interface
     "kOpenVerticalBox", "kOpenHorizontalBox", "kOpenTabBox", "kCloseBox", "kAddButton", "kAddChecButton",
     "kAddHorizontalSlider", "kAddVerticalSlider", "kAddNumEntry", "kAddSoundfile", "kAddHorizontalBargraph",
@@ -485,6 +513,11 @@ static std::string gFBCInstructionTable[] = {
 
     "kNop"};
 
-#define INTERP_FILE_VERSION 7
+/*
+ Bumped each time the opcode numbering changes:
+ - 8: superinstructions inserted before the UI opcodes (kMultAddRealHeap...kStoreIndexedRealMask)
+ - 9: flat bytecode only static table reads (kLoadIndexedStaticReal/Int)
+*/
+#define INTERP_FILE_VERSION 9
 
 #endif
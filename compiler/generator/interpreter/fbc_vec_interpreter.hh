@@ -19,2511 +19,964 @@
  ************************************************************************
  ************************************************************************/
 
+
 #ifndef _FBC_VEC_INTERPRETER_H
 #define _FBC_VEC_INTERPRETER_H
 
-#include <string.h>
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 #include <map>
-#include <sstream>
-#include <string>
+#include <set>
+#include <utility>
+#include <vector>
 
-#include "exception.hh"
-#include "faust/gui/CGlue.h"
-#include "fbc_executor.hh"
 #include "interpreter_bytecode.hh"
 
-//#define interp_assert(exp) faustassert(exp)
-#define interp_assert(exp)
-
-template <class T, int TRACE>
-struct interpreter_dsp_factory_aux;
-
-// FBC interpreter
-template <class T, int VEC>
-class FBCVecInterpreter : public FBCExecutor<T> {
-   protected:
-    interpreter_dsp_factory_aux<T, 0>* fFactory;
-
-    int*        fIntHeap;
-    T*          fRealHeap;
-    Soundfile** fSoundHeap;
-
-    T** fInputs;
-    T** fOutputs;
-
-#define POP_INT() (int_stack[--int_stack_index])
-
-#define pushAddr(addr) (address_stack[addr_stack_index++] = addr)
-#define popAddr() (address_stack[--addr_stack_index])
+/*
+ Vectorized execution of the non recursive loops generated in -vec mode (kLoop with a vector size in fIntValue).
 
-    virtual void ExecuteBuildUserInterface(FIRUserInterfaceBlockInstruction<T>* block, UITemplate* glue)
-    {
-        for (auto& it : block->fInstructions) {
-            // it->write(&std::cout);
-
-            switch (it->fOpcode) {
-                case FBCInstruction::kOpenVerticalBox:
-                    glue->openVerticalBox(it->fLabel.c_str());
-                    break;
-
-                case FBCInstruction::kOpenHorizontalBox:
-                    glue->openHorizontalBox(it->fLabel.c_str());
-                    break;
-
-                case FBCInstruction::kOpenTabBox:
-                    glue->openTabBox(it->fLabel.c_str());
-                    break;
+ The loop body is lowered once in a 'register' form where each value (stack slot, variable local to the loop body,
+ loop index) is a vector of VEC samples: each instruction is then dispatched once for VEC iterations of the loop.
+ Loops which cannot be proven to be free of loop carried dependencies are kept on the scalar path.
+*/
 
-                case FBCInstruction::kCloseBox:
-                    glue->closeBox();
-                    break;
+// Maximum number of vector registers of each type (int/real) used by a vectorized loop
+#define VEC_MAX_REGISTERS 64
 
-                case FBCInstruction::kAddButton:
-                    glue->addButton(it->fLabel.c_str(), &fRealHeap[it->fOffset]);
-                    break;
+template <class T>
+struct FBCVecOperand {
+    enum Kind { kRegister, kHeap, kValue };
 
-                case FBCInstruction::kAddCheckButton:
-                    glue->addCheckButton(it->fLabel.c_str(), &fRealHeap[it->fOffset]);
-                    break;
+    Kind fKind;
+    int  fIndex;  // Register number or heap offset
+    int  fIntValue;
+    T    fRealValue;
 
-                case FBCInstruction::kAddHorizontalSlider:
-                    glue->addHorizontalSlider(it->fLabel.c_str(), &fRealHeap[it->fOffset], it->fInit, it->fMin,
-                                              it->fMax, it->fStep);
-                    break;
+    static FBCVecOperand reg(int index) { return {kRegister, index, 0, T(0)}; }
+    static FBCVecOperand heap(int offset) { return {kHeap, offset, 0, T(0)}; }
+    static FBCVecOperand value(int int_value, T real_value) { return {kValue, -1, int_value, real_value}; }
+};
 
-                case FBCInstruction::kAddVerticalSlider:
-                    glue->addVerticalSlider(it->fLabel.c_str(), &fRealHeap[it->fOffset], it->fInit, it->fMin, it->fMax,
-                                            it->fStep);
-                    break;
+template <class T>
+struct FBCVecInstruction {
+    FBCInstruction::Opcode fOpcode;  // 'stack' version of the operation, kMoveReal/kMoveInt or memory access
+    int                    fDst;     // Destination register
+    int                    fOffset;  // Array offset in the heap, or input/output channel
+    FBCVecOperand<T>       fArg1;
+    FBCVecOperand<T>       fArg2;
+};
 
-                case FBCInstruction::kAddNumEntry:
-                    glue->addNumEntry(it->fLabel.c_str(), &fRealHeap[it->fOffset], it->fInit, it->fMin, it->fMax,
-                                      it->fStep);
-                    break;
+template <class T>
+struct FBCVecLoop {
+    typedef void (*ExecuteFun)(const FBCVecLoop<T>* loop, int* int_heap, T* real_heap, T** inputs, T** outputs);
 
-                case FBCInstruction::kAddSoundfile:
-                    glue->addSoundfile(it->fLabel.c_str(), it->fKey.c_str(), &fSoundHeap[it->fOffset]);
-                    break;
+    std::vector<FBCVecInstruction<T>> fInstructions;
+    ExecuteFun                        fExecute;
 
-                case FBCInstruction::kAddHorizontalBargraph:
-                    glue->addHorizontalBargraph(it->fLabel.c_str(), &fRealHeap[it->fOffset], it->fMin, it->fMax);
-                    break;
+    int fIndexOffset;    // Loop index in the int heap
+    int fIndexRegister;  // Int register holding the loop index of each lane
+    int fInitValue;      // First value of the loop index
+    int fEndValue;       // Loop index bound, when fEndOffset is -1
+    int fEndOffset;      // Loop index bound in the int heap, or -1
 
-                case FBCInstruction::kAddVerticalBargraph:
-                    glue->addVerticalBargraph(it->fLabel.c_str(), &fRealHeap[it->fOffset], it->fMin, it->fMax);
-                    break;
+    // Heap locations written in the loop body with their register, updated with the last iteration value
+    std::map<int, int> fRealLocals;
+    std::map<int, int> fIntLocals;
 
-                case FBCInstruction::kDeclare:
-                    // Special case for "0" zone
-                    if (it->fOffset == -1) {
-                        glue->declare(static_cast<T*>(nullptr), it->fKey.c_str(), it->fValue.c_str());
-                    } else {
-                        glue->declare(&fRealHeap[it->fOffset], it->fKey.c_str(), it->fValue.c_str());
-                    }
-                    break;
+    // Return the vectorized version of a kLoop instruction, or nullptr if the loop cannot be vectorized
+    static FBCVecLoop<T>* create(FBCBasicInstruction<T>* loop);
 
-                default:
-                    break;
-            }
+    static bool isRealArg(FBCInstruction::Opcode op)
+    {
+        switch (op) {
+            case FBCInstruction::kAddReal:
+            case FBCInstruction::kSubReal:
+            case FBCInstruction::kMultReal:
+            case FBCInstruction::kDivReal:
+            case FBCInstruction::kRemReal:
+            case FBCInstruction::kGTReal:
+            case FBCInstruction::kLTReal:
+            case FBCInstruction::kGEReal:
+            case FBCInstruction::kLEReal:
+            case FBCInstruction::kEQReal:
+            case FBCInstruction::kNEReal:
+            case FBCInstruction::kAtan2f:
+            case FBCInstruction::kFmodf:
+            case FBCInstruction::kPowf:
+            case FBCInstruction::kMaxf:
+            case FBCInstruction::kMinf:
+            case FBCInstruction::kCastInt:
+                return true;
+            default:
+                return (op >= FBCInstruction::kAbsf) && (op <= FBCInstruction::kTanhf);
         }
     }
 
-    // virtual void ExecuteVecLoop(FBCBasicInstruction<T>* block)
-    virtual void ExecuteBlock(FBCBlockInstruction<T>* block)
+    static bool isRealResult(FBCInstruction::Opcode op)
     {
-        static void* fDispatchTable[] = {
-
-            // Numbers
-            &&do_kRealValue, &&do_kInt32Value,
-
-            // Memory
-            &&do_kLoadReal, &&do_kLoadInt, &&do_kLoadSound, &&do_kLoadSoundField, &&do_kStoreReal, &&do_kStoreInt,
-            &&do_kStoreSound, &&do_kStoreRealValue, &&do_kStoreIntValue, &&do_kLoadIndexedReal, &&do_kLoadIndexedInt,
-            &&do_kStoreIndexedReal, &&do_kStoreIndexedInt, &&do_kBlockStoreReal, &&do_kBlockStoreInt, &&do_kMoveReal,
-            &&do_kMoveInt, &&do_kPairMoveReal, &&do_kPairMoveInt, &&do_kBlockPairMoveReal, &&do_kBlockPairMoveInt,
-            &&do_kBlockShiftReal, &&do_kBlockShiftInt, &&do_kLoadInput, &&do_kStoreOutput,
-
-            // Cast/bitcast
-            &&do_kCastReal, &&do_kCastInt, &&do_kCastRealHeap, &&do_kCastIntHeap, &&do_kBitcastInt, &&do_kBitcastReal,
-
-            // Standard math (stack OP stack)
-            &&do_kAddReal, &&do_kAddInt, &&do_kSubReal, &&do_kSubInt, &&do_kMultReal, &&do_kMultInt, &&do_kDivReal,
-            &&do_kDivInt, &&do_kRemReal, &&do_kRemInt, &&do_kLshInt, &&do_kRshInt, &&do_kGTInt, &&do_kLTInt,
-            &&do_kGEInt, &&do_kLEInt, &&do_kEQInt, &&do_kNEInt, &&do_kGTReal, &&do_kLTReal, &&do_kGEReal, &&do_kLEReal,
-            &&do_kEQReal, &&do_kNEReal, &&do_kANDInt, &&do_kORInt, &&do_kXORInt,
-
-            // Standard math (heap OP heap)
-            &&do_kAddRealHeap, &&do_kAddIntHeap, &&do_kSubRealHeap, &&do_kSubIntHeap, &&do_kMultRealHeap,
-            &&do_kMultIntHeap, &&do_kDivRealHeap, &&do_kDivIntHeap, &&do_kRemRealHeap, &&do_kRemIntHeap,
-            &&do_kLshIntHeap, &&do_kRshIntHeap, &&do_kGTIntHeap, &&do_kLTIntHeap, &&do_kGEIntHeap, &&do_kLEIntHeap,
-            &&do_kEQIntHeap, &&do_kNEIntHeap, &&do_kGTRealHeap, &&do_kLTRealHeap, &&do_kGERealHeap, &&do_kLERealHeap,
-            &&do_kEQRealHeap, &&do_kNERealHeap, &&do_kANDIntHeap, &&do_kORIntHeap, &&do_kXORIntHeap,
-
-            // Standard math (heap OP stack)
-            &&do_kAddRealStack, &&do_kAddIntStack, &&do_kSubRealStack, &&do_kSubIntStack, &&do_kMultRealStack,
-            &&do_kMultIntStack, &&do_kDivRealStack, &&do_kDivIntStack, &&do_kRemRealStack, &&do_kRemIntStack,
-            &&do_kLshIntStack, &&do_kRshIntStack, &&do_kGTIntStack, &&do_kLTIntStack, &&do_kGEIntStack,
-            &&do_kLEIntStack, &&do_kEQIntStack, &&do_kNEIntStack, &&do_kGTRealStack, &&do_kLTRealStack,
-            &&do_kGERealStack, &&do_kLERealStack, &&do_kEQRealStack, &&do_kNERealStack, &&do_kANDIntStack,
-            &&do_kORIntStack, &&do_kXORIntStack,
-
-            // Standard math (value OP stack)
-            &&do_kAddRealStackValue, &&do_kAddIntStackValue, &&do_kSubRealStackValue, &&do_kSubIntStackValue,
-            &&do_kMultRealStackValue, &&do_kMultIntStackValue, &&do_kDivRealStackValue, &&do_kDivIntStackValue,
-            &&do_kRemRealStackValue, &&do_kRemIntStackValue, &&do_kLshIntStackValue, &&do_kRshIntStackValue,
-            &&do_kGTIntStackValue, &&do_kLTIntStackValue, &&do_kGEIntStackValue, &&do_kLEIntStackValue,
-            &&do_kEQIntStackValue, &&do_kNEIntStackValue, &&do_kGTRealStackValue, &&do_kLTRealStackValue,
-            &&do_kGERealStackValue, &&do_kLERealStackValue, &&do_kEQRealStackValue, &&do_kNERealStackValue,
-            &&do_kANDIntStackValue, &&do_kORIntStackValue, &&do_kXORIntStackValue,
-
-            // Standard math (value OP heap)
-            &&do_kAddRealValue, &&do_kAddIntValue, &&do_kSubRealValue, &&do_kSubIntValue, &&do_kMultRealValue,
-            &&do_kMultIntValue, &&do_kDivRealValue, &&do_kDivIntValue, &&do_kRemRealValue, &&do_kRemIntValue,
-            &&do_kLshIntValue, &&do_kRshIntValue, &&do_kGTIntValue, &&do_kLTIntValue, &&do_kGEIntValue,
-            &&do_kLEIntValue, &&do_kEQIntValue, &&do_kNEIntValue, &&do_kGTRealValue, &&do_kLTRealValue,
-            &&do_kGERealValue, &&do_kLERealValue, &&do_kEQRealValue, &&do_kNERealValue, &&do_kANDIntValue,
-            &&do_kORIntValue, &&do_kXORIntValue,
-
-            // Standard math (value OP heap) : non commutative operations
-            &&do_kSubRealValueInvert, &&do_kSubIntValueInvert, &&do_kDivRealValueInvert, &&do_kDivIntValueInvert,
-            &&do_kRemRealValueInvert, &&do_kRemIntValueInvert, &&do_kLshIntValueInvert, &&do_kRshIntValueInvert,
-            &&do_kGTIntValueInvert, &&do_kLTIntValueInvert, &&do_kGEIntValueInvert, &&do_kLEIntValueInvert,
-            &&do_kGTRealValueInvert, &&do_kLTRealValueInvert, &&do_kGERealValueInvert, &&do_kLERealValueInvert,
-
-            // Extended unary math
-            &&do_kAbs, &&do_kAbsf, &&do_kAcosf, &&do_kAsinf, &&do_kAtanf, &&do_kCeilf, &&do_kCosf, &&do_kCoshf,
-            &&do_kExpf, &&do_kFloorf, &&do_kLogf, &&do_kLog10f, &&do_kRintf, &&do_kRoundf, &&do_kSinf, &&do_kSinhf, &&do_kSqrtf,
-            &&do_kTanf, &&do_kTanhf,
-
-            // Extended unary math (heap OP heap)
-            &&do_kAbsHeap, &&do_kAbsfHeap, &&do_kAcosfHeap, &&do_kAsinfHeap, &&do_kAtanfHeap, &&do_kCeilfHeap,
-            &&do_kCosfHeap, &&do_kCoshfHeap, &&do_kExpfHeap, &&do_kFloorfHeap, &&do_kLogfHeap, &&do_kLog10fHeap,
-            &&do_kRintfHeap, &&do_kRoundfHeap, &&do_kSinfHeap, &&do_kSinhfHeap, &&do_kSqrtfHeap, &&do_kTanfHeap, &&do_kTanhfHeap,
-
-            // Extended binary math
-            &&do_kAtan2f, &&do_kFmodf, &&do_kPowf, &&do_kMax, &&do_kMaxf, &&do_kMin, &&do_kMinf,
-
-            // Extended binary math (heap version)
-            &&do_kAtan2fHeap, &&do_kFmodfHeap, &&do_kPowfHeap, &&do_kMaxHeap, &&do_kMaxfHeap, &&do_kMinHeap,
-            &&do_kMinfHeap,
-
-            // Extended binary math (stack version)
-            &&do_kAtan2fStack, &&do_kFmodfStack, &&do_kPowfStack, &&do_kMaxStack, &&do_kMaxfStack, &&do_kMinStack,
-            &&do_kMinfStack,
-
-            // Extended binary math (Stack/Value version)
-            &&do_kAtan2fStackValue, &&do_kFmodfStackValue, &&do_kPowfStackValue, &&do_kMaxStackValue,
-            &&do_kMaxfStackValue, &&do_kMinStackValue, &&do_kMinfStackValue,
-
-            // Extended binary math (Value version)
-            &&do_kAtan2fValue, &&do_kFmodfValue, &&do_kPowfValue, &&do_kMaxValue, &&do_kMaxfValue, &&do_kMinValue,
-            &&do_kMinfValue,
-
-            // Extended binary math (Value version) : non commutative operations
-            &&do_kAtan2fValueInvert, &&do_kFmodfValueInvert, &&do_kPowfValueInvert,
-
-            // Control
-            &&do_kLoop, &&do_kReturn,
-
-            // Select/if
-            &&do_kIf, &&do_kSelectReal, &&do_kSelectInt, &&do_kCondBranch
-
-        };
-
-        int real_stack_index  = 0;
-        int int_stack_index   = 0;
-        int sound_stack_index = 0;
-        int addr_stack_index  = 0;
-
-        T             real_stack[512];
-        int           int_stack[512];
-        Soundfile*    sound_stack[512];
-        InstructionIT address_stack[64];
-
-#define dispatchFirstVec()                    \
-    {                                         \
-        goto* fDispatchTable[(*it)->fOpcode]; \
-    }
-#define dispatchNextVec()                     \
-    {                                         \
-        it++;                                 \
-        goto* fDispatchTable[(*it)->fOpcode]; \
-    }
-
-#define dispatchBranch1Vec()                         \
-    {                                                \
-        it = (*it)->fBranch1->fInstructions.begin(); \
-        dispatchFirstVec();                          \
-    }
-#define dispatchBranch2Vec()                         \
-    {                                                \
-        it = (*it)->fBranch2->fInstructions.begin(); \
-        dispatchFirstVec();                          \
-    }
-
-#define pushBranch1Vec()                                  \
-    {                                                     \
-        pushAddr((*it)->fBranch1->fInstructions.begin()); \
-    }
-#define pushBranch2Vec()                                  \
-    {                                                     \
-        pushAddr((*it)->fBranch2->fInstructions.begin()); \
+        switch (op) {
+            case FBCInstruction::kGTReal:
+            case FBCInstruction::kLTReal:
+            case FBCInstruction::kGEReal:
+            case FBCInstruction::kLEReal:
+            case FBCInstruction::kEQReal:
+            case FBCInstruction::kNEReal:
+            case FBCInstruction::kCastInt:
+                return false;
+            case FBCInstruction::kCastReal:
+                return true;
+            default:
+                return isRealArg(op);
+        }
     }
+};
 
-#define dispatchReturnVec() \
-    {                       \
-        it = popAddr();     \
-        dispatchFirstVec(); \
-    }
-#define saveReturnVec()   \
-    {                     \
-        pushAddr(it + 1); \
+// Lower a loop body in the vectorized 'register' form, by simulating the int and real stacks
+template <class T>
+struct FBCVecLoopBuilder {
+    typedef FBCVecOperand<T> Operand;
+    typedef std::pair<int, int> Range;  // Heap offset and size
+
+    FBCVecLoop<T>* fLoop;
+    bool           fValid;
+    bool           fHasOutput;
+
+    // Indexed by type : 0 for int, 1 for real
+    std::vector<Operand> fStack[2];
+    std::map<int, int>   fLocals[2];      // Heap locations written in the body, and their register
+    std::set<int>        fInvariants[2];  // Heap locations only read in the body
+    std::vector<Range>   fReads[2];       // Arrays read in the body
+    std::vector<Range>   fWrites[2];      // Arrays written in the body
+    int                  fNextLocal[2];   // Local registers are allocated from the end of the register file
+    int                  fMaxStack[2];    // Highest register used by the stack
+
+    FBCVecLoopBuilder(FBCVecLoop<T>* loop) : fLoop(loop), fValid(true), fHasOutput(false)
+    {
+        // The loop index uses the last int register
+        fLoop->fIndexRegister = VEC_MAX_REGISTERS - 1;
+        fNextLocal[0]         = VEC_MAX_REGISTERS - 2;
+        fNextLocal[1]         = VEC_MAX_REGISTERS - 1;
+        fMaxStack[0]          = -1;
+        fMaxStack[1]          = -1;
     }
-#define emptyReturnVec() (addr_stack_index == 0)
-
-#define pushSound(val) (sound_stack[sound_stack_index++] = val)
-#define popSound() (sound_stack[--sound_stack_index])
 
-        // #pragma clang loop vectorize(enable) interleave(enable)
-
-#define VEC_LOOP(code)                  \
-    {                                   \
-        for (int j = 0; j < VEC; j++) { \
-            code;                       \
-        }                               \
+    void emit(FBCInstruction::Opcode opcode, int dst, int offset, const Operand& arg1,
+              const Operand& arg2 = Operand::value(0, 0))
+    {
+        fLoop->fInstructions.push_back({opcode, dst, offset, arg1, arg2});
     }
 
-#define STACK_UP_INT() int_stack_index += VEC
-#define STACK_DOWN_INT() int_stack_index -= VEC
-
-#define STACK_UP_REAL() real_stack_index += VEC
-#define STACK_DOWN_REAL() real_stack_index -= VEC
-
-#define PUSH_VEC_INT(val) int_stack[int_stack_index + j] = (val)
-#define PUSH_VEC_REAL(val) real_stack[real_stack_index + j] = (val)
+    void push(bool real, const Operand& arg) { fStack[real].push_back(arg); }
 
-#define POP_VEC_INT() int_stack[int_stack_index - (j + 1)]
-#define POP_VEC_REAL() real_stack[real_stack_index - (j + 1)]
-
-#define WRITE_HEAP_VEC_REAL(off, val) fRealHeap[(off) + j] = (val)
-#define WRITE_HEAP_VEC_INT(off, val) fIntHeap[(off) + j] = (val)
-
-#define READ_HEAP_VEC_REAL(off) fRealHeap[(off) + j]
-#define READ_HEAP_VEC_INT(off) fIntHeap[(off) + j]
-
-        // Check block coherency
-        // block->check();
-
-        // std::cout << "ExecuteBlock : " << block->fInstructions.size() << "\n";
-        // block->write(&std::cout);
-
-        int v1_int[VEC];
-        int v2_int[VEC];
-        T   v1_real[VEC];
-        T   v2_real[VEC];
-
-        try {
-            InstructionIT it = block->fInstructions.begin();
-            dispatchFirstVec();
-
-        /*
-        // Execute VecLoop
-        InstructionIT it;
-
-        // Push branch2 (loop content)
-        interp_assert((*it)->fBranch2);
-        pushBranch2Vec();
-
-        // And start branch1 loop variable declaration block
-        interp_assert((*it)->fBranch1);
-        dispatchBranch1Vec();
-        */
-
-        // Number operations
-        do_kRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kInt32Value : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Memory operations
-        do_kLoadReal : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_REAL();
-            dispatchNextVec();
+    Operand pop(bool real)
+    {
+        if (fStack[real].empty()) {
+            fValid = false;
+            return Operand::value(0, 0);
         }
+        Operand arg = fStack[real].back();
+        fStack[real].pop_back();
+        return arg;
+    }
 
-        do_kLoadInt : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
+    // Stack slot register, which must not collide with local registers
+    int stackRegister(bool real)
+    {
+        int reg         = int(fStack[real].size());
+        fMaxStack[real] = std::max(fMaxStack[real], reg);
+        if (reg > fNextLocal[real]) {
+            fValid = false;
         }
+        return reg;
+    }
 
-        do_kLoadSound : {
-            pushSound(fSoundHeap[(*it)->fOffset1]);
-            dispatchNextVec();
+    Operand heapArg(bool real, int offset)
+    {
+        if (!real && offset == fLoop->fIndexOffset) {
+            return Operand::reg(fLoop->fIndexRegister);
         }
-
-        do_kLoadSoundField : {
-            /*
-             if (TRACE) {
-                push_sound(fSoundHeap[assert_sound_heap(it, (*it)->fOffset1)]);
-             } else {
-                push_sound(fSoundHeap[(*it)->fOffset1]);
-             }
-                dispatch_next();
-             */
+        auto local = fLocals[real].find(offset);
+        if (local != fLocals[real].end()) {
+            return Operand::reg(local->second);
         }
+        fInvariants[real].insert(offset);
+        return Operand::heap(offset);
+    }
 
-        do_kStoreReal : {
-            VEC_LOOP(WRITE_HEAP_VEC_REAL((*it)->fOffset1, POP_VEC_REAL()));
-            STACK_DOWN_REAL();
-            dispatchNextVec();
+    void storeHeap(bool real, int offset, const Operand& arg)
+    {
+        // Loop index is only written by the loop increment, and a location read before being written in the body
+        // keeps the value of the previous iteration
+        if ((!real && offset == fLoop->fIndexOffset) || fInvariants[real].count(offset)) {
+            fValid = false;
+            return;
         }
 
-        do_kStoreInt : {
-            VEC_LOOP(WRITE_HEAP_VEC_INT((*it)->fOffset1, POP_VEC_INT()));
-            STACK_DOWN_INT();
-            dispatchNextVec();
+        int  reg;
+        auto local = fLocals[real].find(offset);
+        if (local != fLocals[real].end()) {
+            reg = local->second;
+        } else {
+            reg                   = fNextLocal[real]--;
+            fLocals[real][offset] = reg;
+            if (reg <= fMaxStack[real]) {
+                fValid = false;
+                return;
+            }
         }
 
-        do_kStoreSound : {
-            // fSoundHeap[(*it)->fOffset1] = popSound();
-            dispatchNextVec();
+        // Stack slots still using the previous value of the location are moved in their own register
+        for (size_t i = 0; i < fStack[real].size(); i++) {
+            if (fStack[real][i].fKind == Operand::kRegister && fStack[real][i].fIndex == reg) {
+                emit((real) ? FBCInstruction::kMoveReal : FBCInstruction::kMoveInt, int(i), -1, fStack[real][i]);
+                fStack[real][i] = Operand::reg(int(i));
+            }
         }
 
-        // Directly store a value
-        do_kStoreRealValue : {
-            VEC_LOOP(WRITE_HEAP_VEC_REAL((*it)->fOffset1, (*it)->fRealValue));
-            dispatchNextVec();
-        }
+        emit((real) ? FBCInstruction::kMoveReal : FBCInstruction::kMoveInt, reg, -1, arg);
+    }
 
-        do_kStoreIntValue : {
-            VEC_LOOP(WRITE_HEAP_VEC_INT((*it)->fOffset1, (*it)->fIntValue));
-            dispatchNextVec();
-        }
+    void unary(FBCInstruction::Opcode op, const Operand& arg1)
+    {
+        bool real = FBCVecLoop<T>::isRealResult(op);
+        int  dst  = stackRegister(real);
+        emit(op, dst, -1, arg1);
+        push(real, Operand::reg(dst));
+    }
 
-        do_kLoadIndexedReal : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1 + POP_VEC_INT())));
-            STACK_UP_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+    void binary(FBCInstruction::Opcode op, const Operand& arg1, const Operand& arg2)
+    {
+        bool real = FBCVecLoop<T>::isRealResult(op);
+        int  dst  = stackRegister(real);
+        emit(op, dst, -1, arg1, arg2);
+        push(real, Operand::reg(dst));
+    }
 
-        do_kLoadIndexedInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1 + v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+    void loadIndexed(bool real, int offset, int size, const Operand& index)
+    {
+        fReads[real].push_back(Range(offset, size));
+        int dst = stackRegister(real);
+        emit((real) ? FBCInstruction::kLoadIndexedReal : FBCInstruction::kLoadIndexedInt, dst, offset, index);
+        push(real, Operand::reg(dst));
+    }
 
-        do_kStoreIndexedReal : {
-            VEC_LOOP(WRITE_HEAP_VEC_REAL((*it)->fOffset1 + POP_VEC_INT(), POP_VEC_REAL()));
-            STACK_DOWN_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+    void storeIndexed(bool real, int offset, int size, const Operand& value, const Operand& index)
+    {
+        fWrites[real].push_back(Range(offset, size));
+        emit((real) ? FBCInstruction::kStoreIndexedReal : FBCInstruction::kStoreIndexedInt, -1, offset, value, index);
+    }
 
-        do_kStoreIndexedInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(WRITE_HEAP_VEC_INT((*it)->fOffset1 + v1_int[j], POP_VEC_INT()));
-            STACK_DOWN_INT();
-            dispatchNextVec();
+    static FBCInstruction::Opcode valueInvert2Math(FBCInstruction::Opcode op)
+    {
+        switch (op) {
+            case FBCInstruction::kSubRealValueInvert:
+                return FBCInstruction::kSubReal;
+            case FBCInstruction::kSubIntValueInvert:
+                return FBCInstruction::kSubInt;
+            case FBCInstruction::kDivRealValueInvert:
+                return FBCInstruction::kDivReal;
+            case FBCInstruction::kDivIntValueInvert:
+                return FBCInstruction::kDivInt;
+            case FBCInstruction::kRemRealValueInvert:
+                return FBCInstruction::kRemReal;
+            case FBCInstruction::kRemIntValueInvert:
+                return FBCInstruction::kRemInt;
+            case FBCInstruction::kLshIntValueInvert:
+                return FBCInstruction::kLshInt;
+            case FBCInstruction::kRshIntValueInvert:
+                return FBCInstruction::kRshInt;
+            case FBCInstruction::kGTIntValueInvert:
+                return FBCInstruction::kGTInt;
+            case FBCInstruction::kLTIntValueInvert:
+                return FBCInstruction::kLTInt;
+            case FBCInstruction::kGEIntValueInvert:
+                return FBCInstruction::kGEInt;
+            case FBCInstruction::kLEIntValueInvert:
+                return FBCInstruction::kLEInt;
+            case FBCInstruction::kGTRealValueInvert:
+                return FBCInstruction::kGTReal;
+            case FBCInstruction::kLTRealValueInvert:
+                return FBCInstruction::kLTReal;
+            case FBCInstruction::kGERealValueInvert:
+                return FBCInstruction::kGEReal;
+            default:
+                return FBCInstruction::kLEReal;
         }
+    }
 
-        do_kBlockStoreReal : {
-            FIRBlockStoreRealInstruction<T>* inst = static_cast<FIRBlockStoreRealInstruction<T>*>(*it);
-            interp_assert(inst);
-            for (int i = 0; i < inst->fOffset2; i++) {
-                fRealHeap[inst->fOffset1 + i] = inst->fNumTable[i];
-            }
-            dispatchNextVec();
-        }
+    static FBCInstruction::Opcode offset(FBCInstruction::Opcode op, int base, int family)
+    {
+        return FBCInstruction::Opcode(op - (family - base));
+    }
 
-        do_kBlockStoreInt : {
-            FIRBlockStoreIntInstruction<T>* inst = static_cast<FIRBlockStoreIntInstruction<T>*>(*it);
-            interp_assert(inst);
-            for (int i = 0; i < inst->fOffset2; i++) {
-                fIntHeap[inst->fOffset1 + i] = inst->fNumTable[i];
-            }
-            dispatchNextVec();
-        }
+    void lower(FBCBasicInstruction<T>* inst)
+    {
+        typedef FBCInstruction I;
+        I::Opcode op    = inst->fOpcode;
+        Operand   value = Operand::value(inst->fIntValue, inst->fRealValue);
+
+        if (I::isMath(op)) {
+            bool    real = FBCVecLoop<T>::isRealArg(op);
+            Operand arg1 = pop(real);
+            Operand arg2 = pop(real);
+            binary(op, arg1, arg2);
+        } else if (op >= I::kAddRealHeap && op <= I::kXORIntHeap) {
+            op        = offset(op, I::kAddReal, I::kAddRealHeap);
+            bool real = FBCVecLoop<T>::isRealArg(op);
+            binary(op, heapArg(real, inst->fOffset1), heapArg(real, inst->fOffset2));
+        } else if (op >= I::kAddRealStack && op <= I::kXORIntStack) {
+            op        = offset(op, I::kAddReal, I::kAddRealStack);
+            bool real = FBCVecLoop<T>::isRealArg(op);
+            Operand arg1 = heapArg(real, inst->fOffset1);
+            binary(op, arg1, pop(real));
+        } else if (op >= I::kAddRealStackValue && op <= I::kXORIntStackValue) {
+            op        = offset(op, I::kAddReal, I::kAddRealStackValue);
+            binary(op, value, pop(FBCVecLoop<T>::isRealArg(op)));
+        } else if (op >= I::kAddRealValue && op <= I::kXORIntValue) {
+            op = offset(op, I::kAddReal, I::kAddRealValue);
+            binary(op, value, heapArg(FBCVecLoop<T>::isRealArg(op), inst->fOffset1));
+        } else if (op >= I::kSubRealValueInvert && op <= I::kLERealValueInvert) {
+            op = valueInvert2Math(op);
+            binary(op, heapArg(FBCVecLoop<T>::isRealArg(op), inst->fOffset1), value);
+        } else if (op >= I::kAbs && op <= I::kTanhf) {
+            unary(op, pop(FBCVecLoop<T>::isRealArg(op)));
+        } else if (op >= I::kAbsHeap && op <= I::kTanhfHeap) {
+            op = offset(op, I::kAbs, I::kAbsHeap);
+            unary(op, heapArg(FBCVecLoop<T>::isRealArg(op), inst->fOffset1));
+        } else if (op >= I::kAtan2f && op <= I::kMinf) {
+            bool    real = FBCVecLoop<T>::isRealArg(op);
+            Operand arg1 = pop(real);
+            Operand arg2 = pop(real);
+            binary(op, arg1, arg2);
+        } else if (op >= I::kAtan2fHeap && op <= I::kMinfHeap) {
+            op        = offset(op, I::kAtan2f, I::kAtan2fHeap);
+            bool real = FBCVecLoop<T>::isRealArg(op);
+            binary(op, heapArg(real, inst->fOffset1), heapArg(real, inst->fOffset2));
+        } else if (op >= I::kAtan2fStack && op <= I::kMinfStack) {
+            op        = offset(op, I::kAtan2f, I::kAtan2fStack);
+            bool real = FBCVecLoop<T>::isRealArg(op);
+            Operand arg1 = heapArg(real, inst->fOffset1);
+            binary(op, arg1, pop(real));
+        } else if (op >= I::kAtan2fStackValue && op <= I::kMinfStackValue) {
+            op = offset(op, I::kAtan2f, I::kAtan2fStackValue);
+            binary(op, value, pop(FBCVecLoop<T>::isRealArg(op)));
+        } else if (op >= I::kAtan2fValue && op <= I::kMinfValue) {
+            op = offset(op, I::kAtan2f, I::kAtan2fValue);
+            binary(op, value, heapArg(FBCVecLoop<T>::isRealArg(op), inst->fOffset1));
+        } else if (op >= I::kAtan2fValueInvert && op <= I::kPowfValueInvert) {
+            op = offset(op, I::kAtan2f, I::kAtan2fValueInvert);
+            binary(op, heapArg(true, inst->fOffset1), value);
+        } else {
+            switch (op) {
+                // Numbers
+                case I::kRealValue:
+                    push(true, value);
+                    break;
 
-        do_kMoveReal : {
-            fRealHeap[(*it)->fOffset1] = fRealHeap[(*it)->fOffset2];
-            dispatchNextVec();
-        }
+                case I::kInt32Value:
+                    push(false, value);
+                    break;
 
-        do_kMoveInt : {
-            fIntHeap[(*it)->fOffset1] = fIntHeap[(*it)->fOffset2];
-            dispatchNextVec();
-        }
+                // Memory
+                case I::kLoadReal:
+                case I::kLoadInt: {
+                    bool real = (op == I::kLoadReal);
+                    push(real, heapArg(real, inst->fOffset1));
+                    break;
+                }
 
-        do_kPairMoveReal : {
-            fRealHeap[(*it)->fOffset1] = fRealHeap[(*it)->fOffset1 - 1];
-            fRealHeap[(*it)->fOffset2] = fRealHeap[(*it)->fOffset2 - 1];
-            dispatchNextVec();
-        }
+                case I::kStoreReal:
+                case I::kStoreInt: {
+                    bool real = (op == I::kStoreReal);
+                    storeHeap(real, inst->fOffset1, pop(real));
+                    break;
+                }
 
-        do_kPairMoveInt : {
-            fIntHeap[(*it)->fOffset1] = fIntHeap[(*it)->fOffset1 - 1];
-            fIntHeap[(*it)->fOffset2] = fIntHeap[(*it)->fOffset2 - 1];
-            dispatchNextVec();
-        }
+                case I::kStoreRealValue:
+                case I::kStoreIntValue:
+                    storeHeap(op == I::kStoreRealValue, inst->fOffset1, value);
+                    break;
 
-        do_kBlockPairMoveReal : {
-            for (int i = (*it)->fOffset1; i < (*it)->fOffset2; i += 2) {
-                fRealHeap[i + 1] = fRealHeap[i];
-            }
-            dispatchNextVec();
-        }
+                case I::kMoveReal:
+                case I::kMoveInt: {
+                    bool real = (op == I::kMoveReal);
+                    storeHeap(real, inst->fOffset1, heapArg(real, inst->fOffset2));
+                    break;
+                }
 
-        do_kBlockPairMoveInt : {
-            for (int i = (*it)->fOffset1; i < (*it)->fOffset2; i += 2) {
-                fIntHeap[i + 1] = fIntHeap[i];
-            }
-            dispatchNextVec();
-        }
+                case I::kLoadIndexedReal:
+                case I::kLoadIndexedInt:
+                    loadIndexed(op == I::kLoadIndexedReal, inst->fOffset1, inst->fOffset2, pop(false));
+                    break;
 
-        do_kBlockShiftReal : {
-            for (int i = (*it)->fOffset1; i > (*it)->fOffset2; i -= 1) {
-                fRealHeap[i] = fRealHeap[i - 1];
-            }
-            dispatchNextVec();
-        }
+                case I::kStoreIndexedReal:
+                case I::kStoreIndexedInt: {
+                    bool    real  = (op == I::kStoreIndexedReal);
+                    Operand index = pop(false);
+                    storeIndexed(real, inst->fOffset1, inst->fOffset2, pop(real), index);
+                    break;
+                }
+
+                case I::kLoadInput: {
+                    // Inputs and outputs may be the same buffers
+                    fValid    = fValid && !fHasOutput;
+                    int dst   = stackRegister(true);
+                    emit(op, dst, inst->fOffset1, pop(false));
+                    push(true, Operand::reg(dst));
+                    break;
+                }
 
-        do_kBlockShiftInt : {
-            for (int i = (*it)->fOffset1; i > (*it)->fOffset2; i -= 1) {
-                fIntHeap[i] = fIntHeap[i - 1];
-            }
-            dispatchNextVec();
-        }
+                case I::kStoreOutput: {
+                    fHasOutput    = true;
+                    Operand index = pop(false);
+                    emit(op, -1, inst->fOffset1, pop(true), index);
+                    break;
+                }
 
-        // Input/output access
-        do_kLoadInput : {
-            VEC_LOOP(PUSH_VEC_REAL(fInputs[(*it)->fOffset1][POP_VEC_INT()]));
-            STACK_UP_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+                // Cast
+                case I::kCastReal:
+                    unary(I::kCastReal, pop(false));
+                    break;
 
-        do_kStoreOutput : {
-            VEC_LOOP(fOutputs[(*it)->fOffset1][POP_VEC_INT()] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+                case I::kCastInt:
+                    unary(I::kCastInt, pop(true));
+                    break;
 
-        // Cast operations
-        do_kCastReal : {
-            VEC_LOOP(PUSH_VEC_REAL(T(POP_VEC_INT())));
-            STACK_UP_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+                case I::kCastRealHeap:
+                    unary(I::kCastReal, heapArg(false, inst->fOffset1));
+                    break;
 
-        do_kCastRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(T(READ_HEAP_VEC_INT((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                case I::kCastIntHeap:
+                    unary(I::kCastInt, heapArg(true, inst->fOffset1));
+                    break;
 
-        do_kCastInt : {
-            VEC_LOOP(PUSH_VEC_INT(T(POP_VEC_REAL())));
-            STACK_DOWN_REAL();
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                // Superinstructions
+                case I::kMultAddRealHeap:
+                case I::kMultAddRealHeapStore: {
+                    binary(I::kMultReal, heapArg(true, inst->fOffset1), heapArg(true, inst->fOffset2));
+                    Operand arg1 = pop(true);
+                    binary(I::kAddReal, arg1, pop(true));
+                    if (op == I::kMultAddRealHeapStore) {
+                        storeHeap(true, inst->fIntValue, pop(true));
+                    }
+                    break;
+                }
 
-        do_kCastIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(T(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                case I::kMultAddRealStack: {
+                    Operand arg1 = heapArg(true, inst->fOffset1);
+                    binary(I::kMultReal, arg1, pop(true));
+                    arg1 = heapArg(true, inst->fOffset2);
+                    binary(I::kAddReal, arg1, pop(true));
+                    break;
+                }
+
+                case I::kAddRealStore:
+                case I::kSubRealStore:
+                case I::kMultRealStore: {
+                    Operand arg1 = pop(true);
+                    Operand arg2 = pop(true);
+                    binary((op == I::kAddRealStore) ? I::kAddReal : (op == I::kSubRealStore) ? I::kSubReal : I::kMultReal,
+                           arg1, arg2);
+                    storeHeap(true, inst->fOffset1, pop(true));
+                    break;
+                }
+
+                case I::kAddRealStackStore:
+                case I::kSubRealStackStore:
+                case I::kMultRealStackStore: {
+                    Operand arg1 = heapArg(true, inst->fOffset1);
+                    binary((op == I::kAddRealStackStore)   ? I::kAddReal
+                           : (op == I::kSubRealStackStore) ? I::kSubReal
+                                                           : I::kMultReal,
+                           arg1, pop(true));
+                    storeHeap(true, inst->fOffset2, pop(true));
+                    break;
+                }
 
-        // Bitcast operations
-        do_kBitcastInt : {
-            VEC_LOOP(T v1 = POP_VEC_REAL(); PUSH_VEC_INT(*reinterpret_cast<int*>(&v1)));
-            STACK_DOWN_REAL();
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                case I::kLoadIndexedRealMask:
+                    binary(I::kANDInt, value, pop(false));
+                    loadIndexed(true, inst->fOffset1, inst->fOffset2, pop(false));
+                    break;
 
-        do_kBitcastReal : {
-            VEC_LOOP(int v1 = POP_VEC_INT(); PUSH_VEC_REAL(*reinterpret_cast<T*>(&v1)));
-            STACK_UP_REAL();
-            STACK_DOWN_INT();
-            dispatchNextVec();
-        }
+                case I::kStoreIndexedRealMask: {
+                    binary(I::kANDInt, value, heapArg(false, inst->fOffset2));
+                    Operand index = pop(false);
+                    storeIndexed(true, inst->fOffset1, inst->fIntValue + 1, pop(true), index);
+                    break;
+                }
 
-            //-------------------------------------------------------
-            // Standard math operations : 'stack' OP 'stack' version
-            //-------------------------------------------------------
-
-        do_kAddReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(v1_real[j] + v2_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
+                default:
+                    // Control flow, sound and block instructions are not vectorized
+                    fValid = false;
+                    break;
+            }
         }
+    }
 
-        do_kAddInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] + v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+    static bool overlap(const Range& range, int offset) { return offset >= range.first && offset < range.first + range.second; }
 
-        do_kSubReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(v1_real[j] - v2_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+    static bool overlap(const Range& range1, const Range& range2)
+    {
+        return range1.first < range2.first + range2.second && range2.first < range1.first + range1.second;
+    }
 
-        do_kSubInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] - v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
+    // Arrays written in the body must not be accessed by other instructions in the body
+    bool checkMemory(bool real)
+    {
+        for (size_t i = 0; i < fWrites[real].size(); i++) {
+            const Range& range = fWrites[real][i];
+            for (size_t j = 0; j < fWrites[real].size(); j++) {
+                if (i != j && overlap(range, fWrites[real][j])) return false;
+            }
+            for (auto& read : fReads[real]) {
+                if (overlap(range, read)) return false;
+            }
+            for (auto& offset : fInvariants[real]) {
+                if (overlap(range, offset)) return false;
+            }
+            for (auto& local : fLocals[real]) {
+                if (overlap(range, local.first)) return false;
+            }
+            if (!real && (overlap(range, fLoop->fIndexOffset) || overlap(range, fLoop->fEndOffset))) return false;
         }
-
-        do_kMultReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(v1_real[j] * v2_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
+        for (auto& local : fLocals[real]) {
+            for (auto& read : fReads[real]) {
+                if (overlap(read, local.first)) return false;
+            }
         }
+        return true;
+    }
 
-        do_kMultInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] * v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+    bool isIndex(FBCBasicInstruction<T>* inst, FBCInstruction::Opcode op)
+    {
+        return inst->fOpcode == op && inst->fOffset1 == fLoop->fIndexOffset;
+    }
 
-        do_kDivReal : {
-            VEC_LOOP(v1_int[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(v1_int[j] / v2_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
+    // Match the loop header (index init) and tail (index increment and test), and lower the body
+    bool build(FBCBasicInstruction<T>* loop)
+    {
+        typedef FBCInstruction I;
+        std::vector<FBCBasicInstruction<T>*>& init = loop->fBranch1->fInstructions;
+        std::vector<FBCBasicInstruction<T>*>& body = loop->fBranch2->fInstructions;
+
+        // 'index = value'
+        if (init.size() == 3 && init[0]->fOpcode == I::kInt32Value && init[1]->fOpcode == I::kStoreInt) {
+            fLoop->fInitValue   = init[0]->fIntValue;
+            fLoop->fIndexOffset = init[1]->fOffset1;
+        } else if (init.size() == 2 && init[0]->fOpcode == I::kStoreIntValue) {
+            fLoop->fInitValue   = init[0]->fIntValue;
+            fLoop->fIndexOffset = init[0]->fOffset1;
+        } else {
+            return false;
         }
 
-        do_kDivInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] / v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+        // Body ends with 'index = index + 1', 'index < bound', kCondBranch and kReturn
+        int size = int(body.size());
+        int store = size - 3;
+        while (store >= 0 && !isIndex(body[store], I::kStoreInt)) store--;
+        if (store < 1) return false;
 
-        do_kRemReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::remainder(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
+        int end = store;
+        if (isIndex(body[store - 1], I::kAddIntValue) && body[store - 1]->fIntValue == 1) {
+            end = store - 1;
+        } else if (store >= 3 && isIndex(body[store - 3], I::kLoadInt) && body[store - 2]->fOpcode == I::kInt32Value &&
+                   body[store - 2]->fIntValue == 1 && body[store - 1]->fOpcode == I::kAddInt) {
+            end = store - 3;
+        } else {
+            return false;
+        }
+
+        int test = size - 2 - (store + 1);
+        fLoop->fEndOffset = -1;
+        if (test == 1 && isIndex(body[store + 1], I::kLTIntValueInvert)) {
+            fLoop->fEndValue = body[store + 1]->fIntValue;
+        } else if (test == 1 && isIndex(body[store + 1], I::kLTIntHeap)) {
+            fLoop->fEndOffset = body[store + 1]->fOffset2;
+        } else if (test == 3 && isIndex(body[store + 2], I::kLoadInt) && body[store + 3]->fOpcode == I::kLTInt &&
+                   body[store + 1]->fOpcode == I::kInt32Value) {
+            fLoop->fEndValue = body[store + 1]->fIntValue;
+        } else if (test == 3 && isIndex(body[store + 2], I::kLoadInt) && body[store + 3]->fOpcode == I::kLTInt &&
+                   body[store + 1]->fOpcode == I::kLoadInt) {
+            fLoop->fEndOffset = body[store + 1]->fOffset1;
+        } else {
+            return false;
         }
+        if (fLoop->fEndOffset == fLoop->fIndexOffset || body[size - 2]->fOpcode != I::kCondBranch) return false;
 
-        do_kRemInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] % v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
+        for (int i = 0; i < end && fValid; i++) {
+            lower(body[i]);
         }
 
-        // Shift operation
-        do_kLshInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] << v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+        fLoop->fRealLocals = fLocals[1];
+        fLoop->fIntLocals  = fLocals[0];
 
-        do_kRshInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] >> v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+        return fValid && fStack[0].empty() && fStack[1].empty() && !fLocals[0].count(fLoop->fEndOffset) &&
+               checkMemory(false) && checkMemory(true);
+    }
+};
 
-        // Comparaison Int
-        do_kGTInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] > v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+#define binaryReal(exp)                                                                  \
+    {                                                                                    \
+        const T* a = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);         \
+        const T* b = realArg(inst.fArg2, real_regs, real_heap, real_arg2, size);         \
+        T*       d = real_regs[inst.fDst];                                               \
+        for (int j = 0; j < size; j++) d[j] = (exp);                                     \
+        break;                                                                           \
+    }
+#define compareReal(exp)                                                                 \
+    {                                                                                    \
+        const T* a = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);         \
+        const T* b = realArg(inst.fArg2, real_regs, real_heap, real_arg2, size);         \
+        int*     d = int_regs[inst.fDst];                                                \
+        for (int j = 0; j < size; j++) d[j] = (exp);                                     \
+        break;                                                                           \
+    }
+#define binaryInt(exp)                                                                   \
+    {                                                                                    \
+        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);           \
+        const int* b = intArg(inst.fArg2, int_regs, int_heap, int_arg2, size);           \
+        int*       d = int_regs[inst.fDst];                                              \
+        for (int j = 0; j < size; j++) d[j] = (exp);                                     \
+        break;                                                                           \
+    }
+#define unaryReal(exp)                                                                   \
+    {                                                                                    \
+        const T* a = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);         \
+        T*       d = real_regs[inst.fDst];                                               \
+        for (int j = 0; j < size; j++) d[j] = (exp);                                     \
+        break;                                                                           \
+    }
+#define unaryInt(exp)                                                                    \
+    {                                                                                    \
+        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);           \
+        int*       d = int_regs[inst.fDst];                                              \
+        for (int j = 0; j < size; j++) d[j] = (exp);                                     \
+        break;                                                                           \
+    }
 
-        do_kLTInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] < v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+// Execute a vectorized loop, VEC iterations at a time
+template <class T, int VEC>
+struct FBCVecInterpreter {
+    static inline const T* realArg(const FBCVecOperand<T>& arg, T (*regs)[VEC], const T* heap, T* scratch, int size)
+    {
+        if (arg.fKind == FBCVecOperand<T>::kRegister) return regs[arg.fIndex];
+        T value = (arg.fKind == FBCVecOperand<T>::kHeap) ? heap[arg.fIndex] : arg.fRealValue;
+        for (int j = 0; j < size; j++) scratch[j] = value;
+        return scratch;
+    }
 
-        do_kGEInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] >= v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+    static inline const int* intArg(const FBCVecOperand<T>& arg, int (*regs)[VEC], const int* heap, int* scratch,
+                                    int size)
+    {
+        if (arg.fKind == FBCVecOperand<T>::kRegister) return regs[arg.fIndex];
+        int value = (arg.fKind == FBCVecOperand<T>::kHeap) ? heap[arg.fIndex] : arg.fIntValue;
+        for (int j = 0; j < size; j++) scratch[j] = value;
+        return scratch;
+    }
 
-        do_kLEInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] <= v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+    static void ExecuteLoop(const FBCVecLoop<T>* loop, int* int_heap, T* real_heap, T** inputs, T** outputs)
+    {
+        T   real_regs[VEC_MAX_REGISTERS][VEC];
+        int int_regs[VEC_MAX_REGISTERS][VEC];
+        T   real_arg1[VEC];
+        T   real_arg2[VEC];
+        int int_arg1[VEC];
+        int int_arg2[VEC];
+
+        int first = loop->fInitValue;
+        int last  = (loop->fEndOffset >= 0) ? int_heap[loop->fEndOffset] : loop->fEndValue;
+        // Compiled loops test the index after the body, which is always executed once
+        int count = std::max(last - first, 1);
+        int size  = 0;
+
+        for (int index = 0; index < count; index += VEC) {
+            size = std::min(VEC, count - index);
+
+            int* loop_index = int_regs[loop->fIndexRegister];
+            for (int j = 0; j < size; j++) loop_index[j] = first + index + j;
+
+            for (const auto& inst : loop->fInstructions) {
+                switch (inst.fOpcode) {
+                    // Memory
+                    case FBCInstruction::kMoveReal:
+                        unaryReal(a[j]);
+
+                    case FBCInstruction::kMoveInt:
+                        unaryInt(a[j]);
+
+                    case FBCInstruction::kLoadIndexedReal: {
+                        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);
+                        T*         d = real_regs[inst.fDst];
+                        for (int j = 0; j < size; j++) d[j] = real_heap[inst.fOffset + a[j]];
+                        break;
+                    }
 
-        do_kEQInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] == v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLoadIndexedInt: {
+                        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);
+                        int*       d = int_regs[inst.fDst];
+                        for (int j = 0; j < size; j++) d[j] = int_heap[inst.fOffset + a[j]];
+                        break;
+                    }
 
-        do_kNEInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] != v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kStoreIndexedReal: {
+                        const T*   a = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);
+                        const int* b = intArg(inst.fArg2, int_regs, int_heap, int_arg2, size);
+                        for (int j = 0; j < size; j++) real_heap[inst.fOffset + b[j]] = a[j];
+                        break;
+                    }
 
-        // Comparaison Real
-        do_kGTReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] > v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kStoreIndexedInt: {
+                        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);
+                        const int* b = intArg(inst.fArg2, int_regs, int_heap, int_arg2, size);
+                        for (int j = 0; j < size; j++) int_heap[inst.fOffset + b[j]] = a[j];
+                        break;
+                    }
 
-        do_kLTReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] < v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLoadInput: {
+                        const int* a     = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);
+                        const T*   input = inputs[inst.fOffset];
+                        T*         d     = real_regs[inst.fDst];
+                        for (int j = 0; j < size; j++) d[j] = input[a[j]];
+                        break;
+                    }
 
-        do_kGEReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] >= v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kStoreOutput: {
+                        const T*   a      = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);
+                        const int* b      = intArg(inst.fArg2, int_regs, int_heap, int_arg2, size);
+                        T*         output = outputs[inst.fOffset];
+                        for (int j = 0; j < size; j++) output[b[j]] = a[j];
+                        break;
+                    }
 
-        do_kLEReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] <= v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    // Cast
+                    case FBCInstruction::kCastReal: {
+                        const int* a = intArg(inst.fArg1, int_regs, int_heap, int_arg1, size);
+                        T*         d = real_regs[inst.fDst];
+                        for (int j = 0; j < size; j++) d[j] = T(a[j]);
+                        break;
+                    }
 
-        do_kEQReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] == v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kCastInt: {
+                        const T* a = realArg(inst.fArg1, real_regs, real_heap, real_arg1, size);
+                        int*     d = int_regs[inst.fDst];
+                        for (int j = 0; j < size; j++) d[j] = int(a[j]);
+                        break;
+                    }
 
-        do_kNEReal : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(v1_real[j] != v2_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    // Standard math
+                    case FBCInstruction::kAddReal:
+                        binaryReal(a[j] + b[j]);
 
-        // Logical operations
-        do_kANDInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] & v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAddInt:
+                        binaryInt(a[j] + b[j]);
 
-        do_kORInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] | v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kSubReal:
+                        binaryReal(a[j] - b[j]);
 
-        do_kXORInt : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(v1_int[j] ^ v2_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kSubInt:
+                        binaryInt(a[j] - b[j]);
 
-            //-----------------------------------------------------
-            // Standard math operations : 'heap' OP 'heap' version
-            //-----------------------------------------------------
+                    case FBCInstruction::kMultReal:
+                        binaryReal(a[j] * b[j]);
 
-        do_kAddRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) + READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kMultInt:
+                        binaryInt(a[j] * b[j]);
 
-        do_kAddIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) + READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kDivReal:
+                        binaryReal(a[j] / b[j]);
 
-        do_kSubRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) - READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kDivInt:
+                        binaryInt(a[j] / b[j]);
 
-        do_kSubIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) - READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kRemReal:
+                        binaryReal(std::remainder(a[j], b[j]));
 
-        do_kMultRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) * READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kRemInt:
+                        binaryInt(a[j] % b[j]);
 
-        do_kMultIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) * READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLshInt:
+                        binaryInt(a[j] << b[j]);
 
-        do_kDivRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) / READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kRshInt:
+                        binaryInt(a[j] >> b[j]);
 
-        do_kDivIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) / READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kGTInt:
+                        binaryInt(a[j] > b[j]);
 
-        do_kRemRealHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(
-                std::remainder(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLTInt:
+                        binaryInt(a[j] < b[j]);
 
-        do_kRemIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) % READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kGEInt:
+                        binaryInt(a[j] >= b[j]);
 
-        // Shift operation
-        do_kLshIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) << READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLEInt:
+                        binaryInt(a[j] <= b[j]);
 
-        do_kRshIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >> READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kEQInt:
+                        binaryInt(a[j] == b[j]);
 
-        // Comparaison Int
-        do_kGTIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) > READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kNEInt:
+                        binaryInt(a[j] != b[j]);
 
-        do_kLTIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) < READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kGTReal:
+                        compareReal(a[j] > b[j]);
 
-        do_kGEIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >= READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLTReal:
+                        compareReal(a[j] < b[j]);
 
-        do_kLEIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) <= READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kGEReal:
+                        compareReal(a[j] >= b[j]);
 
-        do_kEQIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) == READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLEReal:
+                        compareReal(a[j] <= b[j]);
 
-        do_kNEIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) != READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kEQReal:
+                        compareReal(a[j] == b[j]);
 
-        // Comparaison Real
-        do_kGTRealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) > READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kNEReal:
+                        compareReal(a[j] != b[j]);
 
-        do_kLTRealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) < READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kANDInt:
+                        binaryInt(a[j] & b[j]);
 
-        do_kGERealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) >= READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kORInt:
+                        binaryInt(a[j] | b[j]);
 
-        do_kLERealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) <= READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kXORInt:
+                        binaryInt(a[j] ^ b[j]);
 
-        do_kEQRealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) == READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    // Extended unary math
+                    case FBCInstruction::kAbs:
+                        unaryInt(std::abs(a[j]));
 
-        do_kNERealHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) != READ_HEAP_VEC_REAL((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAbsf:
+                        unaryReal(std::fabs(a[j]));
 
-        // Logical operations
-        do_kANDIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) & READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAcosf:
+                        unaryReal(std::acos(a[j]));
 
-        do_kORIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) | READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAcoshf:
+                        unaryReal(std::acosh(a[j]));
 
-        do_kXORIntHeap : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) ^ READ_HEAP_VEC_INT((*it)->fOffset2)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAsinf:
+                        unaryReal(std::asin(a[j]));
 
-            //------------------------------------------------------
-            // Standard math operations : 'stack' OP 'heap' version
-            //------------------------------------------------------
+                    case FBCInstruction::kAsinhf:
+                        unaryReal(std::asinh(a[j]));
 
-        do_kAddRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) + v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAtanf:
+                        unaryReal(std::atan(a[j]));
 
-        do_kAddIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) + v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kAtanhf:
+                        unaryReal(std::atanh(a[j]));
 
-        do_kSubRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) - v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kCeilf:
+                        unaryReal(std::ceil(a[j]));
 
-        do_kSubIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) - v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kCosf:
+                        unaryReal(std::cos(a[j]));
 
-        do_kMultRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) * v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kCoshf:
+                        unaryReal(std::cosh(a[j]));
 
-        do_kMultIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) * v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kExpf:
+                        unaryReal(std::exp(a[j]));
 
-        do_kDivRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) / v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kFloorf:
+                        unaryReal(std::floor(a[j]));
 
-        do_kDivIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) / v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLogf:
+                        unaryReal(std::log(a[j]));
 
-        do_kRemRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::remainder(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kLog10f:
+                        unaryReal(std::log10(a[j]));
 
-        do_kRemIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) % v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kRintf:
+                        unaryReal(std::rint(a[j]));
 
-        // Shift operation
-        do_kLshIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) << v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kRoundf:
+                        unaryReal(std::round(a[j]));
 
-        do_kRshIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >> v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kSinf:
+                        unaryReal(std::sin(a[j]));
 
-        // Comparaison Int
-        do_kGTIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) > v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kSinhf:
+                        unaryReal(std::sinh(a[j]));
 
-        do_kLTIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) < v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kSqrtf:
+                        unaryReal(std::sqrt(a[j]));
 
-        do_kGEIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >= v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kTanf:
+                        unaryReal(std::tan(a[j]));
 
-        do_kLEIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) <= v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kTanhf:
+                        unaryReal(std::tanh(a[j]));
 
-        do_kEQIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) == v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    // Extended binary math
+                    case FBCInstruction::kAtan2f:
+                        binaryReal(std::atan2(a[j], b[j]));
 
-        do_kNEIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) != v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kFmodf:
+                        binaryReal(std::fmod(a[j], b[j]));
 
-        // Comparaison Real
-        do_kGTRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) > v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kPowf:
+                        binaryReal(std::pow(a[j], b[j]));
 
-        do_kLTRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) < v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kMax:
+                        binaryInt(std::max(a[j], b[j]));
 
-        do_kGERealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) >= v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kMaxf:
+                        binaryReal(std::max(a[j], b[j]));
 
-        do_kLERealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) <= v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kMin:
+                        binaryInt(std::min(a[j], b[j]));
 
-        do_kEQRealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) == v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+                    case FBCInstruction::kMinf:
+                        binaryReal(std::min(a[j], b[j]));
 
-        do_kNERealStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) != v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
+                    default:
+                        break;
+                }
+            }
         }
 
-        // Logical operations
-        do_kANDIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) & v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+        // Heap locations keep the value of the last iteration
+        for (const auto& local : loop->fRealLocals) real_heap[local.first] = real_regs[local.second][size - 1];
+        for (const auto& local : loop->fIntLocals) int_heap[local.first] = int_regs[local.second][size - 1];
+        int_heap[loop->fIndexOffset] = first + count;
+    }
+};
 
-        do_kORIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) | v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
+#undef binaryReal
+#undef compareReal
+#undef binaryInt
+#undef unaryReal
+#undef unaryInt
+
+template <class T>
+FBCVecLoop<T>* FBCVecLoop<T>::create(FBCBasicInstruction<T>* loop)
+{
+    // Vector size of the loop, generated in -vec mode
+    int vec_size = loop->fIntValue;
+    if (vec_size < 4) return nullptr;
+
+    FBCVecLoop<T>*       vec_loop = new FBCVecLoop<T>();
+    FBCVecLoopBuilder<T> builder(vec_loop);
+    if (!builder.build(loop)) {
+        delete vec_loop;
+        return nullptr;
+    }
 
-        do_kXORIntStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) ^ v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-            //-------------------------------------------------------
-            // Standard math operations : 'stack' OP 'value' version
-            //-------------------------------------------------------
-
-        do_kAddRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue + v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAddIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue + v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kSubRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue - v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSubIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue - v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMultRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue * v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMultIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue * v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kDivRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue / v1_real[j]));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kDivIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue / v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRemRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::remainder((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kRemIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue % v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Shift operation
-        do_kLshIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue << v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRshIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue >> v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Int
-        do_kGTIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue > v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue < v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGEIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue >= v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLEIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue <= v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kEQIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue == v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kNEIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue != v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Real
-        do_kGTRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue > v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue < v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGERealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue >= v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLERealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue <= v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kEQRealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue == v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kNERealStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue != v1_real[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Logical operations
-        do_kANDIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue & v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kORIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue | v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kXORIntStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue ^ v1_int[j]));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-            //------------------------------------------------------
-            // Standard math operations : 'value' OP 'heap' version
-            //------------------------------------------------------
-
-        do_kAddRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue + READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAddIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue + READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kSubRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue - READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSubIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue - READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMultRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue * READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMultIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue * READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kDivRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL((*it)->fRealValue / READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kDivIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue / READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRemRealValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::remainder((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kRemIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue % READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Shift operation
-        do_kLshIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue << READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRshIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue >> READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Int
-        do_kGTIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue > READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue < READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGEIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue >= READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLEIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue <= READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kEQIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue == READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kNEIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue != READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Real
-        do_kGTRealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue > READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTRealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue < READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGERealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue >= READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLERealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue <= READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kEQRealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue == READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kNERealValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fRealValue != READ_HEAP_VEC_REAL((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Logical operations
-        do_kANDIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue & READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kORIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue | READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kXORIntValue : {
-            VEC_LOOP(PUSH_VEC_INT((*it)->fIntValue ^ READ_HEAP_VEC_INT((*it)->fOffset1)));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-            //----------------------------------------------------
-            // Standard math operations : Value inverted version
-            // (non commutative operations)
-            //----------------------------------------------------
-
-        do_kSubRealValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) - (*it)->fRealValue));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSubIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) - (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kDivRealValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(READ_HEAP_VEC_REAL((*it)->fOffset1) / (*it)->fRealValue));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kDivIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) / (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRemRealValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(std::remainder(READ_HEAP_VEC_REAL((*it)->fOffset1), (*it)->fRealValue)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kRemIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) % (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Shift operation
-        do_kLshIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) << (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kRshIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >> (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Int
-        do_kGTIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) > (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) < (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGEIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) >= (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLEIntValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_INT((*it)->fOffset1) <= (*it)->fIntValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        // Comparaison Real
-        do_kGTRealValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) > (*it)->fRealValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLTRealValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) < (*it)->fRealValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kGERealValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) >= (*it)->fRealValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kLERealValueInvert : {
-            VEC_LOOP(PUSH_VEC_INT(READ_HEAP_VEC_REAL((*it)->fOffset1) <= (*it)->fRealValue));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-            //---------------------
-            // Extended unary math
-            //---------------------
-
-        do_kAbs : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::abs(v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kAbsf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::fabs(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAcosf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::acos(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAsinf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::asin(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAtanf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::atan(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCeilf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::ceil(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCosf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::cos(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCoshf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::cosh(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kExpf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::exp(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFloorf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::floor(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kLogf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::log(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kLog10f : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::log10(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-            
-        do_kRintf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::rint(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kRoundf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::round(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSinf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::sin(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSinhf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::sinh(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSqrtf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::sqrt(v1_real[j])));
-            dispatchNextVec();
-        }
-
-        do_kTanf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::tan(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kTanhf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::tanh(v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //------------------------------------
-            // Extended unary math (heap version)
-            ///-----------------------------------
-
-        do_kAbsHeap : {
-            VEC_LOOP(PUSH_VEC_INT(std::abs(READ_HEAP_VEC_INT((*it)->fOffset1))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kAbsfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::fabs(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAcosfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::acos(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAsinfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::asin(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kAtanfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::atan(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCeilfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::ceil(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCosfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::cos(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kCoshfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::cosh(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kExpfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::exp(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFloorfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::floor(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kLogfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::log(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kLog10fHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::log10(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-            
-        do_kRintfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::rint(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kRoundfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::round(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSinfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::sin(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSinhfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::sinh(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kSqrtfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::sqrt(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kTanfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::tan(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kTanhfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::tanh(READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //----------------------
-            // Extended binary math
-            //----------------------
-
-        do_kAtan2f : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::atan2(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::fmod(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::pow(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMax : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::max(v1_int[j], v2_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMaxf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::max(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMin : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(v2_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::min(v1_int[j], v2_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMinf : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(v2_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::min(v1_real[j], v2_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //-------------------------------------
-            // Extended binary math (heap version)
-            //-------------------------------------
-
-        do_kAtan2fHeap : {
-            VEC_LOOP(
-                PUSH_VEC_REAL(std::atan2(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodfHeap : {
-            VEC_LOOP(
-                PUSH_VEC_REAL(std::fmod(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::pow(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMaxHeap : {
-            VEC_LOOP(PUSH_VEC_INT(std::max(READ_HEAP_VEC_INT((*it)->fOffset1), READ_HEAP_VEC_INT((*it)->fOffset2))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMaxfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::max(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMinHeap : {
-            VEC_LOOP(PUSH_VEC_INT(std::min(READ_HEAP_VEC_INT((*it)->fOffset1), READ_HEAP_VEC_INT((*it)->fOffset2))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMinfHeap : {
-            VEC_LOOP(PUSH_VEC_REAL(std::min(READ_HEAP_VEC_REAL((*it)->fOffset1), READ_HEAP_VEC_REAL((*it)->fOffset2))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //--------------------------------------
-            // Extended binary math (stack version)
-            //--------------------------------------
-
-        do_kAtan2fStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::atan2(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodfStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::fmod(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowfStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::pow(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMaxStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::max(READ_HEAP_VEC_INT((*it)->fOffset1), v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMaxfStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::max(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMinStack : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::min(READ_HEAP_VEC_INT((*it)->fOffset1), v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMinfStack : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::min(READ_HEAP_VEC_REAL((*it)->fOffset1), v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //--------------------------------------------
-            // Extended binary math (stack/value version)
-            //--------------------------------------------
-
-        do_kAtan2fStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::atan2((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodfStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::fmod((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowfStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::pow((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMaxStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::max((*it)->fIntValue, v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMaxfStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::max((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMinStackValue : {
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            VEC_LOOP(PUSH_VEC_INT(std::min((*it)->fIntValue, v1_int[j])));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMinfStackValue : {
-            VEC_LOOP(v1_real[j] = POP_VEC_REAL());
-            STACK_DOWN_REAL();
-            VEC_LOOP(PUSH_VEC_REAL(std::min((*it)->fRealValue, v1_real[j])));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //-------------------------------------
-            // Extended binary math (Value version)
-            //-------------------------------------
-
-        do_kAtan2fValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::atan2((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodfValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::fmod((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowfValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::pow((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMaxValue : {
-            VEC_LOOP(PUSH_VEC_INT(std::max((*it)->fIntValue, READ_HEAP_VEC_INT((*it)->fOffset1))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMaxfValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::max((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kMinValue : {
-            VEC_LOOP(PUSH_VEC_INT(std::min((*it)->fIntValue, READ_HEAP_VEC_INT((*it)->fOffset1))));
-            STACK_UP_INT();
-            dispatchNextVec();
-        }
-
-        do_kMinfValue : {
-            VEC_LOOP(PUSH_VEC_REAL(std::min((*it)->fRealValue, READ_HEAP_VEC_REAL((*it)->fOffset1))));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //-------------------------------------------------------------------
-            // Extended binary math (Value version) : non commutative operations
-            //-------------------------------------------------------------------
-
-        do_kAtan2fValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(std::atan2(READ_HEAP_VEC_REAL((*it)->fOffset1), (*it)->fRealValue)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kFmodfValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(std::fmod(READ_HEAP_VEC_REAL((*it)->fOffset1), (*it)->fRealValue)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-        do_kPowfValueInvert : {
-            VEC_LOOP(PUSH_VEC_REAL(std::pow(READ_HEAP_VEC_REAL((*it)->fOffset1), (*it)->fRealValue)));
-            STACK_UP_REAL();
-            dispatchNextVec();
-        }
-
-            //---------
-            // Control
-            //---------
-
-        do_kReturn : {
-            // Empty addr stack = end of computation
-            if (emptyReturnVec()) {
-                goto end;
-            } else {
-                dispatchReturnVec();
-            }
-        }
-
-        do_kIf : {
-            // Keep next instruction
-            saveReturnVec();
-
-            if (POP_INT()) {
-                // Execute new block
-                interp_assert((*it)->fBranch1);
-                dispatchBranch1Vec();
-                // No value (If)
-            } else {
-                // Execute new block
-                interp_assert((*it)->fBranch2);
-                dispatchBranch2Vec();
-                // No value (If)
-            }
-        }
-
-        do_kSelectReal : {
-            // Keep next instruction
-            saveReturnVec();
-
-            // Compute condition vector
-
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            // Execute new block
-            VEC_LOOP(if (v1_int[j]) { dispatchBranch1Vec(); } else { dispatchBranch2Vec(); });
-        }
-
-        do_kSelectInt : {
-            // Keep next instruction
-            saveReturnVec();
-
-            // Compute condition vector
-
-            VEC_LOOP(v1_int[j] = POP_VEC_INT());
-            STACK_DOWN_INT();
-            // Execute new block
-            VEC_LOOP(if (v1_int[j]) { dispatchBranch1Vec(); } else { dispatchBranch2Vec(); });
-        }
-
-        do_kCondBranch : {
-            // If condition is true, just branch back on the block beginning
-            if (POP_INT()) {
-                interp_assert((*it)->fBranch1);
-                dispatchBranch1Vec();
-            } else {
-                // Just continue after 'loop block' (do the final 'return')
-                dispatchNextVec();
-            }
-        }
-
-        do_kLoop : {
-            // (*it)->fIntValue = vec_size
-
-            // this->ExecuteVecLoop((*it));
-
-            /*
-            if ((*it)->fIntValue == 1) {
-                this->ExecuteVecLoop<1, TRACE>((*it));
-            } else if ((*it)->fIntValue == 4) {
-                this->ExecuteVecLoop<4, TRACE>((*it));
-            } else if ((*it)->fIntValue == 8) {
-                this->ExecuteVecLoop<8, TRACE>((*it));
-            } else if ((*it)->fIntValue == 16) {
-                this->ExecuteVecLoop<16, TRACE>((*it));
-            } else if ((*it)->fIntValue == 32) {
-                this->ExecuteVecLoop<32, TRACE>((*it));
-            } else if ((*it)->fIntValue == 64) {
-                this->ExecuteVecLoop<64, TRACE>((*it));
-            } else {
-                this->ExecuteVecLoop<128, TRACE>((*it));
-            }
-            */
-
-            // Keep next instruction
-            saveReturnVec();
-
-            // Push branch2 (loop content)
-            interp_assert((*it)->fBranch2);
-            pushBranch2Vec();
-
-            // And start branch1 loop variable declaration block
-            interp_assert((*it)->fBranch1);
-            dispatchBranch1Vec();
-        }
-
-        end:
-            // printf("END real_stack_index = %d, int_stack_index = %d\n", real_stack_index, int_stack_index);
-
-            // Check stack coherency
-            interp_assert(real_stack_index == 0 && int_stack_index == 0 && sound_stack_index == 0);
-
-        } catch (faustexception& e) {
-            std::cout << e.Message();
-        }
+    if (vec_size >= 32) {
+        vec_loop->fExecute = FBCVecInterpreter<T, 32>::ExecuteLoop;
+    } else if (vec_size >= 16) {
+        vec_loop->fExecute = FBCVecInterpreter<T, 16>::ExecuteLoop;
+    } else if (vec_size >= 8) {
+        vec_loop->fExecute = FBCVecInterpreter<T, 8>::ExecuteLoop;
+    } else {
+        vec_loop->fExecute = FBCVecInterpreter<T, 4>::ExecuteLoop;
     }
-
-   public:
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 0>* factory)
-    {
-        /*
-        std::cout << "FBCVecInterpreter :"
-                << " int_heap_size " << int_heap_size
-                << " real_heap_size " << real_heap_size
-                << " sr_offset " << sr_offset
-                << " count_offset " << count_offset << std::endl;
-        */
-
-        fFactory = factory;
-
-        if (fFactory->getMemoryManager()) {
-            fRealHeap  = static_cast<T*>(fFactory->allocate(sizeof(T) * fFactory->fRealHeapSize));
-            fIntHeap   = static_cast<int*>(fFactory->allocate(sizeof(T) * fFactory->fIntHeapSize));
-            fSoundHeap = static_cast<Soundfile**>(fFactory->allocate(sizeof(Soundfile*) * fFactory->fSoundHeapSize));
-            fInputs    = static_cast<T**>(fFactory->allocate(sizeof(T*) * fFactory->fNumInputs));
-            fOutputs   = static_cast<T**>(fFactory->allocate(sizeof(T*) * fFactory->fNumOutputs));
-        } else {
-            fRealHeap  = new T[fFactory->fRealHeapSize];
-            fIntHeap   = new int[fFactory->fIntHeapSize];
-            fSoundHeap = new Soundfile*[fFactory->fSoundHeapSize];
-            fInputs    = new T*[fFactory->fNumInputs];
-            fOutputs   = new T*[fFactory->fNumOutputs];
-        }
-
-        // std::cout << "==== FBCVecInterpreter ==== " << std::endl;
-        // std::cout << "fRealHeapSize = " << fFactory->fRealHeapSize << std::endl;
-        // std::cout << "fIntHeapSize = " << fFactory->fIntHeapSize << std::endl;
-
-        // Initialise HEAP with 0
-        memset(fRealHeap, 0, fFactory->fRealHeapSize * sizeof(T));
-        memset(fIntHeap, 0, fFactory->fIntHeapSize * sizeof(int));
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 1>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 2>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 3>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 4>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 5>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 6>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    FBCVecInterpreter(interpreter_dsp_factory_aux<T, 7>* factory)
-        : FBCVecInterpreter((interpreter_dsp_factory_aux<T, 0>*)factory)
-    {
-    }
-
-    virtual ~FBCVecInterpreter()
-    {
-        if (fFactory->getMemoryManager()) {
-            fFactory->destroy(fRealHeap);
-            fFactory->destroy(fIntHeap);
-            fFactory->destroy(fSoundHeap);
-            fFactory->destroy(fInputs);
-            fFactory->destroy(fOutputs);
-        } else {
-            delete[] fRealHeap;
-            delete[] fIntHeap;
-            delete[] fSoundHeap;
-            delete[] fInputs;
-            delete[] fOutputs;
-        }
-    }
-
-    void setIntValue(int offset, int value) { fIntHeap[offset] = value; }
-    int  getIntValue(int offset) { return fIntHeap[offset]; }
-
-    virtual void setInput(int offset, T* buffer) { fInputs[offset] = buffer; }
-    virtual void setOutput(int offset, T* buffer) { fOutputs[offset] = buffer; }
-};
+    return vec_loop;
+}
 
 #endif
@@ -23,7 +23,9 @@
 #define _FIR_INTERPRETER_BYTECODE_H
 
 #include <math.h>
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -46,6 +48,9 @@ static inline std::string unquote1(const std::string& str)
 template <class T>
 struct FBCBlockInstruction;
 
+template <class T>
+struct FBCVecLoop;
+
 template <class T>
 struct FBCBasicInstruction : public FBCInstruction {
     std::string fName;
@@ -548,6 +553,96 @@ struct FBCBlockInstruction : public FBCInstruction {
         }
     }
 
+    // Collect the heap ranges (offset, size) possibly written by the block, return false if they cannot be known
+    bool getWrittenMemory(std::map<int, int>& int_ranges, std::map<int, int>& real_ranges)
+    {
+        auto add = [](std::map<int, int>& ranges, int offset, int size) {
+            ranges[offset] = std::max(ranges[offset], size);
+        };
+
+        for (auto& it : fInstructions) {
+            switch (it->fOpcode) {
+                case kStoreReal:
+                case kStoreRealValue:
+                case kMoveReal:
+                case kAddRealStore:
+                case kSubRealStore:
+                case kMultRealStore:
+                    add(real_ranges, it->fOffset1, 1);
+                    break;
+
+                case kStoreInt:
+                case kStoreIntValue:
+                case kMoveInt:
+                    add(int_ranges, it->fOffset1, 1);
+                    break;
+
+                case kAddRealStackStore:
+                case kSubRealStackStore:
+                case kMultRealStackStore:
+                    add(real_ranges, it->fOffset2, 1);
+                    break;
+
+                case kMultAddRealHeapStore:
+                    add(real_ranges, it->fIntValue, 1);
+                    break;
+
+                case kStoreIndexedReal:
+                case kBlockStoreReal:
+                    add(real_ranges, it->fOffset1, it->fOffset2);
+                    break;
+
+                case kStoreIndexedInt:
+                case kBlockStoreInt:
+                    add(int_ranges, it->fOffset1, it->fOffset2);
+                    break;
+
+                case kStoreIndexedRealMask:
+                    add(real_ranges, it->fOffset1, it->fIntValue + 1);
+                    break;
+
+                case kPairMoveReal:
+                    add(real_ranges, it->fOffset1, 1);
+                    add(real_ranges, it->fOffset2, 1);
+                    break;
+
+                case kPairMoveInt:
+                    add(int_ranges, it->fOffset1, 1);
+                    add(int_ranges, it->fOffset2, 1);
+                    break;
+
+                case kBlockPairMoveReal:
+                    add(real_ranges, it->fOffset1, it->fOffset2 - it->fOffset1 + 1);
+                    break;
+
+                case kBlockPairMoveInt:
+                    add(int_ranges, it->fOffset1, it->fOffset2 - it->fOffset1 + 1);
+                    break;
+
+                case kBlockShiftReal:
+                    add(real_ranges, it->fOffset2, it->fOffset1 - it->fOffset2 + 1);
+                    break;
+
+                case kBlockShiftInt:
+                    add(int_ranges, it->fOffset2, it->fOffset1 - it->fOffset2 + 1);
+                    break;
+
+                case kStoreOutput:
+                    return false;
+
+                default:
+                    if (it->getBranch1() && !it->getBranch1()->getWrittenMemory(int_ranges, real_ranges)) {
+                        return false;
+                    }
+                    if (it->getBranch2() && !it->getBranch2()->getWrittenMemory(int_ranges, real_ranges)) {
+                        return false;
+                    }
+                    break;
+            }
+        }
+        return true;
+    }
+
     virtual FBCBlockInstruction<T>* copy()
     {
         FBCBlockInstruction<T>* block = new FBCBlockInstruction<T>();
@@ -573,4 +668,118 @@ struct FBCBlockInstruction : public FBCInstruction {
     bool isRealInst() { return isRealType(fInstructions.back()->fOpcode); }
 };
 
+/*
+ Flat bytecode: the tree of FBCBlockInstruction is linearized in a single contiguous array of fixed-size records
+ (28 bytes with float, 32 with double), directly executed by the interpreter. Sub-blocks are appended after their
+ parent block, and branches are encoded as offsets relative to the branching instruction. Block store tables and
+ debug names are moved in side tables. The tree is still kept, for serialization and the FBC compilers.
+*/
+
+template <class T>
+struct FBCFlatInstruction {
+    FBCInstruction::Opcode fOpcode;
+    int                    fIntValue;  // Index in the side table for kBlockStoreReal/kBlockStoreInt
+    int                    fOffset1;  // Index in the vectorized loops table for kLoop, -1 if none
+    int                    fOffset2;
+    int                    fBranch1;  // Relative offset of the first branch, 0 if none
+    int                    fBranch2;  // Relative offset of the second branch, 0 if none
+    T                      fRealValue;
+};
+
+#define FlatInstructionIT const FBCFlatInstruction<T>*
+
+template <class T>
+struct FBCFlatBlock {
+    std::vector<FBCFlatInstruction<T>> fInstructions;
+    std::vector<T>                     fRealTable;
+    std::vector<int>                   fIntTable;
+    std::map<int, std::string>         fNames;
+    std::vector<FBCVecLoop<T>*>        fVecLoops;
+
+    FBCFlatBlock(FBCBlockInstruction<T>* block)
+    {
+        block->check();
+        flatten(block);
+        fInstructions.shrink_to_fit();
+    }
+
+    ~FBCFlatBlock()
+    {
+        for (auto& it : fVecLoops) {
+            delete it;
+        }
+    }
+
+    FlatInstructionIT begin() const { return fInstructions.data(); }
+
+    std::string getName(FlatInstructionIT it) const
+    {
+        auto name = fNames.find(int(it - begin()));
+        return (name != fNames.end()) ? name->second : "";
+    }
+
+    // Emit the block instructions contiguously, then the sub-blocks, and return the block start index
+    int flatten(FBCBlockInstruction<T>* block)
+    {
+        int start = int(fInstructions.size());
+
+        for (auto& it : block->fInstructions) {
+            FBCFlatInstruction<T> inst = {it->fOpcode, it->fIntValue, it->fOffset1, it->fOffset2, 0, 0, it->fRealValue};
+            if (it->fOpcode == FBCInstruction::kBlockStoreReal) {
+                FIRBlockStoreRealInstruction<T>* store = static_cast<FIRBlockStoreRealInstruction<T>*>(it);
+                inst.fIntValue = int(fRealTable.size());
+                fRealTable.insert(fRealTable.end(), store->fNumTable.begin(), store->fNumTable.end());
+            } else if (it->fOpcode == FBCInstruction::kBlockStoreInt) {
+                FIRBlockStoreIntInstruction<T>* store = static_cast<FIRBlockStoreIntInstruction<T>*>(it);
+                inst.fIntValue = int(fIntTable.size());
+                fIntTable.insert(fIntTable.end(), store->fNumTable.begin(), store->fNumTable.end());
+            } else if (it->fOpcode == FBCInstruction::kLoop) {
+                // Loops generated with a vector size in -vec mode may be executed by the vectorized interpreter
+                FBCVecLoop<T>* vec_loop = (it->fIntValue > 1) ? FBCVecLoop<T>::create(it) : nullptr;
+                if (vec_loop) {
+                    inst.fOffset1 = int(fVecLoops.size());
+                    fVecLoops.push_back(vec_loop);
+                } else {
+                    inst.fOffset1 = -1;
+                }
+            }
+            if (it->fName != "") {
+                fNames[int(fInstructions.size())] = it->fName;
+            }
+            fInstructions.push_back(inst);
+        }
+
+        for (size_t i = 0; i < block->fInstructions.size(); i++) {
+            FBCBasicInstruction<T>* it  = block->fInstructions[i];
+            int                     pos = start + int(i);
+            if (it->fOpcode == FBCInstruction::kCondBranch) {
+                // Special case for loops: branch back on the block beginning
+                fInstructions[pos].fBranch1 = start - pos;
+                continue;
+            }
+            if (it->getBranch1()) {
+                int branch1                 = flatten(it->getBranch1());
+                fInstructions[pos].fBranch1 = branch1 - pos;
+            }
+            if (it->getBranch2()) {
+                int branch2                 = flatten(it->getBranch2());
+                fInstructions[pos].fBranch2 = branch2 - pos;
+            }
+        }
+
+        return start;
+    }
+
+    void write(std::ostream* out, FlatInstructionIT it) const
+    {
+        *out << "opcode " << it->fOpcode << " " << gFBCInstructionTable[it->fOpcode] << " int " << it->fIntValue
+             << " real " << it->fRealValue << " offset1 " << it->fOffset1 << " offset2 " << it->fOffset2;
+        std::string name = getName(it);
+        if (name != "") {
+            *out << " name " << name;
+        }
+        *out << std::endl;
+    }
+};
+
 #endif
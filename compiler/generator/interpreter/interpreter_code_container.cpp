@@ -48,7 +48,7 @@ global memory allocation is implemented)
 */
 
 template <class T>
-map<string, FBCInstruction::Opcode> InterpreterInstVisitor<T>::gMathLibTable;
+thread_local map<string, FBCInstruction::Opcode> InterpreterInstVisitor<T>::gMathLibTable;
 
 template <class T>
 static FBCBlockInstruction<T>* getCurrentBlock()
@@ -198,6 +198,9 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
     const char* trace = getenv("FAUST_INTERP_TRACE");
     int         mode  = (trace) ? std::atoi(trace) : 0;
 
+    // Superinstructions fusion is done at the last optimization level
+    int opt_level = (gGlobal->gInterpSuperInst) ? INTER_MAX_OPT_LEVEL : INTER_DEFAULT_OPT_LEVEL;
+
     // Prepare compilation options
     stringstream compile_options;
     gGlobal->printCompilationOptions(compile_options);
@@ -209,7 +212,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 2:
@@ -218,7 +221,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 3:
@@ -227,7 +230,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 4:
@@ -236,7 +239,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 5:
@@ -245,7 +248,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 6:
@@ -254,7 +257,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         case 7:
@@ -263,7 +266,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
 
         default:
@@ -273,7 +276,7 @@ dsp_factory_base* InterpreterCodeContainer<T>::produceFactory()
                 getInterpreterVisitor<T>()->fIntHeapOffset, getInterpreterVisitor<T>()->fRealHeapOffset,
                 getInterpreterVisitor<T>()->fSoundHeapOffset, getInterpreterVisitor<T>()->getFieldOffset("fSampleRate"),
                 getInterpreterVisitor<T>()->getFieldOffset("count"), getInterpreterVisitor<T>()->getFieldOffset("IOTA"),
-                INTER_MAX_OPT_LEVEL, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
+                opt_level, metadata_block, getInterpreterVisitor<T>()->fUserInterfaceBlock, init_static_block,
                 init_block, resetui_block, clear_block, compute_control_block, compute_dsp_block);
     }
 }
@@ -31,7 +31,7 @@ template <class T, int TRACE>
 struct interpreter_comp_dsp_factory_aux : public interpreter_dsp_factory_aux<T,TRACE> {
     
     // Shared between all DSP instances
-    typename FBCCompiler<T>::CompiledBlocksType* fCompiledBlocks;
+    FBCCompiledBlocks<T>* fCompiledBlocks;
 
     interpreter_comp_dsp_factory_aux(const std::string& name, const std::string& compile_options, const std::string& sha_key,
                                 int version_num, int inputs, int outputs, int int_heap_size, int real_heap_size,
@@ -48,7 +48,7 @@ struct interpreter_comp_dsp_factory_aux : public interpreter_dsp_factory_aux<T,T
                                   resetui, clear,
                                   compute_control, compute_dsp)
     {
-        fCompiledBlocks = new std::map<FBCBlockInstruction<T>*, FBCExecuteFun<T>*>();
+        fCompiledBlocks = new FBCCompiledBlocks<T>();
     }
 
     virtual FBCExecutor<T>* createFBCExecutor()
@@ -58,9 +58,7 @@ struct interpreter_comp_dsp_factory_aux : public interpreter_dsp_factory_aux<T,T
 
     virtual ~interpreter_comp_dsp_factory_aux()
     {
-        for (auto& it : *fCompiledBlocks) {
-            delete it.second;
-        }
+        // Waits for a possibly running background compilation
         delete fCompiledBlocks;
     }
 
@@ -187,6 +187,7 @@ interpreter_dsp_factory_aux<T, TRACE>* interpreter_dsp_factory_aux<T, TRACE>::re
 template <class T, int TRACE>
 void interpreter_dsp_factory_aux<T, TRACE>::optimize()
 {
+    std::lock_guard<std::mutex> lock(fOptimizeMutex);
     if (!fOptimized) {
         fOptimized = true;
         // Bytecode optimization
@@ -200,6 +201,309 @@ void interpreter_dsp_factory_aux<T, TRACE>::optimize()
             fComputeDSPBlock = FBCInstructionOptimizer<T>::optimizeBlock(fComputeDSPBlock, 1, fOptLevel);
     #endif
         }
+        // Flat versions of the final blocks, shared by all instances
+        clearFlatBlocks();
+        flattenBlock(fStaticInitBlock);
+        flattenBlock(fInitBlock);
+        flattenBlock(fResetUIBlock);
+        flattenBlock(fClearBlock);
+        flattenBlock(fComputeBlock);
+        flattenBlock(fComputeDSPBlock);
+        // Heap written by the static init block, to be shared by all instances
+        fStaticShared = fStaticInitBlock->getWrittenMemory(fStaticIntRanges, fStaticRealRanges);
+        if (TRACE == 0 && fStaticShared) {
+            shareStaticTables();
+        }
+    }
+}
+
+// Range of 'ranges' containing [offset, offset + size), or end()
+inline std::map<int, int>::const_iterator findStaticRange(const std::map<int, int>& ranges, int offset, int size)
+{
+    auto it = ranges.upper_bound(offset);
+    if (it == ranges.begin()) return ranges.end();
+    --it;
+    return (offset + size <= it->first + it->second) ? it : ranges.end();
+}
+
+// Remove the ranges intersecting [offset, offset + size)
+inline void removeStaticRanges(std::map<int, int>& ranges, int offset, int size)
+{
+    for (auto it = ranges.begin(); it != ranges.end();) {
+        if (it->first < offset + size && offset < it->first + it->second) {
+            it = ranges.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+// Whether the operands of the binary math opcode 'base' (in [kAddReal, kXORInt]) are reals
+inline bool isRealOperandMath(FBCInstruction::Opcode base)
+{
+    return (base == FBCInstruction::kAddReal) || (base == FBCInstruction::kSubReal) ||
+           (base == FBCInstruction::kMultReal) || (base == FBCInstruction::kDivReal) ||
+           (base == FBCInstruction::kRemReal) || ((base >= FBCInstruction::kGTReal) && (base <= FBCInstruction::kNEReal));
+}
+
+/*
+ Heap operands of the math opcodes, derived from their group in the FBCInstruction enum: each group
+ ('Heap', 'Stack', 'StackValue', 'Value'...) lists the same operations in the same order as its base group.
+ Returns the number of heap operands (read at fOffset1, then fOffset2), or -1 if 'opcode' is not a math opcode.
+*/
+inline int getMathHeapOperands(FBCInstruction::Opcode opcode, bool& real)
+{
+    typedef FBCInstruction I;
+    struct Group {
+        I::Opcode fFirst, fLast, fBase;
+        int       fOperands;
+    };
+    static const Group groups[] = {
+        {I::kAddReal, I::kXORInt, I::kAddReal, 0},
+        {I::kAddRealHeap, I::kXORIntHeap, I::kAddReal, 2},
+        {I::kAddRealStack, I::kXORIntStack, I::kAddReal, 1},
+        {I::kAddRealStackValue, I::kXORIntStackValue, I::kAddReal, 0},
+        {I::kAddRealValue, I::kXORIntValue, I::kAddReal, 1},
+        {I::kAbs, I::kTanhf, I::kAbs, 0},
+        {I::kAbsHeap, I::kTanhfHeap, I::kAbs, 1},
+        {I::kAtan2f, I::kMinf, I::kAtan2f, 0},
+        {I::kAtan2fHeap, I::kMinfHeap, I::kAtan2f, 2},
+        {I::kAtan2fStack, I::kMinfStack, I::kAtan2f, 1},
+        {I::kAtan2fStackValue, I::kMinfStackValue, I::kAtan2f, 0},
+        {I::kAtan2fValue, I::kMinfValue, I::kAtan2f, 1},
+        {I::kAtan2fValueInvert, I::kPowfValueInvert, I::kAtan2f, 1},
+    };
+    for (const auto& group : groups) {
+        if (opcode >= group.fFirst && opcode <= group.fLast) {
+            I::Opcode base = I::Opcode(group.fBase + (opcode - group.fFirst));
+            if (group.fBase == I::kAddReal) {
+                real = isRealOperandMath(base);
+            } else if (group.fBase == I::kAbs) {
+                real = (base != I::kAbs);
+            } else {
+                real = (base != I::kMax) && (base != I::kMin);
+            }
+            return group.fOperands;
+        }
+    }
+    // Non commutative operations with a value, not in the base order
+    if (opcode >= I::kSubRealValueInvert && opcode <= I::kLERealValueInvert) {
+        real = (opcode == I::kSubRealValueInvert) || (opcode == I::kDivRealValueInvert) ||
+               (opcode == I::kRemRealValueInvert) || (opcode >= I::kGTRealValueInvert);
+        return 1;
+    }
+    return -1;
+}
+
+/*
+ Remove in 'int_ranges' and 'real_ranges' the static ranges accessed by 'inst' in the int and real heaps.
+ An opcode whose heap accesses are not known here keeps all the static ranges in the instance heap.
+*/
+template <class T>
+static void removeAccessedRanges(FBCBasicInstruction<T>* inst, std::map<int, int>& int_ranges,
+                                 std::map<int, int>& real_ranges)
+{
+    int  offset1 = inst->fOffset1;
+    int  offset2 = inst->fOffset2;
+    bool real    = false;
+    int  heap_operands = getMathHeapOperands(inst->fOpcode, real);
+    if (heap_operands >= 0) {
+        std::map<int, int>& ranges = (real) ? real_ranges : int_ranges;
+        if (heap_operands > 0) removeStaticRanges(ranges, offset1, 1);
+        if (heap_operands > 1) removeStaticRanges(ranges, offset2, 1);
+        return;
+    }
+
+    switch (inst->fOpcode) {
+        // Scalars
+        case FBCInstruction::kLoadReal:
+        case FBCInstruction::kStoreReal:
+        case FBCInstruction::kStoreRealValue:
+        case FBCInstruction::kAddRealStore:
+        case FBCInstruction::kSubRealStore:
+        case FBCInstruction::kMultRealStore:
+        case FBCInstruction::kCastIntHeap:
+            removeStaticRanges(real_ranges, offset1, 1);
+            break;
+
+        case FBCInstruction::kLoadInt:
+        case FBCInstruction::kStoreInt:
+        case FBCInstruction::kStoreIntValue:
+        case FBCInstruction::kCastRealHeap:
+            removeStaticRanges(int_ranges, offset1, 1);
+            break;
+
+        case FBCInstruction::kMoveReal:
+        case FBCInstruction::kMultAddRealHeap:
+        case FBCInstruction::kMultAddRealStack:
+        case FBCInstruction::kAddRealStackStore:
+        case FBCInstruction::kSubRealStackStore:
+        case FBCInstruction::kMultRealStackStore:
+            removeStaticRanges(real_ranges, offset1, 1);
+            removeStaticRanges(real_ranges, offset2, 1);
+            break;
+
+        case FBCInstruction::kMultAddRealHeapStore:
+            removeStaticRanges(real_ranges, offset1, 1);
+            removeStaticRanges(real_ranges, offset2, 1);
+            removeStaticRanges(real_ranges, inst->fIntValue, 1);
+            break;
+
+        case FBCInstruction::kMoveInt:
+            removeStaticRanges(int_ranges, offset1, 1);
+            removeStaticRanges(int_ranges, offset2, 1);
+            break;
+
+        case FBCInstruction::kPairMoveReal:
+            removeStaticRanges(real_ranges, offset1 - 1, 2);
+            removeStaticRanges(real_ranges, offset2 - 1, 2);
+            break;
+
+        case FBCInstruction::kPairMoveInt:
+            removeStaticRanges(int_ranges, offset1 - 1, 2);
+            removeStaticRanges(int_ranges, offset2 - 1, 2);
+            break;
+
+        // Heap arrays
+        case FBCInstruction::kLoadIndexedReal:
+        case FBCInstruction::kStoreIndexedReal:
+        case FBCInstruction::kBlockStoreReal:
+            removeStaticRanges(real_ranges, offset1, offset2);
+            break;
+
+        case FBCInstruction::kLoadIndexedInt:
+        case FBCInstruction::kStoreIndexedInt:
+        case FBCInstruction::kBlockStoreInt:
+            removeStaticRanges(int_ranges, offset1, offset2);
+            break;
+
+        case FBCInstruction::kLoadIndexedRealMask:
+            removeStaticRanges(real_ranges, offset1, inst->fIntValue + 1);
+            break;
+
+        case FBCInstruction::kStoreIndexedRealMask:
+            removeStaticRanges(real_ranges, offset1, inst->fIntValue + 1);
+            removeStaticRanges(int_ranges, offset2, 1);
+            break;
+
+        case FBCInstruction::kBlockPairMoveReal:
+            removeStaticRanges(real_ranges, offset1, offset2 - offset1 + 1);
+            break;
+
+        case FBCInstruction::kBlockPairMoveInt:
+            removeStaticRanges(int_ranges, offset1, offset2 - offset1 + 1);
+            break;
+
+        case FBCInstruction::kBlockShiftReal:
+            removeStaticRanges(real_ranges, offset2, offset1 - offset2 + 1);
+            break;
+
+        case FBCInstruction::kBlockShiftInt:
+            removeStaticRanges(int_ranges, offset2, offset1 - offset2 + 1);
+            break;
+
+        // No heap access (the sound heap is not shared, the branches are checked by the caller)
+        case FBCInstruction::kRealValue:
+        case FBCInstruction::kInt32Value:
+        case FBCInstruction::kLoadSound:
+        case FBCInstruction::kLoadSoundField:
+        case FBCInstruction::kStoreSound:
+        case FBCInstruction::kLoadInput:
+        case FBCInstruction::kStoreOutput:
+        case FBCInstruction::kCastReal:
+        case FBCInstruction::kCastInt:
+        case FBCInstruction::kBitcastInt:
+        case FBCInstruction::kBitcastReal:
+        case FBCInstruction::kLoop:
+        case FBCInstruction::kReturn:
+        case FBCInstruction::kIf:
+        case FBCInstruction::kSelectReal:
+        case FBCInstruction::kSelectInt:
+        case FBCInstruction::kCondBranch:
+        case FBCInstruction::kNop:
+            break;
+
+        // Unknown accesses: nothing is shared
+        default:
+            int_ranges.clear();
+            real_ranges.clear();
+            break;
+    }
+}
+
+// Keep in 'int_ranges' and 'real_ranges' the static ranges only read by scalar indexed loads in 'block'
+template <class T>
+static void checkStaticAccess(FBCBlockInstruction<T>* block, std::map<int, int>& int_ranges,
+                              std::map<int, int>& real_ranges, bool vec)
+{
+    for (auto& it : block->fInstructions) {
+        // A scalar indexed load fully inside a static range is a table read, any other access keeps the range in the instance heap
+        bool table_read =
+            !vec && ((it->fOpcode == FBCInstruction::kLoadIndexedReal &&
+                      findStaticRange(real_ranges, it->fOffset1, it->fOffset2) != real_ranges.end()) ||
+                     (it->fOpcode == FBCInstruction::kLoadIndexedInt &&
+                      findStaticRange(int_ranges, it->fOffset1, it->fOffset2) != int_ranges.end()));
+        if (!table_read) {
+            removeAccessedRanges(it, int_ranges, real_ranges);
+        }
+        // Loops with a vector size may be run by the vectorized interpreter, that only reads the instance heap
+        bool sub_vec = vec || (it->fOpcode == FBCInstruction::kLoop && it->fIntValue > 1);
+        if (it->getBranch1() && it->fOpcode != FBCInstruction::kCondBranch) {
+            checkStaticAccess(it->getBranch1(), int_ranges, real_ranges, sub_vec);
+        }
+        if (it->getBranch2()) {
+            checkStaticAccess(it->getBranch2(), int_ranges, real_ranges, sub_vec);
+        }
+    }
+}
+
+template <class T, int TRACE>
+void interpreter_dsp_factory_aux<T, TRACE>::shareStaticTables()
+{
+    fSharedIntRanges  = fStaticIntRanges;
+    fSharedRealRanges = fStaticRealRanges;
+
+    // Static ranges also accessed by other instructions, or by the UI, are copied in the instances
+    for (auto block : {fInitBlock, fResetUIBlock, fClearBlock, fComputeBlock, fComputeDSPBlock}) {
+        checkStaticAccess(block, fSharedIntRanges, fSharedRealRanges, false);
+    }
+    for (auto& it : fUserInterfaceBlock->fInstructions) {
+        removeStaticRanges(fSharedRealRanges, it->fOffset, 1);
+    }
+    for (int offset : {fSROffset, fCountOffset, fIOTAOffset}) {
+        removeStaticRanges(fSharedIntRanges, offset, 1);
+    }
+
+    // Offset of each shared range in FBCStaticMemory, where all static ranges are saved in order
+    std::map<int, int> int_shared, real_shared;
+    auto locate = [](const std::map<int, int>& ranges, const std::map<int, int>& shared, std::map<int, int>& located) {
+        int offset = 0;
+        for (auto& it : ranges) {
+            if (shared.find(it.first) != shared.end()) located[it.first] = offset;
+            offset += it.second;
+        }
+    };
+    locate(fStaticIntRanges, fSharedIntRanges, int_shared);
+    locate(fStaticRealRanges, fSharedRealRanges, real_shared);
+
+    // The factory flat blocks (except the static init one) read the shared tables in FBCStaticMemory
+    for (auto block : {fInitBlock, fResetUIBlock, fClearBlock, fComputeBlock, fComputeDSPBlock}) {
+        FBCFlatBlock<T>* flat_block = findFlatBlock(block);
+        for (auto& it : flat_block->fInstructions) {
+            if (it.fOpcode == FBCInstruction::kLoadIndexedReal) {
+                auto range = findStaticRange(fSharedRealRanges, it.fOffset1, it.fOffset2);
+                if (range != fSharedRealRanges.end()) {
+                    it.fOpcode  = FBCInstruction::kLoadIndexedStaticReal;
+                    it.fOffset1 = real_shared[range->first] + (it.fOffset1 - range->first);
+                }
+            } else if (it.fOpcode == FBCInstruction::kLoadIndexedInt) {
+                auto range = findStaticRange(fSharedIntRanges, it.fOffset1, it.fOffset2);
+                if (range != fSharedIntRanges.end()) {
+                    it.fOpcode  = FBCInstruction::kLoadIndexedStaticInt;
+                    it.fOffset1 = int_shared[range->first] + (it.fOffset1 - range->first);
+                }
+            }
+        }
     }
 }
 
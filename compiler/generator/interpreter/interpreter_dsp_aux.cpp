@@ -127,6 +127,20 @@ static string read_real_type(istream* in)
     return type;
 }
 
+dsp_factory_base* readInterpreterDSPFactoryAux(const string& bitcode)
+{
+    stringstream reader(bitcode);
+    string       type = read_real_type(&reader);
+
+    if (type == "float") {
+        return interpreter_dsp_factory_aux<float, 0>::read(&reader);
+    } else if (type == "double") {
+        return interpreter_dsp_factory_aux<double, 0>::read(&reader);
+    } else {
+        throw faustexception("ERROR : unrecognized file format\n");
+    }
+}
+
 static interpreter_dsp_factory* readInterpreterDSPFactoryFromBitcodeAux(const string& bitcode, string& error_msg)
 {
     try {
@@ -139,20 +153,9 @@ static interpreter_dsp_factory* readInterpreterDSPFactoryFromBitcodeAux(const st
             sfactory->addReference();
             return sfactory;
         } else {
-            interpreter_dsp_factory* factory = nullptr;
-            stringstream             reader(bitcode);
-            string                   type = read_real_type(&reader);
-
-            if (type == "float") {
-                factory = new interpreter_dsp_factory(interpreter_dsp_factory_aux<float, 0>::read(&reader));
-            } else if (type == "double") {
-                factory = new interpreter_dsp_factory(interpreter_dsp_factory_aux<double, 0>::read(&reader));
-            } else {
-                throw faustexception("ERROR : unrecognized file format\n");
-            }
-
-            gInterpreterFactoryTable.setFactory(factory);
+            interpreter_dsp_factory* factory = new interpreter_dsp_factory(readInterpreterDSPFactoryAux(bitcode));
             factory->setSHAKey(sha_key);
+            gInterpreterFactoryTable.setFactory(factory);
             factory->setDSPCode(bitcode);
             return factory;
         }
@@ -23,12 +23,16 @@
 #define interpreter_dsp_aux_h
 
 #include <stdlib.h>
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "dsp_aux.hh"
 #include "dsp_factory.hh"
@@ -49,6 +53,39 @@ extern dsp_factory_table<SDsp_factory>                gInterpreterFactoryTable;
 template <class T, int TRACE>
 class interpreter_dsp_aux;
 
+// Number of sample rates whose static memory is kept by a factory when no instance uses it
+#define FBC_STATIC_MEMORY_RATES 4
+
+// Heap content produced by the static init block (tables...) for a given sample rate
+template <class T>
+struct FBCStaticMemory {
+    std::vector<int> fIntValues;
+    std::vector<T>   fRealValues;
+    int              fRefs = 0;  // instances reading the shared tables in this memory
+
+    template <class V>
+    static void save(const std::map<int, int>& ranges, const V* heap, std::vector<V>& values)
+    {
+        for (auto& it : ranges) {
+            values.insert(values.end(), heap + it.first, heap + it.first + it.second);
+        }
+    }
+
+    // The 'shared' ranges (if any) are read in 'values' by the flat blocks, and not copied
+    template <class V>
+    static void load(const std::map<int, int>& ranges, const std::vector<V>& values, V* heap,
+                     const std::map<int, int>* shared = nullptr)
+    {
+        const V* src = values.data();
+        for (auto& it : ranges) {
+            if (!shared || shared->find(it.first) == shared->end()) {
+                std::copy(src, src + it.second, heap + it.first);
+            }
+            src += it.second;
+        }
+    }
+};
+
 template <class T, int TRACE>
 struct interpreter_dsp_factory_aux : public dsp_factory_imp {
     int fVersion;
@@ -64,6 +101,7 @@ struct interpreter_dsp_factory_aux : public dsp_factory_imp {
     int fOptLevel;
 
     bool        fOptimized;
+    std::mutex  fOptimizeMutex;  // instances may be created from several threads
     std::string fCompileOptions;
 
     FIRMetaBlockInstruction*             fMetaBlock;
@@ -75,6 +113,22 @@ struct interpreter_dsp_factory_aux : public dsp_factory_imp {
     FBCBlockInstruction<T>*              fComputeBlock;
     FBCBlockInstruction<T>*              fComputeDSPBlock;
 
+    // Flat versions of the blocks, directly executed by FBCInterpreter
+    std::map<FBCBlockInstruction<T>*, FBCFlatBlock<T>*> fFlatBlocks;
+
+    // Heap ranges written by fStaticInitBlock, and their content computed once per sample rate for all instances
+    // (the contents not used by an instance are freed when more than FBC_STATIC_MEMORY_RATES sample rates are kept)
+    bool                               fStaticShared;
+    std::map<int, int>                 fStaticIntRanges;
+    std::map<int, int>                 fStaticRealRanges;
+    std::map<int, FBCStaticMemory<T>*> fStaticMemory;
+    std::mutex                         fStaticMutex;
+
+    // Static ranges only read by indexed loads (tables): the factory flat blocks read them
+    // in the shared FBCStaticMemory, so that they are not copied in each instance heap
+    std::map<int, int> fSharedIntRanges;
+    std::map<int, int> fSharedRealRanges;
+
     interpreter_dsp_factory_aux(const std::string& name, const std::string& compile_options, const std::string& sha_key,
                                 int version_num, int inputs, int outputs, int int_heap_size, int real_heap_size,
                                 int sound_heap_size, int sr_offset, int count_offset, int iota_offset, int opt_level,
@@ -102,7 +156,8 @@ struct interpreter_dsp_factory_aux : public dsp_factory_imp {
           fResetUIBlock(resetui),
           fClearBlock(clear),
           fComputeBlock(compute_control),
-          fComputeDSPBlock(compute_dsp)
+          fComputeDSPBlock(compute_dsp),
+          fStaticShared(false)
     {}
 
     virtual FBCExecutor<T>* createFBCExecutor()
@@ -121,9 +176,56 @@ struct interpreter_dsp_factory_aux : public dsp_factory_imp {
         delete fClearBlock;
         delete fComputeBlock;
         delete fComputeDSPBlock;
+        clearFlatBlocks();
+        for (auto& it : fStaticMemory) {
+            delete it.second;
+        }
+    }
+
+    // Called with fStaticMutex locked, by an instance not using 'memory' anymore
+    void releaseStaticMemory(FBCStaticMemory<T>* memory)
+    {
+        if (memory) memory->fRefs--;
+    }
+
+    // Called with fStaticMutex locked, before adding the content of a new sample rate
+    void evictStaticMemory()
+    {
+        for (auto it = fStaticMemory.begin(); it != fStaticMemory.end() && fStaticMemory.size() >= FBC_STATIC_MEMORY_RATES;) {
+            if (it->second->fRefs == 0) {
+                delete it->second;
+                it = fStaticMemory.erase(it);
+            } else {
+                it++;
+            }
+        }
     }
 
     void optimize(); // moved in interpreted_dsp.hh
+    void shareStaticTables(); // moved in interpreted_dsp.hh
+
+    // Only called in optimize(), the flat blocks are then read-only and shared by all executors
+    void flattenBlock(FBCBlockInstruction<T>* block)
+    {
+        FBCFlatBlock<T>*& flat_block = fFlatBlocks[block];
+        if (!flat_block) {
+            flat_block = new FBCFlatBlock<T>(block);
+        }
+    }
+
+    FBCFlatBlock<T>* findFlatBlock(FBCBlockInstruction<T>* block) const
+    {
+        auto it = fFlatBlocks.find(block);
+        return (it != fFlatBlocks.end()) ? it->second : nullptr;
+    }
+
+    void clearFlatBlocks()
+    {
+        for (auto& it : fFlatBlocks) {
+            delete it.second;
+        }
+        fFlatBlocks.clear();
+    }
  
     void write(std::ostream* out, bool binary = false, bool small = false)
     {
@@ -487,10 +589,11 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
     int                                    fCycle;
     interpreter_dsp_factory_aux<T, TRACE>* fFactory;
     FBCExecutor<T>*                        fFBCExecutor;
+    FBCStaticMemory<T>*                    fStaticMemory;  // factory memory of the current sample rate
 
    public:
     interpreter_dsp_aux()
-        : fInitialized(false), fTraceOutput(false), fCycle(0), fFactory(nullptr), fFBCExecutor(nullptr)
+        : fInitialized(false), fTraceOutput(false), fCycle(0), fFactory(nullptr), fFBCExecutor(nullptr), fStaticMemory(nullptr)
     {
     }
 
@@ -499,6 +602,7 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
         fFactory = factory;
         fInitialized = false;
         fCycle = 0;
+        fStaticMemory = nullptr;
         fTraceOutput = getenv("FAUST_INTERP_OUTPUT") != NULL;
         // Done before createFBCExecutor that may compile blocks...
         fFactory->optimize();
@@ -507,6 +611,10 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
 
     virtual ~interpreter_dsp_aux()
     {
+        if (fStaticMemory) {
+            std::lock_guard<std::mutex> lock(fFactory->fStaticMutex);
+            fFactory->releaseStaticMemory(fStaticMemory);
+        }
         delete fFBCExecutor;
     }
 
@@ -552,6 +660,45 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
             std::cout << "classInit " << sample_rate << std::endl;
         }
         
+        int* int_heap  = fFBCExecutor->getIntHeap();
+        T*   real_heap = fFBCExecutor->getRealHeap();
+
+        // Tables may depend on 'fSampleRate', read by the static init block
+        fFBCExecutor->setIntValue(fFactory->fSROffset, sample_rate);
+
+        // Tables are computed once per sample rate, then shared or copied from the factory
+        if (TRACE == 0 && fFactory->fStaticShared && int_heap && real_heap) {
+            std::lock_guard<std::mutex> lock(fFactory->fStaticMutex);
+            fFactory->releaseStaticMemory(fStaticMemory);
+            if (fFactory->fStaticMemory.find(sample_rate) == fFactory->fStaticMemory.end()) {
+                fFactory->evictStaticMemory();
+            }
+            FBCStaticMemory<T>*& memory = fFactory->fStaticMemory[sample_rate];
+            if (memory) {
+                bool share = shareStaticTables();
+                FBCStaticMemory<T>::load(fFactory->fStaticIntRanges, memory->fIntValues, int_heap,
+                                         share ? &fFactory->fSharedIntRanges : nullptr);
+                FBCStaticMemory<T>::load(fFactory->fStaticRealRanges, memory->fRealValues, real_heap,
+                                         share ? &fFactory->fSharedRealRanges : nullptr);
+            } else {
+                executeStaticInit();
+                memory = new FBCStaticMemory<T>();
+                FBCStaticMemory<T>::save(fFactory->fStaticIntRanges, int_heap, memory->fIntValues);
+                FBCStaticMemory<T>::save(fFactory->fStaticRealRanges, real_heap, memory->fRealValues);
+            }
+            fFBCExecutor->setStaticHeap(memory->fIntValues.data(), memory->fRealValues.data());
+            fStaticMemory = memory;
+            fStaticMemory->fRefs++;
+        } else {
+            executeStaticInit();
+        }
+    }
+
+    // Whether the instance blocks can read the tables in the factory shared memory
+    virtual bool shareStaticTables() { return fFBCExecutor->sharesStaticHeap(); }
+
+    void executeStaticInit()
+    {
         try {
             // Execute static init instructions
             fFBCExecutor->ExecuteBlock(fFactory->fStaticInitBlock);
@@ -619,7 +766,8 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
             std::cout << "instanceInit " << sample_rate << std::endl;
         }
         
-        // classInit has to be called for each instance since the tables are actually not shared between instances
+        // classInit has to be called for each instance since the tables live in the instance heap (but are only
+        // computed once per sample rate, then copied from the factory)
         classInit(sample_rate);
         
         instanceConstants(sample_rate);
@@ -636,7 +784,7 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
         
         fInitialized = true;
         
-        // classInit is not called here since the tables are actually not shared between instances
+        // classInit is not called here since it is done in instanceInit
         instanceInit(sample_rate);
     }
 
@@ -650,32 +798,6 @@ class interpreter_dsp_aux : public interpreter_dsp_base {
         }
     }
 
-    void ExecuteVecBlock(FBCBlockInstruction<T>* block, int vec_size)
-    {
-        /*
-            Execute the VEC size specialized version of the interpreter
-            vec_size == 1 correspond to the scalar interpreter
-        */
-
-        /*
-        if (vec_size == 1) {
-            fFBCExecutor->ExecuteBlock<T, 1, TRACE>(block);
-        } else if (vec_size == 4) {
-            fFBCExecutor->ExecuteBlock<T, 4, TRACE>(block);
-        } else if (vec_size == 8) {
-            fFBCExecutor->ExecuteBlock<T, 8, TRACE>(block);
-        } else if (vec_size == 16) {
-            fFBCExecutor->ExecuteBlock<T, 16, TRACE>(block);
-        } else if (vec_size == 32) {
-            fFBCExecutor->ExecuteBlock<T, 32, TRACE>(block);
-        } else if (vec_size == 64) {
-            fFBCExecutor->ExecuteBlock<T, 64, TRACE>(block);
-        } else {
-            fFBCExecutor->ExecuteBlock<T, 128, TRACE>(block);
-        }
-        */
-    }
-
     virtual void compute(int count, FAUSTFLOAT** inputs_aux, FAUSTFLOAT** outputs_aux)
     {
         if (count == 0) return;  // Beware: compiled loop does not work with an index of 0
@@ -867,6 +989,9 @@ class EXPORT interpreter_dsp_factory : public dsp_factory, public faust_smartabl
     void write(std::ostream* out, bool binary = false, bool small = false) { fFactory->write(out, binary, small); }
 };
 
+// Read the factory kept in 'bitcode' (not added in the factory table), throws faustexception on error
+dsp_factory_base* readInterpreterDSPFactoryAux(const std::string& bitcode);
+
 EXPORT interpreter_dsp_factory* getInterpreterDSPFactoryFromSHAKey(const std::string& sha_key);
 
 EXPORT bool deleteInterpreterDSPFactory(interpreter_dsp_factory* factory);
@@ -94,6 +94,9 @@ class interpreter_dsp_aux_pe : public interpreter_dsp_aux<T, TRACE> {
             delete this->fComputeDSPBlock;
         }
     
+        // Specialized blocks are not the factory ones, they read the tables in the instance heap
+        virtual bool shareStaticTables() { return false; }
+
         virtual void instanceConstants(int sample_rate)
         {
             // Store sample_rate in specialization fIntMap
@@ -171,6 +174,17 @@ class interpreter_dsp_aux_pe : public interpreter_dsp_aux<T, TRACE> {
             this->fComputeDSPBlock = FBCInstructionOptimizer<T>::optimizeBlock(this->fComputeDSPBlock, 5, 6);
         #endif
             
+            // Specialized blocks are prepared here, out of the audio thread
+            this->fFBCExecutor->PrepareBlock(this->fStaticInitBlock);
+            this->fFBCExecutor->PrepareBlock(this->fInitBlock);
+            this->fFBCExecutor->PrepareBlock(this->fResetUIBlock);
+            this->fFBCExecutor->PrepareBlock(this->fClearBlock);
+            this->fFBCExecutor->PrepareBlock(this->fComputeBlock);
+            this->fFBCExecutor->PrepareBlock(this->fComputeDSPBlock);
+        #ifdef MACHINE
+            this->fFBCExecutor->CompileBlock(this->fComputeDSPBlock);
+        #endif
+            
             /*
              this->fStaticInitBlock->write(&std::cout, false);
              this->fInitBlock->write(&std::cout, false);
@@ -213,11 +227,7 @@ class interpreter_dsp_aux_pe : public interpreter_dsp_aux<T, TRACE> {
                 this->fFBCExecutor->ExecuteBlock(this->fComputeBlock);
                 
                 // Executes the specialized 'DSP' block
-        #ifdef MACHINE
-                this->fFBCExecutor->ExecuteBlock(this->fComputeDSPBlock, true);
-        #else
                 this->fFBCExecutor->ExecuteBlock(this->fComputeDSPBlock);
-        #endif
             }
         }
 };
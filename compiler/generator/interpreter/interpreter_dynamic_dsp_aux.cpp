@@ -46,7 +46,6 @@ EXPORT interpreter_dsp_factory* createInterpreterDSPFactoryFromFile(const string
 EXPORT interpreter_dsp_factory* createInterpreterDSPFactoryFromString(const string& name_app, const string& dsp_content,
                                                                       int argc, const char* argv[], string& error_msg)
 {
-    LOCK_API
     string expanded_dsp_content, sha_key;
 
     //if ((expanded_dsp_content = expandDSPFromString(name_app, dsp_content, argc, argv, sha_key, error_msg)) == "") {
@@ -57,36 +56,69 @@ EXPORT interpreter_dsp_factory* createInterpreterDSPFactoryFromString(const stri
         dsp_factory_table<SDsp_factory>::factory_iterator it;
         interpreter_dsp_factory* factory = nullptr;
 
-        if (gInterpreterFactoryTable.getFactory(sha_key, it)) {
-            SDsp_factory sfactory = (*it).first;
-            sfactory->addReference();
-            return sfactory;
-        } else {
-            int         argc1 = 0;
-            const char* argv1[64];
-            argv1[argc1++] = "faust";
-            argv1[argc1++] = "-lang";
-            argv1[argc1++] = "interp";
-            argv1[argc1++] = "-o";
-            argv1[argc1++] = "string";
-            // Copy arguments
-            for (int i = 0; i < argc; i++) {
-                argv1[argc1++] = argv[i];
+        {
+            LOCK_API
+            if (gInterpreterFactoryTable.getFactory(sha_key, it)) {
+                SDsp_factory sfactory = (*it).first;
+                sfactory->addReference();
+                return sfactory;
+            }
+        }
+
+        int         argc1 = 0;
+        const char* argv1[64];
+        argv1[argc1++] = "faust";
+        argv1[argc1++] = "-lang";
+        argv1[argc1++] = "interp";
+        argv1[argc1++] = "-o";
+        argv1[argc1++] = "string";
+        // Copy arguments
+        for (int i = 0; i < argc; i++) {
+            argv1[argc1++] = argv[i];
+        }
+        argv1[argc1] = nullptr;  // NULL terminated argv
+
+        // Look in the persistent cache (if activated) before compiling
+        dsp_factory_base* dsp_factory_aux = nullptr;
+        string            cache_key       = dsp_factory_cache::getKey(name_app, dsp_content, argc, argv, "interp");
+        string            bitcode;
+        time_t            date = time(nullptr);
+        if (dsp_factory_cache::read(cache_key, bitcode)) {
+            try {
+                dsp_factory_aux = readInterpreterDSPFactoryAux(bitcode);
+            } catch (faustexception& e) {
+                // Corrupted or outdated entry : compile again
+                dsp_factory_aux = nullptr;
             }
-            argv1[argc1] = nullptr;  // NULL terminated argv
-            
-            dsp_factory_base* dsp_factory_aux =
-                compileFaustFactory(argc1, argv1, name_app.c_str(), dsp_content.c_str(), error_msg, true);
-            if (dsp_factory_aux) {
-                dsp_factory_aux->setName(name_app);
-                factory = new interpreter_dsp_factory(dsp_factory_aux);
-                gInterpreterFactoryTable.setFactory(factory);
-                factory->setSHAKey(sha_key);
-                factory->setDSPCode(expanded_dsp_content);
-                return factory;
-            } else {
-                return nullptr;
+        }
+
+        // The compilation itself is reentrant and runs without holding the API lock
+        if (!dsp_factory_aux) {
+            dsp_factory_aux = compileFaustFactory(argc1, argv1, name_app.c_str(), dsp_content.c_str(), error_msg, true);
+            if (dsp_factory_aux && cache_key != "") {
+                stringstream writer;
+                dsp_factory_aux->write(&writer, true);
+                dsp_factory_cache::write(cache_key, date, writer.str());
+            }
+        }
+
+        if (dsp_factory_aux) {
+            LOCK_API
+            // The same DSP may have been compiled by another thread in the meantime
+            if (gInterpreterFactoryTable.getFactory(sha_key, it)) {
+                delete dsp_factory_aux;
+                SDsp_factory sfactory = (*it).first;
+                sfactory->addReference();
+                return sfactory;
             }
+            dsp_factory_aux->setName(name_app);
+            factory = new interpreter_dsp_factory(dsp_factory_aux);
+            factory->setSHAKey(sha_key);
+            gInterpreterFactoryTable.setFactory(factory);
+            factory->setDSPCode(expanded_dsp_content);
+            return factory;
+        } else {
+            return nullptr;
         }
     }
 }
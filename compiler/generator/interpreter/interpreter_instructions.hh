@@ -38,7 +38,7 @@ struct InterpreterInstVisitor : public DispatchVisitor {
      Global functions names table as a static variable in the visitor
      so that each function prototype is generated as most once in the module.
     */
-    static std::map<std::string, FBCInstruction::Opcode> gMathLibTable;
+    static thread_local std::map<std::string, FBCInstruction::Opcode> gMathLibTable;
 
     int  fRealHeapOffset;   // Offset in Real HEAP
     int  fIntHeapOffset;    // Offset in Integer HEAP
@@ -668,10 +668,10 @@ struct InterpreterInstVisitor : public DispatchVisitor {
         // Finally add 'return'
         fCurrentBlock->push(new FBCBasicInstruction<T>(FBCInstruction::kReturn));
 
-        // Add the loop block in previous
+        // Add the loop block in previous, keeping the vector size for non recursive loops generated in -vec mode
         previous->push(new FBCBasicInstruction<T>(FBCInstruction::kLoop, "",
-                                                  ((inst->fIsRecursive) ? 1 : gGlobal->gVecSize), 0, 0, 0, init_block,
-                                                  loop_body_block));
+                                                  ((inst->fIsRecursive || !gGlobal->gVectorSwitch) ? 1 : gGlobal->gVecSize),
+                                                  0, 0, 0, init_block, loop_body_block));
 
         // Restore current block
         fCurrentBlock = previous;
@@ -30,21 +30,24 @@
 #include "exception.hh"
 #include "interpreter_bytecode.hh"
 
-#define INTER_MAX_OPT_LEVEL 6
+#define INTER_MAX_OPT_LEVEL 7
 
-// Tables for math optimization
+// Default level : superinstructions fusion (level 7) has to be explicitly requested
+#define INTER_DEFAULT_OPT_LEVEL 6
 
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Heap;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Stack;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2StackValue;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Value;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2ValueInvert;
+// Tables for math optimization (lazily filled by each thread running the optimizer)
 
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Heap;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Stack;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2StackValue;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Value;
-static std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2ValueInvert;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Heap;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Stack;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2StackValue;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2Value;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRMath2ValueInvert;
+
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Heap;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Stack;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2StackValue;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2Value;
+static thread_local std::map<FBCInstruction::Opcode, FBCInstruction::Opcode> gFIRExtendedMath2ValueInvert;
 
 //=======================
 // Optimization
@@ -563,6 +566,86 @@ struct FBCInstructionMathOptimizer : public FBCInstructionOptimizer<T> {
     }
 };
 
+// Fuse the most common Faust idioms (multiply-accumulate, delay line access, one-pole recursion...)
+// in superinstructions working directly on 'heap' slots, so that fewer instructions have to be dispatched.
+// Has to be done after the math optimizer which produces the 'heap' and 'stack' versions used here.
+template <class T>
+struct FBCInstructionFusionOptimizer : public FBCInstructionOptimizer<T> {
+    FBCInstructionFusionOptimizer() {}
+    
+    virtual ~FBCInstructionFusionOptimizer() {}
+    
+    FBCBasicInstruction<T>* rewrite(InstructionIT cur, InstructionIT& end)
+    {
+        FBCBasicInstruction<T>* &inst1 = *cur;
+        FBCBasicInstruction<T>* &inst2 = *(cur + 1);
+        
+        // kMultRealHeap kAddReal kStoreReal ==> kMultAddRealHeapStore ('inst2' is not the last one of the block)
+        if (inst1->fOpcode == FBCInstruction::kMultRealHeap && inst2->fOpcode == FBCInstruction::kAddReal &&
+            (*(cur + 2))->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 3;
+            return new FBCBasicInstruction<T>(FBCInstruction::kMultAddRealHeapStore, (*(cur + 2))->fOffset1, 0,
+                                              inst1->fOffset1, inst1->fOffset2);
+            
+            // kMultRealHeap kAddReal ==> kMultAddRealHeap
+        } else if (inst1->fOpcode == FBCInstruction::kMultRealHeap && inst2->fOpcode == FBCInstruction::kAddReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kMultAddRealHeap, 0, 0, inst1->fOffset1,
+                                              inst1->fOffset2);
+            
+            // kMultRealStack kAddRealStack ==> kMultAddRealStack
+        } else if (inst1->fOpcode == FBCInstruction::kMultRealStack &&
+                   inst2->fOpcode == FBCInstruction::kAddRealStack) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kMultAddRealStack, 0, 0, inst1->fOffset1,
+                                              inst2->fOffset1);
+            
+            // 'stack' OP 'stack' kStoreReal ==> Store version
+        } else if (inst1->fOpcode == FBCInstruction::kAddReal && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kAddRealStore, 0, 0, inst2->fOffset1, 0);
+        } else if (inst1->fOpcode == FBCInstruction::kSubReal && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kSubRealStore, 0, 0, inst2->fOffset1, 0);
+        } else if (inst1->fOpcode == FBCInstruction::kMultReal && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kMultRealStore, 0, 0, inst2->fOffset1, 0);
+            
+            // 'heap' OP 'stack' kStoreReal ==> Stack/Store version
+        } else if (inst1->fOpcode == FBCInstruction::kAddRealStack && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kAddRealStackStore, 0, 0, inst1->fOffset1,
+                                              inst2->fOffset1);
+        } else if (inst1->fOpcode == FBCInstruction::kSubRealStack && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kSubRealStackStore, 0, 0, inst1->fOffset1,
+                                              inst2->fOffset1);
+        } else if (inst1->fOpcode == FBCInstruction::kMultRealStack && inst2->fOpcode == FBCInstruction::kStoreReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kMultRealStackStore, 0, 0, inst1->fOffset1,
+                                              inst2->fOffset1);
+            
+            // Delay line read : kANDIntStackValue kLoadIndexedReal ==> kLoadIndexedRealMask
+        } else if (inst1->fOpcode == FBCInstruction::kANDIntStackValue &&
+                   inst2->fOpcode == FBCInstruction::kLoadIndexedReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kLoadIndexedRealMask, inst1->fIntValue, 0,
+                                              inst2->fOffset1, inst2->fOffset2);
+            
+            // Delay line write : kANDIntValue kStoreIndexedReal ==> kStoreIndexedRealMask
+        } else if (inst1->fOpcode == FBCInstruction::kANDIntValue &&
+                   inst2->fOpcode == FBCInstruction::kStoreIndexedReal) {
+            end = cur + 2;
+            return new FBCBasicInstruction<T>(FBCInstruction::kStoreIndexedRealMask, inst1->fIntValue, 0,
+                                              inst2->fOffset1, inst1->fOffset1);
+            
+        } else {
+            end = cur + 1;
+            return (*cur)->copy();
+        }
+    }
+};
+
 //============================================
 // Partial evaluation by constant propagation
 //============================================
@@ -1308,6 +1391,12 @@ struct FBCInstructionOptimizer {
             block = FBCInstructionOptimizer<T>::optimize(block, opt6);
         }
         
+        if (min_level <= 7 && 7 <= max_level) {
+            // 7) fuse common idioms in superinstructions
+            FBCInstructionFusionOptimizer<T> opt7;
+            block = FBCInstructionOptimizer<T>::optimize(block, opt7);
+        }
+        
         return block;
     }
 };
@@ -272,6 +272,16 @@ LIBEXPORT bool generateCAuxFilesFromFile(const char* filename, int argc, const c
 LIBEXPORT bool generateCAuxFilesFromString(const char* name_app, const char* dsp_content, int argc, const char* argv[],
                                            char* error_msg);
 
+/**
+ * Return the compilation passes of the last compilation done by the calling thread (factory creation,
+ * expansion or aux files generation) with the '-time' option: for each (possibly nested) pass, its duration,
+ * the number of created trees, the memory allocated by the compiler and the increase of the peak resident set size.
+ *
+ * @return a Chrome trace (JSON) document, or an empty string if '-time' was not used (to be deleted by the caller
+ * using freeCMemory)
+ */
+LIBEXPORT const char* getCCompilationTrace();
+
 /**
  * The free function to be used on memory returned by getCDSPMachineTarget, getCName, getCSHAKey,
  * getCDSPCode, getCLibraryList, getAllCDSPFactories, writeCDSPFactoryToBitcode,
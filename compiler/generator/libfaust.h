@@ -272,6 +272,15 @@ LIBEXPORT bool generateAuxFilesFromFile(const std::string& filename, int argc, c
 LIBEXPORT bool generateAuxFilesFromString(const std::string& name_app, const std::string& dsp_content, int argc,
                                           const char* argv[], std::string& error_msg);
 
+/**
+ * Return the compilation passes of the last compilation done by the calling thread (factory creation,
+ * expansion or aux files generation) with the '-time' option: for each (possibly nested) pass, its duration,
+ * the number of created trees, the memory allocated by the compiler and the increase of the peak resident set size.
+ *
+ * @return a Chrome trace (JSON) document, or an empty string if '-time' was not used
+ */
+LIBEXPORT std::string getCompilationTrace();
+
 /**
  * The free function to be used on memory returned by getCDSPMachineTarget, getCName, getCSHAKey,
  * getCDSPCode, getCLibraryList, getAllCDSPFactories, writeCDSPFactoryToBitcode,
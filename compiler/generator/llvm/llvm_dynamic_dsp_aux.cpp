@@ -384,8 +384,8 @@ static llvm_dsp_factory* readDSPFactoryFromBitcodeAux(MEMORY_BUFFER buffer, cons
 
         if (factory_aux->initJIT(error_msg)) {
             llvm_dsp_factory* factory = new llvm_dsp_factory(factory_aux);
-            llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
             factory->setSHAKey(sha_key);
+            llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
             return factory;
         } else {
             error_msg = "ERROR : " + error_msg;
@@ -506,8 +506,8 @@ static llvm_dsp_factory* readDSPFactoryFromIRAux(MEMORY_BUFFER buffer, const str
         
         if (factory_aux->initJIT(error_msg)) {
             llvm_dsp_factory* factory = new llvm_dsp_factory(factory_aux);
-            llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
             factory->setSHAKey(sha_key);
+            llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
             return factory;
         } else {
             error_msg = "ERROR : " + error_msg;
@@ -621,6 +621,27 @@ EXPORT llvm_dsp_factory* createDSPFactoryFromString(const string& name_app, cons
             }
             argv1[argc1] = nullptr;  // NULL terminated argv
             
+            // Look in the persistent cache (if activated) before compiling
+            string cache_target = (target == "") ? getDSPMachineTarget() : target;
+            string cache_key    = dsp_factory_cache::getKey(name_app, dsp_content, argc, argv,
+                                                            "llvm:" + cache_target + ":" + to_string(opt_level));
+            string machine_code;
+            time_t date = time(nullptr);
+            if (dsp_factory_cache::read(cache_key, machine_code)) {
+                string                error_msg_aux;
+                llvm_dsp_factory_aux* cached_aux = new llvm_dsp_factory_aux(sha_key, base64_decode(machine_code), target);
+                if (cached_aux->initJIT(error_msg_aux)) {
+                    factory = new llvm_dsp_factory(cached_aux);
+                    factory->setSHAKey(sha_key);
+                    llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
+                    factory->setDSPCode(expanded_dsp_content);
+                    return factory;
+                } else {
+                    // Unusable entry : compile again
+                    delete cached_aux;
+                }
+            }
+            
             llvm_dynamic_dsp_factory_aux* factory_aux = nullptr;
             try {
                 factory_aux = static_cast<llvm_dynamic_dsp_factory_aux*>(
@@ -634,9 +655,10 @@ EXPORT llvm_dsp_factory* createDSPFactoryFromString(const string& name_app, cons
                         goto error;
                     }
                     factory = new llvm_dsp_factory(factory_aux);
-                    llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
                     factory->setSHAKey(sha_key);
+                    llvm_dsp_factory_aux::gLLVMFactoryTable.setFactory(factory);
                     factory->setDSPCode(expanded_dsp_content);
+                    dsp_factory_cache::write(cache_key, date, factory_aux->writeDSPFactoryToMachine(target));
                     return factory;
                 }
             } catch (faustexception& e) {
@@ -256,13 +256,29 @@ void WSSCodeContainer::generateLocalOutputs(BlockInst* loop_code, const string&
     }
 }
 
+// Generates 'tasknum = getNextTask(fScheduler, num_thread)'
+static StatementInst* genGetNextTask()
+{
+    list<ValueInst*> fun_args;
+    fun_args.push_back(InstBuilder::genLoadStructVar("fScheduler"));
+    fun_args.push_back(InstBuilder::genLoadFunArgsVar("num_thread"));
+    return InstBuilder::genStoreStackVar("tasknum", InstBuilder::genFunCallInst("getNextTask", fun_args));
+}
+
 BlockInst* WSSCodeContainer::generateDAGLoopWSS(lclgraph dag)
 {
     string index = "fIndex";
 
+    // 'index' is written by the last task: a thread only reads it when holding a task, or once 'getNextTask'
+    // has returned the work stealing index at the end of the cycle, so the first task is taken before the loop
     BlockInst* loop_code = fComputeThreadBlockInstructions;
     loop_code->pushBackInst(InstBuilder::genDecStackVar("tasknum", InstBuilder::genInt32Typed(),
                                                         InstBuilder::genInt32NumInst(WORK_STEALING_INDEX)));
+    BlockInst* first_block = InstBuilder::genBlockInst();
+    first_block->pushBackInst(genGetNextTask());
+    loop_code->pushBackInst(InstBuilder::genIfInst(
+        InstBuilder::genGreaterThan(InstBuilder::genLoadStructVar(fFFullCount), InstBuilder::genInt32NumInst(0)),
+        first_block));
 
     DeclareVarInst* count_dec = InstBuilder::genDecStackVar("vsize", InstBuilder::genInt32Typed());
 
@@ -272,12 +288,7 @@ BlockInst* WSSCodeContainer::generateDAGLoopWSS(lclgraph dag)
     // Work stealing task
     BlockInst* ws_block = InstBuilder::genBlockInst();
     ws_block->pushBackInst(InstBuilder::genLabelInst("/* Work Stealing task */"));
-    list<ValueInst*> fun_args2;
-    fun_args2.push_back(InstBuilder::genLoadStructVar("fScheduler"));
-    fun_args2.push_back(InstBuilder::genLoadFunArgsVar("num_thread"));
-
-    ws_block->pushBackInst(
-        InstBuilder::genStoreStackVar("tasknum", InstBuilder::genFunCallInst("getNextTask", fun_args2)));
+    ws_block->pushBackInst(genGetNextTask());
     switch_block->addCase(WORK_STEALING_INDEX, ws_block);
 
     // Last task
@@ -292,15 +303,14 @@ BlockInst* WSSCodeContainer::generateDAGLoopWSS(lclgraph dag)
     BlockInst* then_block = InstBuilder::genBlockInst();
     BlockInst* else_block = InstBuilder::genBlockInst();
 
-    else_block->pushBackInst(InstBuilder::genRetInst());
-
-    // Generates init DAG and ready tasks activations
+    // Generates init DAG and ready tasks activations, then takes a task of the next iteration
     generateDAGLoopWSSAux1(dag, then_block);
-    // last_block->pushBackInst(InstBuilder::genIfInst(if_cond, then_block, else_block));
-    last_block->pushBackInst(InstBuilder::genIfInst(if_cond, then_block));
+    then_block->pushBackInst(genGetNextTask());
 
-    // Generates tasknum
-    last_block->pushBackInst(InstBuilder::genStoreStackVar("tasknum", InstBuilder::genInt32NumInst(0)));
+    // Last iteration: the loop test reads the index this thread just wrote
+    else_block->pushBackInst(
+        InstBuilder::genStoreStackVar("tasknum", InstBuilder::genInt32NumInst(WORK_STEALING_INDEX)));
+    last_block->pushBackInst(InstBuilder::genIfInst(if_cond, then_block, else_block));
 
     // Push if block as last_task
     switch_block->addCase(LAST_TASK_INDEX, last_block);
@@ -20,6 +20,7 @@
  ************************************************************************/
 
 #include <limits.h>
+#include <algorithm>
 #include <cstdint>
 
 #include "absprim.hh"
@@ -78,13 +79,9 @@
 #include "rust_code_container.hh"
 #endif
 
-// Parser
-extern FILE*       yyin;
-extern const char* yyfilename;
-
 // CG globals
-list<Garbageable*> global::gObjectTable;
-bool               global::gHeapCleanup = false;
+thread_local GarbageableArena global::gObjectArena;
+thread_local bool             global::gHeapCleanup = false;
 
 /*
 faust1 uses a loop size of 512, but 512 makes faust2 crash (stack allocation error).
@@ -128,6 +125,8 @@ global::global() : TABBER(1), gLoopDetector(1024, 400), gStackOverflowDetector(M
     gCUDASwitch      = false;
     gGroupTaskSwitch = false;
     gFunTaskSwitch   = false;
+    gFuseLoops       = false;
+    gVectorMath      = false;
 
     gUIMacroSwitch = false;
     gDumpNorm      = false;
@@ -159,6 +158,8 @@ global::global() : TABBER(1), gLoopDetector(1024, 400), gStackOverflowDetector(M
     gComputeIOTA          = false;
     gFAUSTFLOAT2Internal  = false;
     gInPlace              = false;
+    gCacheControls        = false;
+    gBatchSize            = 1;
     gHasExp10             = false;
     gLoopVarInBytes       = false;
     gWaveformInDSP        = false;
@@ -172,6 +173,7 @@ global::global() : TABBER(1), gLoopDetector(1024, 400), gStackOverflowDetector(M
     gOneSampleControl     = false;
     gFastMathLib          = "default";
     gNameSpace            = "";
+    gInterpSuperInst      = false;
 
     // Fastmath mapping float version
     gFastMathLibTable["fabsf"]      = "fast_fabsf";
@@ -437,12 +439,13 @@ global::global() : TABBER(1), gLoopDetector(1024, 400), gStackOverflowDetector(M
 
     gTimeout = 120;  // Time out to abort compiler (in seconds)
 
-    // Globals to transfer results in thread based evaluation
+    gTimingFile = "";
+
+    // Results of the 'process' evaluation and propagation
     gProcessTree  = 0;
     gLsignalsTree = 0;
     gNumInputs    = 0;
     gNumOutputs   = 0;
-    gErrorMessage = "";
 
     // By default use "cpp" output
     gOutputLang = (getenv("FAUST_DEFAULT_BACKEND")) ? string(getenv("FAUST_DEFAULT_BACKEND")) : "cpp";
@@ -513,21 +516,22 @@ void global::init()
 
     PROPAGATEPROPERTY = symbol("PropagateProperty");
 
-    // yyfilename is defined in errormsg.cpp but must be redefined at each compilation.
-    yyfilename = "";
-    yyin       = 0;
-
     gLatexheaderfilename = "latexheader.tex";
     gDocTextsDefaultFile = "mathdoctexts-default.txt";
 
-    gCurrentLocal = setlocale(LC_ALL, NULL);
+    // Setup standard "C" local, only in the compiling thread so that concurrent compilations do not interfere
+    // (workaround for a bug in bitcode generation : http://lists.cs.uiuc.edu/pipermail/llvmbugs/2012-May/023530.html)
+#ifdef _WIN32
+    gCurrentThreadLocale = _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
+    gCurrentLocal        = setlocale(LC_ALL, NULL);
     if (gCurrentLocal != NULL) {
         gCurrentLocal = strdup(gCurrentLocal);
     }
-
-    // Setup standard "C" local
-    // (workaround for a bug in bitcode generation : http://lists.cs.uiuc.edu/pipermail/llvmbugs/2012-May/023530.html)
     setlocale(LC_ALL, "C");
+#else
+    gCLocal       = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    gCurrentLocal = uselocale(gCLocal);
+#endif
 
     // Source file injection
     gInjectFlag = false;  // inject an external source file into the architecture file
@@ -593,24 +597,29 @@ void global::printCompilationOptions(ostream& dst, bool backend)
 #endif
     }
     if (gInPlace) dst << "-inpl ";
+    if (gCacheControls) dst << "-cc ";
+    if (gBatchSize > 1) dst << "-batch " << gBatchSize << " ";
     if (gOneSample) dst << "-os ";
     if (gLightMode) dst << "-light ";
+    if (gInterpSuperInst) dst << "-isi ";
     if (gSchedulerSwitch) {
         dst << "-sch"
             << " -vs " << gVecSize << ((gFunTaskSwitch) ? " -fun" : "") << ((gGroupTaskSwitch) ? " -g" : "")
-            << ((gDeepFirstSwitch) ? " -dfs" : "")
+            << ((gFuseLoops) ? " -fl" : "") << ((gVectorMath) ? " -vm" : "") << ((gDeepFirstSwitch) ? " -dfs" : "")
             << ((gFloatSize == 2) ? " -double" : (gFloatSize == 3) ? " -quad" : "") << " -ftz " << gFTZMode << " -mcd "
             << gGlobal->gMaxCopyDelay << ((gMemoryManager) ? " -mem" : "");
     } else if (gVectorSwitch) {
         dst << "-vec"
             << " -lv " << gVectorLoopVariant << " -vs " << gVecSize << ((gFunTaskSwitch) ? " -fun" : "")
-            << ((gGroupTaskSwitch) ? " -g" : "") << ((gDeepFirstSwitch) ? " -dfs" : "")
+            << ((gGroupTaskSwitch) ? " -g" : "") << ((gFuseLoops) ? " -fl" : "") << ((gVectorMath) ? " -vm" : "")
+            << ((gDeepFirstSwitch) ? " -dfs" : "")
             << ((gFloatSize == 2) ? " -double" : (gFloatSize == 3) ? " -quad" : "") << " -ftz " << gFTZMode << " -mcd "
             << gGlobal->gMaxCopyDelay << ((gMemoryManager) ? " -mem" : "");
     } else if (gOpenMPSwitch) {
         dst << "-omp"
             << " -vs " << gVecSize << " -vs " << gVecSize << ((gFunTaskSwitch) ? " -fun" : "")
-            << ((gGroupTaskSwitch) ? " -g" : "") << ((gDeepFirstSwitch) ? " -dfs" : "")
+            << ((gGroupTaskSwitch) ? " -g" : "") << ((gFuseLoops) ? " -fl" : "") << ((gVectorMath) ? " -vm" : "")
+            << ((gDeepFirstSwitch) ? " -dfs" : "")
             << ((gFloatSize == 2) ? " -double" : (gFloatSize == 3) ? " -quad" : "") << " -ftz " << gFTZMode << " -mcd "
             << gGlobal->gMaxCopyDelay << ((gMemoryManager) ? " -mem" : "");
     } else {
@@ -669,11 +678,21 @@ int global::audioSampleSize()
 
 global::~global()
 {
+    // The hash consing table is released first, so that destroyed trees do not have to be removed from it
+    CTree::cleanup();
     Garbageable::cleanup();
     BasicTyped::cleanup();
     DeclareVarInst::cleanup();
+#ifdef _WIN32
     setlocale(LC_ALL, gCurrentLocal);
     free(gCurrentLocal);
+    _configthreadlocale(gCurrentThreadLocale);
+#else
+    uselocale(gCurrentLocal);
+    if (gCLocal) {
+        freelocale(gCLocal);
+    }
+#endif
 
     // Cleanup
 #ifdef C_BUILD
@@ -745,59 +764,122 @@ string global::getFreshID(const string& prefix)
     return subst("$0$1", prefix, T(n));
 }
 
-void Garbageable::cleanup()
+GarbageableArena::GarbageableArena() : fCurrent(nullptr), fEnd(nullptr), fLast(nullptr), fAllocated(0)
 {
-    std::list<Garbageable*>::iterator it;
+    std::fill(fFreeBlocks, fFreeBlocks + kMaxReuse / kAlign + 1, nullptr);
+}
 
-    // Here removing the deleted pointer from the list is pointless
-    // and takes time, thus we don't do it.
-    global::gHeapCleanup = true;
-    for (it = global::gObjectTable.begin(); it != global::gObjectTable.end(); it++) {
-#ifdef _WIN32
-        // Hack : "this" and actual pointer are not the same: destructor cannot be called...
-        Garbageable::operator delete(*it);
-#else
-        delete (*it);
+GarbageableArena::~GarbageableArena()
+{
+    for (auto& it : fChunks) {
+        free(it);
+    }
+}
+
+void* GarbageableArena::allocate(size_t size, bool array)
+{
+    // HACK : add 16 bytes to avoid unsolved memory smashing bug...
+    size = (size + 16 + kAlign - 1) & ~(kAlign - 1);
+    fAllocated += size;
+
+    // Reuse a block of the same size released by an explicit delete (the block keeps its place in the objects list)
+    if (size <= kMaxReuse && fFreeBlocks[size / kAlign]) {
+        Header* header             = fFreeBlocks[size / kAlign];
+        fFreeBlocks[size / kAlign] = *static_cast<Header**>(getObject(header));
+        header->fFlags             = size | ((array) ? kArray : 0);
+        return getObject(header);
+    }
+
+    char* block;
+    if (size + kHeader > kChunkSize / 4) {
+        // Large objects get their own chunk
+        block = static_cast<char*>(malloc(size + kHeader));
+        if (!block) throw std::bad_alloc();
+        fChunks.push_back(block);
+    } else {
+        if (fCurrent + size + kHeader > fEnd) {
+            fCurrent = static_cast<char*>(malloc(kChunkSize));
+            if (!fCurrent) throw std::bad_alloc();
+            fEnd = fCurrent + kChunkSize;
+            fChunks.push_back(fCurrent);
+        }
+        block = fCurrent;
+        fCurrent += size + kHeader;
+    }
+
+    Header* header = reinterpret_cast<Header*>(block);
+    header->fPrev  = fLast;
+    header->fFlags = size | ((array) ? kArray : 0);
+    fLast          = header;
+    return getObject(header);
+}
+
+void GarbageableArena::release(void* ptr, bool cleanup)
+{
+    if (!ptr) return;
+    Header* header = getHeader(ptr);
+    size_t  size   = header->fFlags & ~(kAlign - 1);
+    header->fFlags |= kDeleted;
+
+    // Objects deleted during a compilation: the block can be reused by a later allocation of the same size
+    if (!cleanup && size <= kMaxReuse) {
+        *static_cast<Header**>(ptr) = fFreeBlocks[size / kAlign];
+        fFreeBlocks[size / kAlign]  = header;
+    }
+}
+
+void GarbageableArena::cleanup()
+{
+    // Destroy objects in reverse allocation order: objects explicitly deleted during the compilation are skipped,
+    // and arrays are only released (as with the previous malloc based allocator, their elements were not destroyed)
+    for (Header* header = fLast; header; header = header->fPrev) {
+#ifndef _WIN32
+        // On Windows, "this" and actual pointer are not the same: destructor cannot be called...
+        if (!(header->fFlags & (kDeleted | kArray))) {
+            Garbageable* obj = static_cast<Garbageable*>(getObject(header));
+            obj->~Garbageable();
+        }
 #endif
     }
 
+    // Then release the memory in bulk
+    for (auto& it : fChunks) {
+        free(it);
+    }
+    fChunks.clear();
+    fCurrent = fEnd = nullptr;
+    fLast           = nullptr;
+    std::fill(fFreeBlocks, fFreeBlocks + kMaxReuse / kAlign + 1, nullptr);
+}
+
+void Garbageable::cleanup()
+{
+    // Here destroyed objects are not individually released, the arena memory is freed at the end
+    global::gHeapCleanup = true;
+    global::gObjectArena.cleanup();
+
     // Reset to default state
-    global::gObjectTable.clear();
     global::gHeapCleanup = false;
 }
 
 void* Garbageable::operator new(size_t size)
 {
-    // HACK : add 16 bytes to avoid unsolved memory smashing bug...
-    Garbageable* res = (Garbageable*)malloc(size + 16);
-    global::gObjectTable.push_front(res);
-    return res;
+    return global::gObjectArena.allocate(size, false);
 }
 
 void Garbageable::operator delete(void* ptr)
 {
-    // We may have cases when a pointer will be deleted during
-    // a compilation, thus the pointer has to be removed from the list.
-    if (!global::gHeapCleanup) {
-        global::gObjectTable.remove(static_cast<Garbageable*>(ptr));
-    }
-    free(ptr);
+    // We may have cases when a pointer will be deleted during a compilation: the block is marked as deleted
+    // so that it is not destroyed again by cleanup, and can be reused
+    global::gObjectArena.release(ptr, global::gHeapCleanup);
 }
 
 void* Garbageable::operator new[](size_t size)
 {
-    // HACK : add 16 bytes to avoid unsolved memory smashing bug...
-    Garbageable* res = (Garbageable*)malloc(size + 16);
-    global::gObjectTable.push_front(res);
-    return res;
+    return global::gObjectArena.allocate(size, true);
 }
 
 void Garbageable::operator delete[](void* ptr)
 {
-    // We may have cases when a pointer will be deleted during
-    // a compilation, thus the pointer has to be removed from the list.
-    if (!global::gHeapCleanup) {
-        global::gObjectTable.remove(static_cast<Garbageable*>(ptr));
-    }
-    free(ptr);
+    global::gObjectArena.release(ptr, global::gHeapCleanup);
 }
@@ -22,6 +22,7 @@
 #ifndef __FAUST_GLOBAL__
 #define __FAUST_GLOBAL__
 
+#include <locale.h>
 #include <stdio.h>
 #include <string.h>
 #include <list>
@@ -34,6 +35,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
 #include "exception.hh"
 #include "instructions_type.hh"
 #include "loopDetector.hh"
@@ -52,6 +57,7 @@ class xtended;
 class AudioType;
 
 class Garbageable;
+class GarbageableArena;
 
 struct DispatchVisitor;
 class WASTInstVisitor;
@@ -130,6 +136,8 @@ struct global {
     bool gCUDASwitch;
     bool gGroupTaskSwitch;
     bool gFunTaskSwitch;
+    bool gFuseLoops;
+    bool gVectorMath;
 
     bool gUIMacroSwitch;
     bool gDumpNorm;
@@ -159,6 +167,8 @@ struct global {
     bool   gComputeIOTA;           // Cache some computation done with IOTA variable
     bool   gFAUSTFLOAT2Internal;   // FAUSTFLOAT type (= kFloatMacro) forced to internal real
     bool   gInPlace;               // Add cache to input for correct in-place computations
+    bool   gCacheControls;         // Control-rate values are cached and only recomputed when controls change
+    int    gBatchSize;             // Number of independent instances computed in lockstep (1 : no batching)
     bool   gHasExp10;              // If the 'exp10' math function is available
     bool   gLoopVarInBytes;        // If the 'i' variable used in the scalar loop moves by bytes instead of frames
     bool   gWaveformInDSP;         // If waveform are allocated in the DSP and not as global data
@@ -172,6 +182,7 @@ struct global {
     bool   gOneSampleControl;      // Generate one sample computation control structure in DSP module
     string gFastMathLib;           // The fastmath code mapping file
     string gNameSpace;             // Wrapping namespace used with the C++ backend
+    bool   gInterpSuperInst;       // Fuse common idioms in superinstructions with the interpreter backend
 
     map<string, string> gFastMathLibTable;      // Mapping table for fastmath functions
     map<string, bool>   gMathForeignFunctions;  // Map of math foreign functions
@@ -480,7 +491,13 @@ struct global {
     // to keep track of already injected files
     set<string> gAlreadyIncluded;
 
+#ifdef _WIN32
     char* gCurrentLocal;
+    int   gCurrentThreadLocale;
+#else
+    locale_t gCurrentLocal;  // Locale of the compiling thread, restored at the end of the compilation
+    locale_t gCLocal;        // Standard "C" locale used by the compiling thread
+#endif
 
     int gAllocationCount;  // Internal signal types counter
     
@@ -527,16 +544,17 @@ struct global {
 
     int gTimeout;  // Time out to abort compiler (in seconds)
 
-    // Globals to transfer results in thread based evaluation
-    Tree   gProcessTree;
-    Tree   gLsignalsTree;
-    int    gNumInputs;
-    int    gNumOutputs;
-    string gErrorMessage;
+    string gTimingFile;  // File where the timed passes are written as a Chrome trace (JSON) document
+
+    // Results of the 'process' evaluation and propagation
+    Tree gProcessTree;
+    Tree gLsignalsTree;
+    int  gNumInputs;
+    int  gNumOutputs;
 
-    // GC
-    static list<Garbageable*> gObjectTable;
-    static bool               gHeapCleanup;
+    // GC (one arena per compiling thread)
+    static thread_local GarbageableArena gObjectArena;
+    static thread_local bool             gHeapCleanup;
 
     global();
     ~global();
@@ -576,8 +594,8 @@ struct global {
     int audioSampleSize();
 };
 
-// Unique shared global pointer
-extern global* gGlobal;
+// Global context of the compilation running in the current thread
+extern thread_local global* gGlobal;
 
 #define FAUST_LIB_PATH "FAUST_LIB_PATH"
 #define MAX_MACHINE_STACK_SIZE 65536
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <cstdlib>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <list>
@@ -112,17 +113,17 @@
 
 using namespace std;
 
-static unique_ptr<ifstream> injcode;
-static unique_ptr<ifstream> enrobage;
+static thread_local unique_ptr<ifstream> injcode;
+static thread_local unique_ptr<ifstream> enrobage;
 
 #ifdef OCPP_BUILD
 // Old CPP compiler
-Compiler* old_comp = nullptr;
+thread_local Compiler* old_comp = nullptr;
 #endif
 
 // FIR container
-InstructionsCompiler* new_comp  = nullptr;
-CodeContainer*        container = nullptr;
+thread_local InstructionsCompiler* new_comp  = nullptr;
+thread_local CodeContainer*        container = nullptr;
 
 typedef void* (*compile_fun)(void* arg);
 
@@ -172,54 +173,35 @@ static void enumBackends(ostream& out)
 #endif
 }
 
-static void callFun(compile_fun fun)
+// A compilation runs in its own thread, with more stack size. The compiler state ('gGlobal', hash-consing tables,
+// memory arena...) is owned by this thread, so that several compilations can run in parallel.
+static void callFun(compile_fun fun, void* arg)
 {
 #if defined(EMCC) || defined(_WIN32)
     // No thread support in JS or WIN32
-    fun(NULL);
+    fun(arg);
 #else
     pthread_t      thread;
     pthread_attr_t attr;
     faustassert(pthread_attr_init(&attr) == 0);
     faustassert(pthread_attr_setstacksize(&attr, MAX_STACK_SIZE) == 0);
     faustassert(pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE) == 0);
-    faustassert(pthread_create(&thread, &attr, fun, nullptr) == 0);
+    faustassert(pthread_create(&thread, &attr, fun, arg) == 0);
     pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
 #endif
 }
 
 static Tree evaluateBlockDiagram(Tree expandedDefList, int& numInputs, int& numOutputs);
 
-static void* threadEvaluateBlockDiagram(void* arg)
-{
-    try {
-        gGlobal->gProcessTree =
-            evaluateBlockDiagram(gGlobal->gExpandedDefList, gGlobal->gNumInputs, gGlobal->gNumOutputs);
-    } catch (faustexception& e) {
-        gGlobal->gErrorMessage = e.Message();
-    }
-    return 0;
-}
-
-static void* threadBoxPropagateSig(void* arg)
-{
-    try {
-        gGlobal->gLsignalsTree =
-            boxPropagateSig(gGlobal->nil, gGlobal->gProcessTree, makeSigInputList(gGlobal->gNumInputs));
-    } catch (faustexception& e) {
-        gGlobal->gErrorMessage = e.Message();
-    }
-    return 0;
-}
-
 /****************************************************************
                         Global context variable
 *****************************************************************/
 
-global* gGlobal = nullptr;
+thread_local global* gGlobal = nullptr;
 
 // Timing can be used outside of the scope of 'gGlobal'
-extern bool gTimingSwitch;
+extern thread_local bool gTimingSwitch;
 
 /****************************************************************
                         Parser variables
@@ -434,6 +416,14 @@ static bool processCmdline(int argc, const char* argv[])
             gGlobal->gFunTaskSwitch = true;
             i += 1;
 
+        } else if (isCmd(argv[i], "-fl", "--fuse-loops")) {
+            gGlobal->gFuseLoops = true;
+            i += 1;
+
+        } else if (isCmd(argv[i], "-vm", "--vector-math")) {
+            gGlobal->gVectorMath = true;
+            i += 1;
+
         } else if (isCmd(argv[i], "-uim", "--user-interface-macros")) {
             gGlobal->gUIMacroSwitch = true;
             i += 1;
@@ -446,6 +436,11 @@ static bool processCmdline(int argc, const char* argv[])
             gTimingSwitch = true;
             i += 1;
 
+        } else if (isCmd(argv[i], "-tf", "--timing-file") && (i + 1 < argc)) {
+            gTimingSwitch        = true;
+            gGlobal->gTimingFile = argv[i + 1];
+            i += 2;
+
             // double float options
         } else if (isCmd(argv[i], "-single", "--single-precision-floats")) {
             if (float_size && gGlobal->gFloatSize != 1) {
@@ -523,6 +518,10 @@ static bool processCmdline(int argc, const char* argv[])
             gGlobal->gOneSample = true;
             i += 1;
 
+        } else if (isCmd(argv[i], "-isi", "--interp-superinstructions")) {
+            gGlobal->gInterpSuperInst = true;
+            i += 1;
+
         } else if (isCmd(argv[i], "-ftz", "--flush-to-zero")) {
             gGlobal->gFTZMode = std::atoi(argv[i + 1]);
             if ((gGlobal->gFTZMode > 2) || (gGlobal->gFTZMode < 0)) {
@@ -595,6 +594,14 @@ static bool processCmdline(int argc, const char* argv[])
             gGlobal->gInPlace = true;
             i += 1;
 
+        } else if (isCmd(argv[i], "-cc", "--cache-controls")) {
+            gGlobal->gCacheControls = true;
+            i += 1;
+
+        } else if (isCmd(argv[i], "-batch", "--batch-size") && (i + 1 < argc)) {
+            gGlobal->gBatchSize = std::atoi(argv[i + 1]);
+            i += 2;
+
         } else if (isCmd(argv[i], "-es", "--enable-semantics")) {
             gGlobal->gEnableFlag = std::atoi(argv[i + 1]) == 1;
             i += 2;
@@ -665,6 +672,25 @@ static bool processCmdline(int argc, const char* argv[])
         throw faustexception("ERROR : '-os' option cannot only be used in scalar mode\n");
     }
     
+    if (gGlobal->gBatchSize < 1) {
+        stringstream error;
+        error << "ERROR : invalid batch size [-batch = " << gGlobal->gBatchSize << "] should be at least 1" << endl;
+        throw faustexception(error.str());
+    }
+
+    if (gGlobal->gBatchSize > 1) {
+        // Not with 'llvm': the JIT compiled 'llvm_dsp' is a plain 'dsp' built without RTTI,
+        // so mydsp_poly could not find its lanes with 'dynamic_cast<batch_dsp*>'
+        if (gGlobal->gOutputLang != "cpp") {
+            throw faustexception("ERROR : '-batch' option can only be used with cpp backend\n");
+        }
+        if (gGlobal->gVectorSwitch || gGlobal->gOpenCLSwitch || gGlobal->gCUDASwitch || gGlobal->gOneSample ||
+            gGlobal->gInPlace || gGlobal->gCacheControls) {
+            throw faustexception(
+                "ERROR : '-batch' option can only be used in scalar mode, and not with '-os', '-inpl' or '-cc'\n");
+        }
+    }
+
     if (gGlobal->gFTZMode == 2 && gGlobal->gOutputLang == "soul") {
         throw faustexception("ERROR : '-ftz 2' option cannot only be used in 'soul' backend\n");
     }
@@ -689,6 +715,15 @@ static bool processCmdline(int argc, const char* argv[])
         }
     }
 
+    if (gGlobal->gFuseLoops && (!gGlobal->gVectorSwitch || gGlobal->gOpenCLSwitch || gGlobal->gCUDASwitch)) {
+        throw faustexception("ERROR : -fl can only be used in -vec, -omp or -sch mode\n");
+    }
+
+    if (gGlobal->gVectorMath && (!gGlobal->gVectorSwitch || gGlobal->gOpenCLSwitch || gGlobal->gCUDASwitch ||
+                                 !(gGlobal->gOutputLang == "c" || gGlobal->gOutputLang == "cpp"))) {
+        throw faustexception("ERROR : -vm can only be used in -vec, -omp or -sch mode with the c or cpp backends\n");
+    }
+
     if (gGlobal->gFastMath) {
         if (!(gGlobal->gOutputLang == "c"
               || gGlobal->gOutputLang == "cpp"
@@ -837,6 +872,10 @@ static void printHelp()
     cout << tab << "-flist      --file-list                 use file list used to eval process." << endl;
     cout << tab << "-exp10      --generate-exp10            pow(10,x) replaced by possibly faster exp10(x)." << endl;
     cout << tab << "-os         --one-sample                generate one sample computation." << endl;
+    cout << tab
+         << "-isi        --interp-superinstructions  fuse common idioms in superinstructions with the interpreter "
+            "backend."
+         << endl;
     cout << tab
          << "-cn <name>  --class-name <name>         specify the name of the dsp class to be used instead of mydsp."
          << endl;
@@ -875,6 +914,14 @@ static void printHelp()
          << "-inpl      --in-place                   generates code working when input and output buffers are the same "
             "(scalar mode only)."
          << endl;
+    cout << tab
+         << "-cc        --cache-controls             only recompute control-rate values when a control or the sample "
+            "rate has changed."
+         << endl;
+    cout << tab
+         << "-batch <n>  --batch-size <n>            generate a class computing <n> independent instances in lockstep "
+            "(cpp backend, scalar mode only)."
+         << endl;
     cout << tab << "-vec       --vectorize                  generate easier to vectorize code." << endl;
     cout << tab << "-vs <n>    --vec-size <n>               size of the vector (default 32 samples)." << endl;
     cout << tab << "-lv <n>    --loop-variant <n>           [0:fastest (default), 1:simple]." << endl;
@@ -896,6 +943,14 @@ static void printHelp()
          << "-fun       --fun-tasks                  separate tasks code as separated functions (in -vec, -sch, or "
             "-omp mode)."
          << endl;
+    cout << tab
+         << "-fl        --fuse-loops                 fuse loops and keep intermediate vectors in registers using a "
+            "cost model (in -vec, -sch, or -omp mode, decisions printed with -d)."
+         << endl;
+    cout << tab
+         << "-vm        --vector-math                compute math functions once per vector with 'faust/dsp/vecmath.h' "
+            "(in -vec, -sch, or -omp mode with the c or cpp backends)."
+         << endl;
     cout << tab
          << "-fm <file> --fast-math <file>           use optimized versions of mathematical functions implemented in "
             "<file>."
@@ -939,6 +994,10 @@ static void printHelp()
     cout << endl << "Debug options:" << line;
     cout << tab << "-d          --details                   print compilation details." << endl;
     cout << tab << "-time       --compilation-time          display compilation phases timing information." << endl;
+    cout << tab
+         << "-tf <file>  --timing-file <file>        write compilation phases timing, created trees and allocated "
+            "memory in <file> (Chrome trace JSON format)."
+         << endl;
     cout << tab << "-tg         --task-graph                print the internal task graph in dot format." << endl;
     cout << tab << "-sg         --signal-graph              print the internal signal graph in dot format." << endl;
     cout << tab << "-norm       --normalized-form           print signals in normalized form and exit." << endl;
@@ -1560,7 +1619,9 @@ static void generateCode(Tree signals, int numInputs, int numOutputs, bool gener
                 }
 
                 container->printFloatDef();
+                startTiming("produceClass");
                 container->produceClass();
+                endTiming("produceClass");
 
                 streamCopyUntilEnd(*enrobage.get(), *dst.get());
 
@@ -1571,7 +1632,9 @@ static void generateCode(Tree signals, int numInputs, int numOutputs, bool gener
                 container->printFooter();
    
                 // Generate factory
+                startTiming("produceFactory");
                 gGlobal->gDSPFactory = container->produceFactory();
+                endTiming("produceFactory");
                 
                 if (gGlobal->gOutputFile == "string") {
                     gGlobal->gDSPFactory->write(dst.get(), false, false);
@@ -1602,11 +1665,15 @@ static void generateCode(Tree signals, int numInputs, int numOutputs, bool gener
         } else {
             container->printHeader();
             container->printFloatDef();
+            startTiming("produceClass");
             container->produceClass();
+            endTiming("produceClass");
             container->printFooter();
          
             // Generate factory
+            startTiming("produceFactory");
             gGlobal->gDSPFactory = container->produceFactory();
+            endTiming("produceFactory");
             
             if (gGlobal->gOutputFile == "string") {
                 gGlobal->gDSPFactory->write(dst.get(), false, false);
@@ -1813,10 +1880,7 @@ static string expandDSPInternal(int argc, const char* argv[], const char* name,
     /****************************************************************
      3 - evaluate 'process' definition
     *****************************************************************/
-    callFun(threadEvaluateBlockDiagram);  // In a thread with more stack size...
-    if (!gGlobal->gProcessTree) {
-        throw faustexception(gGlobal->gErrorMessage);
-    }
+    gGlobal->gProcessTree = evaluateBlockDiagram(gGlobal->gExpandedDefList, gGlobal->gNumInputs, gGlobal->gNumOutputs);
 
     // Encode compilation options as a 'declare' : has to be located first in the string
     stringstream out;
@@ -1907,10 +1971,7 @@ static void compileFaustFactoryAux(int argc, const char* argv[], const char* nam
      3 - evaluate 'process' definition
     *****************************************************************/
 
-    callFun(threadEvaluateBlockDiagram);  // In a thread with more stack size...
-    if (!gGlobal->gProcessTree) {
-        throw faustexception(gGlobal->gErrorMessage);
-    }
+    gGlobal->gProcessTree = evaluateBlockDiagram(gGlobal->gExpandedDefList, gGlobal->gNumInputs, gGlobal->gNumOutputs);
     Tree process    = gGlobal->gProcessTree;
     int  numInputs  = gGlobal->gNumInputs;
     int  numOutputs = gGlobal->gNumOutputs;
@@ -1943,11 +2004,8 @@ static void compileFaustFactoryAux(int argc, const char* argv[], const char* nam
     *****************************************************************/
     startTiming("propagation");
 
-    callFun(threadBoxPropagateSig);  // In a thread with more stack size...
-    if (!gGlobal->gLsignalsTree) {
-        throw faustexception(gGlobal->gErrorMessage);
-    }
-    Tree lsignals = gGlobal->gLsignalsTree;
+    gGlobal->gLsignalsTree = boxPropagateSig(gGlobal->nil, process, makeSigInputList(numInputs));
+    Tree lsignals          = gGlobal->gLsignalsTree;
 
     if (gGlobal->gDetailsSwitch) {
         cout << "output signals are : " << endl;
@@ -1966,46 +2024,137 @@ static void compileFaustFactoryAux(int argc, const char* argv[], const char* nam
      6 - generate xml description, documentation or dot files
     *****************************************************************/
     generateOutputFiles();
+
+    if (gGlobal->gTimingFile != "") {
+        ofstream trace(gGlobal->gTimingFile.c_str());
+        writeTimingTrace(trace);
+    } else if (gTimingSwitch) {
+        CTree::control();
+    }
 }
 
 // ============
 // Backend API
 // ============
 
-dsp_factory_base* compileFaustFactory(int argc, const char* argv[], const char* name, const char* dsp_content,
-                                      string& error_msg, bool generate)
+// Parameters and results of a compilation running in its own thread
+struct CompileArgs {
+    int                fArgc;
+    const char**       fArgv;
+    const char*        fName;
+    const char*        fDSPContent;
+    bool               fGenerate;
+    dsp_factory_base*  fFactory;
+    string             fExpanded;
+    string             fSHAKey;
+    string             fErrorMsg;
+    string             fTimingTrace;  // Timed passes with the '-time' option
+    vector<string>     fLibraries;    // Imported library files
+    std::exception_ptr fException;     // Any other exception, rethrown in the calling thread
+
+    CompileArgs(int argc, const char* argv[], const char* name, const char* dsp_content, bool generate)
+        : fArgc(argc), fArgv(argv), fName(name), fDSPContent(dsp_content), fGenerate(generate), fFactory(nullptr)
+    {
+    }
+};
+
+// Timed passes and imported libraries of the last compilation done by the calling thread
+static thread_local string         gCompilationTrace;
+static thread_local vector<string> gCompilationLibraries;
+
+// Keep the timed passes of the compiling thread
+static void saveTimingTrace(CompileArgs* args)
 {
-    gGlobal                   = nullptr;
-    dsp_factory_base* factory = nullptr;
+    if (gTimingSwitch) {
+        stringstream trace;
+        writeTimingTrace(trace);
+        args->fTimingTrace = trace.str();
+    }
+    gTimingSwitch = false;
+    resetTiming();
+}
+
+static void* threadCompileFaustFactory(void* arg)
+{
+    CompileArgs* args = static_cast<CompileArgs*>(arg);
+    gGlobal           = nullptr;
 
     try {
         global::allocate();
-        compileFaustFactoryAux(argc, argv, name, dsp_content, generate);
-        error_msg = gGlobal->gErrorMsg;
-        factory   = gGlobal->gDSPFactory;
+        compileFaustFactoryAux(args->fArgc, args->fArgv, args->fName, args->fDSPContent, args->fGenerate);
+        args->fErrorMsg = gGlobal->gErrorMsg;
+        args->fFactory  = gGlobal->gDSPFactory;
+        if (gGlobal->gReader.listSrcFiles().size() > 0) {
+            args->fLibraries = gGlobal->gReader.listLibraryFiles();
+        }
     } catch (faustexception& e) {
-        error_msg = e.Message();
+        args->fErrorMsg = e.Message();
+    } catch (...) {
+        args->fException = std::current_exception();
     }
 
+    saveTimingTrace(args);
     global::destroy();
-    return factory;
+    return nullptr;
 }
 
-string expandDSP(int argc, const char* argv[], const char* name, const char* dsp_content, string& sha_key,
-                 string& error_msg)
+static void* threadExpandDSP(void* arg)
 {
-    gGlobal    = nullptr;
-    string res = "";
+    CompileArgs* args = static_cast<CompileArgs*>(arg);
+    gGlobal           = nullptr;
 
     try {
         global::allocate();
-        res       = expandDSPInternal(argc, argv, name, dsp_content);
-        sha_key   = generateSHA1(res);
-        error_msg = gGlobal->gErrorMsg;
+        args->fExpanded = expandDSPInternal(args->fArgc, args->fArgv, args->fName, args->fDSPContent);
+        args->fSHAKey   = generateSHA1(args->fExpanded);
+        args->fErrorMsg = gGlobal->gErrorMsg;
     } catch (faustexception& e) {
-        error_msg = e.Message();
+        args->fErrorMsg = e.Message();
+    } catch (...) {
+        args->fException = std::current_exception();
     }
 
+    saveTimingTrace(args);
     global::destroy();
-    return res;
+    return nullptr;
+}
+
+dsp_factory_base* compileFaustFactory(int argc, const char* argv[], const char* name, const char* dsp_content,
+                                      string& error_msg, bool generate)
+{
+    CompileArgs args(argc, argv, name, dsp_content, generate);
+    callFun(threadCompileFaustFactory, &args);
+    gCompilationTrace     = args.fTimingTrace;
+    gCompilationLibraries = args.fLibraries;
+    if (args.fException) {
+        std::rethrow_exception(args.fException);
+    }
+    error_msg = args.fErrorMsg;
+    return args.fFactory;
+}
+
+string expandDSP(int argc, const char* argv[], const char* name, const char* dsp_content, string& sha_key,
+                 string& error_msg)
+{
+    CompileArgs args(argc, argv, name, dsp_content, false);
+    callFun(threadExpandDSP, &args);
+    gCompilationTrace = args.fTimingTrace;
+    if (args.fException) {
+        std::rethrow_exception(args.fException);
+    }
+    if (args.fSHAKey != "") {
+        sha_key = args.fSHAKey;
+    }
+    error_msg = args.fErrorMsg;
+    return args.fExpanded;
+}
+
+string getLastCompilationTrace()
+{
+    return gCompilationTrace;
+}
+
+vector<string> getLastCompilationLibraries()
+{
+    return gCompilationLibraries;
 }
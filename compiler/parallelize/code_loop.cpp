@@ -29,6 +29,7 @@
 #include "floats.hh"
 #include "global.hh"
 #include "fir_to_fir.hh"
+#include "instructions_complexity.hh"
 
 using namespace std;
 
@@ -187,6 +188,29 @@ void CodeLoop::concat(CodeLoop* l)
     fBackwardLoopDependencies = l->fBackwardLoopDependencies;
 }
 
+/**
+ * Fuse a producer loop in this one: the code of the producer is computed first at each iteration,
+ * so that the samples it writes are read back while still in cache, or even kept in registers.
+ * @param l the Loop to be fused, only used by this one
+ */
+void CodeLoop::fuse(CodeLoop* l)
+{
+    // the loops must have the same number of iterations
+    faustassert(fSize == l->fSize);
+    fIsRecursive  = fIsRecursive || l->fIsRecursive;
+    fRecSymbolSet = setUnion(fRecSymbolSet, l->fRecSymbolSet);
+
+    // the fused loop now depends on the dependencies of the producer
+    fBackwardLoopDependencies.erase(l);
+    fBackwardLoopDependencies.insert(l->fBackwardLoopDependencies.begin(), l->fBackwardLoopDependencies.end());
+
+    // the code of the producer comes first
+    fPreInst->fCode.insert(fPreInst->fCode.begin(), l->fPreInst->fCode.begin(), l->fPreInst->fCode.end());
+    fComputeInst->fCode.insert(fComputeInst->fCode.begin(), l->fComputeInst->fCode.begin(),
+                               l->fComputeInst->fCode.end());
+    fPostInst->fCode.insert(fPostInst->fCode.begin(), l->fPostInst->fCode.begin(), l->fPostInst->fCode.end());
+}
+
 // Graph sorting
 
 void CodeLoop::setOrder(CodeLoop* l, int order, lclgraph& V)
@@ -290,3 +314,719 @@ void CodeLoop::groupSeqLoops(CodeLoop* l, set<CodeLoop*>& visited)
         }
     }
 }
+
+/*
+ Cost model of loop fusion, estimated in cycles.
+
+ Fusing a producer loop in its only consumer saves the loop overhead, and the vectors written by the
+ producer are read back while in L1 cache (instead of L2 when the vectors of the loops don't fit in L1),
+ or kept in registers when no other loop uses them. But a vectorizable loop fused with a recursive one
+ is no longer vectorized, and in -omp/-sch modes, the producer can no longer be computed in parallel with
+ the other dependencies of the consumer, although each task saves its activation cost.
+*/
+
+#define LOOP_OVERHEAD 2      // per sample cost of a separate loop (loop control, input/output pointers)
+#define TASK_OVERHEAD 2000   // activation and synchronisation of a task in -omp/-sch modes
+#define SIMD_WIDTH 4         // samples computed at once in vectorized loops
+#define L1_CACHE_SIZE 32768  // vectors read back from L1 when the working set of a loop fits in it
+#define L2_ACCESS 4          // otherwise from L2
+
+// Estimated cost and variables of a loop
+struct LoopCost {
+    string           fName;
+    int              fCost;  // per sample
+    map<string, int> fAccesses;
+    map<string, int> fIndexed;
+    map<string, int> fStored;
+
+    static int get(const map<string, int>& vars, const string& name)
+    {
+        auto it = vars.find(name);
+        return (it != vars.end()) ? it->second : 0;
+    }
+
+    static void merge(map<string, int>& dst, const map<string, int>& src)
+    {
+        for (auto& it : src) {
+            dst[it.first] += it.second;
+        }
+    }
+};
+
+class LoopFusion {
+   private:
+    const map<string, Typed*>&   fVectors;
+    bool                         fParallel;
+    ostream*                     fDump;
+    map<CodeLoop*, LoopCost>     fCosts;
+    map<string, set<CodeLoop*> > fUsers;  // loops accessing each variable
+
+    void analyze(CodeLoop* l, const string& name)
+    {
+        LoopCost& cost = fCosts[l];
+        cost.fName     = name;
+
+        InstComplexityVisitor complexity;
+        l->fComputeInst->accept(&complexity);
+        cost.fCost = complexity.cost();
+
+        LoopVarCollector collector(l->fLoopIndex);
+        l->fPreInst->accept(&collector);
+        l->fComputeInst->accept(&collector);
+        l->fPostInst->accept(&collector);
+        cost.fAccesses = collector.fAccesses;
+        cost.fIndexed  = collector.fIndexed;
+        cost.fStored   = collector.fStored;
+
+        for (auto& it : cost.fAccesses) {
+            fUsers[it.first].insert(l);
+        }
+    }
+
+    void collectLoops(CodeLoop* l, set<CodeLoop*>& loops, map<CodeLoop*, int>& consumers)
+    {
+        if (loops.insert(l).second) {
+            for (auto& p : l->fBackwardLoopDependencies) {
+                consumers[p]++;
+                collectLoops(p, loops, consumers);
+            }
+        }
+    }
+
+    // A vector written by 'p' and read by 'c' is kept in registers when only accessed by them at the loop index
+    bool inRegister(const string& vec, CodeLoop* p, CodeLoop* c)
+    {
+        if (fVectors.find(vec) == fVectors.end()) return false;
+        for (auto& it : fUsers[vec]) {
+            if (it != p && it != c) return false;
+        }
+        const LoopCost& pc = fCosts[p];
+        const LoopCost& cc = fCosts[c];
+        return (LoopCost::get(pc.fAccesses, vec) == LoopCost::get(pc.fIndexed, vec)) &&
+               (LoopCost::get(cc.fAccesses, vec) == LoopCost::get(cc.fIndexed, vec)) &&
+               (LoopCost::get(pc.fStored, vec) + LoopCost::get(cc.fStored, vec) == 1);
+    }
+
+    // Variables written before or after the loop by one of them must not be accessed by the other one
+    bool hasConflict(BlockInst* block, CodeLoop* other)
+    {
+        StoredVarCollector stored;
+        block->accept(&stored);
+        const LoopCost& cost = fCosts[other];
+        for (auto& it : stored.fNames) {
+            if (cost.fAccesses.find(it) != cost.fAccesses.end()) return true;
+        }
+        return false;
+    }
+
+    bool canFuse(CodeLoop* p, CodeLoop* c, map<CodeLoop*, int>& consumers)
+    {
+        return (consumers[p] == 1) && !p->isEmpty() && p->fExtraLoops.empty() && c->fExtraLoops.empty() &&
+               (p->fSize == c->fSize) && (p->fLoopIndex == c->fLoopIndex) && !hasConflict(p->fPostInst, c) &&
+               !hasConflict(c->fPreInst, p);
+    }
+
+    // Gain and loss (in cycles per vector) of fusing 'p' in 'c', 'others' is the higher cost of the other
+    // dependencies of 'c'
+    void evaluate(CodeLoop* p, CodeLoop* c, int others, int& gain, int& loss, set<string>& regs, set<string>& mems)
+    {
+        const LoopCost& pc = fCosts[p];
+        const LoopCost& cc = fCosts[c];
+
+        for (auto& it : pc.fStored) {
+            if (cc.fAccesses.find(it.first) != cc.fAccesses.end()) {
+                if (inRegister(it.first, p, c)) {
+                    regs.insert(it.first);
+                } else {
+                    mems.insert(it.first);
+                }
+            }
+        }
+
+        int working_set = gGlobal->gVecSize * ifloatsize() * int(pc.fIndexed.size() + cc.fIndexed.size());
+        int reload      = (working_set <= L1_CACHE_SIZE) ? 1 : L2_ACCESS;
+        gain = (LOOP_OVERHEAD + int(regs.size()) * (1 + reload) + int(mems.size()) * (reload - 1)) * gGlobal->gVecSize;
+
+        // The vectorizable loop fused with a recursive one is no longer vectorized
+        if (p->fIsRecursive != c->fIsRecursive) {
+            const LoopCost& vectorizable = (p->fIsRecursive) ? cc : pc;
+            loss = vectorizable.fCost * gGlobal->gVecSize * (SIMD_WIDTH - 1) / SIMD_WIDTH;
+        } else {
+            loss = 0;
+        }
+
+        if (fParallel) {
+            gain += TASK_OVERHEAD;
+            loss += min(pc.fCost, others) * gGlobal->gVecSize;
+        }
+    }
+
+    void dumpVectors(const string& label, const set<string>& vectors)
+    {
+        if (vectors.size() > 0) {
+            *fDump << ", " << label << " :";
+            for (auto& it : vectors) {
+                *fDump << " " << it;
+            }
+        }
+    }
+
+    // Fuse the most profitable producers of 'c', returns true if some have been fused
+    bool fuseProducers(CodeLoop* c, map<CodeLoop*, int>& consumers)
+    {
+        bool fused = false;
+        while (true) {
+            // The two higher costs of the dependencies of 'c'
+            CodeLoop* first  = nullptr;
+            int       cost1  = 0;
+            int       cost2  = 0;
+            for (auto& d : c->fBackwardLoopDependencies) {
+                int cost = fCosts[d].fCost;
+                if (!first || cost > cost1) {
+                    cost2 = cost1;
+                    cost1 = cost;
+                    first = d;
+                } else if (cost > cost2) {
+                    cost2 = cost;
+                }
+            }
+
+            CodeLoop*   best       = nullptr;
+            int         best_score = 0;
+            int         best_gain  = 0;
+            int         best_loss  = 0;
+            set<string> best_regs, best_mems;
+            for (auto& p : c->fBackwardLoopDependencies) {
+                if (!canFuse(p, c, consumers)) continue;
+                int         gain, loss;
+                set<string> regs, mems;
+                evaluate(p, c, (p == first) ? cost2 : cost1, gain, loss, regs, mems);
+                if (gain - loss > best_score) {
+                    best       = p;
+                    best_score = gain - loss;
+                    best_gain  = gain;
+                    best_loss  = loss;
+                    best_regs  = regs;
+                    best_mems  = mems;
+                }
+            }
+            if (!best) return fused;
+
+            LoopCost& pc = fCosts[best];
+            LoopCost& cc = fCosts[c];
+            if (fDump) {
+                *fDump << "  fuse " << pc.fName << " in " << cc.fName << " : gain " << best_gain << ", loss "
+                       << best_loss;
+                dumpVectors("in registers", best_regs);
+                dumpVectors("in cache", best_mems);
+                *fDump << endl;
+            }
+
+            // The dependencies of the producer are now used by 'c'
+            for (auto& d : best->fBackwardLoopDependencies) {
+                if (c->fBackwardLoopDependencies.find(d) != c->fBackwardLoopDependencies.end()) {
+                    consumers[d]--;
+                }
+            }
+            c->fuse(best);
+            cc.fName = cc.fName + "+" + pc.fName;
+            cc.fCost += pc.fCost;
+            LoopCost::merge(cc.fAccesses, pc.fAccesses);
+            LoopCost::merge(cc.fIndexed, pc.fIndexed);
+            LoopCost::merge(cc.fStored, pc.fStored);
+            for (auto& it : pc.fAccesses) {
+                fUsers[it.first].erase(best);
+                fUsers[it.first].insert(c);
+            }
+            fCosts.erase(best);
+            fused = true;
+        }
+    }
+
+   public:
+    LoopFusion(const map<string, Typed*>& vectors, bool parallel, ostream* dump)
+        : fVectors(vectors), fParallel(parallel), fDump(dump)
+    {
+    }
+
+    void run(CodeLoop* root)
+    {
+        // Loops are numbered as in the generated code and the task graph
+        lclgraph G;
+        CodeLoop::sortGraph(root, G);
+        int lnum = 0;
+        for (int l = int(G.size() - 1); l >= 0; l--) {
+            for (auto& p : G[l]) {
+                analyze(p, "L" + std::to_string(lnum++));
+            }
+        }
+
+        map<CodeLoop*, int> consumers;
+        set<CodeLoop*>      loops;
+        collectLoops(root, loops, consumers);
+        for (auto& p : loops) {
+            if (fCosts.find(p) == fCosts.end()) {
+                analyze(p, "L" + std::to_string(lnum++));
+            }
+        }
+
+        if (fDump) {
+            *fDump << "Loop fusion (" << ((fParallel) ? "tasks" : "loops") << ", vector size " << gGlobal->gVecSize
+                   << ") :" << endl;
+        }
+
+        // Producers first, until no more loops can be fused
+        bool fused;
+        do {
+            fused = false;
+            consumers.clear();
+            loops.clear();
+            collectLoops(root, loops, consumers);
+            CodeLoop::sortGraph(root, G);
+            for (int l = int(G.size() - 1); l >= 0; l--) {
+                for (auto& c : G[l]) {
+                    fused |= fuseProducers(c, consumers);
+                }
+            }
+        } while (fused);
+
+        if (fDump) {
+            for (int l = int(G.size() - 1); l >= 0; l--) {
+                for (auto& c : G[l]) {
+                    const LoopCost& cc = fCosts[c];
+                    for (auto& p : c->fBackwardLoopDependencies) {
+                        if (!canFuse(p, c, consumers)) continue;
+                        int         gain, loss, others = 0;
+                        set<string> regs, mems;
+                        for (auto& d : c->fBackwardLoopDependencies) {
+                            if (d != p) others = max(others, fCosts[d].fCost);
+                        }
+                        evaluate(p, c, others, gain, loss, regs, mems);
+                        *fDump << "  keep " << fCosts[p].fName << " before " << cc.fName << " : gain " << gain
+                               << ", loss " << loss << endl;
+                    }
+                }
+            }
+            for (int l = int(G.size() - 1); l >= 0; l--) {
+                for (auto& c : G[l]) {
+                    const LoopCost& cc = fCosts[c];
+                    *fDump << "  " << ((fParallel) ? "task " : "loop ") << cc.fName << " : cost "
+                           << cc.fCost * gGlobal->gVecSize << ((c->fIsRecursive) ? ", recursive" : ", vectorizable")
+                           << endl;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Fuse producer loops in their consumer when the cost model estimates it is profitable
+ * @param vectors the intermediate vectors (with their type) that can be kept in registers
+ * @param parallel whether loops are computed as parallel tasks
+ * @param dump where to print the decisions (or nullptr)
+ */
+void CodeLoop::fuseLoops(CodeLoop* root, const map<string, Typed*>& vectors, bool parallel, ostream* dump)
+{
+    LoopFusion fusion(vectors, parallel, dump);
+    fusion.run(root);
+}
+
+static void collectAllLoops(CodeLoop* l, list<CodeLoop*>& loops, set<CodeLoop*>& visited)
+{
+    if (visited.insert(l).second) {
+        for (auto& p : l->getBackwardLoopDependencies()) {
+            collectAllLoops(p, loops, visited);
+        }
+        loops.push_back(l);
+    }
+}
+
+/**
+ * Keep in registers the intermediate vectors only written and read in the same loop at the loop index
+ * @param vectors the intermediate vectors with their type
+ * @param scalars the vectors kept in registers, that are no longer used
+ * @param dump where to print the decisions (or nullptr)
+ */
+void CodeLoop::scalarizeVectors(CodeLoop* root, const map<string, Typed*>& vectors, set<string>& scalars,
+                                ostream* dump)
+{
+    list<CodeLoop*> loops;
+    set<CodeLoop*>  visited;
+    collectAllLoops(root, loops, visited);
+
+    // Loops accessing each vector
+    list<LoopVarCollector>            collector_list;
+    map<CodeLoop*, LoopVarCollector*> collectors;
+    map<string, int>                  users;
+    for (auto& l : loops) {
+        collector_list.emplace_back(l->fLoopIndex);
+        LoopVarCollector* collector = &collector_list.back();
+        l->fPreInst->accept(collector);
+        l->fComputeInst->accept(collector);
+        l->fPostInst->accept(collector);
+        for (auto& l1 : l->fExtraLoops) {
+            l1->fPreInst->accept(collector);
+            l1->fComputeInst->accept(collector);
+            l1->fPostInst->accept(collector);
+            // vectors of grouped loops stay in memory
+            collector->fIndexed.clear();
+        }
+        collectors[l] = collector;
+        for (auto& it : collector->fAccesses) {
+            users[it.first]++;
+        }
+    }
+
+    for (auto& l : loops) {
+        LoopVarCollector*            collector = collectors[l];
+        map<string, DeclareVarInst*> loop_scalars;
+        for (auto& it : l->fComputeInst->fCode) {
+            // The vector is written once, by a statement of the loop itself, and only read at the loop index
+            StoreVarInst* store = dynamic_cast<StoreVarInst*>(it);
+            if (!store || !dynamic_cast<IndexedAddress*>(store->fAddress)) continue;
+            string name = store->fAddress->getName();
+            auto   vec  = vectors.find(name);
+            if (vec != vectors.end() && users[name] == 1 && collector->fStored[name] == 1 &&
+                collector->fAccesses[name] == collector->fIndexed[name]) {
+                string scalar      = name.substr(0, 1) + gGlobal->getFreshID("Temp");
+                loop_scalars[name] = InstBuilder::genDecStackVar(scalar, vec->second);
+                scalars.insert(name);
+                if (dump) {
+                    *dump << "  vector " << name << " in register " << scalar << endl;
+                }
+            }
+        }
+        if (loop_scalars.size() > 0) {
+            VectorScalarizer scalarizer(loop_scalars);
+            l->fComputeInst = static_cast<BlockInst*>(l->fComputeInst->clone(&scalarizer));
+        }
+    }
+}
+
+/*
+ Vector math (-vm mode): the math functions called in a non recursive loop are computed once per vector by the
+ functions of 'faust/dsp/vecmath.h'. The loop is split in a chain of loops, each one computing the arguments of a
+ batch of calls in vectors, the batch being called in its post code. The following loops read the result vectors.
+ Statements are placed in the first loop where the variables they read are available, and the loop scalars used
+ across several loops are kept in vectors.
+*/
+
+// Function of the vector math library
+struct VectorMathFunction {
+    string         fName;
+    int            fArity;
+    Typed::VarType fType;
+};
+
+static const map<string, VectorMathFunction>& vectorMathFunctions()
+{
+    // Built once by the static initialization, which is thread safe, since several compilations can run concurrently
+    static const map<string, VectorMathFunction> functions = [] {
+        map<string, VectorMathFunction> table;
+        for (const char* name : {"exp", "exp2", "exp10", "log", "log2", "log10", "sin", "cos", "tan", "tanh"}) {
+            table[string(name) + "f"] = {string("vec_") + name + "f", 1, Typed::kFloat};
+            table[name]               = {string("vec_") + name, 1, Typed::kDouble};
+        }
+        table["powf"] = {"vec_powf", 2, Typed::kFloat};
+        table["pow"]  = {"vec_pow", 2, Typed::kDouble};
+        return table;
+    }();
+    return functions;
+}
+
+class MathVectorizer {
+   private:
+    const map<string, Typed*>& fVectors;  // intermediate vectors that can directly be given to the library
+    list<DeclareVarInst*>&     fDecls;    // the new vectors
+    bool                       fOMP;
+    ostream*                   fDump;
+    map<string, int>           fArities;
+
+    // State of the loop being split
+    string                fIndex;
+    map<string, int>      fReady;   // first segment where a variable written in the loop is available
+    map<string, int>      fLast;    // last segment where a variable is accessed
+    map<string, int>      fScalars; // segment where a loop scalar is declared
+    map<string, set<int>> fUses;    // segments where a loop scalar is read
+    vector<BlockInst*>    fSegments;
+    vector<BlockInst*>    fBatches;
+    int                   fArguments;
+
+    static int get(const map<string, int>& vars, const string& name)
+    {
+        auto it = vars.find(name);
+        return (it != vars.end()) ? it->second : 0;
+    }
+
+    BlockInst* segment(int k)
+    {
+        while (int(fSegments.size()) <= k) {
+            fSegments.push_back(InstBuilder::genBlockInst());
+            fBatches.push_back(InstBuilder::genBlockInst());
+        }
+        return fSegments[k];
+    }
+
+    string declareVector(Typed* type)
+    {
+        string name = "f" + gGlobal->getFreshID("Zec");
+        fDecls.push_back(InstBuilder::genDecStackVar(name, InstBuilder::genArrayTyped(type, gGlobal->gVecSize)));
+        return name;
+    }
+
+    // The variables read by 'inst' in segment 'k'
+    void read(ValueInst* inst, int k)
+    {
+        LoopVarCollector collector(fIndex);
+        inst->accept(&collector);
+        for (auto& it : collector.fAccesses) {
+            fLast[it.first] = max(get(fLast, it.first), k);
+            if (fScalars.find(it.first) != fScalars.end()) {
+                fUses[it.first].insert(k);
+            }
+        }
+    }
+
+    // The first segment where all the variables read by 'inst' are available
+    int ready(ValueInst* inst)
+    {
+        LoopVarCollector collector(fIndex);
+        inst->accept(&collector);
+        int k = 0;
+        for (auto& it : collector.fAccesses) {
+            k = max(k, get(fReady, it.first));
+        }
+        return k;
+    }
+
+    // Only statements writing arrays at the loop index (and only accessed at it) or declaring loop scalars
+    bool isVectorizable(CodeLoop* l)
+    {
+        if (l->fIsRecursive || !l->fExtraLoops.empty()) return false;
+        LoopVarCollector collector(l->fLoopIndex);
+        l->fPreInst->accept(&collector);
+        l->fComputeInst->accept(&collector);
+        l->fPostInst->accept(&collector);
+        for (auto& it : l->fComputeInst->fCode) {
+            StoreVarInst*   store = dynamic_cast<StoreVarInst*>(it);
+            DeclareVarInst* dec   = dynamic_cast<DeclareVarInst*>(it);
+            if (store) {
+                IndexedAddress* indexed = dynamic_cast<IndexedAddress*>(store->fAddress);
+                string          name    = store->fAddress->getName();
+                if (!indexed || !collector.isLoopIndex(indexed->fIndex) ||
+                    collector.fAccesses[name] != collector.fIndexed[name]) {
+                    return false;
+                }
+            } else if (!dec || dec->fAddress->getAccess() != Address::kStack || !dec->fValue) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Place the calls extracted from a statement in their segment, returns the segment of the statement
+    int placeCalls(MathCallExtractor& extractor, size_t first, vector<int>& levels)
+    {
+        for (size_t c = first; c < extractor.fCalls.size(); c++) {
+            MathCallExtractor::Call&  call = extractor.fCalls[c];
+            const VectorMathFunction& fun  = vectorMathFunctions().at(call.fName);
+
+            // Arguments are computed once the nested calls are done and the variables they read are available
+            int level = 0;
+            for (auto& n : call.fNested) {
+                level = max(level, levels[n] + 1);
+            }
+            for (auto& arg : call.fArgs) {
+                level = max(level, ready(arg));
+            }
+            levels.push_back(level);
+            segment(level);
+
+            list<ValueInst*> args;
+            args.push_back(InstBuilder::genLoadLoopVar("vsize"));
+            for (auto& arg : call.fArgs) {
+                // Vectors read at the loop index are directly given, but must not be written before the call
+                LoadVarInst*    load    = dynamic_cast<LoadVarInst*>(arg);
+                IndexedAddress* indexed = (load) ? dynamic_cast<IndexedAddress*>(load->fAddress) : nullptr;
+                string          name    = (indexed) ? indexed->getName() : "";
+                auto            vec     = fVectors.find(name);
+                BasicTyped*     type    = (vec != fVectors.end()) ? dynamic_cast<BasicTyped*>(vec->second) : nullptr;
+                bool            result  = false;
+                for (size_t r = 0; r < extractor.fCalls.size(); r++) {
+                    result |= (r != c && extractor.fCalls[r].fResult == name);
+                }
+                if (indexed && LoopVarCollector(fIndex).isLoopIndex(indexed->fIndex) &&
+                    (result || (type && type->fType == fun.fType))) {
+                    fLast[name] = max(get(fLast, name), level + 1);
+                    args.push_back(InstBuilder::genLoadStackVar(name));
+                } else {
+                    string tmp = declareVector(InstBuilder::genBasicTyped(fun.fType));
+                    fSegments[level]->pushBackInst(
+                        InstBuilder::genStoreArrayStackVar(tmp, InstBuilder::genLoadLoopVar(fIndex), arg));
+                    read(arg, level);
+                    args.push_back(InstBuilder::genLoadStackVar(tmp));
+                    fArguments++;
+                }
+            }
+            fDecls.push_back(InstBuilder::genDecStackVar(
+                call.fResult, InstBuilder::genArrayTyped(InstBuilder::genBasicTyped(fun.fType), gGlobal->gVecSize)));
+            args.push_back(InstBuilder::genLoadStackVar(call.fResult));
+            fBatches[level]->pushBackInst(InstBuilder::genVoidFunCallInst(fun.fName, args));
+        }
+
+        int k = 0;
+        for (auto& c : extractor.fOuter) {
+            k = max(k, levels[c] + 1);
+        }
+        return k;
+    }
+
+    // Split the loop, returns the number of calls
+    int split(CodeLoop* l)
+    {
+        fIndex = l->fLoopIndex;
+        fReady.clear();
+        fLast.clear();
+        fScalars.clear();
+        fUses.clear();
+        fSegments.clear();
+        fBatches.clear();
+        fArguments = 0;
+        segment(0);
+
+        MathCallExtractor extractor(fArities, fIndex);
+        vector<int>       levels;
+        for (auto& it : l->fComputeInst->fCode) {
+            size_t first = extractor.fCalls.size();
+            extractor.fOuter.clear();
+            StatementInst* inst = static_cast<StatementInst*>(it->clone(&extractor));
+
+            StoreVarInst*   store = dynamic_cast<StoreVarInst*>(inst);
+            DeclareVarInst* dec   = dynamic_cast<DeclareVarInst*>(inst);
+            ValueInst*      value = (store) ? store->fValue : dec->fValue;
+            string          name  = (store) ? store->fAddress->getName() : dec->fAddress->getName();
+
+            // After its calls, once the variables it reads are available, and after the previous accesses
+            // of the written variable
+            int k = max(max(placeCalls(extractor, first, levels), ready(value)), get(fLast, name));
+            segment(k)->pushBackInst(inst);
+            read(value, k);
+            fReady[name] = k;
+            fLast[name]  = max(get(fLast, name), k);
+            if (dec) {
+                fScalars[name] = k;
+            }
+        }
+        if (extractor.fCalls.empty()) return 0;
+
+        // Loop scalars read in other segments are kept in vectors
+        map<string, string> spilled;
+        for (auto& it : l->fComputeInst->fCode) {
+            DeclareVarInst* dec = dynamic_cast<DeclareVarInst*>(it);
+            if (!dec) continue;
+            string name = dec->fAddress->getName();
+            for (auto& k : fUses[name]) {
+                if (k != fScalars[name]) {
+                    BasicCloneVisitor cloner;
+                    spilled[name] = declareVector(dec->fType->clone(&cloner));
+                    break;
+                }
+            }
+        }
+        if (spilled.size() > 0) {
+            ScalarVectorizer vectorizer(spilled, fIndex);
+            for (auto& segment : fSegments) {
+                segment = static_cast<BlockInst*>(segment->clone(&vectorizer));
+            }
+        }
+
+        // A chain of loops, each one ending with a batch of calls
+        BlockInst* code = InstBuilder::genBlockInst();
+        CodeLoop*  prev = nullptr;
+        int        num  = 0;
+        for (size_t k = 0; k < fSegments.size(); k++) {
+            code->fCode.insert(code->fCode.end(), fSegments[k]->fCode.begin(), fSegments[k]->fCode.end());
+            if (fBatches[k]->fCode.empty()) continue;
+            CodeLoop* loop     = new CodeLoop(l->fEnclosingLoop, fIndex, l->fSize);
+            loop->fComputeInst = code;
+            // In -omp mode, the batch is computed by a single thread
+            if (fOMP && fBatches[k]->fCode.size() > 1) {
+                fBatches[k]->setIndent(true);
+                loop->fPostInst->pushBackInst(fBatches[k]);
+            } else {
+                loop->fPostInst = fBatches[k];
+            }
+            if (prev) {
+                loop->fBackwardLoopDependencies.insert(prev);
+            } else {
+                loop->fPreInst                  = l->fPreInst;
+                loop->fBackwardLoopDependencies = l->fBackwardLoopDependencies;
+                l->fPreInst                     = InstBuilder::genBlockInst();
+            }
+            prev = loop;
+            code = InstBuilder::genBlockInst();
+            num++;
+        }
+        l->fComputeInst = code;
+        l->fBackwardLoopDependencies.clear();
+        l->fBackwardLoopDependencies.insert(prev);
+
+        if (fDump) {
+            *fDump << " : " << extractor.fCalls.size() << " calls in " << num << " batches, " << fArguments
+                   << " arguments in vectors";
+            if (spilled.size() > 0) {
+                *fDump << ", scalars in vectors :";
+                for (auto& it : spilled) {
+                    *fDump << " " << it.first;
+                }
+            }
+            *fDump << endl;
+        }
+        return int(extractor.fCalls.size());
+    }
+
+   public:
+    MathVectorizer(const map<string, Typed*>& vectors, list<DeclareVarInst*>& decls, bool omp, ostream* dump)
+        : fVectors(vectors), fDecls(decls), fOMP(omp), fDump(dump)
+    {
+        for (auto& it : vectorMathFunctions()) {
+            fArities[it.first] = it.second.fArity;
+        }
+    }
+
+    void run(CodeLoop* root)
+    {
+        if (fDump) {
+            *fDump << "Vector math (vector size " << gGlobal->gVecSize << ") :" << endl;
+        }
+
+        // Loops are numbered as in the generated code
+        lclgraph G;
+        CodeLoop::sortGraph(root, G);
+        int lnum = 0;
+        for (int l = int(G.size() - 1); l >= 0; l--) {
+            for (auto& p : G[l]) {
+                if (fDump) *fDump << "  loop L" << lnum++;
+                if (!isVectorizable(p)) {
+                    if (fDump) *fDump << " : " << ((p->fIsRecursive) ? "recursive" : "kept") << endl;
+                } else if (split(p) == 0 && fDump) {
+                    *fDump << " : no math calls" << endl;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Compute the math functions of the non recursive loops once per vector with the vector math library
+ * @param vectors the intermediate vectors (with their type) that can be given to the library
+ * @param decls the declarations of the new vectors
+ * @param omp whether the loops are computed with OpenMP
+ * @param dump where to print the decisions (or nullptr)
+ */
+void CodeLoop::vectorizeMath(CodeLoop* root, const map<string, Typed*>& vectors, list<DeclareVarInst*>& decls, bool omp,
+                             ostream* dump)
+{
+    MathVectorizer vectorizer(vectors, decls, omp, dump);
+    vectorizer.run(root);
+}
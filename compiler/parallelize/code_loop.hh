@@ -61,6 +61,8 @@ typedef vector<lclset> lclgraph;
 
 class CodeLoop : public virtual Garbageable {
     friend class CodeContainer;
+    friend class LoopFusion;
+    friend class MathVectorizer;
 
    private:
     bool            fIsRecursive;    ///< recursive loops can't be SIMDed
@@ -95,6 +97,7 @@ class CodeLoop : public virtual Garbageable {
 
     void absorb(CodeLoop* l);  ///< absorb a loop inside this one
     void concat(CodeLoop* l);
+    void fuse(CodeLoop* l);  ///< fuse a producer loop in this one
 
     // Graph sorting
     static void setOrder(CodeLoop* l, int order, lclgraph& V);
@@ -184,6 +187,11 @@ class CodeLoop : public virtual Garbageable {
     static void sortGraph(CodeLoop* root, lclgraph& V);
     static void computeUseCount(CodeLoop* l);
     static void groupSeqLoops(CodeLoop* l, set<CodeLoop*>& visited);
+    static void fuseLoops(CodeLoop* root, const map<string, Typed*>& vectors, bool parallel, ostream* dump);
+    static void scalarizeVectors(CodeLoop* root, const map<string, Typed*>& vectors, set<string>& scalars,
+                                 ostream* dump);
+    static void vectorizeMath(CodeLoop* root, const map<string, Typed*>& vectors, list<DeclareVarInst*>& decls, bool omp,
+                              ostream* dump);
 };
 
 #endif
@@ -0,0 +1,533 @@
+/************************************************************************
+ ************************************************************************
+ FAUST compiler
+ Copyright (C) 2003-2020 GRAME, Centre National de Creation Musicale
+ ---------------------------------------------------------------------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ ************************************************************************
+ ************************************************************************/
+
+/*
+ librarycache : persistent cache of parsed library files
+
+ Entry layout (native byte order, the cache is local to a machine):
+
+    "FLIB" <format version> <SHA1 of the file content> <file modification seconds> <nanoseconds> <file size>
+    <node count> { <node kind> <int | double | name | primitive index> <arity> <branch index>* }*
+    <root index>
+    <metadata count> { <key index> <value index> }*
+    <property count> { <tree index> <property kind> <value index> }*
+
+ Nodes are kept in creation order (branches before their tree), so that the hash-consed trees
+ are rebuilt with a single pass.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "boxes.hh"
+#include "enrobage.hh"
+#include "export.hh"
+#include "librarycache.hh"
+#include "libfaust.h"
+#include "list.hh"
+#include "signals.hh"
+
+using namespace std;
+
+#define LIBRARY_CACHE_EXTENSION ".flib"
+#define LIBRARY_CACHE_MAGIC "FLIB"
+#define LIBRARY_CACHE_FORMAT 2
+#define LIBRARY_CACHE_STAMP_OFFSET (4 + sizeof(unsigned) + 40)
+
+// A file modified less than this number of seconds before it is stamped may be modified again with the same
+// modification time and size: its stamp is not kept, so that it is checked by content
+#define LIBRARY_CACHE_RACY_DELAY 2
+
+enum { kCacheInt, kCacheDouble, kCacheSym, kCachePrim };
+enum { kCacheDefLine, kCacheUseLine };
+
+/**
+ * The primitives the parser builds boxes of: their pointer nodes are kept as an index in this list.
+ */
+static void* const gParserPrimitives[] = {
+    (void*)prim1(sigDelay1),      (void*)prim1(sigFloatCast),     (void*)prim1(sigIntCast),
+    (void*)prim2(sigAND),         (void*)prim2(sigAdd),           (void*)prim2(sigAttach),
+    (void*)prim2(sigControl),     (void*)prim2(sigDiv),           (void*)prim2(sigEQ),
+    (void*)prim2(sigEnable),      (void*)prim2(sigFixDelay),      (void*)prim2(sigGE),
+    (void*)prim2(sigGT),          (void*)prim2(sigLE),            (void*)prim2(sigLT),
+    (void*)prim2(sigLeftShift),   (void*)prim2(sigMul),           (void*)prim2(sigNE),
+    (void*)prim2(sigOR),          (void*)prim2(sigPrefix),        (void*)prim2(sigRem),
+    (void*)prim2(sigRightShift),  (void*)prim2(sigSub),           (void*)prim2(sigXOR),
+    (void*)prim3(sigReadOnlyTable), (void*)prim3(sigSelect2),     (void*)prim4(sigSelect3),
+    (void*)prim5(sigWriteReadTable)};
+
+static const unsigned gParserPrimitivesCount = sizeof(gParserPrimitives) / sizeof(gParserPrimitives[0]);
+
+static unsigned parserPrimitive(void* p)
+{
+    return unsigned(find(gParserPrimitives, gParserPrimitives + gParserPrimitivesCount, p) - gParserPrimitives);
+}
+
+template <typename T>
+static void writeValue(string& out, T x)
+{
+    out.append((const char*)&x, sizeof(T));
+}
+
+/**
+ * Serialize trees as a DAG, each tree being written once after its branches.
+ */
+class TreeEncoder {
+    private:
+        unordered_map<Tree, unsigned> fIndex;
+        vector<pair<Tree, bool>>      fStack;
+        vector<Tree>        fOrder;
+
+    public:
+        // Add t and its subtrees, return false if a pointer node cannot be kept
+        bool add(Tree t)
+        {
+            fStack.push_back(make_pair(t, false));
+            while (!fStack.empty()) {
+                Tree cur   = fStack.back().first;
+                bool ready = fStack.back().second;
+                fStack.pop_back();
+                if (fIndex.count(cur)) continue;
+                if (ready) {
+                    if (cur->node().type() == kPointerNode &&
+                        parserPrimitive(cur->node().getPointer()) == gParserPrimitivesCount) {
+                        fStack.clear();
+                        return false;
+                    }
+                    fIndex[cur] = unsigned(fOrder.size());
+                    fOrder.push_back(cur);
+                } else {
+                    fStack.push_back(make_pair(cur, true));
+                    for (int i = cur->arity() - 1; i >= 0; i--) {
+                        if (!fIndex.count(cur->branch(i))) fStack.push_back(make_pair(cur->branch(i), false));
+                    }
+                }
+            }
+            return true;
+        }
+
+        const vector<Tree>& trees() { return fOrder; }
+
+        // Index of an added tree, valid once written
+        unsigned index(Tree t) { return fIndex[t]; }
+
+        void write(string& out)
+        {
+            // Trees are rebuilt in their creation order (which is also topological), so that
+            // code generation, sensitive to this order, gives the same result as after parsing
+            sort(fOrder.begin(), fOrder.end(), [](Tree a, Tree b) { return a->serial() < b->serial(); });
+            for (size_t i = 0; i < fOrder.size(); i++) {
+                fIndex[fOrder[i]] = unsigned(i);
+            }
+
+            writeValue(out, unsigned(fOrder.size()));
+            for (Tree t : fOrder) {
+                const Node& n = t->node();
+                switch (n.type()) {
+                    case kIntNode:
+                        writeValue(out, char(kCacheInt));
+                        writeValue(out, n.getInt());
+                        break;
+                    case kDoubleNode:
+                        writeValue(out, char(kCacheDouble));
+                        writeValue(out, n.getDouble());
+                        break;
+                    case kSymNode: {
+                        const char* s = name(n.getSym());
+                        writeValue(out, char(kCacheSym));
+                        writeValue(out, unsigned(strlen(s)));
+                        out.append(s, strlen(s));
+                        break;
+                    }
+                    default:
+                        writeValue(out, char(kCachePrim));
+                        writeValue(out, parserPrimitive(n.getPointer()));
+                        break;
+                }
+                writeValue(out, unsigned(t->arity()));
+                for (int i = 0; i < t->arity(); i++) {
+                    writeValue(out, fIndex[t->branch(i)]);
+                }
+            }
+        }
+};
+
+/**
+ * Read values from a mapped entry, checking the bounds.
+ */
+class EntryReader {
+    private:
+        const char* fPos;
+        const char* fEnd;
+
+    public:
+        EntryReader(const char* data, size_t size) : fPos(data), fEnd(data + size) {}
+
+        template <typename T>
+        bool read(T& x)
+        {
+            if (size_t(fEnd - fPos) < sizeof(T)) return false;
+            memcpy(&x, fPos, sizeof(T));
+            fPos += sizeof(T);
+            return true;
+        }
+
+        bool read(string& s, size_t size)
+        {
+            if (size_t(fEnd - fPos) < size) return false;
+            s.assign(fPos, size);
+            fPos += size;
+            return true;
+        }
+
+        bool readIndex(unsigned& x, size_t count) { return read(x) && x < count; }
+
+        // Read a number of items of at least 'item_size' bytes each, that must fit in the remaining bytes
+        bool readCount(unsigned& x, size_t item_size) { return read(x) && x <= size_t(fEnd - fPos) / item_size; }
+};
+
+static string readContent(FILE* file)
+{
+    string content;
+    char   buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, size);
+    }
+    return content;
+}
+
+// Write in a temporary file then rename it, so that a concurrent reader never sees a partial entry
+// (the name is unique among the threads of all processes sharing the cache directory)
+static void writeEntry(const string& path, const string& out)
+{
+    string tmp = path + "." + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    {
+        ofstream writer(tmp.c_str(), ios::out | ios::binary);
+        if (!writer.is_open()) return;
+        writer.write(out.data(), out.size());
+        if (!writer.good()) {
+            writer.close();
+            remove(tmp.c_str());
+            return;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+    }
+}
+
+string LibraryCache::getDirectory()
+{
+#if defined(_WIN32) || defined(EMCC)
+    return "";
+#else
+    const char* dir = getenv("FAUST_LIB_CACHE");
+    return (dir && dir[0]) ? string(dir) : "";
+#endif
+}
+
+#ifndef _WIN32
+// Modification time and size of an open file, or all 0 if too recent to be trusted
+static void fileStamp(int fd, int64_t stamp[3])
+{
+    struct stat st;
+    stamp[0] = stamp[1] = stamp[2] = 0;
+    if (fstat(fd, &st) != 0 || st.st_mtime + LIBRARY_CACHE_RACY_DELAY > time(nullptr)) return;
+    stamp[0] = int64_t(st.st_mtime);
+#if defined(__APPLE__)
+    stamp[1] = int64_t(st.st_mtimespec.tv_nsec);
+#else
+    stamp[1] = int64_t(st.st_mtim.tv_nsec);
+#endif
+    stamp[2] = int64_t(st.st_size);
+}
+#endif
+
+LibraryCache::LibraryCache(const char* fname)
+    : fLoaded(false), fSerial(0), fDocSize(0), fLstDependencies(false), fLstDistributed(false), fStripDoc(false)
+{
+    fStamp[0] = fStamp[1] = fStamp[2] = 0;
+    string dir = getDirectory();
+    // The DSP file itself is not cached (it is also parsed differently), neither are URLs
+    if (dir == "" || gGlobal->gInputString || gGlobal->gMasterDocument == fname || strstr(fname, "http://") ||
+        strstr(fname, "https://")) {
+        return;
+    }
+    fFileName = (strstr(fname, "file://")) ? &fname[7] : fname;
+
+    // The file is only located and stamped here, its content is read if the cache entry cannot be used
+    FILE* file = fopenSearch(fFileName.c_str(), fFullPath);
+    if (!file) return;
+#ifndef _WIN32
+    fileStamp(fileno(file), fStamp);
+#endif
+    fclose(file);
+
+    // The parser output depends on the float size (foreign functions)
+    fPath = dir + "/" + generateSHA1(fFullPath + "#" + fFileName + "#" + to_string(gGlobal->gFloatSize) + FAUSTVERSION) +
+            LIBRARY_CACHE_EXTENSION;
+}
+
+void LibraryCache::load()
+{
+    if (fLoaded) return;
+    fLoaded    = true;
+    FILE* file = fopen(fFullPath.c_str(), "r");
+    if (file) {
+        fContent = readContent(file);
+        fclose(file);
+    }
+    fHash = generateSHA1(fContent);
+}
+
+bool LibraryCache::decode(const char* data, size_t size, Tree& ldef)
+{
+    EntryReader reader(data, size);
+    string      magic, hash;
+    unsigned    format;
+    int64_t     stamp[3];
+    if (!reader.read(magic, 4) || magic != LIBRARY_CACHE_MAGIC || !reader.read(format) ||
+        format != LIBRARY_CACHE_FORMAT || !reader.read(hash, 40) || !reader.read(stamp[0]) ||
+        !reader.read(stamp[1]) || !reader.read(stamp[2])) {
+        return false;
+    }
+    // An unchanged stamp avoids reading and hashing the file, otherwise the content is compared
+    bool stamped = fStamp[2] != 0 && memcmp(stamp, fStamp, sizeof(stamp)) == 0;
+    if (!stamped) {
+        load();
+        if (hash != fHash) return false;
+    }
+
+    // Rebuild the trees, counts are checked against the remaining bytes before allocating
+    // (a tree takes at least a kind, a 4 bytes value and its arity, a branch or an index 4 bytes)
+    vector<Tree> trees;
+    unsigned     count;
+    if (!reader.readCount(count, 9)) return false;
+    trees.reserve(count);
+    for (unsigned i = 0; i < count; i++) {
+        char     kind;
+        Node     node(0);
+        unsigned arity;
+        if (!reader.read(kind)) return false;
+        if (kind == kCacheInt) {
+            int x;
+            if (!reader.read(x)) return false;
+            node = Node(x);
+        } else if (kind == kCacheDouble) {
+            double x;
+            if (!reader.read(x)) return false;
+            node = Node(x);
+        } else if (kind == kCacheSym) {
+            unsigned length;
+            string   s;
+            if (!reader.read(length) || !reader.read(s, length)) return false;
+            node = Node(symbol(s));
+        } else if (kind == kCachePrim) {
+            unsigned p;
+            if (!reader.readIndex(p, gParserPrimitivesCount)) return false;
+            node = Node(gParserPrimitives[p]);
+        } else {
+            return false;
+        }
+        if (!reader.readCount(arity, 4)) return false;
+        tvec branches(arity);
+        for (unsigned j = 0; j < arity; j++) {
+            unsigned b;
+            if (!reader.readIndex(b, i)) return false;
+            branches[j] = trees[b];
+        }
+        trees.push_back(CTree::make(node, branches));
+    }
+
+    unsigned root;
+    if (!reader.readIndex(root, trees.size())) return false;
+
+    // Read the side effects before replaying them, so that a truncated entry has no effect
+    vector<pair<Tree, Tree>>            metadata;
+    vector<pair<Tree, pair<int, Tree>>> properties;
+    if (!reader.readCount(count, 8)) return false;
+    for (unsigned i = 0; i < count; i++) {
+        unsigned key, value;
+        if (!reader.readIndex(key, trees.size()) || !reader.readIndex(value, trees.size())) return false;
+        metadata.push_back(make_pair(trees[key], trees[value]));
+    }
+    if (!reader.readCount(count, 9)) return false;
+    for (unsigned i = 0; i < count; i++) {
+        unsigned t, value;
+        char     kind;
+        if (!reader.readIndex(t, trees.size()) || !reader.read(kind) || !reader.readIndex(value, trees.size())) {
+            return false;
+        }
+        properties.push_back(make_pair(trees[t], make_pair(int(kind), trees[value])));
+    }
+
+    for (auto& m : metadata) {
+        gGlobal->gMetaDataSet[m.first].insert(m.second);
+    }
+    for (auto& p : properties) {
+        setProperty(p.first, (p.second.first == kCacheDefLine) ? gGlobal->DEFLINEPROP : gGlobal->USELINEPROP,
+                    p.second.second);
+    }
+    if (!stamped) restamp(data, size);
+    ldef = trees[root];
+    return true;
+}
+
+bool LibraryCache::read(Tree& ldef)
+{
+#ifdef _WIN32
+    return false;
+#else
+    if (fPath == "") return false;
+
+    int fd = open(fPath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    bool res = decode((const char*)data, size_t(st.st_size), ldef);
+    munmap(data, size_t(st.st_size));
+    return res;
+#endif
+}
+
+// Write the entry again with the current stamp of the file, when its content has not changed
+void LibraryCache::restamp(const char* data, size_t size)
+{
+    if (fStamp[2] == 0) return;
+    string out(data, size);
+    out.replace(LIBRARY_CACHE_STAMP_OFFSET, sizeof(fStamp), (const char*)fStamp, sizeof(fStamp));
+    writeEntry(fPath, out);
+}
+
+void LibraryCache::prepare()
+{
+    if (fPath == "") return;
+    fSerial          = CTree::serialCounter();
+    fMetaDataSet     = gGlobal->gMetaDataSet;
+    fDocSize         = gGlobal->gDocVector.size();
+    fLstDependencies = gGlobal->gLstDependenciesSwitch;
+    fLstDistributed  = gGlobal->gLstDistributedSwitch;
+    fStripDoc        = gGlobal->gStripDocSwitch;
+}
+
+void LibraryCache::write(Tree ldef)
+{
+#ifndef _WIN32
+    if (fPath == "") return;
+
+    // Documentation is not kept
+    if (gGlobal->gDocVector.size() != fDocSize || gGlobal->gLstDependenciesSwitch != fLstDependencies ||
+        gGlobal->gLstDistributedSwitch != fLstDistributed || gGlobal->gStripDocSwitch != fStripDoc) {
+        return;
+    }
+
+    // All the trees created while parsing are kept (and not only the ones of the definitions),
+    // so that the trees created later on keep the same order
+    tvec created;
+    CTree::createdSince(fSerial, created);
+    TreeEncoder encoder;
+    if (!encoder.add(ldef)) return;
+    for (Tree t : created) {
+        if (!encoder.add(t)) return;
+    }
+
+    // Metadata declared by the file
+    vector<pair<Tree, Tree>> metadata;
+    for (auto& m : gGlobal->gMetaDataSet) {
+        auto it = fMetaDataSet.find(m.first);
+        for (Tree value : m.second) {
+            if (it == fMetaDataSet.end() || it->second.find(value) == it->second.end()) {
+                metadata.push_back(make_pair(m.first, value));
+            }
+        }
+    }
+
+    // Line properties set while parsing the file
+    vector<pair<Tree, pair<int, Tree>>> properties;
+    tvec                                trees = encoder.trees();
+    Tree file = tree(fFileName.c_str());
+    for (Tree t : trees) {
+        Tree value;
+        if (getProperty(t, gGlobal->DEFLINEPROP, value) && hd(value) == file) {
+            properties.push_back(make_pair(t, make_pair(int(kCacheDefLine), value)));
+        }
+        if (getProperty(t, gGlobal->USELINEPROP, value) && hd(value) == file) {
+            properties.push_back(make_pair(t, make_pair(int(kCacheUseLine), value)));
+        }
+    }
+
+    for (auto& m : metadata) {
+        if (!encoder.add(m.first) || !encoder.add(m.second)) return;
+    }
+    for (auto& p : properties) {
+        if (!encoder.add(p.second.second)) return;
+    }
+
+    load();
+    string out = LIBRARY_CACHE_MAGIC;
+    writeValue(out, unsigned(LIBRARY_CACHE_FORMAT));
+    out += fHash;
+    writeValue(out, fStamp[0]);
+    writeValue(out, fStamp[1]);
+    writeValue(out, fStamp[2]);
+    encoder.write(out);
+    writeValue(out, encoder.index(ldef));
+    writeValue(out, unsigned(metadata.size()));
+    for (auto& m : metadata) {
+        writeValue(out, encoder.index(m.first));
+        writeValue(out, encoder.index(m.second));
+    }
+    writeValue(out, unsigned(properties.size()));
+    for (auto& p : properties) {
+        writeValue(out, encoder.index(p.first));
+        writeValue(out, char(p.second.first));
+        writeValue(out, encoder.index(p.second.second));
+    }
+
+    writeEntry(fPath, out);
+#endif
+}
@@ -0,0 +1,86 @@
+/************************************************************************
+ ************************************************************************
+ FAUST compiler
+ Copyright (C) 2003-2020 GRAME, Centre National de Creation Musicale
+ ---------------------------------------------------------------------
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ ************************************************************************
+ ************************************************************************/
+
+#ifndef __LIBRARYCACHE__
+#define __LIBRARYCACHE__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "global.hh"
+#include "tree.hh"
+
+/*
+ Opt-in on-disk cache of parsed library files, activated by setting the FAUST_LIB_CACHE environment
+ variable to an existing directory. Each entry keeps the list of definitions of a library (after function
+ metadata wrapping) as a serialized tree DAG, with the metadata and line properties the parser produced.
+ An entry is named after the file path, the float size and the compiler version, and is only used when
+ the file has the modification time and size it was built from, or else when the SHA1 of the current file
+ content matches the one it was built from (the entry is then stamped again). Entries are read with mmap.
+*/
+class LibraryCache {
+    private:
+        std::string fFileName;  // the name used by the parser (yyfilename)
+        std::string fFullPath;  // the located file
+        std::string fPath;      // the cache entry, or "" if the cache is not usable for this file
+        std::string fContent;   // the file content, read on demand
+        std::string fHash;      // SHA1 of the file content, computed on demand
+        bool        fLoaded;    // whether fContent and fHash are set
+        int64_t     fStamp[3];  // modification time (seconds, nanoseconds) and size of the file, or 0 if too recent
+
+        // State before parsing, to record the side effects of the parser
+        size_t      fSerial;
+        MetaDataSet fMetaDataSet;
+        size_t      fDocSize;
+        bool        fLstDependencies, fLstDistributed, fStripDoc;
+
+        void load();
+        bool decode(const char* data, size_t size, Tree& ldef);
+        void restamp(const char* data, size_t size);
+
+    public:
+        explicit LibraryCache(const char* fname);
+
+        // Return the cache directory, or "" if the cache is not activated
+        static std::string getDirectory();
+
+        // Rebuild the definitions kept for the file and replay the parser side effects, return false if not found
+        bool read(Tree& ldef);
+
+        // To be called before parsing the file
+        void prepare();
+
+        // Keep the definitions produced by the parser, unless the parse had effects that cannot be replayed
+        void write(Tree ldef);
+
+        // Whether the file has been located and read (only when the cache is activated)
+        bool isValid() { return fPath != ""; }
+
+        const std::string& getFullPath() { return fFullPath; }
+        const std::string& getContent()
+        {
+            load();
+            return fContent;
+        }
+};
+
+#endif
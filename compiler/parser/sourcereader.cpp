@@ -39,6 +39,7 @@
 #include <emscripten.h>
 #endif
 
+#include "TMutex.h"
 #include "compatibility.hh"
 #include "sourcereader.hh"
 #include "sourcefetcher.hh"
@@ -46,6 +47,7 @@
 #include "ppbox.hh"
 #include "exception.hh"
 #include "global.hh"
+#include "librarycache.hh"
 #include "Text.hh"
 
 using namespace std;
@@ -65,6 +67,9 @@ extern FILE* yyin;
 extern int yylineno;
 extern const char* yyfilename;
 
+// The flex/bison generated parser is not reentrant: concurrent compilations parse their files one at a time
+static TLockAble gParserLock;
+
 /**
  * Checks an argument list for containing only
  * standard identifiers, no patterns and
@@ -254,6 +259,7 @@ inline bool isFILE(const char* name) { return strstr(name, "file://") != 0; }
 
 Tree SourceReader::parseFile(const char* fname)
 {
+    TLock lock(&gParserLock);
     yyerr = 0;
     yylineno = 1;
     yyfilename = fname;
@@ -337,6 +343,7 @@ Tree SourceReader::parseFile(const char* fname)
 
 Tree SourceReader::parseString(const char* fname)
 {
+    TLock lock(&gParserLock);
     yyerr = 0;
     yylineno = 1;
     yyfilename = fname;
@@ -347,6 +354,16 @@ Tree SourceReader::parseString(const char* fname)
     return parseLocal(fname);
 }
 
+Tree SourceReader::parseContent(const char* fname, const string& content, const string& fullpath)
+{
+    TLock lock(&gParserLock);
+    yyerr = 0;
+    yylineno = 1;
+    yyfilename = (isFILE(fname)) ? &fname[7] : fname; // skip 'file://'
+    yy_scan_string(content.c_str());
+    return parseLocal(fullpath.c_str());
+}
+
 Tree SourceReader::parseLocal(const char* fname)
 {
     int r = yyparse();
@@ -416,11 +433,27 @@ static Tree addFunctionMetadata(Tree ldef, FunMDSet& M)
 Tree SourceReader::getList(const char* fname)
 {
 	if (!cached(fname)) {
-        // Previous metadata need to be cleared before parsing a file
-        gGlobal->gFunMDSet.clear();
-        Tree ldef = (gGlobal->gInputString) ? parseString(fname) : parseFile(fname);
-        // Definitions with metadata have to be wrapped into a boxMetadata construction
-        fFileCache[fname] = addFunctionMetadata(ldef, gGlobal->gFunMDSet);
+        LibraryCache library(fname);
+        Tree ldef;
+        if (library.read(ldef)) {
+            fFilePathnames.push_back(library.getFullPath());
+        } else {
+            // Previous metadata need to be cleared before parsing a file
+            gGlobal->gFunMDSet.clear();
+            library.prepare();
+            if (gGlobal->gInputString) {
+                ldef = parseString(fname);
+            } else if (library.isValid()) {
+                // The file has already been located and read by the cache
+                ldef = parseContent(fname, library.getContent(), library.getFullPath());
+            } else {
+                ldef = parseFile(fname);
+            }
+            // Definitions with metadata have to be wrapped into a boxMetadata construction
+            ldef = addFunctionMetadata(ldef, gGlobal->gFunMDSet);
+            library.write(ldef);
+        }
+        fFileCache[fname] = ldef;
 	}
     return fFileCache[fname];
 }
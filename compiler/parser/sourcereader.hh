@@ -48,6 +48,7 @@ class SourceReader
         bool cached(string fname);
         Tree parseFile(const char* fname);
         Tree parseString(const char* fname);
+        Tree parseContent(const char* fname, const string& content, const string& fullpath);
         void checkName();
         
     public:
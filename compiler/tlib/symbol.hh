@@ -53,9 +53,9 @@ using namespace std;
  */
 class Symbol : public virtual Garbageable {
    private:
-    static const int kHashTableSize = 511;          ///< Size of the hash table (a prime number is recommended)
-    static Symbol*   gSymbolTable[kHashTableSize];  ///< Hash table used to store the symbols
-    static map<const char*, unsigned int> gPrefixCounters;
+    static const int             kHashTableSize = 511;          ///< Size of the hash table (a prime number is recommended)
+    static thread_local Symbol*  gSymbolTable[kHashTableSize];  ///< Hash table used to store the symbols (one per thread)
+    static thread_local map<const char*, unsigned int> gPrefixCounters;
 
     // Fields
     string       fName;  ///< Name of the symbol
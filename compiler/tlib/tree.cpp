@@ -27,7 +27,8 @@
 Trees are made of a Node associated with a list of branches : (Node x [CTree]).
 Up to 4 branches are allowed in this implementation. A hash table is used to
 maximize the sharing of trees during construction : trees at different
-addresses always have a different content. Reference counting is used for
+addresses always have a different content (among the trees built by a same
+thread, each compiling thread having its own table). Reference counting is used for
 garbage collection, and smart pointers P<CTree> should be used for permanent
 storage of trees.
 
@@ -74,11 +75,15 @@ storage of trees.
 *****************************************************************************/
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <cstdlib>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <iostream>
 
 #include "exception.hh"
 #include "tree.hh"
@@ -92,90 +97,158 @@ storage of trees.
         throw faustexception(s); \
     }
 
-Tree         CTree::gHashTable[kHashTableSize];
-bool         CTree::gDetails       = false;
-unsigned int CTree::gVisitTime     = 0;
-size_t       CTree::gSerialCounter = 0;
+// Hash-consing state is owned by the compiling thread, so that several compilations can run in parallel
+thread_local CTree::HashTable     CTree::gHashTable     = {nullptr, 0, 0, 0, 0, 0, 0};
+thread_local CTree::PropertyTable CTree::gPropertyTable = {nullptr, 0, 0, nullptr, 0};
+thread_local bool                 CTree::gDetails       = false;
+thread_local unsigned int         CTree::gVisitTime     = 0;
+thread_local size_t               CTree::gSerialCounter = 0;
+thread_local uint32_t             CTree::gGeneration    = 0;
+thread_local std::map<std::pair<Tree, size_t>, uint32_t> CTree::gForeignProperties;
+
+// Generations are given to the threads by CTree::init and CTree::cleanup, and are never reused
+static std::atomic<uint32_t> gGenerationCounter(0);
+
+// Marks the slot of a tree removed from the hash table
+static const Tree kDeletedTree = reinterpret_cast<Tree>(uintptr_t(1));
 
 // Constructor : add the tree to the hash table
 CTree::CTree(size_t hk, const Node& n, const tvec& br)
     : fNode(n),
       fType(0),
+      fProperties(0),
+      fGeneration(gGeneration),
       fHashKey(hk),
       fSerial(++gSerialCounter),
       fAperture(calcTreeAperture(n, br)),
       fVisitTime(0),
       fBranch(br)
 {
-    // link dans la hash table
-    int j         = hk % kHashTableSize;
-    fNext         = gHashTable[j];
-    gHashTable[j] = this;
+    insert(hk, this);
 }
 
-// Destructor : remove the tree from the hash table
+// Destructor : remove the tree from the hash table (when the hash table is still allocated)
 CTree::~CTree()
 {
-    int  i = fHashKey % kHashTableSize;
-    Tree t = gHashTable[i];
-
-    // printf("Delete of "); this->print(); printf("\n");
-    if (t == this) {
-        gHashTable[i] = fNext;
-    } else {
-        Tree p = nullptr;
-        while (t != this) {
-            p = t;
-            t = t->fNext;
+    HashTable& table = gHashTable;
+    if (!table.fSlots) return;
+
+    for (size_t i = fHashKey & table.fMask; table.fSlots[i].fTree; i = (i + 1) & table.fMask) {
+        if (table.fSlots[i].fTree == this) {
+            table.fSlots[i].fTree = kDeletedTree;
+            table.fCount--;
+            table.fDeleted++;
+            return;
         }
-        faustassert(p);
-        p->fNext = fNext;
     }
+    faustassert(false);
 }
 
 // equivalence
-bool CTree::equiv(const Node& n, const tvec& br) const
+bool CTree::equiv(const Node& n, int ar, Tree br[]) const
 {
-    return (fNode == n) && (fBranch == br);
+    return (fNode == n) && (int(fBranch.size()) == ar) && std::equal(fBranch.begin(), fBranch.end(), br);
 }
 
-size_t CTree::calcTreeHash(const Node& n, const tvec& br)
+// Finalizer of MurmurHash3 : every bit of the key affects every bit of the result
+static inline uint64_t mixHashKey(uint64_t hk)
 {
-    size_t               hk = size_t(n.getPointer());
-    tvec::const_iterator b  = br.begin();
-    tvec::const_iterator z  = br.end();
-
-    while (b != z) {
-        hk = (hk << 1) ^ (hk >> 20) ^ ((*b)->fHashKey);
-        ++b;
-    }
+    hk ^= hk >> 33;
+    hk *= 0xff51afd7ed558ccdULL;
+    hk ^= hk >> 33;
+    hk *= 0xc4ceb9fe1a85ec53ULL;
+    hk ^= hk >> 33;
     return hk;
 }
 
-Tree CTree::make(const Node& n, int ar, Tree* tbl)
+// Hash key of the (tree, key) pair of a property
+static inline size_t calcPropertyHash(size_t tree_serial, size_t key_serial)
 {
-    tvec br(ar);
+    return size_t(mixHashKey((uint64_t(tree_serial) << 32) ^ uint64_t(key_serial)));
+}
 
-    for (int i = 0; i < ar; i++) br[i] = tbl[i];
+size_t CTree::calcTreeHash(const Node& n, int ar, const Tree* br)
+{
+    uint64_t hk = uint64_t(uintptr_t(n.getPointer())) ^ (uint64_t(n.type()) << 59);
+    for (int i = 0; i < ar; i++) {
+        hk = (hk ^ br[i]->fHashKey) * 0x9e3779b97f4a7c15ULL;
+        hk ^= hk >> 29;
+    }
+    return size_t(mixHashKey(hk ^ uint64_t(ar)));
+}
 
-    size_t hk = calcTreeHash(n, br);
-    Tree   t  = gHashTable[hk % kHashTableSize];
+void CTree::insert(size_t hk, Tree t)
+{
+    HashTable& table = gHashTable;
+    if (!table.fSlots) {
+        resize(kInitHashTableSize);
+    } else if ((table.fCount + table.fDeleted + 1) * 100 > (table.fMask + 1) * kMaxLoad) {
+        // Grow the table, or only rehash it when most of the used slots are removed trees
+        resize((table.fCount * 100 >= (table.fMask + 1) * kMaxLoad / 2) ? (table.fMask + 1) * 2 : table.fMask + 1);
+    }
 
-    while (t && !t->equiv(n, br)) {
-        t = t->fNext;
+    size_t i = hk & table.fMask;
+    while (table.fSlots[i].fTree && table.fSlots[i].fTree != kDeletedTree) {
+        i = (i + 1) & table.fMask;
+    }
+    if (table.fSlots[i].fTree == kDeletedTree) {
+        table.fDeleted--;
     }
-    return (t) ? t : new CTree(hk, n, br);
+    table.fSlots[i].fHashKey = hk;
+    table.fSlots[i].fTree    = t;
+    table.fCount++;
 }
 
-Tree CTree::make(const Node& n, const tvec& br)
+void CTree::resize(size_t size)
 {
-    size_t hk = calcTreeHash(n, br);
-    Tree   t  = gHashTable[hk % kHashTableSize];
+    HashTable&       table = gHashTable;
+    HashTable::Slot* slots = table.fSlots;
+    size_t           count = (slots) ? table.fMask + 1 : 0;
+
+    table.fSlots   = static_cast<HashTable::Slot*>(calloc(size, sizeof(HashTable::Slot)));
+    table.fMask    = size - 1;
+    table.fDeleted = 0;
+    if (!table.fSlots) throw std::bad_alloc();
+
+    for (size_t j = 0; j < count; j++) {
+        Tree t = slots[j].fTree;
+        if (t && t != kDeletedTree) {
+            size_t i = slots[j].fHashKey & table.fMask;
+            while (table.fSlots[i].fTree) {
+                i = (i + 1) & table.fMask;
+            }
+            table.fSlots[i] = slots[j];
+        }
+    }
+    free(slots);
+}
 
-    while (t && !t->equiv(n, br)) {
-        t = t->fNext;
+Tree CTree::make(const Node& n, int ar, Tree* tbl)
+{
+    HashTable& table = gHashTable;
+    size_t     hk    = calcTreeHash(n, ar, tbl);
+    size_t     probe = 0;
+    Tree       t     = nullptr;
+
+    if (table.fSlots) {
+        for (size_t i = hk & table.fMask; table.fSlots[i].fTree; i = (i + 1) & table.fMask, probe++) {
+            HashTable::Slot& slot = table.fSlots[i];
+            if (slot.fHashKey == hk && slot.fTree != kDeletedTree && slot.fTree->equiv(n, ar, tbl)) {
+                t = slot.fTree;
+                break;
+            }
+        }
     }
-    return (t) ? t : new CTree(hk, n, br);
+
+    table.fLookups++;
+    table.fProbes += probe;
+    table.fMaxProbe = std::max(table.fMaxProbe, probe);
+    return (t) ? t : new CTree(hk, n, tvec(tbl, tbl + ar));
+}
+
+Tree CTree::make(const Node& n, const tvec& br)
+{
+    return make(n, int(br.size()), const_cast<Tree*>(br.data()));
 }
 
 ostream& CTree::print(ostream& fout) const
@@ -199,27 +272,44 @@ ostream& CTree::print(ostream& fout) const
     return fout;
 }
 
-void CTree::control()
+void CTree::createdSince(size_t serial, tvec& trees)
 {
-    printf("\ngHashTable Content :\n\n");
-    for (int i = 0; i < kHashTableSize; i++) {
-        Tree t = gHashTable[i];
-        if (t) {
-            printf("%4d = ", i);
-            while (t) {
-                /*t->print();*/
-                printf(" => ");
-                t = t->fNext;
-            }
-            printf("VOID\n");
-        }
+    const HashTable& table = gHashTable;
+    size_t           size  = (table.fSlots) ? table.fMask + 1 : 0;
+    for (size_t i = 0; i < size; i++) {
+        Tree t = table.fSlots[i].fTree;
+        if (t && t != kDeletedTree && t->fSerial > serial) trees.push_back(t);
     }
-    printf("\nEnd gHashTable\n");
+}
+
+void CTree::control()
+{
+    const HashTable& table = gHashTable;
+    size_t           size  = (table.fSlots) ? table.fMask + 1 : 0;
+    cerr << "Hash consing table : " << table.fCount << " trees, " << size << " slots, load factor "
+         << ((size) ? double(table.fCount + table.fDeleted) / double(size) : 0.) << ", " << table.fDeleted
+         << " removed, " << table.fLookups << " lookups, average probe "
+         << ((table.fLookups) ? double(table.fProbes) / double(table.fLookups) : 0.) << ", max probe "
+         << table.fMaxProbe << endl;
 }
 
 void CTree::init()
 {
-    memset(gHashTable, 0, sizeof(Tree) * kHashTableSize);
+    cleanup();
+    resize(kInitHashTableSize);
+}
+
+// Release the hash table and the properties : the trees destroyed afterwards are not removed from it anymore.
+// A new generation starts, so that the property indexes kept in the remaining trees are not used anymore
+void CTree::cleanup()
+{
+    free(gHashTable.fSlots);
+    gHashTable = {nullptr, 0, 0, 0, 0, 0, 0};
+    free(gPropertyTable.fEntries);
+    free(gPropertyTable.fSlots);
+    gPropertyTable = {nullptr, 0, 0, nullptr, 0};
+    gForeignProperties.clear();
+    gGeneration = ++gGenerationCounter;
 }
 
 // if t has a node of type int, return it otherwise error
@@ -395,15 +485,111 @@ void* getUserData(Tree t)
     }
 }
 
+/*****************************************************************************
+                            Properties of a tree
+*****************************************************************************/
+
+CTree::PropertyTable::Entry* CTree::findProperty(Tree key) const
+{
+    const PropertyTable& table = gPropertyTable;
+    if (!table.fSlots) return nullptr;
+    for (size_t i = calcPropertyHash(fSerial, key->fSerial) & table.fMask; table.fSlots[i];
+         i = (i + 1) & table.fMask) {
+        PropertyTable::Entry* e = &table.fEntries[table.fSlots[i] - 1];
+        if (e->fTree == this && e->fKey == key && e->fTreeSerial == fSerial && e->fKeySerial == key->fSerial) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t CTree::propertiesHead() const
+{
+    if (fGeneration == gGeneration) return fProperties;
+    auto it = gForeignProperties.find(std::make_pair(const_cast<Tree>(this), fSerial));
+    return (it != gForeignProperties.end()) ? it->second : 0;
+}
+
+void CTree::setProperty(Tree key, Tree value)
+{
+    PropertyTable::Entry* e = (fProperties || fGeneration != gGeneration) ? findProperty(key) : nullptr;
+    if (e) {
+        e->fValue = value;
+        return;
+    }
+
+    PropertyTable& table = gPropertyTable;
+    if (!table.fSlots) {
+        resizeProperties(kInitPropertyTableSize);
+    } else if ((table.fCount + 1) * 100 > (table.fMask + 1) * kMaxLoad) {
+        resizeProperties((table.fMask + 1) * 2);
+    }
+    if (table.fCount == table.fCapacity) {
+        size_t                capacity = (table.fCapacity) ? table.fCapacity * 2 : kInitPropertyTableSize / 2;
+        PropertyTable::Entry* entries =
+            static_cast<PropertyTable::Entry*>(realloc(table.fEntries, capacity * sizeof(PropertyTable::Entry)));
+        if (!entries) throw std::bad_alloc();
+        table.fEntries  = entries;
+        table.fCapacity = capacity;
+    }
+    if (table.fCount >= UINT32_MAX) throw faustexception("ERROR : too many tree properties\n");
+
+    table.fEntries[table.fCount] = {this, key, value, fSerial, key->fSerial, propertiesHead()};
+    uint32_t head                = uint32_t(++table.fCount);
+    if (fGeneration == gGeneration) {
+        fProperties = head;
+    } else {
+        gForeignProperties[std::make_pair(this, fSerial)] = head;
+    }
+
+    size_t i = calcPropertyHash(fSerial, key->fSerial) & table.fMask;
+    while (table.fSlots[i]) {
+        i = (i + 1) & table.fMask;
+    }
+    table.fSlots[i] = head;
+}
+
+void CTree::resizeProperties(size_t size)
+{
+    PropertyTable& table = gPropertyTable;
+    uint32_t*      slots = static_cast<uint32_t*>(calloc(size, sizeof(uint32_t)));
+    if (!slots) throw std::bad_alloc();
+
+    free(table.fSlots);
+    table.fSlots = slots;
+    table.fMask  = size - 1;
+    for (size_t j = 0; j < table.fCount; j++) {
+        const PropertyTable::Entry& e = table.fEntries[j];
+        size_t                      i = calcPropertyHash(e.fTreeSerial, e.fKeySerial) & table.fMask;
+        while (table.fSlots[i]) {
+            i = (i + 1) & table.fMask;
+        }
+        table.fSlots[i] = uint32_t(j + 1);
+    }
+}
+
+void CTree::clearProperties()
+{
+    for (uint32_t p = propertiesHead(); p; p = gPropertyTable.fEntries[p - 1].fNext) {
+        gPropertyTable.fEntries[p - 1].fValue = nullptr;
+    }
+}
+
 /**
  * export the properties of a CTree as two vectors, one for the keys
- * and one for the associated values
+ * and one for the associated values (ordered by key address)
  */
 
 void CTree::exportProperties(vector<Tree>& keys, vector<Tree>& values)
 {
-    for (plist::const_iterator p = fProperties.begin(); p != fProperties.end(); p++) {
-        keys.push_back(p->first);
-        values.push_back(p->second);
+    vector<pair<Tree, Tree>> props;
+    for (uint32_t p = propertiesHead(); p; p = gPropertyTable.fEntries[p - 1].fNext) {
+        const PropertyTable::Entry& e = gPropertyTable.fEntries[p - 1];
+        if (e.fValue) props.push_back(make_pair(e.fKey, e.fValue));
+    }
+    sort(props.begin(), props.end());
+    for (const auto& p : props) {
+        keys.push_back(p.first);
+        values.push_back(p.second);
     }
 }
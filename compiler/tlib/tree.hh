@@ -72,6 +72,7 @@
 #ifndef __TREE__
 #define __TREE__
 
+#include <stdint.h>
 #include <map>
 #include <vector>
 
@@ -85,8 +86,7 @@
 class CTree;
 typedef CTree* Tree;
 
-typedef map<Tree, Tree> plist;
-typedef vector<Tree>    tvec;
+typedef vector<Tree> tvec;
 
 /**
  * A CTree = (Node x [CTree]) is a Node associated with a list of subtrees called branches.
@@ -107,20 +107,79 @@ typedef vector<Tree>    tvec;
 
 class CTree : public virtual Garbageable {
    private:
-    static const int kHashTableSize = 400009;     ///< size of the hash table (prime number)
-    static size_t    gSerialCounter;              ///< the serial number counter
-    static Tree      gHashTable[kHashTableSize];  ///< hash table used for "hash consing"
+    /**
+     * Hash table used for "hash consing" : open addressing with linear probing in a power of two array,
+     * grown when the load factor reaches kMaxLoad. The hash key is kept in the slot so that most
+     * probes do not have to access the tree itself.
+     *
+     * The table is not shared between threads : each compiling thread owns its table, like the rest of its
+     * compiler state (gGlobal, properties, memory arena), and only this thread inserts and removes trees.
+     * So there is no concurrent insert and no lock. A consequence is that trees are not shared across
+     * threads : the same content built by two threads gives two different trees, so pointer equality (and
+     * properties) only hold for trees built by the same thread, and a tree must not be passed to another
+     * compilation thread. A front-end pass split on several threads would need a table shared by them.
+     */
+    struct HashTable {
+        struct Slot {
+            size_t fHashKey;
+            Tree   fTree;  ///< nullptr for an empty slot, kDeletedTree for a removed tree
+        };
+        Slot*  fSlots;     ///< the slots (capacity = fMask + 1)
+        size_t fMask;      ///< capacity - 1
+        size_t fCount;     ///< number of trees in the table
+        size_t fDeleted;   ///< number of removed trees slots
+        size_t fLookups;   ///< statistics : number of lookups
+        size_t fProbes;    ///< statistics : number of probed slots
+        size_t fMaxProbe;  ///< statistics : longest probe sequence
+    };
+
+    /**
+     * Property table : the properties of all the trees are kept in a single flat table rather than in a map per tree.
+     * Entries are appended in an array, and indexed by an open addressing hash table hashed by the serial numbers
+     * of the tree and of the key. Entries are matched by address and serial : serials are only unique in a thread
+     * (static keys created by the main thread can share their serial with a tree of a compiling thread), and the
+     * address of a tree deleted during the compilation can be reused by a new tree with a new serial.
+     * The entries of a same tree are chained so that they can be enumerated. The head of the chain is kept in
+     * the tree for the trees of the current generation (created by this thread since its last CTree::init),
+     * and in gForeignProperties for the other ones, so that a tree is only modified by the thread owning it.
+     */
+    struct PropertyTable {
+        struct Entry {
+            Tree     fTree;        ///< the tree holding the property
+            Tree     fKey;         ///< the key
+            Tree     fValue;       ///< the value, nullptr for a cleared property
+            size_t   fTreeSerial;  ///< the serial of the tree
+            size_t   fKeySerial;   ///< the serial of the key
+            uint32_t fNext;        ///< index + 1 of the next entry of the same tree, 0 at the end of the chain
+        };
+        Entry*    fEntries;   ///< the entries
+        size_t    fCount;     ///< number of entries
+        size_t    fCapacity;  ///< allocated entries
+        uint32_t* fSlots;     ///< index + 1 of the entries, 0 for an empty slot (capacity = fMask + 1)
+        size_t    fMask;      ///< capacity - 1
+    };
+
+    static const size_t kInitHashTableSize     = 1 << 16;  ///< initial size of the hash table (power of two)
+    static const size_t kInitPropertyTableSize = 1 << 14;  ///< initial size of the property table (power of two)
+    static const size_t kMaxLoad               = 70;       ///< maximum load factor of the hash tables (in percent)
+
+    static thread_local size_t        gSerialCounter;    ///< the serial number counter
+    static thread_local HashTable     gHashTable;        ///< hash table used for "hash consing" (one per compiling thread)
+    static thread_local PropertyTable gPropertyTable;    ///< properties of the trees (one per compiling thread)
+    static thread_local uint32_t      gGeneration;       ///< generation of the trees created by this thread
+    static thread_local std::map<std::pair<Tree, size_t>, uint32_t>
+        gForeignProperties;  ///< head of the property chains of the trees of other generations
 
    public:
-    static bool         gDetails;    ///< Ctree::print() print with more details when true
-    static unsigned int gVisitTime;  ///< Should be incremented for each new visit to keep track of visited tree.
+    static thread_local bool         gDetails;    ///< Ctree::print() print with more details when true
+    static thread_local unsigned int gVisitTime;  ///< Should be incremented for each new visit to keep track of visited tree.
 
    private:
     // fields
-    Tree         fNext;        ///< next tree in the same hashtable entry
     Node         fNode;        ///< the node content of the tree
     void*        fType;        ///< the type of a tree
-    plist        fProperties;  ///< the properties list attached to the tree
+    uint32_t     fProperties;  ///< index + 1 of the last property entry of the tree, 0 without properties
+    uint32_t     fGeneration;  ///< generation of the thread that created the tree (fProperties is only used by it)
     size_t       fHashKey;     ///< the hashtable key
     size_t       fSerial;      ///< the increasing serial number
     int          fAperture;    ///< how "open" is a tree (synthezised field)
@@ -129,11 +188,17 @@ class CTree : public virtual Garbageable {
 
     CTree(size_t hk, const Node& n, const tvec& br);  ///< construction is private, uses tree::make instead
 
-    bool          equiv(const Node& n, const tvec& br) const;  ///< used to check if an equivalent tree already exists
-    static size_t calcTreeHash(const Node& n,
-                               const tvec& br);  ///< compute the hash key of a tree according to its node and branches
+    bool          equiv(const Node& n, int ar, Tree br[]) const;  ///< used to check if an equivalent tree already exists
+    static size_t calcTreeHash(const Node& n, int ar,
+                               const Tree* br);  ///< compute the hash key of a tree according to its node and branches
+    static void   insert(size_t hk, Tree t);     ///< add a new tree in the hash table
+    static void   resize(size_t size);           ///< rehash the trees of the hash table in 'size' slots
     static int    calcTreeAperture(const Node& n, const tvec& br);  ///< compute how open is a tree
 
+    PropertyTable::Entry* findProperty(Tree key) const;  ///< return the property entry of 'key' if any
+    uint32_t              propertiesHead() const;         ///< index + 1 of the last property entry of the tree
+    static void           resizeProperties(size_t size);  ///< reindex the property entries in 'size' slots
+
    public:
     virtual ~CTree();
 
@@ -152,9 +217,12 @@ class CTree : public virtual Garbageable {
 
     // Print a tree and the hash table (for debugging purposes)
     ostream&    print(ostream& fout) const;  ///< print recursively the content of a tree on a stream
-    static void control();                   ///< print the hash table content (for debug purpose)
+    static void control();                   ///< print the hash table statistics (for debug purpose)
+    static size_t serialCounter() { return gSerialCounter; }  ///< number of trees created by the current thread
+    static void   createdSince(size_t serial, tvec& trees);  ///< collect the trees created after 'serial'
 
     static void init();
+    static void cleanup();
 
     // type information
     void  setType(void* t) { fType = t; }
@@ -169,20 +237,23 @@ class CTree : public virtual Garbageable {
     }
 
     // Property list of a tree
-    void setProperty(Tree key, Tree value) { fProperties[key] = value; }
-    void clearProperty(Tree key) { fProperties.erase(key); }
-    void clearProperties() { fProperties = plist(); }
+    void setProperty(Tree key, Tree value);
+    void clearProperty(Tree key)
+    {
+        if (fProperties || fGeneration != gGeneration) {
+            PropertyTable::Entry* e = findProperty(key);
+            if (e) e->fValue = nullptr;
+        }
+    }
+    void clearProperties();
 
     void exportProperties(vector<Tree>& keys, vector<Tree>& values);
 
     Tree getProperty(Tree key)
     {
-        plist::iterator i = fProperties.find(key);
-        if (i == fProperties.end()) {
-            return 0;
-        } else {
-            return i->second;
-        }
+        if (!fProperties && fGeneration == gGeneration) return nullptr;
+        PropertyTable::Entry* e = findProperty(key);
+        return (e) ? e->fValue : nullptr;
     }
 };
 
@@ -45,7 +45,6 @@
 #include "faust/audio/jack-dsp.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int main(int argc, const char* argv[])
 {
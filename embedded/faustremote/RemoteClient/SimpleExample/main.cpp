@@ -43,7 +43,6 @@
 #include "faust/audio/jack-dsp.h"
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int testClient(int argc, const char* argv[])
 {
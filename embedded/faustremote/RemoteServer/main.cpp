@@ -39,7 +39,6 @@
 #include <iostream>
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int main(int argc, const char* argv[])
 {
@@ -27,7 +27,6 @@ using std::min;
 using namespace std;
 
 std::list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 //----------------------------------------------------------------------------
 // Test MemoryReader
@@ -0,0 +1,33 @@
+#ifndef FAUSTFLOAT
+#define FAUSTFLOAT double
+#endif
+
+#include "controlTools.h"
+
+//----------------------------------------------------------------------------
+//FAUST generated code
+//----------------------------------------------------------------------------
+
+<<includeIntrinsic>>
+
+<<includeclass>>
+
+// The class is generated with '-batch <n>': a single instance is checked on its last lane,
+// and the polyphonic DSP packs its voices in the lanes
+int main(int argc, char* argv[])
+{
+    int linenum = 0;
+    int nbsamples = 60000;
+    int lane = mydsp().getNumLanes() - 1;
+
+    // print general informations
+    printHeader(new dsp_lane(new mydsp(), lane, true), nbsamples);
+
+    // linenum is incremented in runDSP and runPolyDSP
+    runDSP(new dsp_lane(new mydsp(), lane, true), argv[0], linenum, nbsamples/4);
+    runDSP(new dsp_lane(new mydsp(), lane, true), argv[0], linenum, nbsamples/4, false, true);
+    runPolyDSP(new mydsp(), linenum, nbsamples/4, 4);
+    runPolyDSP(new mydsp(), linenum, nbsamples/4, 1);
+
+    return 0;
+}
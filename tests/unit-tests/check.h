@@ -0,0 +1,31 @@
+/*
+ Minimal checks for the unit tests: failures are reported with their line, and counted for the exit status.
+*/
+
+#ifndef __check__
+#define __check__
+
+#include <stdio.h>
+
+static int gFailures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            gFailures++;                                                            \
+        }                                                                           \
+    } while (0)
+
+static int checkResult(const char* name)
+{
+    if (gFailures == 0) {
+        printf("%s: OK\n", name);
+        return 0;
+    } else {
+        printf("%s: %d check(s) failed\n", name, gFailures);
+        return 1;
+    }
+}
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ dsp-combiner: random combiner trees computed with the planned buffer pool give the same output as a reference
+ computation using separate buffers, and the intermediate channels of the whole tree are kept in a single pool
+ once the root is built. A tree can be computed before being initialized.
+*/
+
+#include <new>
+#include <set>
+#include <stdlib.h>
+#include <vector>
+
+#define FAUSTFLOAT float
+
+#include "faust/dsp/dsp-combiner.h"
+#include "check.h"
+
+#define BUFFER_FRAMES 4096
+
+// The live allocations of at least one buffer of frames (the set itself only uses the scalar operator new)
+static std::set<void*> gBuffers;
+
+void* operator new[](size_t size)
+{
+    void* ptr = malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    if (size >= BUFFER_FRAMES * sizeof(FAUSTFLOAT)) gBuffers.insert(ptr);
+    return ptr;
+}
+void operator delete[](void* ptr) noexcept
+{
+    gBuffers.erase(ptr);
+    free(ptr);
+}
+
+// A stateful DSP, whose outputs depend on all its inputs
+struct LeafDSP : public dsp {
+
+    int fInputs, fOutputs;
+    float fSeed;
+    std::vector<float> fState;
+
+    LeafDSP(int inputs, int outputs, float seed):fInputs(inputs), fOutputs(outputs), fSeed(seed), fState(outputs, 0.f) {}
+
+    int getNumInputs() { return fInputs; }
+    int getNumOutputs() { return fOutputs; }
+    void buildUserInterface(UI* ui) {}
+    int getSampleRate() { return 44100; }
+    void init(int sample_rate) { instanceClear(); }
+    void instanceInit(int sample_rate) { instanceClear(); }
+    void instanceConstants(int sample_rate) {}
+    void instanceResetUserInterface() {}
+    void instanceClear() { std::fill(fState.begin(), fState.end(), 0.f); }
+    dsp* clone() { return new LeafDSP(fInputs, fOutputs, fSeed); }
+    void metadata(Meta* m) {}
+    void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+    {
+        for (int i = 0; i < count; i++) {
+            float in = 0.f;
+            for (int chan = 0; chan < fInputs; chan++) in += inputs[chan][i] * (chan + 1 + fSeed);
+            for (int chan = 0; chan < fOutputs; chan++) {
+                fState[chan] = fState[chan] * 0.5f + in + (chan + 1) * fSeed * 0.01f;
+                outputs[chan][i] = fState[chan];
+            }
+        }
+    }
+};
+
+// A combiner tree, with a reference computation using its own leaves and buffers
+struct Node {
+
+    enum { kLeaf, kSequencer, kParallelizer, kSplitter, kMerger };
+
+    int fType;
+    Node* fA;
+    Node* fB;
+    LeafDSP* fLeaf;
+    int fInputs, fOutputs;
+
+    Node(LeafDSP* leaf):fType(kLeaf), fA(nullptr), fB(nullptr), fLeaf(leaf), fInputs(leaf->fInputs), fOutputs(leaf->fOutputs) {}
+    Node(int type, Node* a, Node* b):fType(type), fA(a), fB(b), fLeaf(nullptr)
+    {
+        fInputs = (type == kParallelizer) ? a->fInputs + b->fInputs : a->fInputs;
+        fOutputs = (type == kParallelizer) ? a->fOutputs + b->fOutputs : b->fOutputs;
+    }
+    ~Node() { delete fA; delete fB; delete fLeaf; }
+
+    dsp* create()
+    {
+        switch (fType) {
+            case kLeaf: return fLeaf->clone();
+            case kSequencer: return new dsp_sequencer(fA->create(), fB->create());
+            case kParallelizer: return new dsp_parallelizer(fA->create(), fB->create());
+            case kSplitter: return new dsp_splitter(fA->create(), fB->create());
+            default: return new dsp_merger(fA->create(), fB->create());
+        }
+    }
+
+    typedef std::vector<std::vector<float> > channels;
+
+    channels compute(int count, const channels& inputs)
+    {
+        channels outputs;
+        if (fType == kLeaf) {
+            outputs.assign(fOutputs, std::vector<float>(count));
+            std::vector<FAUSTFLOAT*> in, out;
+            for (auto& it : inputs) in.push_back(const_cast<float*>(it.data()));
+            for (auto& it : outputs) out.push_back(it.data());
+            fLeaf->compute(count, in.data(), out.data());
+        } else if (fType == kSequencer) {
+            outputs = fB->compute(count, fA->compute(count, inputs));
+        } else if (fType == kParallelizer) {
+            channels in1(inputs.begin(), inputs.begin() + fA->fInputs);
+            channels in2(inputs.begin() + fA->fInputs, inputs.end());
+            outputs = fA->compute(count, in1);
+            channels out2 = fB->compute(count, in2);
+            outputs.insert(outputs.end(), out2.begin(), out2.end());
+        } else if (fType == kSplitter) {
+            channels out1 = fA->compute(count, inputs);
+            channels in2;
+            for (int chan = 0; chan < fB->fInputs; chan++) in2.push_back(out1[chan % out1.size()]);
+            outputs = fB->compute(count, in2);
+        } else {
+            channels out1 = fA->compute(count, inputs);
+            channels in2(fB->fInputs, std::vector<float>(count, 0.f));
+            for (size_t chan = 0; chan < out1.size(); chan++) {
+                for (int i = 0; i < count; i++) in2[chan % fB->fInputs][i] += out1[chan][i];
+            }
+            outputs = fB->compute(count, in2);
+        }
+        return outputs;
+    }
+};
+
+static int gSeed = 0;
+
+// A random tree with 'inputs' inputs
+static Node* randomTree(int depth, int inputs)
+{
+    int type = (depth == 0) ? Node::kLeaf : rand() % 5;
+    if (type == Node::kLeaf) {
+        return new Node(new LeafDSP(inputs, 1 + rand() % 3, float(++gSeed) * 0.01f));
+    } else if (type == Node::kSequencer) {
+        Node* a = randomTree(depth - 1, inputs);
+        return new Node(type, a, randomTree(depth - 1, a->fOutputs));
+    } else if (type == Node::kParallelizer) {
+        int inputs1 = (inputs > 0) ? rand() % (inputs + 1) : 0;
+        Node* a = randomTree(depth - 1, inputs1);
+        return new Node(type, a, randomTree(depth - 1, inputs - inputs1));
+    } else if (type == Node::kSplitter) {
+        Node* a = randomTree(depth - 1, inputs);
+        return new Node(type, a, randomTree(depth - 1, a->fOutputs * (2 + rand() % 2)));
+    } else {
+        Node* a = randomTree(depth - 1, inputs);
+        // A merger needs fewer inputs in B than outputs in A, dividing them
+        int inputs2 = a->fOutputs;
+        for (int div = 2; div <= a->fOutputs; div++) {
+            if (a->fOutputs % div == 0) { inputs2 = a->fOutputs / div; break; }
+        }
+        return new Node((inputs2 < a->fOutputs) ? type : int(Node::kSequencer), a, randomTree(depth - 1, inputs2));
+    }
+}
+
+int main()
+{
+    srand(1234);
+    int mismatches = 0;
+    bool single_pool = true;
+
+    for (int test = 0; test < 300; test++) {
+        Node* tree = randomTree(1 + test % 5, rand() % 3);
+
+        // The pools of the sub-trees are freed when the root is built, and init does not allocate
+        dsp* combiner = tree->create();
+        size_t built = gBuffers.size();
+        if (test % 2 == 0) combiner->init(44100);
+        single_pool &= (built <= 1 && gBuffers.size() == built);
+
+        Node::channels inputs(tree->fInputs, std::vector<float>(256));
+        Node::channels outputs(tree->fOutputs, std::vector<float>(256));
+        std::vector<FAUSTFLOAT*> in, out;
+        for (auto& it : inputs) in.push_back(it.data());
+        for (auto& it : outputs) out.push_back(it.data());
+
+        for (int cycle = 0; cycle < 4; cycle++) {
+            for (auto& it : inputs) {
+                for (auto& frame : it) frame = float(rand() % 1000) / 1000.f;
+            }
+            int count = 64 * (cycle + 1);
+            combiner->compute(count, in.data(), out.data());
+            Node::channels ref = tree->compute(count, inputs);
+            bool same = true;
+            for (int chan = 0; chan < tree->fOutputs; chan++) {
+                for (int i = 0; i < count; i++) same &= (outputs[chan][i] == ref[chan][i]);
+            }
+            if (!same) mismatches++;
+        }
+        delete combiner;
+        delete tree;
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(single_pool);
+    return checkResult("combiner");
+}
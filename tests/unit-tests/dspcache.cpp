@@ -0,0 +1,113 @@
+/*
+ FAUST_DSP_CACHE: interpreter factories are kept on disk, used again while their imported libraries
+ are unchanged, and compiled again when a library has changed.
+*/
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "faust/dsp/interpreter-dsp.h"
+#include "check.h"
+
+static std::vector<std::string> listCache(const std::string& dir)
+{
+    std::vector<std::string> res;
+    if (DIR* dirp = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(dirp)) {
+            std::string name = ent->d_name;
+            if (name.size() > 7 && name.compare(name.size() - 7, 7, ".fcache") == 0) res.push_back(dir + "/" + name);
+        }
+        closedir(dirp);
+    }
+    return res;
+}
+
+// Write a file, dated in the past (files modified during a compilation are not trusted by the cache)
+static void writeFile(const std::string& path_name, const std::string& content, time_t date)
+{
+    {
+        std::ofstream writer(path_name.c_str());
+        writer << content;
+    }
+    struct utimbuf times = { date, date };
+    utime(path_name.c_str(), &times);
+}
+
+static struct stat getStat(const std::string& path_name)
+{
+    struct stat st = {};
+    stat(path_name.c_str(), &st);
+    return st;
+}
+
+// Compile the DSP, and return its output for an input of 1
+static float compute(const std::string& dsp_content, const std::string& dir)
+{
+    std::string error_msg;
+    const char* argv[] = { "-I", dir.c_str() };
+    interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromString("cache", dsp_content, 2, argv, error_msg);
+    if (!factory) return -1.f;
+    dsp* dsp = factory->createDSPInstance();
+    dsp->init(44100);
+    FAUSTFLOAT in = 1.f, out = 0.f;
+    FAUSTFLOAT* inputs[1] = { &in };
+    FAUSTFLOAT* outputs[1] = { &out };
+    dsp->compute(1, inputs, outputs);
+    delete dsp;
+    deleteInterpreterDSPFactory(factory);
+    return out;
+}
+
+int main()
+{
+    char dir_template[] = "/tmp/faust-unit-XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::string library = dir + "/gain.lib";
+    std::string dsp_content = "import(\"gain.lib\"); process = *(gain);";
+    time_t past = time(nullptr) - 100;
+    writeFile(library, "gain = 2;", past);
+    setenv("FAUST_DSP_CACHE", dir.c_str(), 1);
+
+    // Compiled once and kept in the cache
+    CHECK(compute(dsp_content, dir) == 2.f);
+    std::vector<std::string> entries = listCache(dir);
+    CHECK(entries.size() == 1);
+    if (entries.size() != 1) return checkResult("dspcache");
+
+    // Used again (a new entry would be a new file): its 'last use' date is updated
+    struct utimbuf times = { past, past };
+    utime(entries[0].c_str(), &times);
+    ino_t inode = getStat(entries[0]).st_ino;
+    CHECK(compute(dsp_content, dir) == 2.f);
+    CHECK(getStat(entries[0]).st_ino == inode && getStat(entries[0]).st_mtime > past);
+
+    // Compiled again when the library has changed
+    writeFile(library, "gain = 3;", past + 10);
+    inode = getStat(entries[0]).st_ino;
+    CHECK(compute(dsp_content, dir) == 3.f);
+    CHECK(listCache(dir).size() == 1 && getStat(entries[0]).st_ino != inode);
+
+    // A library modified during the compilation is not trusted: the entry is not replaced
+    writeFile(library, "gain = 4;", time(nullptr) + 100);
+    inode = getStat(entries[0]).st_ino;
+    CHECK(compute(dsp_content, dir) == 4.f);
+    CHECK(getStat(entries[0]).st_ino == inode);
+    writeFile(library, "gain = 4;", past + 20);
+    CHECK(compute(dsp_content, dir) == 4.f);
+
+    // Another DSP has its own entry
+    CHECK(compute("import(\"gain.lib\"); process = *(gain+1);", dir) == 5.f);
+    entries = listCache(dir);
+    CHECK(entries.size() == 2);
+
+    for (size_t i = 0; i < entries.size(); i++) unlink(entries[i].c_str());
+    unlink(library.c_str());
+    rmdir(dir.c_str());
+    return checkResult("dspcache");
+}
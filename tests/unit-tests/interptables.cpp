@@ -0,0 +1,85 @@
+/*
+ Interpreter static tables: the tables computed once per sample rate are shared by the instances
+ of a factory, stay valid while they are used, and are computed again after being evicted.
+*/
+
+#include <string>
+#include <vector>
+
+#include "faust/dsp/interpreter-dsp.h"
+#include "check.h"
+
+#define TABLE_SIZE 1024
+
+// A table depending on the sample rate, read at the index given by the input, and a scalar static value
+static const char* gCode =
+    "sr = fconstant(int fSamplingFreq, <math.h>);"
+    "time = (+(1) ~ _) - 1;"
+    "process = rdtable(1024, float(time) + float(sr), int(_)) + float(sr);";
+
+// Check that the instance outputs the table of 'sample_rate'
+static bool checkTable(dsp* dsp, int sample_rate)
+{
+    std::vector<FAUSTFLOAT> in(TABLE_SIZE), out(TABLE_SIZE);
+    for (int i = 0; i < TABLE_SIZE; i++) in[i] = FAUSTFLOAT((i * 7) % TABLE_SIZE);
+    FAUSTFLOAT* inputs[1] = { in.data() };
+    FAUSTFLOAT* outputs[1] = { out.data() };
+    dsp->compute(TABLE_SIZE, inputs, outputs);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        if (out[i] != FAUSTFLOAT(in[i] + 2 * sample_rate)) return false;
+    }
+    return true;
+}
+
+int main()
+{
+    std::string error_msg;
+    interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromString("tables", gCode, 0, nullptr, error_msg);
+    CHECK(factory != nullptr);
+    if (!factory) return checkResult("interptables");
+
+    // Instances at the same sample rate share the tables
+    std::vector<dsp*> instances;
+    for (int i = 0; i < 3; i++) {
+        instances.push_back(factory->createDSPInstance());
+        instances.back()->init(44100);
+    }
+    bool same_rate = true;
+    for (auto& it : instances) same_rate &= checkTable(it, 44100);
+    CHECK(same_rate);
+
+    // More sample rates than kept by the factory: the tables of the rates still used are kept
+    std::vector<int> rates = { 8000, 11025, 16000, 22050, 32000, 48000, 88200, 96000 };
+    bool other_rates = true;
+    for (int rate : rates) {
+        dsp* dsp = factory->createDSPInstance();
+        dsp->init(rate);
+        other_rates &= checkTable(dsp, rate);
+        delete dsp;
+        for (auto& it : instances) other_rates &= checkTable(it, 44100);
+    }
+    CHECK(other_rates);
+
+    // Instances moving to another sample rate, then back to an evicted one
+    bool moved = true;
+    for (int rate : rates) {
+        instances[0]->init(rate);
+        moved &= checkTable(instances[0], rate) && checkTable(instances[1], 44100);
+    }
+    instances[1]->init(8000);
+    instances[2]->init(8000);
+    moved &= checkTable(instances[1], 8000) && checkTable(instances[2], 8000);
+    for (auto& it : instances) it->init(44100);
+    for (auto& it : instances) moved &= checkTable(it, 44100);
+    CHECK(moved);
+
+    // Cloned instances
+    dsp* clone = instances[0]->clone();
+    clone->init(48000);
+    CHECK(checkTable(clone, 48000) && checkTable(instances[0], 44100));
+    delete clone;
+
+    for (auto& it : instances) delete it;
+    deleteInterpreterDSPFactory(factory);
+    return checkResult("interptables");
+}
@@ -0,0 +1,126 @@
+/*
+ FAUST_LIB_CACHE: parsed libraries are kept on disk, used while the library has the modification time and size
+ they were built from (or the same content), and parsed again when the library has changed or the entry is corrupted.
+*/
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "faust/dsp/interpreter-dsp.h"
+#include "check.h"
+
+static std::vector<std::string> listCache(const std::string& dir)
+{
+    std::vector<std::string> res;
+    if (DIR* dirp = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(dirp)) {
+            std::string name = ent->d_name;
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".flib") == 0) res.push_back(dir + "/" + name);
+        }
+        closedir(dirp);
+    }
+    return res;
+}
+
+// Write a file, dated in the past (files modified in the last seconds are not trusted by the cache)
+static void writeFile(const std::string& path_name, const std::string& content, time_t date)
+{
+    {
+        std::ofstream writer(path_name.c_str());
+        writer << content;
+    }
+    struct utimbuf times = { date, date };
+    utime(path_name.c_str(), &times);
+}
+
+static ino_t getInode(const std::string& path_name)
+{
+    struct stat st = {};
+    stat(path_name.c_str(), &st);
+    return st.st_ino;
+}
+
+// Compile the DSP, and return its output for an input of 1
+static float compute(const std::string& dsp_content, const std::string& dir)
+{
+    std::string error_msg;
+    const char* argv[] = { "-I", dir.c_str() };
+    interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromString("cache", dsp_content, 2, argv, error_msg);
+    if (!factory) return -1.f;
+    dsp* dsp = factory->createDSPInstance();
+    dsp->init(44100);
+    FAUSTFLOAT in = 1.f, out = 0.f;
+    FAUSTFLOAT* inputs[1] = { &in };
+    FAUSTFLOAT* outputs[1] = { &out };
+    dsp->compute(1, inputs, outputs);
+    delete dsp;
+    deleteInterpreterDSPFactory(factory);
+    return out;
+}
+
+int main()
+{
+    char dir_template[] = "/tmp/faust-unit-XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::string library = dir + "/gain.lib";
+    std::string dsp_content = "import(\"gain.lib\"); process = *(gain) : +(offset);";
+    time_t past = time(nullptr) - 100;
+    writeFile(library, "gain = 2; offset = 0;", past);
+    unsetenv("FAUST_DSP_CACHE");
+    setenv("FAUST_LIB_CACHE", dir.c_str(), 1);
+
+    // Parsed once and kept in the cache
+    CHECK(compute(dsp_content, dir) == 2.f);
+    std::vector<std::string> entries = listCache(dir);
+    CHECK(entries.size() == 1);
+    if (entries.size() != 1) return checkResult("libcache");
+
+    // Used again without being written: a content change keeping the same date and size is not seen
+    ino_t inode = getInode(entries[0]);
+    CHECK(compute(dsp_content, dir) == 2.f);
+    CHECK(getInode(entries[0]) == inode);
+    writeFile(library, "gain = 3; offset = 0;", past);
+    CHECK(compute(dsp_content, dir) == 2.f);
+    CHECK(getInode(entries[0]) == inode);
+
+    // Parsed again when the library date has changed
+    writeFile(library, "gain = 3; offset = 0;", past + 10);
+    CHECK(compute(dsp_content, dir) == 3.f);
+    CHECK(listCache(dir).size() == 1 && getInode(entries[0]) != inode);
+
+    // Same content with a new date: used, and stamped with the new date
+    writeFile(library, "gain = 3; offset = 0;", past + 20);
+    inode = getInode(entries[0]);
+    CHECK(compute(dsp_content, dir) == 3.f);
+    CHECK(getInode(entries[0]) != inode);
+    inode = getInode(entries[0]);
+    CHECK(compute(dsp_content, dir) == 3.f);
+    CHECK(getInode(entries[0]) == inode);
+
+    // A library modified in the last seconds is not trusted
+    writeFile(library, "gain = 4; offset = 1;", time(nullptr));
+    CHECK(compute(dsp_content, dir) == 5.f);
+
+    // A truncated entry is ignored and written again
+    writeFile(library, "gain = 4; offset = 2;", past + 30);
+    CHECK(compute(dsp_content, dir) == 6.f);
+    CHECK(truncate(entries[0].c_str(), 64) == 0);
+    CHECK(compute(dsp_content, dir) == 6.f);
+    struct stat st = {};
+    stat(entries[0].c_str(), &st);
+    CHECK(st.st_size > 64);
+    CHECK(compute(dsp_content, dir) == 6.f);
+
+    entries = listCache(dir);
+    CHECK(entries.size() == 1);
+    for (size_t i = 0; i < entries.size(); i++) unlink(entries[i].c_str());
+    unlink(library.c_str());
+    rmdir(dir.c_str());
+    return checkResult("libcache");
+}
@@ -0,0 +1,141 @@
+/*
+ MMapSoundfileReader cache files: sharing, invalid cache files and eviction.
+ The soundfiles are 'decoded' by a test reader filling each frame with its index.
+*/
+
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define FAUSTFLOAT float
+
+#include "faust/gui/MMapSoundfileReader.h"
+#include "check.h"
+
+struct RampReader : public SoundfileReader {
+
+    // Files hold their length in frames
+    static int getLength(const std::string& path_name)
+    {
+        std::ifstream reader(path_name.c_str());
+        int length = 0;
+        reader >> length;
+        return length;
+    }
+
+    bool checkFile(const std::string& path_name) { return getLength(path_name) > 0; }
+
+    void getParamsFile(const std::string& path_name, int& channels, int& length)
+    {
+        channels = 2;
+        length = getLength(path_name);
+    }
+
+    void readFile(Soundfile* soundfile, const std::string& path_name, int part, int& offset, int max_chan)
+    {
+        int length = getLength(path_name);
+        soundfile->fLength[part] = length;
+        soundfile->fSR[part] = 44100;
+        soundfile->fOffset[part] = offset;
+        for (int chan = 0; chan < soundfile->fChannels; chan++) {
+            for (int frame = 0; frame < length; frame++) {
+                soundfile->fBuffers[chan][offset + frame] = FAUSTFLOAT(frame + chan * 0.5);
+            }
+        }
+        offset += length;
+    }
+};
+
+static void writeFile(const std::string& path_name, int length)
+{
+    std::ofstream writer(path_name.c_str());
+    writer << length;
+}
+
+static std::vector<std::string> listCache(const std::string& dir)
+{
+    std::vector<std::string> res;
+    if (DIR* dirp = opendir(dir.c_str())) {
+        while (struct dirent* ent = readdir(dirp)) {
+            std::string name = ent->d_name;
+            if (name.compare(0, 6, "faust-") == 0) res.push_back(dir + "/" + name);
+        }
+        closedir(dirp);
+    }
+    return res;
+}
+
+static bool checkRamp(Soundfile* soundfile, int length)
+{
+    if (!soundfile || soundfile->fLength[0] != length || soundfile->fOffset[0] != 0) return false;
+    for (int frame = 0; frame < length; frame++) {
+        if (soundfile->fBuffers[0][frame] != FAUSTFLOAT(frame)) return false;
+        if (soundfile->fBuffers[1][frame] != FAUSTFLOAT(frame + 0.5)) return false;
+    }
+    return true;
+}
+
+int main()
+{
+    char dir_template[] = "/tmp/faust-unit-XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::string sound1 = dir + "/sound1.txt";
+    std::string sound2 = dir + "/sound2.txt";
+    writeFile(sound1, 100000);
+    writeFile(sound2, 300000);
+    std::vector<std::string> list1(1, sound1);
+    std::vector<std::string> list2(1, sound2);
+
+    MMapSoundfileReader<RampReader> reader(dir);
+    reader.setSampleRate(44100);
+
+    // Decoded once in a cache file, then shared
+    Soundfile* soundfile1 = reader.createSoundfile(list1, 2);
+    CHECK(checkRamp(soundfile1, 100000));
+    CHECK(listCache(dir).size() == 1);
+    Soundfile* soundfile2 = reader.createSoundfile(list1, 2);
+    CHECK(soundfile2 == soundfile1);
+    reader.destroySoundfile(soundfile2);
+    reader.destroySoundfile(soundfile1);
+
+    // Mapped from the cache file
+    std::string cache_file = listCache(dir)[0];
+    soundfile1 = reader.createSoundfile(list1, 2);
+    CHECK(checkRamp(soundfile1, 100000));
+    reader.destroySoundfile(soundfile1);
+
+    // A cache file whose part is outside of the channels is rejected and rewritten
+    MMapSoundfileHeader header;
+    int fd = open(cache_file.c_str(), O_RDWR);
+    CHECK(pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)));
+    int32_t offset = header.fOffset[1];
+    header.fOffset[1] = int32_t(header.fStride);
+    CHECK(pwrite(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)));
+    close(fd);
+    soundfile1 = reader.createSoundfile(list1, 2);
+    CHECK(checkRamp(soundfile1, 100000) && soundfile1->fOffset[1] == offset);
+    reader.destroySoundfile(soundfile1);
+
+    // A truncated cache file is rejected and rewritten
+    CHECK(truncate(cache_file.c_str(), 8192) == 0);
+    soundfile1 = reader.createSoundfile(list1, 2);
+    CHECK(checkRamp(soundfile1, 100000));
+    reader.destroySoundfile(soundfile1);
+    struct stat info;
+    CHECK(stat(cache_file.c_str(), &info) == 0 && info.st_size > 8192);
+
+    // Over the cache size, the least recently used file is evicted
+    setenv("FAUST_SOUNDFILE_CACHE_SIZE", "1", 1);
+    soundfile2 = reader.createSoundfile(list2, 2);
+    CHECK(checkRamp(soundfile2, 300000));
+    reader.destroySoundfile(soundfile2);
+    std::vector<std::string> files = listCache(dir);
+    CHECK(files.size() == 1 && files[0] != cache_file);
+
+    for (size_t i = 0; i < files.size(); i++) unlink(files[i].c_str());
+    unlink(sound1.c_str());
+    unlink(sound2.c_str());
+    rmdir(dir.c_str());
+    return checkResult("mmapsoundfile");
+}
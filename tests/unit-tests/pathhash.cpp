@@ -0,0 +1,132 @@
+/*
+ PathHash: every key of the table is found with its value and unknown keys are not, for tables of any size.
+ MapUI and APIUI: parameters are found by path or label once the UI is complete, and set by index.
+*/
+
+#include <stdlib.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#define FAUSTFLOAT float
+
+#include "faust/gui/PathHash.h"
+#include "faust/gui/MapUI.h"
+#include "faust/gui/APIUI.h"
+#include "check.h"
+
+static std::string randomKey()
+{
+    std::string key;
+    int len = rand() % 24;
+    for (int i = 0; i < len; i++) key += char('a' + rand() % 4);
+    return key;
+}
+
+// Tables of random keys (with a short alphabet, to get many shared prefixes)
+static bool checkRandomTables()
+{
+    bool res = true;
+    for (int size = 0; size < 400; size += 1 + size / 8) {
+        std::set<std::string> set;
+        while (int(set.size()) < size) set.insert(randomKey());
+        std::vector<std::string> keys(set.begin(), set.end());
+        std::vector<int> values;
+        for (int i = 0; i < size; i++) values.push_back(i * 3);
+
+        PathHash hash;
+        hash.build(keys, values);
+        for (int i = 0; i < size; i++) res &= (hash.find(keys[i]) == i * 3);
+        for (int i = 0; i < 200; i++) {
+            std::string key = randomKey() + "z";
+            res &= (hash.find(key) == -1);
+        }
+        for (int i = 0; i < size; i++) {
+            std::string prefix = keys[i].substr(0, keys[i].size() / 2);
+            if (set.find(prefix) == set.end()) res &= (hash.find(prefix) == -1);
+        }
+    }
+    return res;
+}
+
+// Two groups with the same labels, and labels appearing only once
+template <class UI_TYPE>
+static void buildUI(UI_TYPE& ui, FAUSTFLOAT* zones)
+{
+    ui.openVerticalBox("synth");
+    ui.openHorizontalBox("osc1");
+    ui.addHorizontalSlider("freq", &zones[0], 440, 20, 2000, 1);
+    ui.addHorizontalSlider("gain", &zones[1], 0.5, 0, 1, 0.01);
+    ui.closeBox();
+    ui.openHorizontalBox("osc2");
+    ui.addHorizontalSlider("freq", &zones[2], 440, 20, 2000, 1);
+    ui.addHorizontalSlider("gain", &zones[3], 0.5, 0, 1, 0.01);
+    ui.closeBox();
+    ui.addButton("gate", &zones[4]);
+    ui.addVerticalBargraph("level", &zones[5], 0, 1);
+    ui.closeBox();
+}
+
+static const char* gPaths[] = { "/synth/osc1/freq", "/synth/osc1/gain", "/synth/osc2/freq",
+                                "/synth/osc2/gain", "/synth/gate", "/synth/level" };
+
+static bool checkMapUI()
+{
+    FAUSTFLOAT zones[6] = {};
+    MapUI ui;
+    buildUI(ui, zones);
+
+    bool res = (ui.getParamsCount() == 6);
+    for (int i = 0; i < 6; i++) {
+        int index = ui.getParamIndex(gPaths[i]);
+        res &= (index >= 0 && ui.getParamZone(index) == &zones[i] && ui.getParamAddress(index) == gPaths[i]);
+    }
+    // A label shared by two controls gives one of them, a single one gives its control
+    int freq = ui.getParamIndex("freq");
+    res &= (ui.getParamZone(freq) == &zones[0] || ui.getParamZone(freq) == &zones[2]);
+    res &= (ui.getParamZone(ui.getParamIndex("gate")) == &zones[4]);
+    res &= (ui.getParamIndex("/synth/osc3/freq") == -1 && ui.getParamIndex("/synth/osc1") == -1);
+    res &= (ui.getParamIndex("") == -1 && ui.getParamIndex("/synth/gate/") == -1);
+
+    // By path and by index
+    ui.setParamValue("/synth/osc2/gain", 0.25f);
+    res &= (zones[3] == 0.25f && ui.getParamValue("/synth/osc2/gain") == 0.25f);
+    int indexes[2] = { ui.getParamIndex("/synth/osc1/freq"), ui.getParamIndex("/synth/gate") };
+    FAUSTFLOAT values[2] = { 880.f, 1.f };
+    ui.setParamValues(indexes, values, 2);
+    FAUSTFLOAT read[2] = {};
+    ui.getParamValues(indexes, read, 2);
+    res &= (zones[0] == 880.f && zones[4] == 1.f && read[0] == 880.f && read[1] == 1.f);
+    return res;
+}
+
+static bool checkAPIUI()
+{
+    FAUSTFLOAT zones[6] = {};
+    APIUI ui;
+    bool res = (ui.getParamIndex("/synth/gate") == -1);  // Not built yet
+    buildUI(ui, zones);
+
+    res &= (ui.getParamsCount() == 6);
+    for (int i = 0; i < 6; i++) {
+        int index = ui.getParamIndex(gPaths[i]);
+        res &= (index >= 0 && ui.getParamZone(index) == &zones[i] && std::string(ui.getParamAddress(index)) == gPaths[i]);
+    }
+    res &= (ui.getParamZone(ui.getParamIndex("level")) == &zones[5]);
+    res &= (ui.getParamIndex("/synth/osc1/level") == -1 && ui.getParamIndex("synth") == -1);
+
+    int indexes[2] = { ui.getParamIndex("/synth/osc2/freq"), ui.getParamIndex("gain") };
+    FAUSTFLOAT values[2] = { 220.f, 0.75f };
+    ui.setParamValues(indexes, values, 2);
+    res &= (zones[2] == 220.f && (zones[1] == 0.75f || zones[3] == 0.75f));
+    return res;
+}
+
+int main()
+{
+    srand(1234);
+    CHECK(checkRandomTables());
+    CHECK(checkMapUI());
+    CHECK(checkAPIUI());
+    return checkResult("pathhash");
+}
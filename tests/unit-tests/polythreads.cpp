@@ -0,0 +1,133 @@
+/*
+ mydsp_poly with POLY_THREADS: voices computed by the worker pool give the same output as the sequential
+ voices, including after the workers have parked between two audio cycles.
+ dsp_voice_pool: compute() only returns when all the jobs of the cycle are finished, so that the audio thread
+ never mixes a voice buffer still being written.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define FAUSTFLOAT float
+#define POLY_THREADS
+
+#include "faust/dsp/poly-dsp.h"
+#include "check.h"
+
+std::list<GUI*> GUI::fGuiList;
+
+// A ramp at 'freq', of amplitude 'gain' when 'gate' is on
+struct VoiceDSP : public dsp {
+
+    FAUSTFLOAT fFreq, fGain, fGate;
+    float fPhase;
+
+    VoiceDSP():fFreq(440), fGain(1), fGate(0), fPhase(0) {}
+
+    int getNumInputs() { return 0; }
+    int getNumOutputs() { return 2; }
+    void buildUserInterface(UI* ui)
+    {
+        ui->openVerticalBox("voice");
+        ui->addHorizontalSlider("freq", &fFreq, 440, 20, 20000, 1);
+        ui->addHorizontalSlider("gain", &fGain, 1, 0, 1, 0.01);
+        ui->addButton("gate", &fGate);
+        ui->closeBox();
+    }
+    int getSampleRate() { return 44100; }
+    void init(int sample_rate) { instanceInit(sample_rate); }
+    void instanceInit(int sample_rate) { instanceResetUserInterface(); instanceClear(); }
+    void instanceConstants(int sample_rate) {}
+    void instanceResetUserInterface() { fFreq = 440; fGain = 1; fGate = 0; }
+    void instanceClear() { fPhase = 0; }
+    dsp* clone() { return new VoiceDSP(); }
+    void metadata(Meta* m) {}
+    void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+    {
+        for (int i = 0; i < count; i++) {
+            fPhase = std::fmod(fPhase + fFreq / 44100.f, 1.f);
+            outputs[0][i] = fGate * fGain * fPhase;
+            outputs[1][i] = -outputs[0][i];
+        }
+    }
+};
+
+// Jobs of random durations write their buffer, which must be complete when compute() returns
+static bool checkPoolCycles(int num_threads, int cycles)
+{
+    const int kMaxJobs = 16;
+    const int kSize = 64;
+    std::vector<std::atomic<int>> buffers(kMaxJobs * kSize);
+    std::atomic<int> cycle(0);
+    dsp_voice_pool pool(num_threads, [&](int job) {
+        int value = cycle.load();
+        std::minstd_rand rand(value * kMaxJobs + job);
+        for (int i = 0; i < kSize; i++) {
+            buffers[job * kSize + i].store(value, std::memory_order_relaxed);
+            for (int spin = int(rand() % 64); spin > 0; spin--) std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+        if (rand() % 16 == 0) std::this_thread::yield();
+    });
+    std::minstd_rand rand(1234);
+    bool complete = true;
+    for (int i = 1; i <= cycles; i++) {
+        cycle.store(i);
+        int jobs = 1 + int(rand() % kMaxJobs);
+        pool.compute(jobs);
+        for (int j = 0; j < jobs * kSize; j++) {
+            complete &= (buffers[j].load(std::memory_order_relaxed) == i);
+        }
+        // Let the workers park from time to time
+        if (i % 5000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return complete;
+}
+
+int main()
+{
+    CHECK(checkPoolCycles(2, 20000));
+    CHECK(checkPoolCycles(4, 20000));
+
+    mydsp_poly* sequential = new mydsp_poly(new VoiceDSP(), 16, true, false);
+    mydsp_poly* threaded = new mydsp_poly(new VoiceDSP(), 16, true, false);
+    sequential->init(44100);
+    threaded->init(44100);
+    threaded->setNumThreads(3);
+    CHECK(threaded->getNumThreads() == 3);
+
+    FAUSTFLOAT buffer1[2][256], buffer2[2][256];
+    FAUSTFLOAT* outputs1[2] = { buffer1[0], buffer1[1] };
+    FAUSTFLOAT* outputs2[2] = { buffer2[0], buffer2[1] };
+
+    for (int note = 0; note < 12; note++) {
+        sequential->keyOn(0, 60 + note, 100);
+        threaded->keyOn(0, 60 + note, 100);
+    }
+
+    bool same = true;
+    for (int cycle = 0; cycle < 200; cycle++) {
+        sequential->compute(256, nullptr, outputs1);
+        threaded->compute(256, nullptr, outputs2);
+        for (int chan = 0; chan < 2; chan++) {
+            for (int i = 0; i < 256; i++) {
+                same &= (std::fabs(buffer1[chan][i] - buffer2[chan][i]) < 1e-5f);
+            }
+        }
+        // Long enough for the idle workers to park, and to be woken up by the next cycle
+        if (cycle % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    CHECK(same);
+
+    // Back to the sequential mode, then deleted with parked workers
+    threaded->setNumThreads(1);
+    CHECK(threaded->getNumThreads() == 1);
+    threaded->setNumThreads(4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    delete threaded;
+    delete sequential;
+    return checkResult("polythreads");
+}
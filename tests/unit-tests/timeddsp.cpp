@@ -0,0 +1,140 @@
+/*
+ timed_dsp: dated values are applied at their frame, timed UIs can be built and deleted
+ while the audio thread is computing, and values are written by several threads.
+*/
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define FAUSTFLOAT float
+
+#include "faust/gui/GUI.h"
+#include "faust/dsp/timed-dsp.h"
+#include "check.h"
+
+std::list<GUI*> GUI::fGuiList;
+
+#define ZONES 64
+
+// Outputs the value of its first zone, and has ZONES sliders
+struct ZonesDSP : public dsp {
+
+    FAUSTFLOAT fZones[ZONES];
+
+    ZonesDSP() { for (int i = 0; i < ZONES; i++) fZones[i] = 0; }
+
+    int getNumInputs() { return 0; }
+    int getNumOutputs() { return 1; }
+    void buildUserInterface(UI* ui)
+    {
+        ui->openVerticalBox("zones");
+        for (int i = 0; i < ZONES; i++) {
+            ui->addHorizontalSlider("zone", &fZones[i], 0, 0, 1000000, 1);
+        }
+        ui->closeBox();
+    }
+    int getSampleRate() { return 44100; }
+    void init(int sample_rate) {}
+    void instanceInit(int sample_rate) {}
+    void instanceConstants(int sample_rate) {}
+    void instanceResetUserInterface() {}
+    void instanceClear() {}
+    dsp* clone() { return new ZonesDSP(); }
+    void metadata(Meta* m) {}
+    void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+    {
+        for (int i = 0; i < count; i++) outputs[0][i] = fZones[0];
+    }
+};
+
+struct TimedItem : public uiTimedItem {
+
+    TimedItem(GUI* ui, FAUSTFLOAT* zone):uiTimedItem(ui, zone) {}
+    void reflectZone() {}
+};
+
+// A GUI with a timed item on its first zones (deleted with the GUI)
+struct TimedUI : public GUI {
+
+    std::vector<uiTimedItem*> fItems;
+    size_t fTimedZones;
+
+    TimedUI(size_t timed_zones = ZONES):fTimedZones(timed_zones) {}
+
+    void addZone(FAUSTFLOAT* zone)
+    {
+        if (fItems.size() < fTimedZones) fItems.push_back(new TimedItem(this, zone));
+    }
+
+    void addHorizontalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+    {
+        addZone(zone);
+    }
+};
+
+int main()
+{
+    ZonesDSP* zones_dsp = new ZonesDSP();
+    timed_dsp* dsp = new timed_dsp(zones_dsp);
+    FAUSTFLOAT buffer[256];
+    FAUSTFLOAT* outputs[1] = { buffer };
+
+    // Dated values (in frames) are applied at their frame
+    {
+        TimedUI ui(1);
+        dsp->buildUserInterface(&ui);
+        ui.fItems[0]->modifyZone(10., 1.f);
+        ui.fItems[0]->modifyZone(100., 2.f);
+        dsp->compute(-1, 256, nullptr, outputs);
+        CHECK(buffer[9] == 0.f && buffer[10] == 1.f && buffer[99] == 1.f && buffer[100] == 2.f && buffer[255] == 2.f);
+    }
+
+    // Without a timed UI, the values of a deleted UI are not seen
+    dsp->compute(-1, 256, nullptr, outputs);
+    CHECK(buffer[0] == 2.f && buffer[255] == 2.f);
+
+    // UIs timing more and more zones built and deleted while the audio thread computes, and written by several threads
+    std::atomic<bool> running(true);
+    std::thread audio([&]() {
+        FAUSTFLOAT audio_buffer[64];
+        FAUSTFLOAT* audio_outputs[1] = { audio_buffer };
+        while (running) {
+            dsp->compute(-1, 64, nullptr, audio_outputs);
+            for (int i = 0; i < 64; i++) {
+                if (audio_buffer[i] < 0.f || audio_buffer[i] > 1000000.f) running = false;
+            }
+        }
+    });
+    for (int round = 0; round < ZONES; round++) {
+        TimedUI ui(round + 1);
+        dsp->buildUserInterface(&ui);
+        std::vector<std::thread> writers;
+        for (int writer = 0; writer < 3; writer++) {
+            writers.push_back(std::thread([&ui, writer]() {
+                for (int i = 0; i < 100; i++) {
+                    ui.fItems[(i * 7 + writer) % ui.fItems.size()]->modifyZone(double(i % 64), FAUSTFLOAT(i));
+                }
+            }));
+        }
+        for (auto& it : writers) it.join();
+        // Let the audio thread read the values
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    CHECK(running);
+    running = false;
+    audio.join();
+
+    // The zones are still timed with a new UI
+    {
+        TimedUI ui;
+        dsp->buildUserInterface(&ui);
+        ui.fItems[0]->modifyZone(0., 12345.f);
+        dsp->compute(-1, 64, nullptr, outputs);
+        CHECK(buffer[0] == 12345.f && buffer[63] == 12345.f);
+    }
+
+    delete dsp;
+    CHECK(GUI::getTimedZoneQueueMap().empty());
+    return checkResult("timeddsp");
+}
@@ -57,7 +57,6 @@
 using namespace std;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 struct malloc_memory_manager : public dsp_memory_manager {
     
@@ -41,7 +41,6 @@
 using namespace std;
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int main(int argc, char* argv[])
 {
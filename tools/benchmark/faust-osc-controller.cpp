@@ -41,7 +41,6 @@ using namespace std;
 // Usage: faust-osc-controller /clarinet localhost -port 5001 -outport 5000 -xmit 1
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 static string replaceChar(string str, char src, char dst)
 {
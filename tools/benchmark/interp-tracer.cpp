@@ -100,7 +100,6 @@ struct CheckControlUI : public MapUI {
 };
 
 list<GUI*> GUI::fGuiList;
-ztimedmap GUI::gTimedZoneMap;
 
 int main(int argc, char* argv[])
 {